@@ -0,0 +1,201 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "base/async_client.hpp"
+
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "base/node_util.hpp"
+#include "utils/global.hpp"
+#include "utils/timer.hpp"
+#include "utils/tool.hpp"
+
+#include "glog/logging.h"
+
+using namespace std;
+
+AsyncClient::AsyncClient(const string& cfg_fname, uint64_t request_timeout_ms)
+    : cfg_fname_(cfg_fname), request_timeout_us_(request_timeout_ms * 1000), stop_(false) {}
+
+AsyncClient::~AsyncClient() {
+    if (recv_thread_.joinable()) {
+        stop_ = true;
+        recv_thread_.join();
+    }
+    delete sender_;
+    delete receiver_;
+}
+
+void AsyncClient::Init() {
+    vector<Node> nodes = ParseFile(cfg_fname_);
+    CHECK(CheckUniquePort(nodes));
+
+    char hostname[HOST_NAME_MAX];
+    gethostname(hostname, HOST_NAME_MAX);
+    host_ = hostname;
+
+    // Request a worker from master
+    Node& master = GetNodeById(nodes, MASTER_RANK);
+    zmq::socket_t master_socket(context_, ZMQ_REQ);
+    char addr[64];
+    snprintf(addr, sizeof(addr), "tcp://%s:%d", master.hostname.c_str(), master.tcp_port);
+    master_socket.connect(addr);
+
+    ibinstream m;
+    m << -1;  // new client
+    zmq::message_t request(m.size());
+    memcpy(request.data(), m.get_buf(), m.size());
+    master_socket.send(request);
+
+    zmq::message_t response;
+    CHECK(master_socket.recv(&response)) << "[AsyncClient] recvs from master failed";
+    char* buf = new char[response.size()];
+    memcpy(buf, response.data(), response.size());
+    obinstream um(buf, response.size());
+    int client_id, worker_rank;
+    um >> client_id >> worker_rank;
+
+    Node& worker = GetNodeById(nodes, worker_rank);
+    sender_ = new zmq::socket_t(context_, ZMQ_PUSH);
+    snprintf(addr, sizeof(addr), "tcp://%s:%d", worker.hostname.c_str(), worker.tcp_port);
+    sender_->connect(addr);
+
+    // Replies are sent to an ephemeral port, so that multiple clients can run on the same host
+    receiver_ = new zmq::socket_t(context_, ZMQ_PULL);
+    int timeout_ms = 100;
+    receiver_->setsockopt(ZMQ_RCVTIMEO, &timeout_ms, sizeof(timeout_ms));
+    receiver_->bind("tcp://*:*");
+    char endpoint[256];
+    size_t endpoint_len = sizeof(endpoint);
+    receiver_->getsockopt(ZMQ_LAST_ENDPOINT, endpoint, &endpoint_len);
+    string port = string(endpoint).substr(string(endpoint).rfind(':') + 1);
+    reply_endpoint_ = "tcp://" + host_ + ":" + port;
+
+    recv_thread_ = thread(&AsyncClient::RecvReplies, this);
+    LOG(INFO) << "[AsyncClient] Client " << client_id << " connects to worker_node" << worker_rank - 1
+              << ", receiving replies at " << reply_endpoint_;
+}
+
+future<AsyncReply> AsyncClient::Submit(const string& query) {
+    return move(SubmitBatch(vector<string>{query})[0]);
+}
+
+vector<future<AsyncReply>> AsyncClient::SubmitBatch(const vector<string>& queries) {
+    vector<future<AsyncReply>> futures;
+    SendRequests(queries, [&](uint64_t req_id) {
+        futures.emplace_back(pending_[req_id].promise.get_future());
+    });
+    return futures;
+}
+
+void AsyncClient::Submit(const string& query, Callback callback) {
+    SendRequests(vector<string>{query}, [&](uint64_t req_id) {
+        pending_[req_id].callback = move(callback);
+    });
+}
+
+void AsyncClient::SendRequests(const vector<string>& queries, const function<void(uint64_t)>& register_pending) {
+    vector<AsyncRequest> reqs(queries.size());
+
+    uint64_t now = timer::get_usec();
+    lock_guard<mutex> lock(mutex_);
+    for (int i = 0; i < queries.size(); i++) {
+        reqs[i].req_id = next_req_id_++;
+        reqs[i].query = queries[i];
+        register_pending(reqs[i].req_id);
+        pending_[reqs[i].req_id].submit_time = now;
+    }
+
+    ibinstream m;
+    m << host_;
+    m << string(ASYNC_QUERY_TAG);
+    m << reply_endpoint_;
+    m << reqs;
+
+    zmq::message_t msg(m.size());
+    memcpy(msg.data(), m.get_buf(), m.size());
+    sender_->send(msg);
+}
+
+void AsyncClient::RecvReplies() {
+    while (!stop_) {
+        ExpireRequests();
+        zmq::message_t msg;
+        if (!receiver_->recv(&msg))
+            continue;  // timeout
+
+        char* buf = new char[msg.size()];
+        memcpy(buf, msg.data(), msg.size());
+        obinstream um(buf, msg.size());
+        vector<AsyncReply> replies;
+        um >> replies;
+
+        vector<PendingRequest> finished;
+        {
+            lock_guard<mutex> lock(mutex_);
+            for (auto& reply : replies) {
+                auto itr = pending_.find(reply.req_id);
+                if (itr == pending_.end()) {
+                    LOG(WARNING) << "[AsyncClient] Unexpected reply of request " << reply.req_id;
+                    reply.req_id = UINT64_MAX;
+                    finished.emplace_back();
+                    continue;
+                }
+                finished.emplace_back(move(itr->second));
+                pending_.erase(itr);
+            }
+        }
+
+        // callbacks may submit new requests, thus called without the lock
+        for (int i = 0; i < replies.size(); i++) {
+            if (replies[i].req_id == UINT64_MAX)
+                continue;
+            FinishRequest(finished[i], replies[i]);
+        }
+    }
+}
+
+void AsyncClient::ExpireRequests() {
+    uint64_t now = timer::get_usec();
+    vector<pair<uint64_t, PendingRequest>> expired;
+    {
+        lock_guard<mutex> lock(mutex_);
+        // the oldest requests are at the beginning
+        while (!pending_.empty() && now - pending_.begin()->second.submit_time > request_timeout_us_) {
+            expired.emplace_back(pending_.begin()->first, move(pending_.begin()->second));
+            pending_.erase(pending_.begin());
+        }
+    }
+
+    for (auto& p : expired) {
+        LOG(WARNING) << "[AsyncClient] Request " << p.first << " timed out";
+        AsyncReply reply;
+        reply.req_id = p.first;
+        reply.status = TRX_STAT::ABORT;
+        reply.results.emplace_back();
+        Tool::str2str("Request timed out without reply", reply.results.back());
+        reply.time = now - p.second.submit_time;
+        FinishRequest(p.second, reply);
+    }
+}
+
+void AsyncClient::FinishRequest(PendingRequest& pending, AsyncReply& reply) {
+    if (pending.callback) {
+        pending.callback(reply);
+    } else {
+        pending.promise.set_value(move(reply));
+    }
+}
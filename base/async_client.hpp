@@ -0,0 +1,98 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/async_protocol.hpp"
+#include "base/node.hpp"
+#include "utils/zmq.hpp"
+
+/* Client library with pipelined transactions, see base/async_protocol.hpp.
+ * All transactions of a client are sent to the worker assigned by master in Init,
+ * and any number of them can be in flight.
+ *
+ * Usage:
+ *     AsyncClient client(cfg_fname);
+ *     client.Init();
+ *     future<AsyncReply> f = client.Submit("g.V().count()");
+ *     vector<future<AsyncReply>> fs = client.SubmitBatch(queries);
+ *     AsyncReply reply = f.get();
+ *     client.Submit("g.V().count()", [](AsyncReply& reply) { ... });
+ *
+ * A request without reply in request_timeout_ms is finished with status ABORT and the error message as result.
+ */
+class AsyncClient {
+ public:
+    // Called by the thread receiving replies once the reply arrives, thus should be short
+    typedef std::function<void(AsyncReply&)> Callback;
+
+    explicit AsyncClient(const std::string& cfg_fname, uint64_t request_timeout_ms = 60000);
+    ~AsyncClient();
+
+    // Request a worker from master, and start the thread receiving replies
+    void Init();
+
+    std::future<AsyncReply> Submit(const std::string& query);
+
+    // Submit all queries in one frame
+    std::vector<std::future<AsyncReply>> SubmitBatch(const std::vector<std::string>& queries);
+
+    void Submit(const std::string& query, Callback callback);
+
+ private:
+    // Either promise or callback is used
+    struct PendingRequest {
+        std::promise<AsyncReply> promise;
+        Callback callback;
+        uint64_t submit_time;  // in us
+    };
+
+    // Send queries in one frame, with pending requests registered by register_pending(req_id)
+    void SendRequests(const std::vector<std::string>& queries,
+                      const std::function<void(uint64_t)>& register_pending);
+    void RecvReplies();
+    // Finish requests pending longer than request timeout
+    void ExpireRequests();
+    // Set the reply to promise or call callback, without mutex_
+    void FinishRequest(PendingRequest& pending, AsyncReply& reply);
+
+    std::string cfg_fname_;
+    std::string host_;
+    std::string reply_endpoint_;
+    uint64_t request_timeout_us_;
+
+    zmq::context_t context_;
+    zmq::socket_t* sender_ = nullptr;
+    zmq::socket_t* receiver_ = nullptr;
+
+    // guards sender_, next_req_id_ and pending_
+    std::mutex mutex_;
+    uint64_t next_req_id_ = 0;
+    // ordered by req_id, thus by submit time
+    std::map<uint64_t, PendingRequest> pending_;
+
+    std::thread recv_thread_;
+    std::atomic<bool> stop_;
+};
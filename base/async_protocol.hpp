@@ -0,0 +1,73 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/serialization.hpp"
+#include "base/type.hpp"
+
+/*
+Pipelined protocol between AsyncClient and workers.
+-----------------------------------------------------------------------------------
+Request frame (client -> worker, through the same socket as synchronous queries):
+    [client_host][ASYNC_QUERY_TAG][reply_endpoint][vector<AsyncRequest>]
+    Many transactions can be submitted in one frame, each tagged with a request id unique in the client.
+Reply frame (worker -> reply_endpoint of client):
+    [vector<AsyncReply>]
+    Replies finished close in time are batched into one frame, in any order.
+    Results are sent as typed value_t, instead of strings, with the status of the transaction (committed or aborted).
+    Frames to a client which stops reading are kept in a bounded backlog and retried, without blocking other clients.
+    A request without reply is failed by the client after its timeout, with status ABORT.
+*/
+
+#define ASYNC_QUERY_TAG "async"
+
+struct AsyncRequest {
+    uint64_t req_id;
+    string query;
+};
+
+struct AsyncReply {
+    uint64_t req_id;
+    TRX_STAT status = TRX_STAT::COMMITTED;  // COMMITTED or ABORT
+    vector<value_t> results;
+    uint64_t time;  // in us, from parsing to finishing the transaction
+};
+
+inline ibinstream& operator<<(ibinstream& m, const AsyncRequest& req) {
+    m << req.req_id << req.query;
+    return m;
+}
+
+inline obinstream& operator>>(obinstream& m, AsyncRequest& req) {
+    m >> req.req_id >> req.query;
+    return m;
+}
+
+inline ibinstream& operator<<(ibinstream& m, const AsyncReply& reply) {
+    m << reply.req_id << static_cast<int>(reply.status) << reply.results << reply.time;
+    return m;
+}
+
+inline obinstream& operator>>(obinstream& m, AsyncReply& reply) {
+    int status;
+    m >> reply.req_id >> status >> reply.results >> reply.time;
+    reply.status = static_cast<TRX_STAT>(status);
+    return m;
+}
@@ -80,3 +80,66 @@ void recv_obinstream(obinstream& m, int src, MPI_Comm world, int tag) {
     recv(buf, msg_sz, src, world, tag);
     m.assign(buf, size, 0);
 }
+
+// ============================================
+
+void all_to_all_bytes(Node & node, bool is_global, vector<vector<char>>& to_exchange) {
+    int np;
+    MPI_Comm world;
+    if (is_global) {
+        np = node.get_world_size();
+        world = MPI_COMM_WORLD;
+    } else {
+        np = node.get_local_size();
+        world = node.local_comm;
+    }
+
+    vector<uint64_t> send_sizes(np), recv_sizes(np);
+    for (int i = 0; i < np; i++) {
+        send_sizes[i] = to_exchange[i].size();
+    }
+    MPI_Alltoall(&send_sizes[0], 1, MPI_UINT64_T, &recv_sizes[0], 1, MPI_UINT64_T, world);
+
+    vector<vector<char>> received(np);
+    uint64_t max_size = 0;
+    for (int i = 0; i < np; i++) {
+        received[i].resize(recv_sizes[i]);
+        max_size = max(max_size, max(send_sizes[i], recv_sizes[i]));
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &max_size, 1, MPI_UINT64_T, MPI_MAX, world);
+
+    // counts and displacements of MPI_Alltoallv are int, exchange in rounds
+    uint64_t chunk = INT_MAX / np;
+    vector<int> send_counts(np), send_displs(np), recv_counts(np), recv_displs(np);
+    vector<char> send_buf, recv_buf;
+    for (uint64_t offset = 0; offset < max_size; offset += chunk) {
+        int send_total = 0, recv_total = 0;
+        for (int i = 0; i < np; i++) {
+            send_counts[i] = send_sizes[i] > offset ? min(chunk, send_sizes[i] - offset) : 0;
+            recv_counts[i] = recv_sizes[i] > offset ? min(chunk, recv_sizes[i] - offset) : 0;
+            send_displs[i] = send_total;
+            recv_displs[i] = recv_total;
+            send_total += send_counts[i];
+            recv_total += recv_counts[i];
+        }
+
+        send_buf.resize(send_total);
+        recv_buf.resize(recv_total);
+        for (int i = 0; i < np; i++) {
+            if (send_counts[i] != 0) {
+                memcpy(&send_buf[send_displs[i]], &to_exchange[i][offset], send_counts[i]);
+            }
+        }
+
+        MPI_Alltoallv(send_buf.data(), &send_counts[0], &send_displs[0], MPI_BYTE,
+                      recv_buf.data(), &recv_counts[0], &recv_displs[0], MPI_BYTE, world);
+
+        for (int i = 0; i < np; i++) {
+            if (recv_counts[i] != 0) {
+                memcpy(&received[i][offset], &recv_buf[recv_displs[i]], recv_counts[i]);
+            }
+        }
+    }
+
+    to_exchange.swap(received);
+}
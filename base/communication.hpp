@@ -72,6 +72,10 @@ void all_to_all(Node & node, bool is_global, vector<T>& to_send, vector<T1>& to_
 template <class T, class T1>
 void all_to_all_cat(Node & node, bool is_global, std::vector<T>& to_exchange1, std::vector<T1>& to_exchange2);
 
+// exchange packed buffers by MPI_Alltoallv without serialization
+// send out to_exchange[i] to i, save received data in to_exchange[i]
+void all_to_all_bytes(Node & node, bool is_global, vector<vector<char>>& to_exchange);
+
 template <class T, class T1, class T2>
 void all_to_all_cat(Node & node, bool is_global, std::vector<T>& to_exchange1,
             std::vector<T1>& to_exchange2, std::vector<T2>& to_exchange3);
@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <queue>
@@ -45,6 +46,17 @@ class ThreadSafeQueue : public AbstractThreadSafeQueue<T> {
         queue_.pop();
     }
 
+    // Return false if nothing is pushed in timeout_us
+    bool WaitAndPop(T & elem, uint64_t timeout_us) {
+        std::unique_lock<std::mutex> lk(mu_);
+        if (!cond_.wait_for(lk, std::chrono::microseconds(timeout_us), [this] { return !queue_.empty(); })) {
+            return false;
+        }
+        elem = std::move(queue_.front());
+        queue_.pop();
+        return true;
+    }
+
     int Size() override {
         std::lock_guard<std::mutex> lk(mu_);
         return queue_.size();
@@ -21,6 +21,7 @@
 #include <ext/hash_set>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
@@ -453,6 +454,14 @@ struct ValueTHash {
     }
 };
 
+// Hash on the whole content, for long-lived tables where values may share long prefixes (e.g. index)
+struct ValueTContentHash {
+    size_t operator() (const value_t& val) const {
+        size_t hash_tmp = std::hash<std::string_view>()(std::string_view(val.content.data(), val.content.size()));
+        return mymath::hash_u64(hash_tmp + val.type);
+    }
+};
+
 static uint8_t IntValueType = 1;
 static uint8_t DoubleValueType = 2;
 static uint8_t CharValueType = 3;
@@ -515,8 +524,9 @@ enum Index_T { E_LABEL, E_PROPERTY, V_LABEL, V_PROPERTY };
 // Spawn: spawn a new expert
 // Feed: "proxy" feed expert a input
 // Reply: expert returns the intermidiate result to expert
-enum class MSG_T : char { INIT, SPAWN, FEED, REPLY, BARRIER, BRANCH, EXIT, VALIDATION, COMMIT, ABORT, TERMINATE};
-static const char *MsgType[] = {"init", "spawn", "feed", "reply", "barrier", "branch", "exit", "validation", "commit", "abort", "terminate"};
+// Cancel: range expert has enough data, upstream experts can drop their input
+enum class MSG_T : char { INIT, SPAWN, FEED, REPLY, BARRIER, BRANCH, EXIT, VALIDATION, COMMIT, ABORT, TERMINATE, CANCEL};
+static const char *MsgType[] = {"init", "spawn", "feed", "reply", "barrier", "branch", "exit", "validation", "commit", "abort", "terminate", "cancel"};
 
 ibinstream& operator<<(ibinstream& m, const MSG_T& type);
 
@@ -698,4 +708,10 @@ enum AddEdgeMethodType { PlaceHolder, StepLabel, NotApplicable };
 
 // For GCTask
 enum class JobType { EraseV, EraseOutE, EraseInE, VMVCCGC, VPMVCCGC, EPMVCCGC, EMVCCGC, TopoIndexGC,
-    PropIndexGC, RCTGC, TrxStatusTableGC, TopoRowGC, TopoRowDefrag, VPRowGC, VPRowDefrag, EPRowGC, EPRowDefrag };
+    PropIndexGC, RCTGC, TrxStatusTableGC, TopoRowGC, TopoRowDefrag, VPRowGC, VPRowDefrag, EPRowGC, EPRowDefrag, COUNT };
+
+static const char *JobTypeName[] = {
+    "EraseV", "EraseOutE", "EraseInE", "VMVCCGC", "VPMVCCGC", "EPMVCCGC", "EMVCCGC", "TopoIndexGC",
+    "PropIndexGC", "RCTGC", "TrxStatusTableGC", "TopoRowGC", "TopoRowDefrag", "VPRowGC", "VPRowDefrag", "EPRowGC",
+    "EPRowDefrag"
+};
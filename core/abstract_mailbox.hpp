@@ -26,8 +26,13 @@ class AbstractMailbox {
     virtual void Init(vector<Node> & nodes) = 0;
     virtual int Send(int tid, const Message & msg) = 0;
     virtual bool TryRecv(int tid, Message & msg) = 0;
+    // Only receive msgs already in recv rings of tid, which returns credits to their senders.
+    //  Used when tid is congested, mailboxes without rings receive as usual.
+    virtual bool TryRecvRing(int tid, Message & msg) { return TryRecv(tid, msg); }
     virtual void Recv(int tid, Message & msg) = 0;
     virtual void Sweep(int tid) = 0;
+    // True if too many messages of tid are waiting for space in remote buffers
+    virtual bool IsCongested(int tid) { return false; }
     virtual void SendNotification(int dst_nid, ibinstream& in) = 0;
     virtual void RecvNotification(obinstream& out) = 0;
 };
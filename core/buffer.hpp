@@ -39,10 +39,11 @@ class Buffer {
     // Get index of (nid, tid) at reference node
     // GetxxxBuf: get local address, nid = remote_nid, ref_nid = local_nid
     // GetxxxBufOffset: get offset at remote machine, nid = local_nid, ref_nid = remote_nid
+    // tid: the index of recv ring, which is always 0 with SHARED_RECV_RING
     inline int GetIndex(int tid, int nid, int ref_nid) {
         // Get virtual nid at ref_nid
         nid = nid < ref_nid ? nid : nid - 1;
-        return nid * config_->global_num_threads + tid;
+        return nid * config_->num_recv_rings + tid;
     }
 
     inline char* GetBuf() {
@@ -88,7 +89,7 @@ class Buffer {
 
     inline char* GetRecvBuf(int tid, int nid) {
         assert(config_->global_use_rdma);
-        CHECK_LT(tid, config_->global_num_threads);
+        CHECK_LT(tid, config_->num_recv_rings);
         CHECK_LT(nid, config_->global_num_workers);
         return config_->recv_buf +
                GetIndex(tid, nid, node_.get_local_rank()) * MiB2B(config_->global_per_recv_buffer_sz_mb);
@@ -101,7 +102,7 @@ class Buffer {
 
     inline uint64_t GetRecvBufOffset(int tid, int nid) {
         assert(config_->global_use_rdma);
-        CHECK_LT(tid, config_->global_num_threads);
+        CHECK_LT(tid, config_->num_recv_rings);
         CHECK_LT(nid, config_->global_num_workers);
         return config_->recv_buffer_offset +
                GetIndex(tid, node_.get_local_rank(), nid) * MiB2B(config_->global_per_recv_buffer_sz_mb);
@@ -109,7 +110,7 @@ class Buffer {
 
     inline char* GetLocalHeadBuf(int tid, int nid) {
         assert(config_->global_use_rdma);
-        CHECK_LT(tid, config_->global_num_threads);
+        CHECK_LT(tid, config_->num_recv_rings);
         CHECK_LT(nid, config_->global_num_workers);
         return config_->local_head_buf + GetIndex(tid, nid, node_.get_local_rank()) * sizeof(uint64_t);
     }
@@ -121,14 +122,14 @@ class Buffer {
 
     inline uint64_t GetLocalHeadBufOffset(int tid, int nid) {
         assert(config_->global_use_rdma);
-        CHECK_LT(tid, config_->global_num_threads);
+        CHECK_LT(tid, config_->num_recv_rings);
         CHECK_LT(nid, config_->global_num_workers);
         return config_->local_head_buffer_offset + GetIndex(tid, node_.get_local_rank(), nid) * sizeof(uint64_t);
     }
 
     inline char* GetRemoteHeadBuf(int tid, int nid) {
         assert(config_->global_use_rdma);
-        CHECK_LT(tid, config_->global_num_threads);
+        CHECK_LT(tid, config_->num_recv_rings);
         CHECK_LT(nid, config_->global_num_workers);
         return config_->remote_head_buf + GetIndex(tid, nid, node_.get_local_rank()) * sizeof(uint64_t);
     }
@@ -140,7 +141,7 @@ class Buffer {
 
     inline uint64_t GetRemoteHeadBufOffset(int tid, int nid) {
         assert(config_->global_use_rdma);
-        CHECK_LT(tid, config_->global_num_threads);
+        CHECK_LT(tid, config_->num_recv_rings);
         CHECK_LT(nid, config_->global_num_workers);
         return config_->remote_head_buffer_offset + GetIndex(tid, node_.get_local_rank(), nid) * sizeof(uint64_t);
     }
@@ -19,6 +19,7 @@ ibinstream& operator<<(ibinstream& m, const QueryPlan& plan) {
     m << plan.query_index;
     m << plan.experts;
     m << plan.is_process;
+    m << plan.profile;
     m << plan.trx_type;
     m << plan.trxid;
     m << plan.st;
@@ -29,6 +30,7 @@ obinstream& operator>>(obinstream& m, QueryPlan& plan) {
     m >> plan.query_index;
     m >> plan.experts;
     m >> plan.is_process;
+    m >> plan.profile;
     m >> plan.trx_type;
     m >> plan.trxid;
     m >> plan.st;
@@ -55,6 +57,39 @@ void TrxPlan::RegDependency(uint8_t src_index, uint8_t dst_index) {
     }
 }
 
+void TrxPlan::RegBindParam(int bind_index, uint8_t value_type, int query_index, int expert_index, int param_index) {
+    bind_param_t& bind_param = bind_params_[bind_index];
+    bind_param.value_type = value_type;
+    bind_param.positions.emplace_back(query_index, expert_index, param_index);
+}
+
+bool TrxPlan::BindParams(const vector<string>& params, string& error_msg) {
+    if (params.size() != bind_params_.size()) {
+        error_msg = "expect " + to_string(bind_params_.size()) + " params but get " + to_string(params.size());
+        return false;
+    }
+
+    for (auto& kv : bind_params_) {
+        string param = params[kv.first];
+        Tool::trim(param, " ");
+
+        value_t v;
+        if (!Tool::str2value_t(param, v)) {
+            error_msg = "unexpected value: " + param;
+            return false;
+        }
+        if (kv.second.value_type != 0 && Tool::checktype(param) != kv.second.value_type) {
+            error_msg = "param type no match: " + param;
+            return false;
+        }
+
+        for (position_t& pos : kv.second.positions) {
+            query_plans_[pos.query].experts[pos.expert].params[pos.param] = v;
+        }
+    }
+    return true;
+}
+
 void TrxPlan::Abort() {
     if (is_abort_) {
         // Abort statement already sent
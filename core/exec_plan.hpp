@@ -32,6 +32,7 @@ class QueryPlan {
     uint8_t query_index;
     vector<Expert_Object> experts;
     bool is_process;  // True if query is in process phase
+    bool profile = false;  // True if query ends with .profile()
 
     // Transaction info
     uint64_t trxid;
@@ -73,6 +74,13 @@ class TrxPlan {
     // Return false if the transaction is aborted due to placeholder error
     bool FillResult(int query_index, vector<value_t>& vec);
 
+    // Register bind param of prepared transaction, value_type = 0 for any type
+    void RegBindParam(int bind_index, uint8_t value_type, int query_index, int expert_index, int param_index);
+
+    // Fill in bind params of prepared transaction
+    // Return false if params do not match bind markers
+    bool BindParams(const vector<string>& params, string& error_msg);
+
     void Abort();
 
     // Get result of queries after transaction finished
@@ -85,6 +93,10 @@ class TrxPlan {
 
     string client_host;
 
+    // Set for transactions from AsyncClient, see base/async_protocol.hpp
+    string reply_endpoint;
+    uint64_t req_id = 0;
+
     // physical time
     uint64_t start_time;
 
@@ -121,6 +133,13 @@ class TrxPlan {
     map<uint8_t, set<uint8_t>> topo_;
     map<uint8_t, vector<position_t>> place_holder_;
 
+    // Bind params of prepared transaction
+    struct bind_param_t {
+        uint8_t value_type;
+        vector<position_t> positions;
+    };
+    map<int, bind_param_t> bind_params_;
+
     // Query index to query result
     map<int, vector<value_t>> results_;
 
@@ -18,6 +18,7 @@
 #include <omp.h>
 #include <tbb/concurrent_hash_map.h>
 #include <map>
+#include <set>
 #include <vector>
 #include <atomic>
 #include <thread>
@@ -57,6 +58,9 @@
 #include "base/core_affinity.hpp"
 #include "core/abstract_mailbox.hpp"
 #include "core/factory.hpp"
+#include "core/profiler.hpp"
+#include "core/profiling_mailbox.hpp"
+#include "core/query_plan_store.hpp"
 #include "core/result_collector.hpp"
 #include "layout/data_storage.hpp"
 #include "layout/index_store.hpp"
@@ -78,51 +82,54 @@ class ExpertAdapter {
         node_(node),
         rc_(rc),
         mailbox_(mailbox),
+        expert_mailbox_(mailbox),
         core_affinity_(core_affinity) {
         config_ = Config::GetInstance();
         num_thread_ = config_->global_num_threads;
         times_.resize(num_thread_, 0);
         data_storage_ = DataStorage::GetInstance();
+        Profiler::GetInstance()->Init(node_.get_local_rank());
     }
 
     void Init() {
+        // experts send msgs via expert_mailbox_ so that msgs of profiled queries are recorded
         int id = 0;
-        experts_[EXPERT_T::AGGREGATE] = unique_ptr<AbstractExpert>(new AggregateExpert(id ++, node_.get_local_size(), num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::ADDV] = unique_ptr<AbstractExpert>(new AddVertexExpert(id ++, num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::ADDE] = unique_ptr<AbstractExpert>(new AddEdgeExpert(id ++, num_thread_, node_.get_local_rank(), mailbox_, core_affinity_));
-        experts_[EXPERT_T::AS] = unique_ptr<AbstractExpert>(new AsExpert(id ++, num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::BRANCH] = unique_ptr<AbstractExpert>(new BranchExpert(id ++, num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::BRANCHFILTER] = unique_ptr<AbstractExpert>(new BranchFilterExpert(id ++, num_thread_, mailbox_, core_affinity_, &id_allocator_));
-        experts_[EXPERT_T::CAP] = unique_ptr<AbstractExpert>(new CapExpert(id ++, num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::CONFIG] = unique_ptr<AbstractExpert>(new ConfigExpert(id ++, num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::COUNT] = unique_ptr<AbstractExpert>(new CountExpert(id ++, num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::DROP] = unique_ptr<AbstractExpert>(new DropExpert(id ++, num_thread_, node_.get_local_rank(), mailbox_, core_affinity_));
-        experts_[EXPERT_T::DEDUP] = unique_ptr<AbstractExpert>(new DedupExpert(id ++, num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::END] = unique_ptr<AbstractExpert>(new EndExpert(id ++, node_.get_local_size(), rc_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::GROUP] = unique_ptr<AbstractExpert>(new GroupExpert(id ++, num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::HAS] = unique_ptr<AbstractExpert>(new HasExpert(id ++, node_.get_local_rank(), num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::HASLABEL] = unique_ptr<AbstractExpert>(new HasLabelExpert(id ++, node_.get_local_rank(), num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::INIT] = unique_ptr<AbstractExpert>(new InitExpert(id ++, num_thread_, mailbox_, core_affinity_, node_.get_local_size()));
-        experts_[EXPERT_T::INDEX] = unique_ptr<AbstractExpert>(new IndexExpert(id ++, num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::IS] = unique_ptr<AbstractExpert>(new IsExpert(id ++, num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::KEY] = unique_ptr<AbstractExpert>(new KeyExpert(id ++, num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::LABEL] = unique_ptr<AbstractExpert>(new LabelExpert(id ++, node_.get_local_rank(), num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::MATH] = unique_ptr<AbstractExpert>(new MathExpert(id ++, num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::ORDER] = unique_ptr<AbstractExpert>(new OrderExpert(id ++, num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::POSTVALIDATION] = unique_ptr<AbstractExpert>(new PostValidationExpert(id ++, node_.get_local_size(), mailbox_, core_affinity_));
-        experts_[EXPERT_T::PROJECT] = unique_ptr<AbstractExpert>(new ProjectExpert(id ++, node_.get_local_rank(), num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::PROPERTIES] = unique_ptr<AbstractExpert>(new PropertiesExpert(id ++, node_.get_local_rank(), num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::PROPERTY] = unique_ptr<AbstractExpert>(new PropertyExpert(id ++, num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::RANGE] = unique_ptr<AbstractExpert>(new RangeExpert(id ++, num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::COIN] = unique_ptr<AbstractExpert>(new CoinExpert(id ++, num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::REPEAT] = unique_ptr<AbstractExpert>(new RepeatExpert(id ++, num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::SELECT] = unique_ptr<AbstractExpert>(new SelectExpert(id ++, num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::STATUS] = unique_ptr<AbstractExpert>(new StatusExpert(id ++, num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::TERMINATE] = unique_ptr<AbstractExpert>(new TerminateExpert(id ++, mailbox_, core_affinity_, &experts_, &msg_logic_table_));
-        experts_[EXPERT_T::TRAVERSAL] = unique_ptr<AbstractExpert>(new TraversalExpert(id ++, num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::VALIDATION] = unique_ptr<AbstractExpert>(new ValidationExpert(id ++, node_.get_local_rank(), num_thread_, mailbox_, core_affinity_, &experts_, &msg_logic_table_));
-        experts_[EXPERT_T::VALUES] = unique_ptr<AbstractExpert>(new ValuesExpert(id ++, node_.get_local_rank(), num_thread_, mailbox_, core_affinity_));
-        experts_[EXPERT_T::WHERE] = unique_ptr<AbstractExpert>(new WhereExpert(id ++, num_thread_, mailbox_, core_affinity_));
+        experts_[EXPERT_T::AGGREGATE] = unique_ptr<AbstractExpert>(new AggregateExpert(id ++, node_.get_local_size(), num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::ADDV] = unique_ptr<AbstractExpert>(new AddVertexExpert(id ++, num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::ADDE] = unique_ptr<AbstractExpert>(new AddEdgeExpert(id ++, num_thread_, node_.get_local_rank(), &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::AS] = unique_ptr<AbstractExpert>(new AsExpert(id ++, num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::BRANCH] = unique_ptr<AbstractExpert>(new BranchExpert(id ++, num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::BRANCHFILTER] = unique_ptr<AbstractExpert>(new BranchFilterExpert(id ++, num_thread_, &expert_mailbox_, core_affinity_, &id_allocator_));
+        experts_[EXPERT_T::CAP] = unique_ptr<AbstractExpert>(new CapExpert(id ++, num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::CONFIG] = unique_ptr<AbstractExpert>(new ConfigExpert(id ++, num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::COUNT] = unique_ptr<AbstractExpert>(new CountExpert(id ++, num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::DROP] = unique_ptr<AbstractExpert>(new DropExpert(id ++, num_thread_, node_.get_local_rank(), &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::DEDUP] = unique_ptr<AbstractExpert>(new DedupExpert(id ++, num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::END] = unique_ptr<AbstractExpert>(new EndExpert(id ++, node_.get_local_size(), rc_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::GROUP] = unique_ptr<AbstractExpert>(new GroupExpert(id ++, num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::HAS] = unique_ptr<AbstractExpert>(new HasExpert(id ++, node_.get_local_rank(), num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::HASLABEL] = unique_ptr<AbstractExpert>(new HasLabelExpert(id ++, node_.get_local_rank(), num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::INIT] = unique_ptr<AbstractExpert>(new InitExpert(id ++, num_thread_, &expert_mailbox_, core_affinity_, node_.get_local_size()));
+        experts_[EXPERT_T::INDEX] = unique_ptr<AbstractExpert>(new IndexExpert(id ++, num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::IS] = unique_ptr<AbstractExpert>(new IsExpert(id ++, num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::KEY] = unique_ptr<AbstractExpert>(new KeyExpert(id ++, num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::LABEL] = unique_ptr<AbstractExpert>(new LabelExpert(id ++, node_.get_local_rank(), num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::MATH] = unique_ptr<AbstractExpert>(new MathExpert(id ++, num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::ORDER] = unique_ptr<AbstractExpert>(new OrderExpert(id ++, num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::POSTVALIDATION] = unique_ptr<AbstractExpert>(new PostValidationExpert(id ++, node_.get_local_size(), &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::PROJECT] = unique_ptr<AbstractExpert>(new ProjectExpert(id ++, node_.get_local_rank(), num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::PROPERTIES] = unique_ptr<AbstractExpert>(new PropertiesExpert(id ++, node_.get_local_rank(), num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::PROPERTY] = unique_ptr<AbstractExpert>(new PropertyExpert(id ++, num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::RANGE] = unique_ptr<AbstractExpert>(new RangeExpert(id ++, node_.get_local_size(), num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::COIN] = unique_ptr<AbstractExpert>(new CoinExpert(id ++, num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::REPEAT] = unique_ptr<AbstractExpert>(new RepeatExpert(id ++, num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::SELECT] = unique_ptr<AbstractExpert>(new SelectExpert(id ++, num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::STATUS] = unique_ptr<AbstractExpert>(new StatusExpert(id ++, num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::TERMINATE] = unique_ptr<AbstractExpert>(new TerminateExpert(id ++, &expert_mailbox_, core_affinity_, &experts_, &msg_logic_table_));
+        experts_[EXPERT_T::TRAVERSAL] = unique_ptr<AbstractExpert>(new TraversalExpert(id ++, num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::VALIDATION] = unique_ptr<AbstractExpert>(new ValidationExpert(id ++, node_.get_local_rank(), num_thread_, &expert_mailbox_, core_affinity_, &experts_, &msg_logic_table_));
+        experts_[EXPERT_T::VALUES] = unique_ptr<AbstractExpert>(new ValuesExpert(id ++, node_.get_local_rank(), num_thread_, &expert_mailbox_, core_affinity_));
+        experts_[EXPERT_T::WHERE] = unique_ptr<AbstractExpert>(new WhereExpert(id ++, num_thread_, &expert_mailbox_, core_affinity_));
     }
 
     void Start() {
@@ -140,8 +147,65 @@ class ExpertAdapter {
         thread.join();
     }
 
+    // INIT msg may only carry plan id, fill in the experts from QueryPlanStore
+    // Return false if msg is sent to another node for the plan
+    bool ResolveQueryPlan(int tid, Message & msg) {
+        Meta & m = msg.meta;
+        QueryPlanStore * plan_store = QueryPlanStore::GetInstance();
+        if (m.has_plan) {
+            if (plan_store->IsEnabled()) {
+                plan_store->Insert(m.plan_id, m.qplan.experts);
+                FillPlanParams(m);
+            }
+            return true;
+        }
+
+        if (plan_store->Get(m.plan_id, m.qplan.experts)) {
+            m.has_plan = true;
+            if (m.plan_requester != -1) {
+                // answer plan request, send msg back with plan
+                m.recver_nid = m.plan_requester;
+                m.plan_requester = -1;
+                mailbox_->Send(tid, msg);
+                return false;
+            }
+            FillPlanParams(m);
+            return true;
+        }
+
+        if (m.plan_requester != -1) {
+            // plans are pinned on parent node until the trx finishes, thus msg is left of finished trx
+            LOG(WARNING) << "[ExpertAdapter] Plan of qid " << m.qid << " not found on parent node, drop the plan request";
+            return false;
+        }
+
+        // cache miss, fetch plan from parent node lazily
+        m.plan_requester = node_.get_local_rank();
+        m.recver_nid = m.parent_nid;
+        mailbox_->Send(tid, msg);
+        return false;
+    }
+
+    // Fill params carried by INIT msg into the plan skeleton
+    void FillPlanParams(Meta & m) {
+        CHECK_EQ(m.plan_params.size(), m.qplan.experts.size());
+        for (int i = 0; i < m.plan_params.size(); i++) {
+            m.qplan.experts[i].params = move(m.plan_params[i]);
+        }
+        m.plan_params.clear();
+    }
+
     void execute(int tid, Message & msg) {
         Meta & m = msg.meta;
+        Profiler * profiler = Profiler::GetInstance();
+        profiler->Absorb(msg);
+
+        if (m.msg_type == MSG_T::INIT && !ResolveQueryPlan(tid, msg)) {
+            return;
+        } else if (m.msg_type == MSG_T::CANCEL) {
+            InsertCancelledStep(m.qid, m.step);
+            return;
+        }
 
         bool acquire_writer_lock = false, check_trx_status = false;
         if (m.msg_type == MSG_T::INIT && m.qplan.experts[0].expert_type == EXPERT_T::TERMINATE) {
@@ -232,13 +296,66 @@ class ExpertAdapter {
         do {
             current_step = msg.meta.step;
             EXPERT_T next_expert = ac->second.experts[current_step].expert_type;
-            experts_[next_expert]->process(ac->second, msg);
+            if (IsDownstreamCancelled(ac->second, msg.meta)) {
+                // keep msg flowing with empty data so that barrier can still collect all msgs
+                msg.data.clear();
+            }
+            if (ac->second.profile) {
+                profiler->BeginExpert(msg);
+                experts_[next_expert]->process(ac->second, msg);
+                profiler->EndExpert(msg);
+            } else {
+                experts_[next_expert]->process(ac->second, msg);
+            }
         } while (current_step != msg.meta.step);  // process next expert directly if step is modified
 
         // Commit expert cannot erase its own qid in process
         if (ac->second.experts[current_step].expert_type == EXPERT_T::TERMINATE) {
             msg_logic_table_.erase(ac);
+            cancel_table_.erase(trx_id);
+            // drop profile records left on this node
+            for (int i = 0; i < m.query_count_in_trx; i++) {
+                profiler->Erase(trx_id + i);
+            }
+        }
+    }
+
+    // Record that range expert at given step has enough data
+    void InsertCancelledStep(uint64_t qid, int step) {
+        // Hold ac until inserted, so that TerminateExpert erasing qid waits, and cancel_table_ is cleared after that
+        const_accessor ac;
+        if (!msg_logic_table_.find(ac, qid)) {
+            // query already finished on this node
+            return;
+        }
+        CancelAccessor cac;
+        cancel_table_.insert(cac, qid & _56HFLAG);
+        cac->second.emplace(qid, step);
+    }
+
+    // Check if the first barrier after current step is a cancelled range expert
+    bool IsDownstreamCancelled(const QueryPlan& qplan, const Meta& m) {
+        if (m.branch_infos.size() != 0) {
+            return false;
+        }
+
+        const vector<Expert_Object>& experts = qplan.experts;
+        int step = m.step;
+        if (experts[step].IsBarrier()) {
+            return false;
+        }
+        while (step < experts.size() && !experts[step].IsBarrier()) {
+            step = experts[step].next_expert;
         }
+        if (step >= experts.size() || experts[step].expert_type != EXPERT_T::RANGE) {
+            return false;
+        }
+
+        CancelConstAccessor cac;
+        if (!cancel_table_.find(cac, m.qid & _56HFLAG)) {
+            return false;
+        }
+        return cac->second.count(make_pair(m.qid, step)) != 0;
     }
 
     //tid --> [0, config->global_num_threads)
@@ -256,14 +373,17 @@ class ExpertAdapter {
         while (true) {
             mailbox_->Sweep(tid);
 
+            // Backpressure: when too many msgs wait for full remote buffers, take no new input from the local queue
+            // or other threads, but keep draining own recv rings to return credits, so that senders never wait on each other
+            bool congested = mailbox_->IsCongested(tid);
             Message recv_msg;
-            bool success = mailbox_->TryRecv(tid, recv_msg);
+            bool success = congested ? mailbox_->TryRecvRing(tid, recv_msg) : mailbox_->TryRecv(tid, recv_msg);
             times_[tid] = timer::get_usec();
             if (success) {
                 execute(tid, recv_msg);
                 times_[tid] = timer::get_usec();
             } else {
-                if (!config_->global_enable_workstealing)
+                if (!config_->global_enable_workstealing || congested)
                     continue;
 
                 if (steal_list.size() == 0) {  // num_thread_ < 6
@@ -290,6 +410,7 @@ class ExpertAdapter {
 
  private:
     AbstractMailbox * mailbox_;
+    ProfilingMailbox expert_mailbox_;
     ResultCollector * rc_;
     DataStorage * data_storage_;
     Config * config_;
@@ -310,6 +431,11 @@ class ExpertAdapter {
 
     tbb::concurrent_hash_map<uint64_t, uint64_t> exit_msg_count_table_;
 
+    // trxid -> set of <qid, step> of range experts which have enough data
+    tbb::concurrent_hash_map<uint64_t, set<pair<uint64_t, int>>> cancel_table_;
+    typedef tbb::concurrent_hash_map<uint64_t, set<pair<uint64_t, int>>>::accessor CancelAccessor;
+    typedef tbb::concurrent_hash_map<uint64_t, set<pair<uint64_t, int>>>::const_accessor CancelConstAccessor;
+
     // Thread pool
     vector<thread> thread_pool_;
 
@@ -320,9 +446,6 @@ class ExpertAdapter {
     // locks
     WritePriorRWLock* locks_;
 
-    // 5 more timers for total, recv , send, serialization, create msg
-    static const int timer_offset = 5;
-
     static const uint64_t STEALTIMEOUT = 1000;
 };
 
@@ -12,7 +12,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "core/message.hpp"
 
@@ -47,8 +51,39 @@ ibinstream& operator<<(ibinstream& m, const Meta& meta) {
     m << meta.parent_tid;
     m << meta.msg_path;
     m << meta.branch_infos;
+    m << meta.is_combined;
+    bool has_profile = !meta.profile_records.empty();
+    m << has_profile;
+    if (has_profile) {
+        m << meta.profile_records;
+    }
     if (meta.msg_type == MSG_T::INIT) {
-        m << meta.qplan;
+        m << meta.plan_id;
+        m << meta.has_plan;
+        m << meta.plan_requester;
+        if (meta.has_plan && !meta.plan_bytes.empty()) {
+            // same as m << meta.qplan, without serializing experts again
+            m << meta.qplan.query_index;
+            m.raw_bytes(meta.plan_bytes.data(), meta.plan_bytes.size());
+            m << meta.qplan.is_process;
+            m << meta.qplan.profile;
+            m << meta.qplan.trx_type;
+            m << meta.qplan.trxid;
+            m << meta.qplan.st;
+        } else if (meta.has_plan) {
+            m << meta.qplan;
+        } else {
+            // transaction info only
+            m << meta.qplan.query_index;
+            m << meta.qplan.is_process;
+            m << meta.qplan.profile;
+            m << meta.qplan.trx_type;
+            m << meta.qplan.trxid;
+            m << meta.qplan.st;
+        }
+        if (meta.plan_id != 0) {
+            m << meta.plan_params;
+        }
     }
     return m;
 }
@@ -64,8 +99,29 @@ obinstream& operator>>(obinstream& m, Meta& meta) {
     m >> meta.parent_tid;
     m >> meta.msg_path;
     m >> meta.branch_infos;
+    m >> meta.is_combined;
+    bool has_profile;
+    m >> has_profile;
+    if (has_profile) {
+        m >> meta.profile_records;
+    }
     if (meta.msg_type == MSG_T::INIT) {
-        m >> meta.qplan;
+        m >> meta.plan_id;
+        m >> meta.has_plan;
+        m >> meta.plan_requester;
+        if (meta.has_plan) {
+            m >> meta.qplan;
+        } else {
+            m >> meta.qplan.query_index;
+            m >> meta.qplan.is_process;
+            m >> meta.qplan.profile;
+            m >> meta.qplan.trx_type;
+            m >> meta.qplan.trxid;
+            m >> meta.qplan.st;
+        }
+        if (meta.plan_id != 0) {
+            m >> meta.plan_params;
+        }
     }
     return m;
 }
@@ -82,6 +138,7 @@ std::string Meta::DebugString() const {
     ss << ", parent node: " << parent_nid;
     ss << ", paraent thread: " << parent_tid;
     if (msg_type == MSG_T::INIT) {
+        ss << ", plan id: " << plan_id;
         ss << ", experts [";
         for (auto &expert : qplan.experts) {
             ss  << ExpertType[static_cast<int>(expert.expert_type)];
@@ -323,6 +380,9 @@ void Message::CreateInitMsg(uint64_t qid, uint8_t query_count_in_trx, int parent
     m.parent_tid = recv_tid;
     m.msg_type = MSG_T::INIT;
     m.msg_path = to_string(nodes_num);
+    m.plan_id = 0;
+    m.has_plan = true;
+    m.plan_requester = -1;
 
     // Check first expert type
     bool isAddV = qplan.experts[0].expert_type == EXPERT_T::ADDV;
@@ -344,11 +404,33 @@ void Message::CreateInitMsg(uint64_t qid, uint8_t query_count_in_trx, int parent
     qplans.push_back(move(qplan));
     AssignParamsByLocality(qplans);
 
+    QueryPlanStore* plan_store = QueryPlanStore::GetInstance();
     for (int i = 0; i < nodes_num; i++) {
         Message msg;
         msg.meta = m;
         msg.meta.recver_nid = i;
         msg.meta.qplan = move(qplans[i]);
+        if (plan_store->IsEnabled()) {
+            // Plan id is keyed on the plan skeleton, so that queries differing only in params share it,
+            //  params are carried by each INIT msg
+            vector<Expert_Object>& experts = msg.meta.qplan.experts;
+            msg.meta.plan_params.resize(experts.size());
+            for (int j = 0; j < experts.size(); j++) {
+                msg.meta.plan_params[j].swap(experts[j].params);
+            }
+            ibinstream plan_stream;
+            plan_stream << msg.meta.qplan.experts;
+            string plan_bytes(plan_stream.get_buf(), plan_stream.size());
+            // parent node keeps the plan to answer plan requests until the trx terminates
+            msg.meta.plan_id = plan_store->Register(parent_node, qid & _56HFLAG, plan_bytes, msg.meta.qplan.experts);
+            // only ship plan id if the plan has been shipped to the remote node before
+            if (i != parent_node && !plan_store->MarkShipped(msg.meta.plan_id, i)) {
+                msg.meta.has_plan = false;
+                msg.meta.qplan.experts.clear();
+            } else if (i != parent_node) {
+                msg.meta.plan_bytes = move(plan_bytes);
+            }
+        }
         if (isAddV && i == parent_node) {
             // only parent node will add one vertex
             msg.data.emplace_back(history_t(), vector<value_t>(1));
@@ -554,6 +636,21 @@ void Message::CreateFeedMsg(int key, int nodes_num, vector<value_t>& data, vecto
     }
 }
 
+void Message::CreateCancelMsg(int step, int nodes_num, vector<Message>& vec) {
+    Meta m;
+    m.qid = this->meta.qid;
+    m.recver_tid = this->meta.parent_tid;
+    m.step = step;
+    m.query_count_in_trx = this->meta.query_count_in_trx;
+    m.msg_type = MSG_T::CANCEL;
+
+    for (int i = 0; i < nodes_num; i++) {
+        Message msg(m);
+        msg.meta.recver_nid = i;
+        vec.push_back(move(msg));
+    }
+}
+
 void Message::DispatchData(Meta& m, const vector<Expert_Object>& experts, vector<pair<history_t, vector<value_t>>>& data,
                         int num_thread, CoreAffinity * core_affinity, vector<Message>& vec) {
     Meta cm = m;
@@ -564,9 +661,11 @@ void Message::DispatchData(Meta& m, const vector<Expert_Object>& experts, vector
     // store history with empty data
     vector<pair<history_t, vector<value_t>>> empty_his;
 
-    bool is_count = false;
-    if (experts[m.step].expert_type == EXPERT_T::COUNT && experts[m.step-1].expert_type != EXPERT_T::INIT) {
-        is_count = true;
+    // pre-aggregate data for barrier expert
+    m.is_combined = false;
+    cm.is_combined = false;
+    if (m.msg_type == MSG_T::BARRIER) {
+        m.is_combined = CombineData(m, experts, data);
     }
     bool consider_both_edge = false;
     if (experts[m.step].expert_type == EXPERT_T::DROP) {
@@ -623,13 +722,7 @@ void Message::DispatchData(Meta& m, const vector<Expert_Object>& experts, vector
                     empty_his.push_back(move(p));
                 continue;
             }
-            if (is_count) {
-                value_t v;
-                Tool::str2int(to_string(p.second.size()), v);
-                id2data[m.recver_nid].emplace_back(move(p.first), vector<value_t>{move(v)});
-            } else {
-                id2data[m.recver_nid].push_back(move(p));
-            }
+            id2data[m.recver_nid].push_back(move(p));
         }
 
         // no data is added to next expert
@@ -665,6 +758,329 @@ void Message::DispatchData(Meta& m, const vector<Expert_Object>& experts, vector
     }
 }
 
+bool Message::CombineData(const Meta& m, const vector<Expert_Object>& experts,
+                        vector<pair<history_t, vector<value_t>>>& data) {
+    const Expert_Object& expert = experts[m.step];
+    int branch_depth = m.branch_infos.size();
+    int branch_key = branch_depth == 0 ? -1 : m.branch_infos[branch_depth - 1].key;
+
+    switch (expert.expert_type) {
+      case EXPERT_T::COUNT:
+        // init expert counts data by itself
+        if (experts[m.step - 1].expert_type != EXPERT_T::INIT) {
+            MergeByBranch(data, branch_key);
+            for (auto& p : data) {
+                if (p.second.size() != 0) {
+                    value_t v;
+                    Tool::str2int(to_string(p.second.size()), v);
+                    p.second.clear();
+                    p.second.push_back(move(v));
+                }
+            }
+        }
+        return false;
+      case EXPERT_T::DEDUP:
+        CombineDedup(expert, data, branch_key);
+        return false;
+      case EXPERT_T::GROUP:
+        return CombineGroup(expert, data, branch_key);
+      case EXPERT_T::MATH:
+        return CombineMath(expert, data, branch_key);
+      case EXPERT_T::ORDER:
+        CombineOrder(experts, m.step, data, branch_key);
+        return false;
+      default:
+        return false;
+    }
+}
+
+int Message::GetBranchValue(history_t& his, int branch_key, bool erase_his) {
+    // same as BarrierExpertBase::get_branch_value
+    int branch_value = -1;
+    if (branch_key >= 0) {
+        auto itr = find_if(his.begin(), his.end(),
+            [&branch_key](const pair<int, value_t>& element) { return element.first == branch_key; });
+        if (itr != his.end()) {
+            branch_value = Tool::value_t2int(itr->second);
+            if (erase_his) {
+                his.erase(itr + 1, his.end());
+            }
+        }
+    }
+    return branch_value;
+}
+
+void Message::MergeByBranch(vector<pair<history_t, vector<value_t>>>& data, int branch_key) {
+    vector<pair<history_t, vector<value_t>>> merged;
+    // branch value -> index in merged
+    unordered_map<int, int> branch_index;
+
+    for (auto& p : data) {
+        if (p.second.size() == 0) {
+            merged.push_back(move(p));
+            continue;
+        }
+
+        int branch_value = GetBranchValue(p.first, branch_key, true);
+        auto itr = branch_index.find(branch_value);
+        if (itr == branch_index.end()) {
+            branch_index[branch_value] = merged.size();
+            merged.push_back(move(p));
+        } else {
+            vector<value_t>& vec = merged[itr->second].second;
+            vec.insert(vec.end(), make_move_iterator(p.second.begin()), make_move_iterator(p.second.end()));
+        }
+    }
+    data = move(merged);
+}
+
+void Message::CombineDedup(const Expert_Object& expert, vector<pair<history_t, vector<value_t>>>& data, int branch_key) {
+    set<int> key_set;
+    for (auto& param : expert.params) {
+        key_set.insert(Tool::value_t2int(param));
+    }
+
+    unordered_map<int, unordered_set<history_t, HistoryTHash>> dedup_his_map;
+    unordered_map<int, unordered_set<value_t, ValueTHash>> dedup_val_map;
+    vector<pair<history_t, vector<value_t>>> filtered;
+    for (auto& p : data) {
+        if (p.second.size() == 0) {
+            filtered.push_back(move(p));
+            continue;
+        }
+
+        int branch_value = GetBranchValue(p.first, branch_key, false);
+        if (key_set.size() > 0) {
+            // dedup by history with given keys
+            history_t his;
+            for (auto& val : p.first) {
+                if (key_set.find(val.first) != key_set.end()) {
+                    his.push_back(val);
+                }
+            }
+            // only first value is kept by dedup expert
+            if (dedup_his_map[branch_value].insert(move(his)).second) {
+                p.second.resize(1);
+                filtered.push_back(move(p));
+            }
+        } else {
+            // dedup by value
+            auto& dedup_set = dedup_val_map[branch_value];
+            vector<value_t> vec;
+            for (auto& val : p.second) {
+                if (dedup_set.insert(val).second) {
+                    vec.push_back(move(val));
+                }
+            }
+            if (vec.size() != 0) {
+                filtered.emplace_back(move(p.first), move(vec));
+            }
+        }
+    }
+    data = move(filtered);
+}
+
+bool Message::CombineGroup(const Expert_Object& expert, vector<pair<history_t, vector<value_t>>>& data, int branch_key) {
+    bool isCount = Tool::value_t2int(expert.params[0]);
+    if (!isCount) {
+        // all values are needed by group
+        return false;
+    }
+    int label_step = Tool::value_t2int(expert.params[1]);
+
+    vector<pair<history_t, vector<value_t>>> merged;
+    // branch value -> index in merged
+    unordered_map<int, int> branch_index;
+    // counter of each key, aligned with merged
+    vector<map<string, int>> counters;
+
+    for (auto& p : data) {
+        if (p.second.size() == 0) {
+            merged.push_back(move(p));
+            counters.emplace_back();
+            continue;
+        }
+
+        // get projected key before history is truncated
+        string key;
+        if (label_step >= 0) {
+            for (auto& his : p.first) {
+                if (his.first == label_step) {
+                    key = his.second.DebugString();
+                    break;
+                }
+            }
+        }
+
+        int branch_value = GetBranchValue(p.first, branch_key, true);
+        auto itr = branch_index.find(branch_value);
+        if (itr == branch_index.end()) {
+            itr = branch_index.emplace(branch_value, merged.size()).first;
+            merged.emplace_back(move(p.first), vector<value_t>());
+            counters.emplace_back();
+        }
+
+        map<string, int>& counter = counters[itr->second];
+        for (auto& val : p.second) {
+            if (label_step == -1) {
+                key = val.DebugString();
+            }
+            counter[key]++;
+        }
+    }
+
+    // partial result: key1, count1, key2, count2 ...
+    for (int i = 0; i < merged.size(); i++) {
+        for (auto& kv : counters[i]) {
+            value_t k, c;
+            Tool::str2str(kv.first, k);
+            Tool::str2int(to_string(kv.second), c);
+            merged[i].second.push_back(move(k));
+            merged[i].second.push_back(move(c));
+        }
+    }
+    data = move(merged);
+    return true;
+}
+
+bool Message::CombineMath(const Expert_Object& expert, vector<pair<history_t, vector<value_t>>>& data, int branch_key) {
+    Math_T math_type = (Math_T)Tool::value_t2int(expert.params[0]);
+    MergeByBranch(data, branch_key);
+
+    for (auto& p : data) {
+        if (p.second.size() == 0) {
+            continue;
+        }
+        int count = p.second.size();
+        value_t result = move(p.second[0]);
+        for (int i = 1; i < count; i++) {
+            value_t& v = p.second[i];
+            switch (math_type) {
+              case Math_T::SUM:
+              case Math_T::MEAN:
+              {
+                // same as MathExpert::sum
+                value_t temp = move(result);
+                result = value_t();
+                switch (v.type) {
+                  case 1:
+                    Tool::str2int(to_string(Tool::value_t2int(temp) + Tool::value_t2int(v)), result);
+                    break;
+                  case 2:
+                    Tool::str2double(to_string(Tool::value_t2double(temp) + Tool::value_t2double(v)), result);
+                    break;
+                }
+                break;
+              }
+              case Math_T::MAX:
+                if (result < v) { result = move(v); }
+                break;
+              case Math_T::MIN:
+                if (result > v) { result = move(v); }
+                break;
+            }
+        }
+
+        // partial result: value, count
+        value_t c;
+        Tool::str2int(to_string(count), c);
+        p.second.clear();
+        p.second.push_back(move(result));
+        p.second.push_back(move(c));
+    }
+    return true;
+}
+
+void Message::CombineOrder(const vector<Expert_Object>& experts, int step,
+                        vector<pair<history_t, vector<value_t>>>& data, int branch_key) {
+    // only when order is followed by range with bounded end
+    int next = experts[step].next_expert;
+    if (next >= experts.size() || experts[next].expert_type != EXPERT_T::RANGE) {
+        return;
+    }
+    int end = Tool::value_t2int(experts[next].params[1]);
+    if (end == -1) {
+        return;
+    }
+    int limit = end + 1;
+
+    int label_step = Tool::value_t2int(experts[step].params[0]);
+    Order_T order = (Order_T)Tool::value_t2int(experts[step].params[1]);
+
+    // key of each pair for ordering, empty string if not found
+    // keys are not compared for order without mapping
+    value_t empty_key;
+    Tool::str2str("", empty_key);
+    vector<value_t> keys(data.size(), empty_key);
+    // branch value -> <pair index, value index> of data
+    unordered_map<int, vector<pair<int, int>>> branch_elems;
+    for (int i = 0; i < data.size(); i++) {
+        if (label_step >= 0) {
+            for (auto& his : data[i].first) {
+                if (his.first == label_step) {
+                    keys[i] = his.second;
+                    break;
+                }
+            }
+        }
+        int branch_value = GetBranchValue(data[i].first, branch_key, false);
+        auto& elems = branch_elems[branch_value];
+        for (int j = 0; j < data[i].second.size(); j++) {
+            elems.emplace_back(i, j);
+        }
+    }
+
+    // same order as OrderExpert: by key first, then by data
+    bool use_key = label_step >= 0;
+    auto cmp = [&](const pair<int, int>& a, const pair<int, int>& b) {
+        const value_t& ka = keys[a.first];
+        const value_t& kb = keys[b.first];
+        const value_t& va = data[a.first].second[a.second];
+        const value_t& vb = data[b.first].second[b.second];
+        if (!use_key) {
+            return order == Order_T::INCR ? va < vb : vb < va;
+        }
+        bool less = ka < kb || (!(kb < ka) && va < vb);
+        bool greater = kb < ka || (!(ka < kb) && vb < va);
+        return order == Order_T::INCR ? less : greater;
+    };
+
+    // keep top k data of each branch
+    vector<vector<bool>> keep(data.size());
+    for (int i = 0; i < data.size(); i++) {
+        keep[i].resize(data[i].second.size(), true);
+    }
+    for (auto& item : branch_elems) {
+        auto& elems = item.second;
+        if (elems.size() <= limit) {
+            continue;
+        }
+        nth_element(elems.begin(), elems.begin() + limit, elems.end(), cmp);
+        for (auto itr = elems.begin() + limit; itr != elems.end(); itr++) {
+            keep[itr->first][itr->second] = false;
+        }
+    }
+
+    vector<pair<history_t, vector<value_t>>> filtered;
+    for (int i = 0; i < data.size(); i++) {
+        if (data[i].second.size() == 0) {
+            filtered.push_back(move(data[i]));
+            continue;
+        }
+        vector<value_t> vec;
+        for (int j = 0; j < data[i].second.size(); j++) {
+            if (keep[i][j]) {
+                vec.push_back(move(data[i].second[j]));
+            }
+        }
+        // remove pairs with all data filtered
+        if (vec.size() != 0) {
+            filtered.emplace_back(move(data[i].first), move(vec));
+        }
+    }
+    data = move(filtered);
+}
+
 bool Message::UpdateRoute(Meta& m, const vector<Expert_Object>& experts) {
     int branch_depth = m.branch_infos.size() - 1;
     // update recver route & msg_type
@@ -28,6 +28,8 @@
 #include "base/predicate.hpp"
 #include "core/exec_plan.hpp"
 #include "core/id_mapper.hpp"
+#include "core/profiler.hpp"
+#include "core/query_plan_store.hpp"
 #include "expert/expert_object.hpp"
 
 #define TEN_MB 1048576
@@ -76,6 +78,25 @@ struct Meta {
     // Query Plan
     QueryPlan qplan;
 
+    // For INIT msg only
+    // Id of qplan experts in QueryPlanStore
+    uint64_t plan_id;
+    // False if only plan_id is carried, experts are fetched from QueryPlanStore
+    bool has_plan;
+    // Node requesting the plan from parent node on cache miss, -1 if none
+    int plan_requester;
+    // Serialized qplan.experts computed by parent node, reused when sending the plan, not serialized itself
+    string plan_bytes;
+    // Params of each expert if plan_id is set, qplan.experts is then the plan skeleton without params
+    //  until ResolveQueryPlan fills them in
+    vector<vector<value_t>> plan_params;
+
+    // True if data is partial aggregates pre-combined by sender of barrier msg
+    bool is_combined = false;
+
+    // Records of profiled query, piggybacked until merged by EndExpert
+    vector<ProfileRecord> profile_records;
+
     std::string DebugString() const;
 };
 
@@ -161,12 +182,29 @@ class Message {
     // Feed data to all node with tid = parent_tid
     void CreateFeedMsg(int key, int nodes_num, vector<value_t>& data, vector<Message>& vec);
 
+    // create Cancel msg
+    // Notify all nodes that data for expert at given step is no longer needed
+    void CreateCancelMsg(int step, int nodes_num, vector<Message>& vec);
+
     std::string DebugString() const;
 
  private:
     // dispatch input data to different node
     void DispatchData(Meta& m, const vector<Expert_Object>& experts, vector<pair<history_t, vector<value_t>>>& data,
                     int num_thread, CoreAffinity * core_affinity, vector<Message>& vec);
+    // Pre-aggregate data on sender side before sending to barrier expert
+    // Return true if data is turned into partial aggregates which should be merged by barrier expert
+    static bool CombineData(const Meta& m, const vector<Expert_Object>& experts,
+                            vector<pair<history_t, vector<value_t>>>& data);
+    // Get branch value from history, truncate history after branch key if erase_his
+    static int GetBranchValue(history_t& his, int branch_key, bool erase_his);
+    // Merge data with same branch value into one pair, as barrier expert does
+    static void MergeByBranch(vector<pair<history_t, vector<value_t>>>& data, int branch_key);
+    static void CombineDedup(const Expert_Object& expert, vector<pair<history_t, vector<value_t>>>& data, int branch_key);
+    static bool CombineGroup(const Expert_Object& expert, vector<pair<history_t, vector<value_t>>>& data, int branch_key);
+    static void CombineOrder(const vector<Expert_Object>& experts, int step,
+                             vector<pair<history_t, vector<value_t>>>& data, int branch_key);
+    static bool CombineMath(const Expert_Object& expert, vector<pair<history_t, vector<value_t>>>& data, int branch_key);
     // update route to next expert
     bool UpdateRoute(Meta& m, const vector<Expert_Object>& experts);
     // update route to barrier or labelled branch experts for msg collection
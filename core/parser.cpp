@@ -75,6 +75,106 @@ bool Parser::Parse(const string& trx_input, TrxPlan& plan, string& error_msg) {
     return parser_object.Parse(trx_input, plan, error_msg);
 }
 
+bool Parser::Prepare(const string& trx_template, uint64_t& stmt_id, string& error_msg) {
+    {
+        lock_guard<mutex> lock(prepare_mutex_);
+        if (FindPreparedId(trx_template, stmt_id)) {
+            // already prepared
+            prepared_lru_.splice(prepared_lru_.begin(), prepared_lru_, prepared_plans_[stmt_id]);
+            return true;
+        }
+    }
+
+    // Parse without lock, trxid and client_host will be reset for each execution
+    TrxPlan plan(0, "");
+    ParserObject parser_object(this, true);
+    if (!parser_object.Parse(trx_template, plan, error_msg)) {
+        return false;
+    }
+
+    lock_guard<mutex> lock(prepare_mutex_);
+    // prepared by another thread meanwhile
+    if (FindPreparedId(trx_template, stmt_id)) {
+        return true;
+    }
+
+    while (prepared_lru_.size() >= config->prepared_cache_size) {
+        prepared_plans_.erase(prepared_lru_.back().stmt_id);
+        prepared_lru_.pop_back();
+    }
+    prepared_lru_.emplace_front();
+    prepared_lru_.front().stmt_id = stmt_id;
+    prepared_lru_.front().trx_template = trx_template;
+    prepared_lru_.front().plan = move(plan);
+    prepared_plans_[stmt_id] = prepared_lru_.begin();
+    return true;
+}
+
+bool Parser::FindPreparedId(const string& trx_template, uint64_t& stmt_id) {
+    // Linear probing, so that templates with the same hash get different ids
+    stmt_id = hash<string>()(trx_template);
+    while (true) {
+        auto itr = prepared_plans_.find(stmt_id);
+        if (itr == prepared_plans_.end()) {
+            return false;
+        }
+        if (itr->second->trx_template == trx_template) {
+            return true;
+        }
+        stmt_id++;
+    }
+}
+
+bool Parser::Execute(const string& execute_input, TrxPlan& plan, string& error_msg) {
+    string error_prefix = "Execute error: ";
+    string input = execute_input;
+    Tool::trim(input, " \n");
+
+    // <stmt_id>(<param1>, <param2>, ...)
+    size_t pos = input.find("(");
+    string id_str = input.substr(0, pos);
+    Tool::trim(id_str, " ");
+    vector<string> params;
+    if (pos != string::npos) {
+        if (input.back() != ')') {
+            error_msg = error_prefix + "expect ')' at the end: " + input;
+            return false;
+        }
+        string param_str = input.substr(pos + 1, input.size() - pos - 2);
+        Tool::splitWithEscape(param_str, ",", params);
+    }
+
+    if (!regex_match(id_str, regex("[0-9]+"))) {
+        error_msg = error_prefix + "unexpected statement id: " + id_str;
+        return false;
+    }
+    uint64_t stmt_id = stoull(id_str);
+
+    TrxPlan prepared;
+    {
+        lock_guard<mutex> lock(prepare_mutex_);
+        auto itr = prepared_plans_.find(stmt_id);
+        if (itr == prepared_plans_.end()) {
+            // never prepared, or evicted by newer prepared transactions
+            error_msg = error_prefix + "prepared transaction not found, please prepare it again: " + id_str;
+            return false;
+        }
+        prepared_lru_.splice(prepared_lru_.begin(), prepared_lru_, itr->second);
+        prepared = itr->second->plan;
+    }
+
+    prepared.trxid = plan.trxid;
+    prepared.client_host = plan.client_host;
+    prepared.start_time = plan.start_time;
+    if (!prepared.BindParams(params, error_msg)) {
+        error_msg = error_prefix + error_msg;
+        return false;
+    }
+
+    plan = move(prepared);
+    return true;
+}
+
 bool ParserObject::Parse(const string& trx_input, TrxPlan& plan, string& error_msg) {
     ClearTrx();
     vector<string> lines;
@@ -85,6 +185,14 @@ bool ParserObject::Parse(const string& trx_input, TrxPlan& plan, string& error_m
     for (string& line : lines) {
         Tool::trim(line, " ");
         plan.deps_count_[line_index] = 0;
+
+        // Query ends with ".profile()" returns execution profile instead of results
+        const string profile_suffix = ".profile()";
+        if (line.size() > profile_suffix.size() &&
+            line.compare(line.size() - profile_suffix.size(), profile_suffix.size(), profile_suffix) == 0) {
+            line.erase(line.size() - profile_suffix.size());
+            plan.query_plans_[line_index].profile = true;
+        }
         if (!ParseLine(line, plan.query_plans_[line_index].experts, error_msg)) {
             return false;
         }
@@ -106,6 +214,10 @@ bool ParserObject::Parse(const string& trx_input, TrxPlan& plan, string& error_m
         line_index++;
     }
 
+    if (is_template_ && !RegBindParams(plan, error_msg)) {
+        return false;
+    }
+
     // Add validation expert and finish expert (commit or abort)
     AddCommitStatement(plan);
 
@@ -132,7 +244,7 @@ bool ParserObject::ParseLine(const string& line, vector<Expert_Object>& vec, str
     /*
     else {
         error_msg = "1. Execute query with 'g.V()' or 'g.E()'\n";
-        error_msg += "2. Set up index by BuildIndex(V/E, propertyname)\n";
+        error_msg += "2. Set up index by BuildIndex(V/E, propertyname[, propertyname...])\n";
         error_msg += "3. Change config by SetConfig(config_name, t/f)\n";
         error_msg += "4. Run emulator mode with 'emu <file>'";
         return false;
@@ -317,11 +429,67 @@ void ParserObject::RegPlaceHolder(const string& var, int step, int param_index,
     trx_plan->RegPlaceHolder(p.first, line_index, step, param_index);
 }
 
+bool ParserObject::IsBindMarker(const string& param, int& index) {
+    if (!regex_match(param, regex("\\$[1-9][0-9]*"))) {
+        return false;
+    }
+    index = stoi(param.substr(1));
+    return true;
+}
+
+bool ParserObject::IsBindValue(const value_t& v) {
+    return v.type == 4 && v.content.size() > 0 && v.content[0] == bind_tag;
+}
+
+bool ParserObject::ParseBindMarker(const string& param, uint8_t type, value_t& v) {
+    int index;
+    if (!is_template_ || !IsBindMarker(param, index)) {
+        return false;
+    }
+
+    auto itr = bind_types_.find(index);
+    if (itr == bind_types_.end()) {
+        bind_types_[index] = type;
+    } else if (type != 0) {
+        if (itr->second != 0 && itr->second != type) {
+            throw ParserException("bind marker " + param + " is used for different value types");
+        }
+        itr->second = type;
+    }
+
+    // Placeholder value, replaced by TrxPlan::BindParams
+    Tool::str2str(string(1, bind_tag) + to_string(index), v);
+    return true;
+}
+
+bool ParserObject::RegBindParams(TrxPlan& plan, string& error_msg) {
+    // bind markers should be $1, $2, ..., $n
+    if (bind_types_.size() != 0 && bind_types_.rbegin()->first != bind_types_.size()) {
+        error_msg = "Prepare error: expect bind markers from $1 to $" + to_string(bind_types_.rbegin()->first);
+        return false;
+    }
+
+    // Locate placeholders after parsing, since predicates may be moved among experts
+    for (int i = 0; i < plan.query_plans_.size(); i++) {
+        vector<Expert_Object>& experts = plan.query_plans_[i].experts;
+        for (int j = 0; j < experts.size(); j++) {
+            for (int k = 0; k < experts[j].params.size(); k++) {
+                const value_t& v = experts[j].params[k];
+                if (IsBindValue(v)) {
+                    int index = stoi(string(v.content.begin() + 1, v.content.end()));
+                    plan.RegBindParam(index - 1, bind_types_[index], i, j, k);
+                }
+            }
+        }
+    }
+    return true;
+}
+
 void ParserObject::ParseIndex(const string& param) {
     vector<string> params;
     Tool::splitWithEscape(param, ",() ", params);
-    if (params.size() != 3) {
-        throw ParserException("expect 2 parameters");
+    if (params.size() < 3) {
+        throw ParserException("expect at least 2 parameters");
     }
 
     Expert_Object expert(EXPERT_T::INDEX);
@@ -337,14 +505,16 @@ void ParserObject::ParseIndex(const string& param) {
         throw ParserException("expect V/E but get: " + params[1]);
     }
 
-    int property_key = 0;
-    Tool::trim(params[2], "\"");
-    if (params[2] != "label" && !ParseKeyId(params[2], false, property_key)) {
-        throw ParserException("unexpected property key: " + params[2] + ", expected is " + ExpectedKey(false));
-    }
-
     expert.AddParam(type);
-    expert.AddParam(property_key);
+    // composite index if more than one key
+    for (int i = 2; i < params.size(); i++) {
+        int property_key = 0;
+        Tool::trim(params[i], "\"");
+        if (params[i] != "label" && !ParseKeyId(params[i], false, property_key)) {
+            throw ParserException("unexpected property key: " + params[i] + ", expected is " + ExpectedKey(false));
+        }
+        expert.AddParam(property_key);
+    }
     AppendExpert(expert);
     is_read_only_ = false;
 }
@@ -815,6 +985,9 @@ void ParserObject::ParsePredicate(string& param, uint8_t type, Expert_Object& ex
         if (pred_params.size() != 1) {
             throw ParserException("expect only one param: " + param);
         }
+        if (!toKey && ParseBindMarker(pred_params[0], 0, pred_param)) {
+            break;
+        }
         if (!Tool::str2value_t(pred_params[0], pred_param)) {
             throw ParserException("unexpected value: " + param);
         }
@@ -827,6 +1000,14 @@ void ParserObject::ParsePredicate(string& param, uint8_t type, Expert_Object& ex
             throw ParserException("expect two params: " + param);
         }
       case Predicate_T::WITHIN: case Predicate_T::WITHOUT:
+        if (is_template_) {
+            int index;
+            for (auto& p : pred_params) {
+                if (IsBindMarker(p, index)) {
+                    throw ParserException("bind marker is not supported in collection predicate: " + param);
+                }
+            }
+        }
         if (!Tool::vec2value_t(pred_params, pred_param, type)) {
             throw ParserException("predicate type not match: " + param);
         }
@@ -1234,7 +1415,10 @@ void ParserObject::ParseHas(const vector<string>& params, Step_T type) {
         for (string param : params) {
             expert.AddParam(key);
             expert.AddParam(Predicate_T::EQ);
-            if (!expert.AddParam(param)) {
+            value_t v;
+            if (ParseBindMarker(param, 0, v)) {
+                expert.params.push_back(move(v));
+            } else if (!expert.AddParam(param)) {
                 throw ParserException("unexpected value: " + param);
             }
         }
@@ -1283,7 +1467,13 @@ void ParserObject::ParseHas(const vector<string>& params, Step_T type) {
         PredicateValue pred(pred_type, expert.params[size - 1]);
 
         uint64_t count = 0;
-        bool enabled = parser_->index_store->IsIndexEnabled(element_type, key, &pred, &count);
+        bool enabled;
+        if (IsBindValue(expert.params[size - 1])) {
+            // value of bind marker is unknown when preparing, use index whenever it is enabled
+            enabled = parser_->index_store->IsIndexEnabled(element_type, key);
+        } else {
+            enabled = parser_->index_store->IsIndexEnabled(element_type, key, &pred, &count);
+        }
 
         if (enabled && count / index_ratio < min_count_) {
             Expert_Object &init_expert = experts_[0];
@@ -1321,6 +1511,8 @@ void ParserObject::ParseHas(const vector<string>& params, Step_T type) {
             }
         }
     }
+
+    TryCompositeIndex(element_type);
 }
 
 void ParserObject::ParseHasLabel(const vector<string>& params) {
@@ -1371,6 +1563,114 @@ void ParserObject::ParseHasLabel(const vector<string>& params) {
             init_expert.params.push_back(v);
         }
     }
+
+    TryCompositeIndex(element_type);
+}
+
+void ParserObject::TryCompositeIndex(Element_T element_type) {
+    // Only for has/hasLabel chain directly after init without input
+    if (experts_.size() < 2 || experts_[0].expert_type != EXPERT_T::INIT
+        || Tool::value_t2int(experts_[0].params[1]) != 0) {
+        return;
+    }
+    for (int i = 1; i < experts_.size(); i++) {
+        if (experts_[i].expert_type != EXPERT_T::HAS && experts_[i].expert_type != EXPERT_T::HASLABEL) {
+            return;
+        }
+    }
+
+    vector<vector<int>> pids_list;
+    parser_->index_store->GetCompositeIndexes(element_type, pids_list);
+    if (pids_list.size() == 0) {
+        return;
+    }
+
+    // Collect all predicates with their positions (expert, param)
+    vector<pair<int, PredicateValue>> pred_chain;
+    vector<pair<int, int>> pred_pos;
+    for (int i = 0; i < experts_.size(); i++) {
+        const Expert_Object& expert = experts_[i];
+        if (expert.expert_type == EXPERT_T::HASLABEL) {
+            // hasLabel with one label stands for EQ on label
+            if (expert.params.size() == 2) {
+                pred_chain.emplace_back(0, PredicateValue(Predicate_T::EQ, vector<value_t>{expert.params[1]}));
+                pred_pos.emplace_back(i, 1);
+            }
+            continue;
+        }
+        int first = (i == 0) ? 2 : 1;
+        for (int j = first; j + 2 < expert.params.size(); j += 3) {
+            int pid = Tool::value_t2int(expert.params[j]);
+            if (pid == -1 || IsBindValue(expert.params[j + 2])) {
+                continue;
+            }
+            Predicate_T pred_type = (Predicate_T) Tool::value_t2int(expert.params[j + 1]);
+            pred_chain.emplace_back(pid, PredicateValue(pred_type, expert.params[j + 2]));
+            pred_pos.emplace_back(i, j);
+        }
+    }
+
+    // Choose composite index with minimum count
+    uint64_t min_count = -1;
+    vector<int> best_matched;
+    for (auto& pids : pids_list) {
+        uint64_t count;
+        vector<int> matched;
+        if (parser_->index_store->GetCompositeCount(element_type, pids, pred_chain, count, &matched)
+            && count < min_count) {
+            min_count = count;
+            best_matched.swap(matched);
+        }
+    }
+    if (best_matched.size() == 0 || min_count / index_ratio >= min_count_) {
+        return;
+    }
+
+    // Move matched predicates into init expert
+    Expert_Object &init_expert = experts_[0];
+    map<int, vector<int>> erase_pos;  // expert index -> params to erase
+    for (auto& i : best_matched) {
+        int e_idx = pred_pos[i].first;
+        int p_idx = pred_pos[i].second;
+        if (e_idx == 0) {
+            continue;
+        }
+        Expert_Object &expert = experts_[e_idx];
+        if (expert.expert_type == EXPERT_T::HASLABEL) {
+            init_expert.AddParam(0);
+            init_expert.AddParam(Predicate_T::EQ);
+            init_expert.params.push_back(expert.params[p_idx]);
+        } else {
+            init_expert.params.insert(init_expert.params.end(),
+                                      expert.params.begin() + p_idx,
+                                      expert.params.begin() + p_idx + 3);
+        }
+        erase_pos[e_idx].push_back(p_idx);
+        index_count_.push_back(min_count);
+    }
+    min_count_ = min_count;
+
+    for (auto itr = erase_pos.rbegin(); itr != erase_pos.rend(); itr++) {
+        Expert_Object &expert = experts_[itr->first];
+        vector<int>& pos = itr->second;
+        sort(pos.rbegin(), pos.rend());
+        if (expert.expert_type == EXPERT_T::HAS) {
+            for (auto& p : pos) {
+                expert.params.erase(expert.params.begin() + p, expert.params.begin() + p + 3);
+            }
+        }
+        // no predicate left
+        if (expert.expert_type == EXPERT_T::HASLABEL || expert.params.size() == 1) {
+            experts_.erase(experts_.begin() + itr->first);
+        }
+    }
+
+    // Experts after init are linear, reassign links
+    for (int i = 0; i < experts_.size(); i++) {
+        experts_[i].next_expert = i + 1;
+        experts_[i].index = experts_[0].index + i;
+    }
+    expert_index = experts_[0].index + experts_.size();
 }
 
 void ParserObject::ParseIs(const vector<string>& params) {
@@ -1550,13 +1850,17 @@ void ParserObject::ParseProperty(const vector<string>& params) {
     if (!ParseKeyId(params[0], false, key, &key_type)) {
         throw ParserException("unexpected key in property: " + params[0] + ", expected is " + ExpectedKey(false));
     }
-    int value_type = Tool::checktype(params[1]);
-    if (value_type != key_type) {
-        throw ParserException("property key type no match with value type in property()");
-    }
-
     expert.AddParam(key);
-    expert.AddParam(params[1]);
+    value_t v;
+    if (ParseBindMarker(params[1], key_type, v)) {
+        expert.params.push_back(move(v));
+    } else {
+        int value_type = Tool::checktype(params[1]);
+        if (value_type != key_type) {
+            throw ParserException("property key type no match with value type in property()");
+        }
+        expert.AddParam(params[1]);
+    }
     AppendExpert(expert);
     trx_plan->trx_type_ |= TRX_UPDATE;
     is_read_only_ = false;
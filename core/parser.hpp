@@ -14,11 +14,16 @@
 
 #pragma once
 
+#include <list>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <map>
+#include <mutex>
 #include <utility>
 
+#include "tbb/concurrent_hash_map.h"
+
 #include "base/type.hpp"
 #include "core/exec_plan.hpp"
 #include "layout/data_storage.hpp"
@@ -40,10 +45,34 @@ class Parser {
 
     string vpks_str, vlks_str, epks_str, elks_str;
 
+    // Prepared transaction, the cached plan is copied and filled with bind params for each execution
+    struct PreparedPlan {
+        uint64_t stmt_id;
+        string trx_template;
+        TrxPlan plan;
+    };
+
+    // Prepared transactions from the most recently used, at most prepared_cache_size entries
+    std::list<PreparedPlan> prepared_lru_;
+    // From statement id (hash of template, probed on collision) to prepared transaction
+    std::unordered_map<uint64_t, std::list<PreparedPlan>::iterator> prepared_plans_;
+    std::mutex prepare_mutex_;
+
+    // Find the statement id of template, or the first free id after its hash. Return true if prepared.
+    //  Called with prepare_mutex_ held
+    bool FindPreparedId(const string& trx_template, uint64_t& stmt_id);
+
  public:
     // Parse query string
     bool Parse(const string& trx_input, TrxPlan& vec, string& error_msg);
 
+    // Parse transaction template with bind markers ($1, $2, ...) and cache its plan
+    bool Prepare(const string& trx_template, uint64_t& stmt_id, string& error_msg);
+
+    // Execute prepared transaction with input "<stmt_id>(<param1>, <param2>, ...)"
+    // plan should be constructed with trxid and client_host in advance
+    bool Execute(const string& execute_input, TrxPlan& plan, string& error_msg);
+
     Parser(IndexStore* index_store_): index_store(index_store_) {
         config = Config::GetInstance();
     }
@@ -71,6 +100,9 @@ class ParserObject {
 
     static const int index_ratio = 3;
 
+    // First char of string value which stands for a bind marker in prepared transaction
+    static const char bind_tag = '\x01';
+
     // Used to access global members for all transactions.
     Parser* parser_;
 
@@ -94,6 +126,12 @@ class ParserObject {
 
     TrxPlan* trx_plan;
 
+    // True if parsing template of prepared transaction
+    bool is_template_;
+
+    // Index of bind marker to expected value type, 0 for any type
+    map<int, uint8_t> bind_types_;
+
 /*-----------------local members for one line in trx----------------------------
 ------------------------------------------------------------------------------*/
     bool is_read_only_;
@@ -153,6 +191,12 @@ class ParserObject {
 
     void RegPlaceHolder(const string& var, int step, int param_index, IO_T type);
 
+    // Bind markers ($1, $2, ...) of prepared transaction
+    bool IsBindMarker(const string& param, int& index);
+    static bool IsBindValue(const value_t& v);
+    bool ParseBindMarker(const string& param, uint8_t type, value_t& v);
+    bool RegBindParams(TrxPlan& plan, string& error_msg);
+
     // Parse each line of transaction
     bool ParseLine(const string& query, vector<Expert_Object>& vec, string& error_msg);
 
@@ -205,6 +249,8 @@ class ParserObject {
     void ParseGroup(const vector<string>& params, Step_T type);
     void ParseHas(const vector<string>& params, Step_T type);
     void ParseHasLabel(const vector<string>& params);
+    // Move predicates after init into init expert if composite index is cheaper
+    void TryCompositeIndex(Element_T element_type);
     void ParseIs(const vector<string>& params);
     void ParseKey(const vector<string>& params);
     void ParseLabel(const vector<string>& params);
@@ -224,7 +270,7 @@ class ParserObject {
     // Add commit statement including validation & finish (Commit or Abort)
     void AddCommitStatement(TrxPlan& vec);
 
-    ParserObject(Parser* parser) : parser_(parser) {}
+    ParserObject(Parser* parser, bool is_template = false) : parser_(parser), is_template_(is_template) {}
 
     bool Parse(const string& trx_input, TrxPlan& vec, string& error_msg);
 
@@ -0,0 +1,218 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <set>
+#include <sstream>
+#include <string>
+
+#include "core/message.hpp"
+#include "core/profiler.hpp"
+#include "utils/timer.hpp"
+#include "utils/tool.hpp"
+
+thread_local Profiler::Scope Profiler::scope_;
+
+void ProfileRecord::Merge(const ProfileRecord& other) {
+    time_us += other.time_us;
+    rows_in += other.rows_in;
+    rows_out += other.rows_out;
+    storage_reads += other.storage_reads;
+    storage_aborts += other.storage_aborts;
+    for (auto& p : other.sends) {
+        sends[p.first].first += p.second.first;
+        sends[p.first].second += p.second.second;
+    }
+}
+
+ibinstream& operator<<(ibinstream& m, const ProfileRecord& r) {
+    m << r.step;
+    m << r.nid;
+    m << r.time_us;
+    m << r.rows_in;
+    m << r.rows_out;
+    m << r.storage_reads;
+    m << r.storage_aborts;
+    m << r.sends;
+    return m;
+}
+
+obinstream& operator>>(obinstream& m, ProfileRecord& r) {
+    m >> r.step;
+    m >> r.nid;
+    m >> r.time_us;
+    m >> r.rows_in;
+    m >> r.rows_out;
+    m >> r.storage_reads;
+    m >> r.storage_aborts;
+    m >> r.sends;
+    return m;
+}
+
+static uint64_t CountRows(const Message& msg) {
+    uint64_t rows = 0;
+    for (auto& p : msg.data) {
+        rows += p.second.size();
+    }
+    return rows;
+}
+
+void Profiler::BeginExpert(const Message& msg) {
+    scope_.active = true;
+    scope_.qid = msg.meta.qid;
+    scope_.start_time = timer::get_usec();
+    scope_.record = ProfileRecord();
+    scope_.record.step = msg.meta.step;
+    scope_.record.nid = nid_;
+    scope_.record.rows_in = CountRows(msg);
+}
+
+void Profiler::EndExpert(const Message& msg) {
+    if (!scope_.active)
+        return;
+    // msg is passed to next expert on this thread directly without sending
+    if (msg.meta.step != scope_.record.step)
+        scope_.record.rows_out += CountRows(msg);
+    FlushScope();
+    scope_.active = false;
+}
+
+void Profiler::Absorb(Message& msg) {
+    if (msg.meta.profile_records.empty())
+        return;
+
+    PendingAccessor ac;
+    pending_.insert(ac, msg.meta.qid);
+    for (auto& r : msg.meta.profile_records) {
+        MergeInto(ac->second, r);
+    }
+    msg.meta.profile_records.clear();
+}
+
+void Profiler::RecordSend(Message& msg) {
+    if (!IsRecording(msg.meta.qid))
+        return;
+
+    scope_.record.rows_out += CountRows(msg);
+    auto& send = scope_.record.sends[msg.meta.recver_nid];
+    send.first++;
+    send.second += MemSize(msg.data);
+    FlushScope();
+
+    PendingAccessor ac;
+    if (pending_.find(ac, msg.meta.qid)) {
+        msg.meta.profile_records = move(ac->second);
+        pending_.erase(ac);
+    }
+}
+
+void Profiler::FlushScope() {
+    uint64_t now = timer::get_usec();
+    scope_.record.time_us = now - scope_.start_time;
+    scope_.start_time = now;
+    {
+        PendingAccessor ac;
+        pending_.insert(ac, scope_.qid);
+        MergeInto(ac->second, scope_.record);
+    }
+
+    int step = scope_.record.step;
+    scope_.record = ProfileRecord();
+    scope_.record.step = step;
+    scope_.record.nid = nid_;
+}
+
+void Profiler::MergeInto(vector<ProfileRecord>& records, const ProfileRecord& r) {
+    for (auto& record : records) {
+        if (record.step == r.step && record.nid == r.nid) {
+            record.Merge(r);
+            return;
+        }
+    }
+    records.push_back(r);
+}
+
+void Profiler::Collect(const QueryPlan& qplan, uint64_t qid, vector<value_t>& data) {
+    if (IsRecording(qid))
+        FlushScope();
+
+    vector<ProfileRecord> records;
+    {
+        PendingAccessor ac;
+        if (pending_.find(ac, qid)) {
+            records = move(ac->second);
+            pending_.erase(ac);
+        }
+    }
+
+    const vector<Expert_Object>& experts = qplan.experts;
+    vector<ProfileRecord> totals(experts.size());
+    vector<ProfileRecord> slowest(experts.size());
+    set<int> nodes;
+    for (auto& r : records) {
+        if (r.step < 0 || r.step >= experts.size())
+            continue;
+        totals[r.step].Merge(r);
+        if (r.time_us >= slowest[r.step].time_us)
+            slowest[r.step] = r;
+        nodes.insert(r.nid);
+    }
+
+    size_t num_results = data.size();
+    data.clear();
+    auto append_line = [&data](const string& line) {
+        value_t v;
+        Tool::str2str(line, v);
+        data.push_back(move(v));
+    };
+
+    append_line("Profile on " + to_string(nodes.size()) + " node(s), time in us, rows in -> out:");
+
+    // sub-query experts of a branch expert are stored in (i, experts[i].next_expert)
+    vector<int> ends;
+    for (int i = 0; i < experts.size(); i++) {
+        while (!ends.empty() && i >= ends.back()) {
+            ends.pop_back();
+        }
+
+        const ProfileRecord& total = totals[i];
+        stringstream ss;
+        ss << string(2 * ends.size(), ' ') << "[" << i << "] "
+           << ExpertType[static_cast<int>(experts[i].expert_type)];
+        ss << "  time: " << total.time_us;
+        if (total.time_us > 0)
+            ss << " (max " << slowest[i].time_us << " @ node " << slowest[i].nid << ")";
+        ss << "  rows: " << total.rows_in << " -> " << total.rows_out;
+        if (total.storage_reads > 0 || total.storage_aborts > 0)
+            ss << "  reads: " << total.storage_reads << "  aborts: " << total.storage_aborts;
+        if (!total.sends.empty()) {
+            uint64_t msgs = 0, bytes = 0;
+            ss << "  sends: {";
+            for (auto itr = total.sends.begin(); itr != total.sends.end(); itr++) {
+                if (itr != total.sends.begin())
+                    ss << ", ";
+                ss << "node " << itr->first << ": " << itr->second.first << " msgs / " << itr->second.second << " B";
+                msgs += itr->second.first;
+                bytes += itr->second.second;
+            }
+            ss << "}  total: " << msgs << " msgs / " << bytes << " B";
+        }
+        append_line(ss.str());
+
+        if (experts[i].next_expert > i + 1)
+            ends.push_back(experts[i].next_expert);
+    }
+
+    append_line("results: " + to_string(num_results));
+}
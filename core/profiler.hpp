@@ -0,0 +1,110 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <tbb/concurrent_hash_map.h>
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "base/serialization.hpp"
+#include "base/type.hpp"
+#include "core/exec_plan.hpp"
+
+class Message;
+
+// Execution statistics of the expert at given step on one node
+struct ProfileRecord {
+    int step = 0;
+    int nid = 0;
+    uint64_t time_us = 0;
+    uint64_t rows_in = 0;
+    uint64_t rows_out = 0;
+    uint64_t storage_reads = 0;
+    uint64_t storage_aborts = 0;
+    // dst nid -> <msgs, bytes>
+    map<int, pair<uint64_t, uint64_t>> sends;
+
+    void Merge(const ProfileRecord& other);
+};
+
+ibinstream& operator<<(ibinstream& m, const ProfileRecord& r);
+
+obinstream& operator>>(obinstream& m, ProfileRecord& r);
+
+// Per-query execution profile, enabled by query suffix ".profile()".
+// Each node records statistics of (qid, step) while executing experts of a profiled query,
+// and records are piggybacked on outgoing messages of the query until reaching EndExpert,
+// where they are merged and returned to client as the plan tree instead of the query results.
+class Profiler {
+ public:
+    static Profiler* GetInstance() {
+        static Profiler profiler;
+        return &profiler;
+    }
+
+    void Init(int nid) { nid_ = nid; }
+
+    // Start and stop recording expert at msg.meta.step on current thread
+    void BeginExpert(const Message& msg);
+    void EndExpert(const Message& msg);
+
+    // Move records carried by msg to local pending records
+    void Absorb(Message& msg);
+
+    // True if current thread is recording expert of qid
+    static bool IsRecording(uint64_t qid) { return scope_.active && scope_.qid == qid; }
+
+    // Record msg sent by current expert, and attach pending records of the query to msg
+    void RecordSend(Message& msg);
+
+    // Called by DataStorage on read paths
+    static void RecordStorageRead() {
+        if (scope_.active)
+            scope_.record.storage_reads++;
+    }
+    static void RecordStorageAbort() {
+        if (scope_.active)
+            scope_.record.storage_aborts++;
+    }
+
+    // Replace data with the plan tree of qplan annotated by collected records
+    void Collect(const QueryPlan& qplan, uint64_t qid, vector<value_t>& data);
+
+    // Drop records left of finished query
+    void Erase(uint64_t qid) { pending_.erase(qid); }
+
+ private:
+    Profiler() : nid_(0) {}
+
+    struct Scope {
+        bool active = false;
+        uint64_t qid;
+        uint64_t start_time;
+        ProfileRecord record;
+    };
+    static thread_local Scope scope_;
+
+    // Merge time of current scope into pending records, and restart the timer
+    void FlushScope();
+    static void MergeInto(vector<ProfileRecord>& records, const ProfileRecord& r);
+
+    int nid_;
+
+    // qid -> records not yet sent
+    tbb::concurrent_hash_map<uint64_t, vector<ProfileRecord>> pending_;
+    typedef tbb::concurrent_hash_map<uint64_t, vector<ProfileRecord>>::accessor PendingAccessor;
+};
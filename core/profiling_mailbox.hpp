@@ -0,0 +1,49 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <vector>
+
+#include "core/abstract_mailbox.hpp"
+#include "core/profiler.hpp"
+
+// Mailbox used by experts, records msgs sent for profiled queries and forwards everything to the underlying mailbox
+class ProfilingMailbox : public AbstractMailbox {
+ public:
+    explicit ProfilingMailbox(AbstractMailbox * mailbox) : mailbox_(mailbox) {}
+
+    void Init(vector<Node> & nodes) override { mailbox_->Init(nodes); }
+
+    int Send(int tid, const Message & msg) override {
+        if (!Profiler::IsRecording(msg.meta.qid))
+            return mailbox_->Send(tid, msg);
+
+        Message profiled_msg(msg);
+        Profiler::GetInstance()->RecordSend(profiled_msg);
+        return mailbox_->Send(tid, profiled_msg);
+    }
+
+    bool TryRecv(int tid, Message & msg) override { return mailbox_->TryRecv(tid, msg); }
+    bool TryRecvRing(int tid, Message & msg) override { return mailbox_->TryRecvRing(tid, msg); }
+    void Recv(int tid, Message & msg) override { mailbox_->Recv(tid, msg); }
+    void Sweep(int tid) override { mailbox_->Sweep(tid); }
+    bool IsCongested(int tid) override { return mailbox_->IsCongested(tid); }
+    void SendNotification(int dst_nid, ibinstream& in) override { mailbox_->SendNotification(dst_nid, in); }
+    void RecvNotification(obinstream& out) override { mailbox_->RecvNotification(out); }
+
+ private:
+    // not owned
+    AbstractMailbox * mailbox_;
+};
@@ -0,0 +1,120 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "core/query_plan_store.hpp"
+#include "glog/logging.h"
+
+uint64_t QueryPlanStore::Register(int nid, uint64_t trx_id, const string& plan_bytes,
+                                  const vector<Expert_Object>& experts) {
+    lock_guard<mutex> lock(mutex_);
+    uint64_t plan_id;
+    auto itr = ids_.find(plan_bytes);
+    if (itr != ids_.end()) {
+        plan_id = itr->second;
+    } else {
+        // the highest 16 bits for nid, so that ids from different nodes never conflict
+        plan_id = (static_cast<uint64_t>(nid) << 48) | next_seq_++;
+        ids_[plan_bytes] = plan_id;
+        InsertLocked(plan_id, experts, plan_bytes);
+    }
+
+    {
+        PlanAccessor ac;
+        CHECK(plans_.find(ac, plan_id));
+        ac->second.pins++;
+    }
+    pinned_[trx_id].push_back(plan_id);
+
+    EvictLocked();
+    return plan_id;
+}
+
+void QueryPlanStore::Insert(uint64_t plan_id, const vector<Expert_Object>& experts) {
+    {
+        PlanConstAccessor ac;
+        if (plans_.find(ac, plan_id)) {
+            // already cached
+            return;
+        }
+    }
+
+    lock_guard<mutex> lock(mutex_);
+    InsertLocked(plan_id, experts, "");
+    EvictLocked();
+}
+
+void QueryPlanStore::InsertLocked(uint64_t plan_id, const vector<Expert_Object>& experts, const string& bytes) {
+    PlanAccessor ac;
+    if (!plans_.insert(ac, plan_id)) {
+        return;
+    }
+    ac->second.experts = experts;
+    ac->second.bytes = bytes;
+    fifo_.push_back(plan_id);
+}
+
+void QueryPlanStore::EvictLocked() {
+    // each plan is checked at most once
+    size_t n = fifo_.size();
+    while (fifo_.size() > capacity_ && n-- > 0) {
+        uint64_t plan_id = fifo_.front();
+        fifo_.pop_front();
+
+        PlanAccessor ac;
+        CHECK(plans_.find(ac, plan_id));
+        if (ac->second.pins > 0) {
+            // still used by running trx
+            fifo_.push_back(plan_id);
+            continue;
+        }
+        if (!ac->second.bytes.empty()) {
+            ids_.erase(ac->second.bytes);
+        }
+        plans_.erase(ac);
+        // the plan should be shipped again since this node can no longer answer plan requests
+        shipped_.erase(plan_id);
+    }
+}
+
+bool QueryPlanStore::Get(uint64_t plan_id, vector<Expert_Object>& experts) {
+    PlanConstAccessor ac;
+    if (!plans_.find(ac, plan_id)) {
+        return false;
+    }
+    experts = ac->second.experts;
+    return true;
+}
+
+bool QueryPlanStore::MarkShipped(uint64_t plan_id, int nid) {
+    ShippedAccessor ac;
+    shipped_.insert(ac, plan_id);
+    return ac->second.insert(nid).second;
+}
+
+void QueryPlanStore::Unpin(uint64_t trx_id) {
+    lock_guard<mutex> lock(mutex_);
+    auto itr = pinned_.find(trx_id);
+    if (itr == pinned_.end()) {
+        return;
+    }
+    for (uint64_t plan_id : itr->second) {
+        PlanAccessor ac;
+        CHECK(plans_.find(ac, plan_id));
+        ac->second.pins--;
+    }
+    pinned_.erase(itr);
+    EvictLocked();
+}
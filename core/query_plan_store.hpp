@@ -0,0 +1,106 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <tbb/concurrent_hash_map.h>
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/serialization.hpp"
+#include "expert/expert_object.hpp"
+#include "utils/config.hpp"
+
+// Per-node cache of query plans (expert chains).
+// INIT msg only carries the plan id once the plan has been shipped to the receiver node,
+// and the receiver fetches the plan from parent node on cache miss.
+//
+// Only the plan skeleton (experts without params) is cached, params are carried by each INIT msg.
+// Plan ids are assigned by the parent node as <nid, sequence number>, and the parent node finds the id of a plan
+// by its serialized skeleton, thus different skeletons never share an id.
+// Plans registered by the parent node are pinned until the transaction finishes, so that plan requests
+// can always be answered, and the cache may exceed its capacity when too many plans are pinned.
+class QueryPlanStore {
+ public:
+    static QueryPlanStore* GetInstance() {
+        static QueryPlanStore store;
+        return &store;
+    }
+
+    // Called by parent node, get the id of plan with given serialized skeleton and pin it until trx_id finishes
+    uint64_t Register(int nid, uint64_t trx_id, const string& plan_bytes, const vector<Expert_Object>& experts);
+
+    // Insert plan shipped from parent node
+    void Insert(uint64_t plan_id, const vector<Expert_Object>& experts);
+
+    // Copy plan into experts, return false if not found
+    bool Get(uint64_t plan_id, vector<Expert_Object>& experts);
+
+    // Mark that plan has been shipped to node nid
+    // Return false if it was already shipped, then only plan id is needed
+    bool MarkShipped(uint64_t plan_id, int nid);
+
+    // Unpin plans registered for trx_id
+    void Unpin(uint64_t trx_id);
+
+    // Shipping plan by id is disabled if cache size is 0
+    bool IsEnabled() const { return capacity_ > 0; }
+
+ private:
+    QueryPlanStore() {
+        capacity_ = Config::GetInstance()->plan_cache_size;
+        // 0 is never a valid plan id
+        next_seq_ = 1;
+    }
+
+    struct Plan {
+        vector<Expert_Object> experts;
+        // serialized experts, empty if shipped from other node
+        string bytes;
+        // number of running trxs using this plan
+        int pins = 0;
+    };
+
+    // Insert plan with plan_id if not exists, called with mutex_ held
+    void InsertLocked(uint64_t plan_id, const vector<Expert_Object>& experts, const string& bytes);
+    // Evict the oldest unpinned plans when cache is full, called with mutex_ held
+    void EvictLocked();
+
+    int capacity_;
+    uint64_t next_seq_;
+
+    // plan id -> plan, read without mutex_
+    tbb::concurrent_hash_map<uint64_t, Plan> plans_;
+    typedef tbb::concurrent_hash_map<uint64_t, Plan>::accessor PlanAccessor;
+    typedef tbb::concurrent_hash_map<uint64_t, Plan>::const_accessor PlanConstAccessor;
+
+    // plan id -> nodes that the plan has been shipped to
+    tbb::concurrent_hash_map<uint64_t, set<int>> shipped_;
+    typedef tbb::concurrent_hash_map<uint64_t, set<int>>::accessor ShippedAccessor;
+
+    // protects members below and modification of plans_
+    std::mutex mutex_;
+    // serialized skeleton -> id, for plans registered by this node
+    unordered_map<string, uint64_t> ids_;
+    // trx id -> plans pinned by the trx
+    unordered_map<uint64_t, vector<uint64_t>> pinned_;
+    // insertion order of plans for eviction
+    std::deque<uint64_t> fifo_;
+};
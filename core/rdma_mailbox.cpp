@@ -12,6 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include "core/rdma_mailbox.hpp"
 
@@ -44,11 +46,12 @@ void RdmaMailbox::Init(vector<Node> & nodes) {
     //      Worker::Start (with tid = config_->global_num_threads)
     //      Worker::ProcessAllocatedTimestamp (with tid = config_->global_num_threads + 1)
     //      Worker::RecvNotification (with tid = config_->global_num_threads + 2)
-    //      RunningTrxList::UpdateMinBT (with tid = config_->global_num_threads + 3)
-    //      Coordinator::PerformCalibration (with tid = config_->global_num_threads + 4)
+    //      Coordinator::PerformCalibration (with tid = config_->global_num_threads + 3)
+    //      Worker::ProcessIngestBatches (with tid = config_->global_num_threads + 4)
+    //      Worker::ProcessIngestParts (with tid = config_->global_num_threads + 5)
     RDMA_init(config_->global_num_workers, config_->global_num_threads + Config::extra_rdma_rc_thread_count, nid, mem_info, nodes);
 
-    int nrbfs = (config_->global_num_workers - 1) * config_->global_num_threads;
+    int nrbfs = (config_->global_num_workers - 1) * config_->num_recv_rings;
 
     rmetas = (rbf_rmeta_t *)malloc(sizeof(rbf_rmeta_t) * nrbfs);
     memset(rmetas, 0, sizeof(rbf_rmeta_t) * nrbfs);
@@ -80,9 +83,40 @@ void RdmaMailbox::Init(vector<Node> & nodes) {
 
     // 1 more thread for worker to send init msg
     pending_msgs.resize(config_->global_num_threads + Config::extra_send_buf_count);
+    pending_bytes.resize(config_->global_num_threads + Config::extra_send_buf_count, 0);
     rr_size = 3;
 
     pthread_spin_init(&send_notification_lock_, 0);
+
+    RegisterMetrics();
+}
+
+void RdmaMailbox::RegisterMetrics() {
+    MetricsRegistry* registry = MetricsRegistry::GetInstance();
+    registry->RegisterGauge("gtran_mailbox_local_queue_depth", "Msgs received but not yet processed, by thread",
+                            [this](vector<pair<string, double>>& samples) {
+        for (int i = 0; i < config_->global_num_threads; i++)
+            samples.emplace_back("tid=\"" + to_string(i) + "\"", local_msgs[i]->Size());
+    });
+    registry->RegisterGauge("gtran_mailbox_pending_bytes", "Bytes of msgs waiting for space in remote recv buffers, by thread",
+                            [this](vector<pair<string, double>>& samples) {
+        for (int i = 0; i < pending_bytes.size(); i++)
+            samples.emplace_back("tid=\"" + to_string(i) + "\"", __atomic_load_n(&pending_bytes[i], __ATOMIC_RELAXED));
+    });
+    registry->RegisterGauge("gtran_rdma_ring_occupancy_ratio", "Used fraction of remote recv buffers, as seen by this worker",
+                            [this](vector<pair<string, double>>& samples) {
+        uint64_t rbf_sz = MiB2B(config_->global_per_recv_buffer_sz_mb);
+        for (int nid = 0; nid < config_->global_num_workers; nid++) {
+            if (nid == node_.get_local_rank())
+                continue;
+            for (int ring = 0; ring < config_->num_recv_rings; ring++) {
+                uint64_t tail = __atomic_load_n(&rmetas[GetIndex(ring, nid)].tail, __ATOMIC_ACQUIRE);
+                uint64_t head = *(volatile uint64_t *)buffer_->GetRemoteHeadBuf(ring, nid);
+                samples.emplace_back("dst=\"" + to_string(nid) + "\",ring=\"" + to_string(ring) + "\"",
+                                     static_cast<double>(tail - head) / rbf_sz);
+            }
+        }
+    });
 }
 
 bool RdmaMailbox::IsBufferFull(int dst_nid, int dst_tid, uint64_t tail, uint64_t msg_sz) {
@@ -93,18 +127,47 @@ bool RdmaMailbox::IsBufferFull(int dst_nid, int dst_tid, uint64_t tail, uint64_t
     return rbf_sz < (tail - head + msg_sz);
 }
 
+/* Messages to the same recv buffer are coalesced: they are copied into the send buffer together,
+ * and written with one reservation of the recv buffer and one signaled RDMA write.
+ * The order of messages to the same recv buffer is kept.
+ */
 void RdmaMailbox::Sweep(int tid) {
-    if (pending_msgs[tid].size() == 0) {
+    vector<mailbox_data_t>& pending = pending_msgs[tid];
+    if (pending.size() == 0) {
         return;
     }
 
-    for (auto it = pending_msgs[tid].begin(); it != pending_msgs[tid].end();) {
-        if (SendData(tid, *it)) {
-            it = pending_msgs[tid].erase(it);
-        } else {
-            it++;
+    // Group messages by recv buffer
+    vector<int> rbf_order;
+    unordered_map<int, vector<const mailbox_data_t*>> rbf_batches;
+    for (auto& data : pending) {
+        int idx = GetIndex(GetRing(data.dst_tid), data.dst_nid);
+        auto& batch = rbf_batches[idx];
+        if (batch.empty())
+            rbf_order.emplace_back(idx);
+        batch.emplace_back(&data);
+    }
+
+    unordered_set<const mailbox_data_t*> sent;
+    for (int idx : rbf_order) {
+        auto& batch = rbf_batches[idx];
+        int sent_count = SendData(tid, batch);
+        for (int i = 0; i < sent_count; i++) {
+            sent.emplace(batch[i]);
+            pending_bytes[tid] -= batch[i]->stream.size();
         }
     }
+
+    // Keep unsent messages for the next sweep
+    auto it = pending.begin();
+    for (auto& data : pending) {
+        if (sent.count(&data) != 0)
+            continue;
+        if (&*it != &data)
+            *it = move(data);
+        it++;
+    }
+    pending.erase(it, pending.end());
 }
 
 int RdmaMailbox::Send(int tid, const Message & msg) {
@@ -117,54 +180,79 @@ int RdmaMailbox::Send(int tid, const Message & msg) {
 
         data.stream << msg;
 
+        pending_bytes[tid] += data.stream.size();
         pending_msgs[tid].push_back(move(data));
     }
 }
 
-bool RdmaMailbox::SendData(int tid, const mailbox_data_t& data) {
-    // Send data to remote machine only
-    int dst_nid = data.dst_nid;
-    int dst_tid = data.dst_tid;
-
-    size_t data_sz = data.stream.size();
-    uint64_t msg_sz = sizeof(uint64_t) + ceil(data_sz, sizeof(uint64_t)) + sizeof(uint64_t);
-
-    rbf_rmeta_t *rmeta = &rmetas[GetIndex(dst_tid, dst_nid)];
+/* The remote head buffer works as credits: it is RDMA-written by the receiver in FetchMsgFromRecvBuf,
+ * and the free space of the remote buffer is rbf_sz - (tail - head).
+ * When the messages waiting for credits exceed MAILBOX_CONGESTION_CAP_MB, the sender is congested,
+ * and should only drain its own recv rings (TryRecvRing) until the receivers catch up.
+ */
+bool RdmaMailbox::IsCongested(int tid) {
+    return pending_bytes[tid] > MiB2B(config_->mailbox_congestion_cap_mb);
+}
 
-    pthread_spin_lock(&rmeta->lock);
-     // detect overflow
-    if (IsBufferFull(dst_nid, dst_tid, rmeta->tail, msg_sz)) {
-        pthread_spin_unlock(&rmeta->lock);
-        return false;
-    }
-    // update tail
-    uint64_t off = rmeta->tail;
-    rmeta->tail += msg_sz;
-    pthread_spin_unlock(&rmeta->lock);
+int RdmaMailbox::SendData(int tid, const vector<const mailbox_data_t*>& batch) {
+    // Send data to remote machine only
+    int dst_nid = batch[0]->dst_nid;
+    int dst_tid = batch[0]->dst_tid;
+    // With SHARED_RECV_RING, the batch may be sent to multiple threads of dst_nid.
+    // The QP of dst_tid is used, which is also guarded by rmeta->lock
+    int ring = GetRing(dst_tid);
+
+    rbf_rmeta_t *rmeta = &rmetas[GetIndex(ring, dst_nid)];
+    uint64_t send_buf_sz = buffer_->GetSendBufSize();
+
+    // Reserve space for as many messages as possible, without locking
+    int count;
+    uint64_t off, batch_sz;
+    do {
+        off = __atomic_load_n(&rmeta->tail, __ATOMIC_ACQUIRE);
+        count = 0;
+        batch_sz = 0;
+        for (auto* data : batch) {
+            uint64_t msg_sz = sizeof(uint64_t) + ceil(data->stream.size(), sizeof(uint64_t)) + sizeof(uint64_t);
+            // detect overflow
+            if ((count > 0 && batch_sz + msg_sz > send_buf_sz) || IsBufferFull(dst_nid, ring, off, batch_sz + msg_sz))
+                break;
+            batch_sz += msg_sz;
+            count++;
+        }
+        if (count == 0)
+            return 0;
+    } while (!__atomic_compare_exchange_n(&rmeta->tail, &off, off + batch_sz, false,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
 
-    uint64_t rbf_sz = MiB2B(config_->global_per_recv_buffer_sz_mb);
     char *rdma_buf = buffer_->GetSendBuf(tid);
+    for (int i = 0; i < count; i++) {
+        size_t data_sz = batch[i]->stream.size();
 
-    *((uint64_t *)rdma_buf) = data_sz;  // header
-    rdma_buf += sizeof(uint64_t);
+        *((uint64_t *)rdma_buf) = data_sz;  // header
+        rdma_buf += sizeof(uint64_t);
 
-    memcpy(rdma_buf, data.stream.get_buf(), data_sz);    // data
-    rdma_buf += ceil(data_sz, sizeof(uint64_t));
+        memcpy(rdma_buf, batch[i]->stream.get_buf(), data_sz);    // data
+        rdma_buf += ceil(data_sz, sizeof(uint64_t));
 
-    *((uint64_t*)rdma_buf) = data_sz;   // footer
+        *((uint64_t*)rdma_buf) = data_sz;   // footer
+        rdma_buf += sizeof(uint64_t);
+    }
 
+    uint64_t rbf_sz = MiB2B(config_->global_per_recv_buffer_sz_mb);
     RDMA &rdma = RDMA::get_rdma();
-    uint64_t rdma_off = buffer_->GetRecvBufOffset(dst_tid, dst_nid);
+    uint64_t rdma_off = buffer_->GetRecvBufOffset(ring, dst_nid);
     pthread_spin_lock(&rmeta->lock);
-    if (off / rbf_sz == (off + msg_sz - 1) / rbf_sz) {
-        rdma.dev->RdmaWrite(dst_tid, dst_nid, buffer_->GetSendBuf(tid), msg_sz, rdma_off + (off % rbf_sz));
+    if (off / rbf_sz == (off + batch_sz - 1) / rbf_sz) {
+        rdma.dev->RdmaWrite(dst_tid, dst_nid, buffer_->GetSendBuf(tid), batch_sz, rdma_off + (off % rbf_sz));
     } else {
+        // completions on the same QP are in order, thus only the last write need to be signaled
         uint64_t _sz = rbf_sz - (off % rbf_sz);
-        rdma.dev->RdmaWrite(dst_tid, dst_nid, buffer_->GetSendBuf(tid), _sz, rdma_off + (off % rbf_sz));
-        rdma.dev->RdmaWrite(dst_tid, dst_nid, buffer_->GetSendBuf(tid) + _sz, msg_sz - _sz, rdma_off);
+        rdma.dev->RdmaWriteNonSignal(dst_tid, dst_nid, buffer_->GetSendBuf(tid), _sz, rdma_off + (off % rbf_sz));
+        rdma.dev->RdmaWrite(dst_tid, dst_nid, buffer_->GetSendBuf(tid) + _sz, batch_sz - _sz, rdma_off);
     }
     pthread_spin_unlock(&rmeta->lock);
-    return true;
+    return count;
 }
 
 void RdmaMailbox::Recv(int tid, Message & msg) {
@@ -179,8 +267,25 @@ void RdmaMailbox::Recv(int tid, Message & msg) {
 }
 
 
+/* With SHARED_RECV_RING, a thread polls the recv buffers of all remote workers, and dispatches
+ * messages found there to the local queues of their receivers. Thus all messages of a thread come from its local queue,
+ * which also keeps the order of messages from the same recv buffer.
+ */
 bool RdmaMailbox::TryRecv(int tid, Message & msg) {
     pthread_spin_lock(&recv_locks[tid]);
+    if (config_->global_shared_recv_ring) {
+        for (int machine_id = 0; machine_id < node_.get_local_size(); machine_id++) {
+            if (machine_id != node_.get_local_rank())
+                DispatchFromSharedRecvBuf(machine_id);
+        }
+
+        bool success = local_msgs[tid]->Size() != 0;
+        if (success)
+            local_msgs[tid]->WaitAndPop(msg);
+        pthread_spin_unlock(&recv_locks[tid]);
+        return success;
+    }
+
     int type = (schedulers[tid].rr_cnt++) % rr_size;
 
     // Try local message queue in higher priority
@@ -194,21 +299,58 @@ bool RdmaMailbox::TryRecv(int tid, Message & msg) {
     }
 
     // Try rdma memory
+    obinstream um;
+    bool success = FetchFromRecvRings(tid, um);
+    pthread_spin_unlock(&recv_locks[tid]);
+    if (success)
+        um >> msg;
+    return success;
+}
+
+bool RdmaMailbox::TryRecvRing(int tid, Message & msg) {
+    // A shared ring is dispatched to local queues of all threads
+    if (config_->global_shared_recv_ring)
+        return TryRecv(tid, msg);
+
+    obinstream um;
+    pthread_spin_lock(&recv_locks[tid]);
+    bool success = FetchFromRecvRings(tid, um);
+    pthread_spin_unlock(&recv_locks[tid]);
+    if (success)
+        um >> msg;
+    return success;
+}
+
+bool RdmaMailbox::FetchFromRecvRings(int tid, obinstream & um) {
     for (int i = 0; i < node_.get_local_size(); i++) {
         int machine_id = (schedulers[tid].machine_rr_cnt++) % node_.get_local_size();
         if (machine_id != node_.get_local_rank() && CheckRecvBuf(tid, machine_id)) {
-            obinstream um;
             FetchMsgFromRecvBuf(tid, machine_id, um);
-            pthread_spin_unlock(&recv_locks[tid]);
-
-            um >> msg;
             return true;
         }
     }
-    pthread_spin_unlock(&recv_locks[tid]);
     return false;
 }
 
+void RdmaMailbox::DispatchFromSharedRecvBuf(int nid) {
+    rbf_lmeta_t *lmeta = &lmetas[GetIndex(0, nid)];
+    // skip if another thread is dispatching this buffer
+    if (pthread_spin_trylock(&lmeta->lock) != 0)
+        return;
+
+    if (CheckRecvBuf(0, nid)) {
+        obinstream um;
+        FetchMsgFromRecvBuf(0, nid, um);
+
+        Message msg;
+        um >> msg;
+        // push before unlocking to keep the order of messages
+        int recver_tid = msg.meta.recver_tid;
+        local_msgs[recver_tid]->Push(move(msg));
+    }
+    pthread_spin_unlock(&lmeta->lock);
+}
+
 bool RdmaMailbox::CheckRecvBuf(int tid, int nid) {
     rbf_lmeta_t *lmeta = &lmetas[GetIndex(tid, nid)];
     char * rbf = buffer_->GetRecvBuf(tid, nid);
@@ -265,10 +407,14 @@ void RdmaMailbox::FetchMsgFromRecvBuf(int tid, int nid, obinstream & um) {
         // advance the pointer
         lmeta->head += 2 * sizeof(uint64_t) + ceil(pop_msg_size, sizeof(uint64_t));
 
-        // update heads of ring buffer to writer to help it detect overflow
+        // update heads of ring buffer to writer to help it detect overflow.
+        // Also return credits once the ring is drained, so that a blocked writer needs not wait for the threshold.
+        //  Fewer than min_consumed credits only block a msg nearly as large as the ring, not worth an RdmaWrite on every drain
         const uint64_t threshold = rbf_sz / 16;
+        const uint64_t min_consumed = threshold / 16;
         char *head = buffer_->GetLocalHeadBuf(tid, nid);
-        if (lmeta->head - *(uint64_t *)head > threshold) {
+        uint64_t consumed = lmeta->head - *(uint64_t *)head;
+        if (consumed > threshold || (consumed > min_consumed && !CheckRecvBuf(tid, nid))) {
             *(uint64_t *)head = lmeta->head;
             if (node_.get_local_rank() == nid) {
                 *(uint64_t *)buffer_->GetRemoteHeadBuf(tid, nid) = lmeta->head;
@@ -29,6 +29,7 @@
 #include "base/thread_safe_queue.hpp"
 #include "utils/config.hpp"
 #include "utils/global.hpp"
+#include "utils/metrics.hpp"
 #include "utils/simple_spinlock_guard.hpp"
 
 #include "glog/logging.h"
@@ -54,21 +55,25 @@ class RdmaMailbox : public AbstractMailbox {
 
     bool TryRecv(int tid, Message & msg) override;
 
+    bool TryRecvRing(int tid, Message & msg) override;
+
     void Sweep(int tid) override;
 
+    bool IsCongested(int tid) override;
+
     void SendNotification(int dst_nid, ibinstream& in) override;
 
     void RecvNotification(obinstream& out) override;
 
  private:
     struct rbf_rmeta_t {
-        uint64_t tail;  // write from here
-        pthread_spinlock_t lock;
+        uint64_t tail;  // write from here, reserved by CAS
+        pthread_spinlock_t lock;  // the QP to the remote buffer is shared by local threads
     } __attribute__((aligned(CLINE)));
 
     struct rbf_lmeta_t {
         uint64_t head;  // read from here
-        pthread_spinlock_t lock;
+        pthread_spinlock_t lock;  // held by the thread dispatching a shared recv buffer
     } __attribute__((aligned(CLINE)));
 
     // each thread uses a round-robin strategy to check its physical-queues
@@ -88,14 +93,29 @@ class RdmaMailbox : public AbstractMailbox {
         int dst_tid;
     };
 
+    // tid of CheckRecvBuf and FetchMsgFromRecvBuf is the index of recv ring, see GetRing
     bool CheckRecvBuf(int tid, int nid);
     void FetchMsgFromRecvBuf(int tid, int nid, obinstream & um);
     bool IsBufferFull(int dst_nid, int dst_tid, uint64_t tail, uint64_t msg_sz);
-    bool SendData(int tid, const mailbox_data_t& data);
+    // Send a prefix of batch (all to the same recv buffer) with one reservation of the recv buffer.
+    // Returns the number of messages sent
+    int SendData(int tid, const vector<const mailbox_data_t*>& batch);
+    // Fetch one message from the recv rings of tid, with recv_locks[tid] held
+    bool FetchFromRecvRings(int tid, obinstream & um);
+    // Move one message from the recv buffer shared by local threads to the local queue of its receiver
+    void DispatchFromSharedRecvBuf(int nid);
+
+    // Queue depths and occupancy of remote recv buffers, collected on export
+    void RegisterMetrics();
+
+    // The recv ring of thread tid for each remote worker
+    inline int GetRing(int tid) {
+        return config_->global_shared_recv_ring ? 0 : tid;
+    }
 
     inline int GetIndex(int tid, int nid) {
         nid = nid < node_.get_local_rank() ? nid : nid - 1;
-        return nid * config_->global_num_threads + tid;
+        return nid * config_->num_recv_rings + tid;
     }
 
     Node & node_;
@@ -103,6 +123,8 @@ class RdmaMailbox : public AbstractMailbox {
     Buffer * buffer_;
 
     vector<vector<mailbox_data_t>> pending_msgs;
+    // bytes of pending_msgs[tid], i.e., messages waiting for credits (space in remote buffers)
+    vector<uint64_t> pending_bytes;
 
     // Fail to use vector as copy constructors of ThreadSafeQueue are deleted
     ThreadSafeQueue<Message>** local_msgs;
@@ -175,7 +175,21 @@ uint64_t RunningTrxList::UpdateGlobalMinBT() {
 }
 
 uint64_t RunningTrxList::GetGlobalMinBT() {
-    return global_min_bt_;
+    return min(static_cast<uint64_t>(global_min_bt_), static_cast<uint64_t>(min_held_bt_));
+}
+
+void RunningTrxList::HoldBT(uint64_t bt) {
+    std::lock_guard<std::mutex> lock(held_mutex_);
+    held_bts_.insert(bt);
+    min_held_bt_ = *held_bts_.begin();
+}
+
+void RunningTrxList::ReleaseBT(uint64_t bt) {
+    std::lock_guard<std::mutex> lock(held_mutex_);
+    auto itr = held_bts_.find(bt);
+    CHECK(itr != held_bts_.end());
+    held_bts_.erase(itr);
+    min_held_bt_ = held_bts_.empty() ? UINT64_MAX : *held_bts_.begin();
 }
 
 void RunningTrxList::ProcessReadMinBTRequest() {
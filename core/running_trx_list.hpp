@@ -18,6 +18,8 @@
 #include <memory.h>
 #include <pthread.h>
 
+#include <mutex>
+#include <set>
 #include <string>
 #include <unordered_map>
 
@@ -63,7 +65,12 @@ class RunningTrxList {
 
     // Called by the GC thread.
     uint64_t UpdateGlobalMinBT();  // update global_min_bt_
-    uint64_t GetGlobalMinBT();  // simply read global_min_bt_
+    uint64_t GetGlobalMinBT();  // read global_min_bt_, bounded by held BTs on this worker
+
+    // Keep reading at bt on this worker after its trx finished (e.g., background index build),
+    // GetGlobalMinBT() does not exceed bt until it is released
+    void HoldBT(uint64_t bt);
+    void ReleaseBT(uint64_t bt);
 
  private:
     struct ListNode {
@@ -81,6 +88,11 @@ class RunningTrxList {
     tbb::atomic<uint64_t> global_min_bt_ = 0;  // the global min BT, used by GCProducer: updated in UpdateGlobalMinBT(), read by GetGlobalMinBT()
     uint64_t max_bt_ = 0;
 
+    // BTs held on this worker, and the min of them, UINT64_MAX if none
+    std::mutex held_mutex_;
+    std::multiset<uint64_t> held_bts_;
+    tbb::atomic<uint64_t> min_held_bt_ = UINT64_MAX;
+
     // Enable fast erasure in the list
     std::unordered_map<uint64_t, ListNode*> list_node_map_;
 
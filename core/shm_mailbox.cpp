@@ -0,0 +1,286 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/shm_mailbox.hpp"
+
+#include <emmintrin.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <unordered_set>
+#include <utility>
+
+#include "base/node_util.hpp"
+#include "utils/unit.hpp"
+
+#include "glog/logging.h"
+
+using namespace std;
+
+namespace {
+
+// Copy between a linear buffer and the ring, which may wrap around at the end of the ring
+void CopyToRing(char* ring, uint64_t ring_sz, uint64_t pos, const char* src, uint64_t sz) {
+    uint64_t first = min(sz, ring_sz - pos);
+    memcpy(ring + pos, src, first);
+    memcpy(ring, src + first, sz - first);
+}
+
+void CopyFromRing(char* dst, const char* ring, uint64_t ring_sz, uint64_t pos, uint64_t sz) {
+    uint64_t first = min(sz, ring_sz - pos);
+    memcpy(dst, ring + pos, first);
+    memcpy(dst + first, ring, sz - first);
+}
+
+void ZeroRing(char* ring, uint64_t ring_sz, uint64_t pos, uint64_t sz) {
+    uint64_t first = min(sz, ring_sz - pos);
+    memset(ring + pos, 0, first);
+    memset(ring, 0, sz - first);
+}
+
+}  // namespace
+
+ShmMailbox::~ShmMailbox() {
+    for (char* segment : segments_) {
+        if (segment != nullptr)
+            munmap(segment, segment_sz_);
+    }
+
+    free(recv_locks_);
+    free(schedulers_);
+    delete inner_;
+}
+
+string ShmMailbox::GetSegmentName(const Node & node) {
+    // tcp ports are unique among workers on the same host
+    return "/gtran_shm_" + to_string(node.tcp_port);
+}
+
+void ShmMailbox::Init(vector<Node> & nodes) {
+    inner_->Init(nodes);
+
+    int my_nid = node_.get_local_rank();
+    int num_workers = config_->global_num_workers;
+
+    // Gather processor names of all workers, to find co-located workers
+    char hostname[MPI_MAX_PROCESSOR_NAME] = {0};
+    int hostname_len;
+    MPI_Get_processor_name(hostname, &hostname_len);
+    vector<char> all_hostnames(num_workers * MPI_MAX_PROCESSOR_NAME);
+    MPI_Allgather(hostname, MPI_MAX_PROCESSOR_NAME, MPI_CHAR,
+                  all_hostnames.data(), MPI_MAX_PROCESSOR_NAME, MPI_CHAR, node_.local_comm);
+
+    is_colocated_.resize(num_workers, false);
+    for (int nid = 0; nid < num_workers; nid++) {
+        if (nid != my_nid && strcmp(hostname, &all_hostnames[nid * MPI_MAX_PROCESSOR_NAME]) == 0) {
+            is_colocated_[nid] = true;
+            colocated_nids_.emplace_back(nid);
+        }
+    }
+
+    // a ring holds several messages of the max size (i.e., the size of send buffer)
+    ring_sz_ = 4 * MiB2B(config_->global_per_send_buffer_sz_mb);
+    num_rings_ = num_workers * config_->global_num_threads;
+    segment_sz_ = num_rings_ * (sizeof(ring_meta_t) + ring_sz_);
+    segments_.resize(num_workers, nullptr);
+
+    // Create the segment of this worker, which is zero-filled
+    string my_name = GetSegmentName(GetNodeById(nodes, my_nid + 1));
+    if (!colocated_nids_.empty()) {
+        shm_unlink(my_name.c_str());  // left by a crashed run
+        int fd = shm_open(my_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        CHECK(fd >= 0) << "[ShmMailbox] cannot create " << my_name << ": " << strerror(errno);
+        CHECK(ftruncate(fd, segment_sz_) == 0) << "[ShmMailbox] cannot resize " << my_name << ": " << strerror(errno);
+        void* addr = mmap(nullptr, segment_sz_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        CHECK(addr != MAP_FAILED) << "[ShmMailbox] cannot map " << my_name << ": " << strerror(errno);
+        close(fd);
+        segments_[my_nid] = reinterpret_cast<char*>(addr);
+    }
+    MPI_Barrier(node_.local_comm);
+
+    // Map segments of co-located workers
+    for (int nid : colocated_nids_) {
+        string name = GetSegmentName(GetNodeById(nodes, nid + 1));
+        int fd = shm_open(name.c_str(), O_RDWR, 0600);
+        CHECK(fd >= 0) << "[ShmMailbox] cannot open " << name << ": " << strerror(errno);
+        void* addr = mmap(nullptr, segment_sz_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        CHECK(addr != MAP_FAILED) << "[ShmMailbox] cannot map " << name << ": " << strerror(errno);
+        close(fd);
+        segments_[nid] = reinterpret_cast<char*>(addr);
+    }
+    MPI_Barrier(node_.local_comm);
+
+    // The memory is released after all workers unmap it
+    if (!colocated_nids_.empty())
+        shm_unlink(my_name.c_str());
+
+    pending_msgs_.resize(config_->global_num_threads + Config::extra_send_buf_count);
+    pending_bytes_.resize(config_->global_num_threads + Config::extra_send_buf_count, 0);
+
+    recv_locks_ = (pthread_spinlock_t *)malloc(sizeof(pthread_spinlock_t) * config_->global_num_threads);
+    for (int i = 0; i < config_->global_num_threads; i++) {
+        pthread_spin_init(&recv_locks_[i], 0);
+    }
+
+    schedulers_ = (scheduler_t *)malloc(sizeof(scheduler_t) * config_->global_num_threads);
+    memset(schedulers_, 0, sizeof(scheduler_t) * config_->global_num_threads);
+
+    if (colocated_nids_.size() > 0) {
+        LOG(INFO) << "[ShmMailbox] Worker " << my_nid << " has " << colocated_nids_.size() << " co-located workers";
+    }
+}
+
+bool ShmMailbox::WriteRing(int dst_nid, int dst_tid, ibinstream & stream) {
+    int my_nid = node_.get_local_rank();
+    ring_meta_t* meta = GetRingMeta(dst_nid, my_nid, dst_tid);
+    char* ring = GetRing(dst_nid, my_nid, dst_tid);
+
+    uint64_t data_sz = stream.size();
+    uint64_t msg_sz = sizeof(uint64_t) + ceil(data_sz, sizeof(uint64_t)) + sizeof(uint64_t);
+    CHECK_LE(msg_sz, ring_sz_) << "[ShmMailbox] msg is larger than the ring";
+
+    uint64_t off;
+    do {
+        off = __atomic_load_n(&meta->tail, __ATOMIC_ACQUIRE);
+        if (off + msg_sz - __atomic_load_n(&meta->head, __ATOMIC_ACQUIRE) > ring_sz_)
+            return false;
+    } while (!__atomic_compare_exchange_n(&meta->tail, &off, off + msg_sz, false,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    CopyToRing(ring, ring_sz_, (off + sizeof(uint64_t)) % ring_sz_, stream.get_buf(), data_sz);
+    *(uint64_t *)(ring + off % ring_sz_) = data_sz;  // header
+    // the footer is written last, the receiver waits for it before reading data
+    __atomic_store_n((uint64_t *)(ring + (off + msg_sz - sizeof(uint64_t)) % ring_sz_), data_sz, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool ShmMailbox::ReadRing(int tid, int src_nid, Message & msg) {
+    int my_nid = node_.get_local_rank();
+    ring_meta_t* meta = GetRingMeta(my_nid, src_nid, tid);
+    char* ring = GetRing(my_nid, src_nid, tid);
+
+    // only written by the receiver
+    uint64_t head = meta->head;
+    uint64_t data_sz = __atomic_load_n((uint64_t *)(ring + head % ring_sz_), __ATOMIC_ACQUIRE);  // header
+    if (data_sz == 0)
+        return false;
+
+    uint64_t msg_sz = sizeof(uint64_t) + ceil(data_sz, sizeof(uint64_t)) + sizeof(uint64_t);
+    uint64_t *footer = (uint64_t *)(ring + (head + msg_sz - sizeof(uint64_t)) % ring_sz_);
+    while (__atomic_load_n(footer, __ATOMIC_ACQUIRE) != data_sz) {
+        _mm_pause();
+    }
+
+    // obinstream takes the ownership of buf
+    char* buf = new char[data_sz];
+    CopyFromRing(buf, ring, ring_sz_, (head + sizeof(uint64_t)) % ring_sz_, data_sz);
+
+    // clean the msg, so that a later header or footer at these bytes starts from zero
+    ZeroRing(ring, ring_sz_, head % ring_sz_, msg_sz);
+    __atomic_store_n(&meta->head, head + msg_sz, __ATOMIC_RELEASE);
+
+    obinstream um(buf, data_sz);
+    um >> msg;
+    return true;
+}
+
+int ShmMailbox::Send(int tid, const Message & msg) {
+    int dst_nid = msg.meta.recver_nid;
+    if (!is_colocated_[dst_nid]) {
+        return inner_->Send(tid, msg);
+    }
+
+    pending_data_t data;
+    data.dst_nid = dst_nid;
+    data.dst_tid = msg.meta.recver_tid;
+    data.stream << msg;
+
+    // Keep the order after pending msgs
+    vector<pending_data_t>& pending = pending_msgs_[tid];
+    if (!pending.empty() || !WriteRing(data.dst_nid, data.dst_tid, data.stream)) {
+        pending_bytes_[tid] += data.stream.size();
+        pending.push_back(move(data));
+    }
+    return 0;
+}
+
+void ShmMailbox::Sweep(int tid) {
+    vector<pending_data_t>& pending = pending_msgs_[tid];
+    if (!pending.empty()) {
+        // Once a msg fails, later msgs to the same ring wait for the next sweep
+        unordered_set<int> blocked_rings;
+        auto it = pending.begin();
+        for (auto& data : pending) {
+            int ring_idx = GetRingIndex(data.dst_nid, data.dst_tid);
+            if (blocked_rings.count(ring_idx) == 0 && WriteRing(data.dst_nid, data.dst_tid, data.stream)) {
+                pending_bytes_[tid] -= data.stream.size();
+                continue;
+            }
+            blocked_rings.emplace(ring_idx);
+            if (&*it != &data)
+                *it = move(data);
+            it++;
+        }
+        pending.erase(it, pending.end());
+    }
+
+    inner_->Sweep(tid);
+}
+
+bool ShmMailbox::TryRecvShm(int tid, Message & msg) {
+    if (colocated_nids_.empty())
+        return false;
+
+    pthread_spin_lock(&recv_locks_[tid]);
+    for (int i = 0; i < colocated_nids_.size(); i++) {
+        int nid = colocated_nids_[(schedulers_[tid].machine_rr_cnt++) % colocated_nids_.size()];
+        if (ReadRing(tid, nid, msg)) {
+            pthread_spin_unlock(&recv_locks_[tid]);
+            return true;
+        }
+    }
+    pthread_spin_unlock(&recv_locks_[tid]);
+    return false;
+}
+
+bool ShmMailbox::TryRecv(int tid, Message & msg) {
+    // Use round-robin to avoid starvation
+    if ((schedulers_[tid].rr_cnt++) % 2 == 0) {
+        return TryRecvShm(tid, msg) || inner_->TryRecv(tid, msg);
+    }
+    return inner_->TryRecv(tid, msg) || TryRecvShm(tid, msg);
+}
+
+bool ShmMailbox::TryRecvRing(int tid, Message & msg) {
+    return TryRecvShm(tid, msg) || inner_->TryRecvRing(tid, msg);
+}
+
+void ShmMailbox::Recv(int tid, Message & msg) {
+    inner_->Recv(tid, msg);
+}
+
+bool ShmMailbox::IsCongested(int tid) {
+    return pending_bytes_[tid] > MiB2B(config_->mailbox_congestion_cap_mb) || inner_->IsCongested(tid);
+}
+
+void ShmMailbox::SendNotification(int dst_nid, ibinstream& in) {
+    inner_->SendNotification(dst_nid, in);
+}
+
+void ShmMailbox::RecvNotification(obinstream& out) {
+    inner_->RecvNotification(out);
+}
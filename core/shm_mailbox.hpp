@@ -0,0 +1,127 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/node.hpp"
+#include "base/serialization.hpp"
+#include "core/abstract_mailbox.hpp"
+#include "core/message.hpp"
+#include "utils/config.hpp"
+
+#define CLINE 64
+
+/*
+ShmMailbox delivers messages between workers on the same host through shared memory,
+and forwards everything else to the inner mailbox (RdmaMailbox or TCPMailbox).
+-----------------------------------------------------------------------------------
+Description:
+    1. Co-located workers are detected by gathering the processor names of all workers.
+    2. Each worker creates one segment in /dev/shm, holding a ring for each (src worker, local thread).
+       Co-located workers map the segment, and write into the rings like RDMA writes into recv buffers,
+       i.e., [header: size][data][footer: size]. The tail is reserved by CAS, and the head is published by the receiver.
+    3. A message that does not fit into the ring is kept in pending msgs, and retried in Sweep.
+    4. Notifications always go through the inner mailbox.
+*/
+
+class ShmMailbox : public AbstractMailbox {
+ public:
+    // ShmMailbox takes the ownership of inner
+    ShmMailbox(Node & node, AbstractMailbox * inner) : node_(node), inner_(inner) {
+        config_ = Config::GetInstance();
+    }
+
+    ~ShmMailbox();
+
+    void Init(vector<Node> & nodes) override;
+
+    int Send(int tid, const Message & msg) override;
+
+    void Recv(int tid, Message & msg) override;
+
+    bool TryRecv(int tid, Message & msg) override;
+
+    bool TryRecvRing(int tid, Message & msg) override;
+
+    void Sweep(int tid) override;
+
+    bool IsCongested(int tid) override;
+
+    void SendNotification(int dst_nid, ibinstream& in) override;
+
+    void RecvNotification(obinstream& out) override;
+
+ private:
+    struct ring_meta_t {
+        uint64_t tail __attribute__((aligned(CLINE)));  // reserved by senders with CAS
+        uint64_t head __attribute__((aligned(CLINE)));  // published by the receiver
+    };
+
+    struct pending_data_t {
+        ibinstream stream;
+        int dst_nid;
+        int dst_tid;
+    };
+
+    struct scheduler_t {
+        uint64_t rr_cnt;  // choosing shm or inner mailbox
+        uint64_t machine_rr_cnt;  // choosing co-located machine
+    } __attribute__((aligned(CLINE)));
+
+    // Segment of nid: [ring_meta_t * num_rings][ring * num_rings], ring index = src_nid * num_threads + tid
+    inline int GetRingIndex(int src_nid, int tid) {
+        return src_nid * config_->global_num_threads + tid;
+    }
+
+    inline ring_meta_t* GetRingMeta(int nid, int src_nid, int tid) {
+        return reinterpret_cast<ring_meta_t*>(segments_[nid]) + GetRingIndex(src_nid, tid);
+    }
+
+    inline char* GetRing(int nid, int src_nid, int tid) {
+        return segments_[nid] + num_rings_ * sizeof(ring_meta_t) + GetRingIndex(src_nid, tid) * ring_sz_;
+    }
+
+    string GetSegmentName(const Node & node);
+    // Write the framed msg into the ring of (dst_nid, dst_tid). Returns false if the ring is full
+    bool WriteRing(int dst_nid, int dst_tid, ibinstream & stream);
+    // Read a msg of tid from co-located worker src_nid. Returns false if the ring is empty
+    bool ReadRing(int tid, int src_nid, Message & msg);
+    bool TryRecvShm(int tid, Message & msg);
+
+    Node & node_;
+    Config * config_;
+    AbstractMailbox * inner_;
+
+    // co-located workers, excluding this worker
+    vector<int> colocated_nids_;
+    vector<bool> is_colocated_;
+
+    // mapped segments of this worker and co-located workers, indexed by nid
+    vector<char*> segments_;
+    uint64_t segment_sz_;
+    uint64_t ring_sz_;
+    int num_rings_;
+
+    vector<vector<pending_data_t>> pending_msgs_;
+    // bytes of pending_msgs_[tid]
+    vector<uint64_t> pending_bytes_;
+    pthread_spinlock_t *recv_locks_ = nullptr;
+    scheduler_t *schedulers_ = nullptr;
+};
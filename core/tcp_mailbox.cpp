@@ -15,6 +15,35 @@
 #include "core/tcp_mailbox.hpp"
 
 TCPMailbox::~TCPMailbox() {
+    if (config_->tcp_mux_channels > 0) {
+        mux_stop_ = true;
+        for (auto q : mux_send_queues_)
+            q->push(MuxFrame{-1, nullptr});
+        for (auto &t : mux_threads_)
+            t.join();
+
+        for (auto &batches : mux_batches_)
+            for (auto b : batches)
+                delete b;
+        for (auto q : mux_send_queues_)
+            delete q;
+        for (auto &senders : mux_senders_)
+            for (auto s : senders)
+                delete s;
+        for (auto r : mux_receivers_)
+            delete r;
+
+        if (remote_msgs_ != nullptr) {
+            MuxRecvItem item;
+            for (int i = 0; i < config_->global_num_threads; i++) {
+                while (remote_msgs_[i]->try_pop(item))
+                    delete[] item.buf;
+                delete remote_msgs_[i];
+            }
+            free(remote_msgs_);
+        }
+    }
+
     for (auto &r : receivers_)
         if (r != NULL) delete r;
 
@@ -55,8 +84,12 @@ void TCPMailbox::Init(vector<Node> &nodes) {
 
 
 
+    if (config_->tcp_mux_channels > 0) {
+        InitMux(nodes);
+    }
+
     //The regular senders for threads[0, global_num_workers), by using constant +1 to distinguish with above channels (i.e., +2)
-    for (int nid = 0; nid < config_->global_num_workers; nid++) {
+    for (int nid = 0; nid < config_->global_num_workers && config_->tcp_mux_channels == 0; nid++) {
         Node &r_node = GetNodeById(nodes, nid + 1);
         string ibname = r_node.ibname;
 
@@ -73,8 +106,8 @@ void TCPMailbox::Init(vector<Node> &nodes) {
         }
     }
 
-    receivers_.resize(config_->global_num_threads);
-    for (int tid = 0; tid < config_->global_num_threads; tid++) {
+    receivers_.resize(config_->global_num_threads, NULL);
+    for (int tid = 0; tid < config_->global_num_threads && config_->tcp_mux_channels == 0; tid++) {
         receivers_[tid] = new zmq::socket_t(context, ZMQ_PULL);
         char addr[64] = "";
         snprintf(addr, sizeof(addr), "tcp://*:%d",
@@ -105,11 +138,150 @@ void TCPMailbox::Init(vector<Node> &nodes) {
     rr_size = 3;
 
     pthread_spin_init(&send_notification_lock_, 0);
+
+    RegisterMetrics();
+}
+
+void TCPMailbox::RegisterMetrics() {
+    MetricsRegistry* registry = MetricsRegistry::GetInstance();
+    registry->RegisterGauge("gtran_mailbox_local_queue_depth", "Msgs received but not yet processed, by thread",
+                            [this](vector<pair<string, double>>& samples) {
+        for (int i = 0; i < config_->global_num_threads; i++) {
+            double depth = local_msgs[i]->Size();
+            if (config_->tcp_mux_channels > 0)
+                depth += remote_msgs_[i]->unsafe_size();
+            samples.emplace_back("tid=\"" + to_string(i) + "\"", depth);
+        }
+    });
+    if (config_->tcp_mux_channels == 0)
+        return;
+    registry->RegisterGauge("gtran_mailbox_mux_send_queue_depth", "Frames waiting for the I/O thread, by channel",
+                            [this](vector<pair<string, double>>& samples) {
+        for (int c = 0; c < config_->tcp_mux_channels; c++)
+            samples.emplace_back("channel=\"" + to_string(c) + "\"", mux_send_queues_[c]->size());
+    });
+}
+
+// Ports of channels reuse the ports of per-thread receivers, i.e., tcp_port + 1 + channel
+void TCPMailbox::InitMux(vector<Node> & nodes) {
+    int num_channels = config_->tcp_mux_channels;
+
+    mux_receivers_.resize(num_channels);
+    for (int c = 0; c < num_channels; c++) {
+        mux_receivers_[c] = new zmq::socket_t(context, ZMQ_PULL);
+        // wake up periodically to check mux_stop_
+        int timeout_ms = 100;
+        mux_receivers_[c]->setsockopt(ZMQ_RCVTIMEO, &timeout_ms, sizeof(timeout_ms));
+        char addr[64] = "";
+        snprintf(addr, sizeof(addr), "tcp://*:%d", my_node_.tcp_port + 1 + c);
+        mux_receivers_[c]->bind(addr);
+        DLOG(INFO) << "[TCPMailbox::InitMux] Worker " << my_node_.hostname << " binds " << string(addr);
+    }
+
+    mux_senders_.resize(num_channels);
+    mux_send_queues_.resize(num_channels);
+    for (int c = 0; c < num_channels; c++) {
+        mux_senders_[c].resize(config_->global_num_workers, NULL);
+        for (int nid = 0; nid < config_->global_num_workers; nid++) {
+            if (nid == my_node_.get_local_rank())
+                continue;
+            Node &r_node = GetNodeById(nodes, nid + 1);
+            mux_senders_[c][nid] = new zmq::socket_t(context, ZMQ_PUSH);
+            char addr[64] = "";
+            snprintf(addr, sizeof(addr), "tcp://%s:%d", r_node.ibname.c_str(), r_node.tcp_port + 1 + c);
+            mux_senders_[c][nid]->connect(addr);
+            DLOG(INFO) << "[TCPMailbox::InitMux] Worker " << my_node_.hostname << " connect to " << string(addr);
+        }
+        mux_send_queues_[c] = new tbb::concurrent_bounded_queue<MuxFrame>();
+    }
+
+    mux_batches_.resize(config_->global_num_threads + Config::extra_send_buf_count,
+                        vector<ibinstream*>(config_->global_num_workers, nullptr));
+
+    remote_msgs_ = reinterpret_cast<tbb::concurrent_queue<MuxRecvItem> **>(
+                malloc(sizeof(tbb::concurrent_queue<MuxRecvItem>*) * config_->global_num_threads));
+    for (int i = 0; i < config_->global_num_threads; i++) {
+        remote_msgs_[i] = new tbb::concurrent_queue<MuxRecvItem>();
+    }
+
+    // sockets are created above, and then only used by the I/O threads
+    for (int c = 0; c < num_channels; c++) {
+        mux_threads_.emplace_back(&TCPMailbox::MuxSendLoop, this, c);
+        mux_threads_.emplace_back(&TCPMailbox::MuxRecvLoop, this, c);
+    }
+}
+
+void TCPMailbox::FreeMuxFrame(void* data, void* hint) {
+    delete reinterpret_cast<ibinstream*>(hint);
+}
+
+void TCPMailbox::FlushMuxBatch(int tid, int dst_nid) {
+    ibinstream*& batch = mux_batches_[tid][dst_nid];
+    if (batch == nullptr)
+        return;
+    mux_send_queues_[tid % config_->tcp_mux_channels]->push(MuxFrame{dst_nid, batch});
+    batch = nullptr;
+}
+
+void TCPMailbox::MuxSendLoop(int channel) {
+    MuxFrame frame;
+    while (true) {
+        mux_send_queues_[channel]->pop(frame);
+        if (frame.dst_nid < 0)
+            return;
+
+        // the stream is released by zmq after sending
+        zmq::message_t zmq_msg(frame.stream->get_buf(), frame.stream->size(), FreeMuxFrame, frame.stream);
+        CHECK(mux_senders_[channel][frame.dst_nid]->send(zmq_msg))
+            << "[TCPMailbox::MuxSendLoop] send failed: " << strerror(errno);
+    }
+}
+
+void TCPMailbox::MuxRecvLoop(int channel) {
+    while (!mux_stop_) {
+        zmq::message_t zmq_msg;
+        if (!mux_receivers_[channel]->recv(&zmq_msg))
+            continue;  // timeout
+
+        const char* frame = reinterpret_cast<const char*>(zmq_msg.data());
+        size_t pos = 0;
+        while (pos < zmq_msg.size()) {
+            MuxMsgHeader header;
+            memcpy(&header, frame + pos, sizeof(MuxMsgHeader));
+            pos += sizeof(MuxMsgHeader);
+
+            MuxRecvItem item;
+            item.buf = new char[header.size];
+            item.size = header.size;
+            memcpy(item.buf, frame + pos, header.size);
+            pos += header.size;
+
+            remote_msgs_[header.recver_tid]->push(item);
+        }
+    }
 }
 
 int TCPMailbox::Send(int tid, const Message & msg) {
     if (msg.meta.recver_nid == my_node_.get_local_rank()) {
         local_msgs[msg.meta.recver_tid]->Push(msg);
+    } else if (config_->tcp_mux_channels > 0) {
+        int dst_nid = msg.meta.recver_nid;
+        ibinstream*& batch = mux_batches_[tid][dst_nid];
+        if (batch == nullptr)
+            batch = new ibinstream();
+
+        // serialize msg into the batch directly, and fill the header after that
+        size_t header_pos = batch->size();
+        MuxMsgHeader header;
+        header.recver_tid = msg.meta.recver_tid;
+        batch->raw_bytes(&header, sizeof(MuxMsgHeader));
+        *batch << msg;
+        CHECK_LE(batch->size() - header_pos - sizeof(MuxMsgHeader), UINT32_MAX);
+        header.size = batch->size() - header_pos - sizeof(MuxMsgHeader);
+        memcpy(batch->get_buf() + header_pos, &header, sizeof(MuxMsgHeader));
+
+        if (batch->size() >= MUX_BATCH_SZ)
+            FlushMuxBatch(tid, dst_nid);
     } else {
         int pcode = port_code(msg.meta.recver_nid, msg.meta.recver_tid);
 
@@ -144,6 +316,21 @@ bool TCPMailbox::TryRecv(int tid, Message & msg) {
         }
     }
 
+    if (config_->tcp_mux_channels > 0) {
+        MuxRecvItem item;
+        if (remote_msgs_[tid]->try_pop(item)) {
+            obinstream um(item.buf, item.size);
+            um >> msg;
+            return true;
+        }
+
+        if (type == 0 && local_msgs[tid]->Size() != 0) {
+            local_msgs[tid]->WaitAndPop(msg);
+            return true;
+        }
+        return false;
+    }
+
     // Try tcp recv
     zmq::message_t zmq_msg;
     obinstream um;
@@ -186,4 +373,9 @@ void TCPMailbox::RecvNotification(obinstream &out) {
 }
 
 void TCPMailbox::Recv(int tid, Message & msg) { return; }
-void TCPMailbox::Sweep(int tid) { return; }
+void TCPMailbox::Sweep(int tid) {
+    if (config_->tcp_mux_channels == 0)
+        return;
+    for (int nid = 0; nid < config_->global_num_workers; nid++)
+        FlushMuxBatch(tid, nid);
+}
@@ -17,12 +17,15 @@
 #include <errno.h>
 #include <pthread.h>
 #include <string.h>
+#include <tbb/concurrent_queue.h>
 #include <tbb/concurrent_unordered_map.h>
 #include <unistd.h>
+#include <atomic>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -30,6 +33,7 @@
 #include "base/thread_safe_queue.hpp"
 #include "core/abstract_mailbox.hpp"
 #include "core/message.hpp"
+#include "utils/metrics.hpp"
 #include "utils/simple_spinlock_guard.hpp"
 #include "utils/zmq.hpp"
 
@@ -72,8 +76,55 @@ class TCPMailbox : public AbstractMailbox {
 
     pthread_spinlock_t send_notification_lock_;
 
+    /* Multiplexed mode, enabled by TCP_MUX_CHANNELS > 0:
+     *   Threads send to a worker over TCP_MUX_CHANNELS connections (channel = tid % TCP_MUX_CHANNELS),
+     *   instead of one connection per remote thread.
+     *   Messages from a thread to the same worker are appended into one batch, each with a MuxMsgHeader.
+     *   The batch is flushed as one zmq frame when it exceeds MUX_BATCH_SZ, or in Sweep.
+     *   Each channel has an I/O thread sending frames without copy, and an I/O thread splitting received frames.
+     *   They exchange data with expert threads by concurrent queues.
+     */
+    struct MuxMsgHeader {
+        uint32_t recver_tid;
+        uint32_t size;  // size of the serialized msg after the header
+    };
+
+    struct MuxFrame {
+        int dst_nid;  // -1 to stop the sender thread
+        ibinstream* stream;
+    };
+
+    struct MuxRecvItem {
+        char* buf;
+        size_t size;
+    };
+
+    static const size_t MUX_BATCH_SZ = 64 * 1024;
+
+    // [tid][dst_nid], only accessed by the thread of tid
+    vector<vector<ibinstream*>> mux_batches_;
+    // [channel], frames to send
+    vector<tbb::concurrent_bounded_queue<MuxFrame>*> mux_send_queues_;
+    // [channel][dst_nid]
+    vector<socket_vector> mux_senders_;
+    // [channel]
+    socket_vector mux_receivers_;
+    // [tid], received msgs
+    tbb::concurrent_queue<MuxRecvItem>** remote_msgs_ = nullptr;
+    vector<thread> mux_threads_;
+    atomic<bool> mux_stop_;
+
+    void InitMux(vector<Node> & nodes);
+    void FlushMuxBatch(int tid, int dst_nid);
+    void MuxSendLoop(int channel);
+    void MuxRecvLoop(int channel);
+    static void FreeMuxFrame(void* data, void* hint);
+
+    // Queue depths, collected on export
+    void RegisterMetrics();
+
  public:
-    TCPMailbox(Node & my_node) : my_node_(my_node), context(1) {
+    TCPMailbox(Node & my_node) : my_node_(my_node), context(1), mux_stop_(false) {
         config_ = Config::GetInstance();
     }
 
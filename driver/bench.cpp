@@ -0,0 +1,349 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "driver/bench.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include "utils/timer.hpp"
+
+#include "glog/logging.h"
+
+using namespace std;
+
+bool ParamGenerator::Parse(const string& spec, string& error_msg) {
+    istringstream iss(spec);
+    string type;
+    iss >> type;
+    if (type == "uniform") {
+        type_ = UNIFORM;
+        if (!(iss >> min_ >> max_) || min_ > max_) {
+            error_msg = "expect uniform <min> <max>";
+            return false;
+        }
+    } else if (type == "zipf") {
+        type_ = ZIPF;
+        if (!(iss >> min_ >> max_ >> theta_) || min_ > max_ || theta_ <= 0 || theta_ >= 1) {
+            error_msg = "expect zipf <min> <max> <theta>, with 0 < theta < 1";
+            return false;
+        }
+        uint64_t n = max_ - min_ + 1;
+        zetan_ = 0;
+        for (uint64_t i = 1; i <= n; i++)
+            zetan_ += 1.0 / pow(i, theta_);
+        double zeta2 = 1 + 1.0 / pow(2, theta_);
+        alpha_ = 1.0 / (1.0 - theta_);
+        eta_ = (1 - pow(2.0 / n, 1 - theta_)) / (1 - zeta2 / zetan_);
+    } else if (type == "file") {
+        type_ = FILE;
+        string path;
+        iss >> path;
+        ifstream in(path);
+        string line;
+        while (getline(in, line)) {
+            if (!line.empty())
+                values_.emplace_back(line);
+        }
+        if (values_.empty()) {
+            error_msg = "cannot read values from " + path;
+            return false;
+        }
+    } else {
+        error_msg = "unexpected generator " + type;
+        return false;
+    }
+    return true;
+}
+
+uint64_t ParamGenerator::NextZipf(mt19937_64& rng) {
+    uint64_t n = max_ - min_ + 1;
+    double u = uniform_real_distribution<double>(0, 1)(rng);
+    double uz = u * zetan_;
+    if (uz < 1)
+        return 1;
+    if (uz < 1 + pow(0.5, theta_))
+        return 2;
+    return 1 + static_cast<uint64_t>(n * pow(eta_ * u - eta_ + 1, alpha_));
+}
+
+string ParamGenerator::Next(mt19937_64& rng) {
+    switch (type_) {
+      case UNIFORM:
+        return to_string(uniform_int_distribution<int64_t>(min_, max_)(rng));
+      case ZIPF:
+        return to_string(min_ + static_cast<int64_t>(NextZipf(rng)) - 1);
+      case FILE:
+        return values_[uniform_int_distribution<size_t>(0, values_.size() - 1)(rng)];
+    }
+    return "";
+}
+
+string BenchTrxType::Generate(mt19937_64& rng) {
+    string result = query;
+    // replace $P10 before $P1
+    for (int i = params.size() - 1; i >= 0; i--) {
+        string marker = "$P" + to_string(i);
+        string value = params[i].Next(rng);
+        size_t pos;
+        while ((pos = result.find(marker)) != string::npos)
+            result.replace(pos, marker.size(), value);
+    }
+    return result;
+}
+
+bool Bench::ParseWorkload(const string& fname, string& error_msg) {
+    ifstream in(fname);
+    if (!in.is_open()) {
+        error_msg = "cannot open " + fname;
+        return false;
+    }
+
+    string line;
+    int line_no = 0;
+    while (getline(in, line)) {
+        line_no++;
+        istringstream iss(line);
+        string key;
+        if (!(iss >> key) || key[0] == '#')
+            continue;
+
+        bool success = true;
+        if (key == "mode") {
+            string mode;
+            success = static_cast<bool>(iss >> mode) && (mode == "open" || mode == "closed");
+            open_loop_ = mode == "open";
+        } else if (key == "arrival") {
+            string arrival;
+            success = static_cast<bool>(iss >> arrival) && (arrival == "uniform" || arrival == "poisson");
+            poisson_ = arrival == "poisson";
+        } else if (key == "rate") {
+            success = static_cast<bool>(iss >> rate_) && rate_ > 0;
+        } else if (key == "concurrency") {
+            success = static_cast<bool>(iss >> concurrency_) && concurrency_ > 0;
+        } else if (key == "warmup") {
+            success = static_cast<bool>(iss >> warmup_sec_) && warmup_sec_ >= 0;
+        } else if (key == "duration") {
+            success = static_cast<bool>(iss >> duration_sec_) && duration_sec_ > 0;
+        } else if (key == "seed") {
+            success = static_cast<bool>(iss >> seed_);
+        } else if (key == "output") {
+            success = static_cast<bool>(iss >> output_);
+        } else if (key == "trx") {
+            BenchTrxType type;
+            success = static_cast<bool>(iss >> type.name >> type.weight) && type.weight >= 0;
+            getline(iss, type.query);
+            type.query.erase(0, type.query.find_first_not_of(" \t"));
+            success = success && !type.query.empty();
+            types_.emplace_back(move(type));
+        } else if (key == "param") {
+            string name, spec;
+            int index;
+            success = static_cast<bool>(iss >> name >> index) && index >= 0;
+            getline(iss, spec);
+            auto itr = find_if(types_.begin(), types_.end(), [&](const BenchTrxType& t) {return t.name == name;});
+            if (success && itr == types_.end()) {
+                error_msg = "line " + to_string(line_no) + ": trx " + name + " is not defined before";
+                return false;
+            }
+            if (success) {
+                if (itr->params.size() <= index)
+                    itr->params.resize(index + 1);
+                success = itr->params[index].Parse(spec, error_msg);
+            }
+        } else {
+            error_msg = "line " + to_string(line_no) + ": unexpected option " + key;
+            return false;
+        }
+
+        if (!success) {
+            error_msg = "line " + to_string(line_no) + ": invalid " + key + (error_msg.empty() ? "" : ", " + error_msg);
+            return false;
+        }
+    }
+
+    if (types_.empty()) {
+        error_msg = "no trx is defined";
+        return false;
+    }
+    for (auto& type : types_) {
+        for (int i = 0; i < type.params.size(); i++) {
+            if (type.query.find("$P" + to_string(i)) == string::npos) {
+                error_msg = "$P" + to_string(i) + " is not used in trx " + type.name;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void Bench::Run(AsyncClient& client) {
+    mt19937_64 rng(seed_);
+    vector<double> weights;
+    for (auto& type : types_)
+        weights.emplace_back(type.weight);
+    discrete_distribution<int> type_dist(weights.begin(), weights.end());
+    exponential_distribution<double> interval_dist(rate_);
+
+    uint64_t start = timer::get_usec();
+    uint64_t measure_start = start + warmup_sec_ * 1000000ull;
+    uint64_t end = measure_start + duration_sec_ * 1000000ull;
+    double next_arrival = start;
+
+    cout << "[Bench] " << (open_loop_ ? "open" : "closed") << " loop, warm-up " << warmup_sec_
+         << " s, measurement " << duration_sec_ << " s" << endl;
+
+    while (true) {
+        uint64_t intended;
+        if (open_loop_) {
+            intended = static_cast<uint64_t>(next_arrival);
+            if (intended >= end)
+                break;
+            next_arrival += poisson_ ? interval_dist(rng) * 1000000 : 1000000 / rate_;
+
+            // sleep for long waits, and spin for short ones
+            uint64_t now = timer::get_usec();
+            if (intended > now + 100)
+                this_thread::sleep_for(chrono::microseconds(intended - now - 50));
+            while (timer::get_usec() < intended) {}
+        } else {
+            unique_lock<mutex> lock(mutex_);
+            cv_.wait(lock, [&] {return inflight_ < concurrency_;});
+            intended = timer::get_usec();
+            if (intended >= end)
+                break;
+        }
+
+        BenchTrxType& type = types_[type_dist(rng)];
+        string query = type.Generate(rng);
+        bool measured = intended >= measure_start;
+        {
+            lock_guard<mutex> lock(mutex_);
+            inflight_++;
+        }
+        submitted_++;
+
+        uint64_t submit_time = timer::get_usec();
+        client.Submit(query, [this, &type, intended, submit_time, measured](AsyncReply& reply) {
+            uint64_t now = timer::get_usec();
+            {
+                lock_guard<mutex> lock(mutex_);
+                if (measured && reply.status == TRX_STAT::ABORT) {
+                    type.aborted++;
+                } else if (measured) {
+                    type.completed++;
+                    type.response.Record(now - intended);
+                    type.service.Record(now - submit_time);
+                    type.server.Record(reply.time);
+                }
+                inflight_--;
+            }
+            cv_.notify_all();
+        });
+    }
+
+    // Wait for transactions in flight
+    unique_lock<mutex> lock(mutex_);
+    if (!cv_.wait_for(lock, chrono::seconds(60), [&] {return inflight_ == 0;})) {
+        LOG(WARNING) << "[Bench] " << inflight_ << " transactions are not finished in 60 seconds";
+    }
+    unfinished_ = inflight_;
+    elapsed_sec_ = duration_sec_;
+}
+
+namespace {
+
+void PrintJsonHistogram(ostream& out, const string& name, const HdrHistogram& h) {
+    out << "\"" << name << "\": {\"count\": " << h.Count() << ", \"mean\": " << h.Mean()
+        << ", \"min\": " << h.Min() << ", \"p50\": " << h.ValueAtPercentile(50)
+        << ", \"p90\": " << h.ValueAtPercentile(90) << ", \"p99\": " << h.ValueAtPercentile(99)
+        << ", \"p999\": " << h.ValueAtPercentile(99.9) << ", \"max\": " << h.Max() << "}";
+}
+
+}  // namespace
+
+void Bench::Report() {
+    lock_guard<mutex> lock(mutex_);
+
+    cout << endl << "[Bench] submitted " << submitted_ << ", unfinished " << unfinished_ << endl;
+    cout << left << setw(16) << "trx" << setw(10) << "phase" << setw(12) << "trx/s" << setw(12) << "abort/s"
+         << setw(10) << "p50(us)" << setw(10) << "p90(us)" << setw(10) << "p99(us)"
+         << setw(10) << "p999(us)" << setw(10) << "max(us)" << endl;
+    for (auto& type : types_) {
+        vector<pair<string, const HdrHistogram*>> phases = {
+            {"response", &type.response}, {"service", &type.service}, {"server", &type.server}};
+        for (auto& phase : phases) {
+            cout << left << setw(16) << type.name << setw(10) << phase.first
+                 << setw(12) << fixed << setprecision(1) << type.completed / elapsed_sec_
+                 << setw(12) << type.aborted / elapsed_sec_
+                 << setw(10) << phase.second->ValueAtPercentile(50) << setw(10) << phase.second->ValueAtPercentile(90)
+                 << setw(10) << phase.second->ValueAtPercentile(99) << setw(10) << phase.second->ValueAtPercentile(99.9)
+                 << setw(10) << phase.second->Max() << endl;
+        }
+    }
+
+    if (output_.empty())
+        return;
+
+    ofstream out(output_);
+    CHECK(out.is_open()) << "[Bench] cannot write " << output_;
+    out << "{\"mode\": \"" << (open_loop_ ? "open" : "closed") << "\", \"rate\": " << rate_
+        << ", \"arrival\": \"" << (poisson_ ? "poisson" : "uniform") << "\", \"concurrency\": " << concurrency_
+        << ", \"warmup_sec\": " << warmup_sec_ << ", \"duration_sec\": " << duration_sec_ << ", \"seed\": " << seed_
+        << ", \"submitted\": " << submitted_ << ", \"unfinished\": " << unfinished_ << ", \"trx\": [";
+    for (int i = 0; i < types_.size(); i++) {
+        BenchTrxType& type = types_[i];
+        out << (i == 0 ? "" : ", ") << "{\"name\": \"" << type.name << "\", \"weight\": " << type.weight
+            << ", \"completed\": " << type.completed << ", \"throughput\": " << type.completed / elapsed_sec_
+            << ", \"aborted\": " << type.aborted << ", \"abort_throughput\": " << type.aborted / elapsed_sec_
+            << ", \"latency_us\": {";
+        PrintJsonHistogram(out, "response", type.response);
+        out << ", ";
+        PrintJsonHistogram(out, "service", type.service);
+        out << ", ";
+        PrintJsonHistogram(out, "server", type.server);
+        out << "}}";
+    }
+    out << "]}" << endl;
+    cout << "[Bench] results are written to " << output_ << endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        cout << "Usage: " << argv[0] << " <cfg_file> <workload_file>" << endl;
+        return 0;
+    }
+
+    google::InitGoogleLogging(argv[0]);
+
+    Bench bench;
+    string error_msg;
+    if (!bench.ParseWorkload(argv[2], error_msg)) {
+        cout << "[Bench] invalid workload: " << error_msg << endl;
+        return 1;
+    }
+
+    AsyncClient client(argv[1]);
+    client.Init();
+    bench.Run(client);
+    bench.Report();
+    return 0;
+}
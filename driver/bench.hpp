@@ -0,0 +1,115 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BENCH_HPP_
+#define BENCH_HPP_
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "base/async_client.hpp"
+#include "utils/hdr_histogram.hpp"
+
+/*
+Benchmark driver with AsyncClient.
+-----------------------------------------------------------------------------------
+Workload file (one option per line, lines starting with # are skipped):
+    mode <open|closed>              open: transactions arrive at a fixed rate, regardless of replies
+                                    closed: keep <concurrency> transactions in flight
+    rate <trx per second>           for open mode
+    arrival <uniform|poisson>       interval between arrivals in open mode, uniform by default
+    concurrency <n>                 for closed mode
+    warmup <seconds>                transactions arriving in warm-up are not recorded
+    duration <seconds>              length of the measurement window
+    seed <n>
+    output <file>                   results in JSON
+    trx <name> <weight> <query>     a transaction type, the query (until the end of line) may refer to $P0, $P1, ...
+    param <name> <index> <generator>
+        generator of $P<index> in transaction <name>:
+            uniform <min> <max>
+            zipf <min> <max> <theta>    rank 1 (the most frequent) is <min>, 0 < theta < 1
+            file <path>                 a random line of <path>
+-----------------------------------------------------------------------------------
+Latency is recorded per transaction type in three phases:
+    response: from the intended arrival time to the reply. In open mode, it includes the time waiting for the driver,
+              thus is free of coordinated omission.
+    service:  from submitting to the reply
+    server:   processing time on the worker
+*/
+
+class ParamGenerator {
+ public:
+    bool Parse(const std::string& spec, std::string& error_msg);
+    std::string Next(std::mt19937_64& rng);
+
+ private:
+    enum Type { UNIFORM, ZIPF, FILE };
+    Type type_;
+    int64_t min_, max_;
+    std::vector<std::string> values_;
+
+    // zipf in Gray et al., Quickly Generating Billion-Record Synthetic Databases
+    double theta_, zetan_, alpha_, eta_;
+    uint64_t NextZipf(std::mt19937_64& rng);
+};
+
+struct BenchTrxType {
+    std::string name;
+    double weight;
+    std::string query;
+    std::vector<ParamGenerator> params;
+
+    uint64_t completed = 0;  // committed
+    uint64_t aborted = 0;
+    // Latencies of committed transactions only
+    HdrHistogram response, service, server;
+
+    std::string Generate(std::mt19937_64& rng);
+};
+
+class Bench {
+ public:
+    bool ParseWorkload(const std::string& fname, std::string& error_msg);
+    void Run(AsyncClient& client);
+    void Report();
+
+ private:
+    bool open_loop_ = true;
+    bool poisson_ = false;
+    double rate_ = 1000;
+    int concurrency_ = 16;
+    int warmup_sec_ = 10;
+    int duration_sec_ = 60;
+    uint64_t seed_ = 1;
+    std::string output_;
+
+    std::vector<BenchTrxType> types_;
+
+    // statistics of the run
+    uint64_t submitted_ = 0;
+    uint64_t unfinished_ = 0;
+    double elapsed_sec_ = 0;
+
+    // guards statistics in types_ and inflight_, updated by the thread receiving replies
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int inflight_ = 0;
+};
+
+#endif  // BENCH_HPP_
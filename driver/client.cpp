@@ -45,7 +45,6 @@ void Client::RequestWorker() {
 
 string Client::CommitQuery(string query) {
     ibinstream m;
-    obinstream um;
 
     char hostname[HOST_NAME_MAX];
     gethostname(hostname, HOST_NAME_MAX);
@@ -56,6 +55,27 @@ string Client::CommitQuery(string query) {
     cc_.Send(handler_, m);
     cout << "[Client] Client posts the query to worker_node" << handler_ - 1 << endl << endl;
 
+    return RecvResult("Query '" + query + "'");
+}
+
+string Client::CommitIngestBatch(const IngestBatch& batch, const string& fname) {
+    ibinstream m;
+
+    char hostname[HOST_NAME_MAX];
+    gethostname(hostname, HOST_NAME_MAX);
+    string host_str(hostname);
+    m << host_str;
+    m << string("ingest");
+    m << batch;
+
+    cc_.Send(handler_, m);
+    cout << "[Client] Client posts the ingestion batch to worker_node" << handler_ - 1 << endl << endl;
+
+    return RecvResult("Ingest '" + fname + "'");
+}
+
+string Client::RecvResult(const string& title) {
+    obinstream um;
     cc_.Recv(handler_, um);
 
     string result;
@@ -66,12 +86,10 @@ string Client::CommitQuery(string query) {
     um >> values;
     um >> time_;
 
-    result = "";
+    result = title + " result: \n";
     if (values.size() == 0) {
-        result = "Query '" + query + "' result: \n";
         result += "=>Empty\n";
     } else {
-        result = "Query '" + query + "' result: \n";
         for (auto& v : values) {
             result += "=>" + v.DebugString() + "\n";
         }
@@ -111,6 +129,8 @@ void Client::print_help() {
     cout << "    help config         display help infomation for setting config" << endl;
     cout << "    help emu            display help infomation for running emulation of througput test" << endl;
     cout << "    help status         display help infomation for displaying system status" << endl;
+    cout << "    help prepare        display help infomation for prepared transactions" << endl;
+    cout << "    help ingest         display help infomation for bulk ingestion" << endl;
     cout << "    quit                quit from console" << endl;
     cout << "    gtran <args>       run Gremlin-Like queries" << endl;
     cout << "        -q <query> [<args>] a single query input by user" << endl;
@@ -202,12 +222,50 @@ void Client::print_display_status_help() {
     cout << "Available status keys:" << endl;
     cout << "    mem: Display memory info of containers " << endl;
     cout << "    gc: Display dependent gc tasks' status " << endl;
+    cout << "    index: Display progress of index building " << endl;
+    cout << "    metrics: Display runtime metrics in Prometheus text format " << endl;
     cout << endl;
     cout << "Example:" << endl;
     cout << "    gtran -q DisplayStatus(mem)" << endl;
     cout << endl;
 }
 
+void Client::print_prepare_help() {
+    cout << endl;
+    cout << "Help information for prepared transactions:" << endl;
+    cout << "Usage:" << endl;
+    cout << "    prepare <transaction with bind markers $1, $2, ...>" << endl;
+    cout << "    execute <statement_id>(<param1>, <param2>, ...)" << endl;
+    cout << endl;
+    cout << "Bind markers are allowed as values of has, hasValue, is and property steps." << endl;
+    cout << "The statement id is returned by prepare, after the transaction is prepared on all workers." << endl;
+    cout << "Least recently used statements are evicted when PREPARED_CACHE_SIZE is exceeded, and should be prepared again." << endl;
+    cout << endl;
+    cout << "Example:" << endl;
+    cout << "    gtran -q prepare g.V().has(\"firstName\",$1).values(\"lastName\")" << endl;
+    cout << "    gtran -q execute <statement_id>(\"Jack\")" << endl;
+    cout << endl;
+}
+
+void Client::print_ingest_help() {
+    cout << endl;
+    cout << "Help information for bulk ingestion:" << endl;
+    cout << "Usage:" << endl;
+    cout << "    ingest <file>" << endl;
+    cout << endl;
+    cout << "Each line of the file adds a vertex or an edge:" << endl;
+    cout << "    v <label> [<key> <value>]..." << endl;
+    cout << "    e <src> <dst> <label> [<key> <value>]..." << endl;
+    cout << "<src> and <dst> are $<i> for the i-th vertex in the file (from 0), or vids of existing vertices." << endl;
+    cout << "The whole file is committed as one transaction, and vids of new vertices are returned." << endl;
+    cout << endl;
+    cout << "Example:" << endl;
+    cout << "    v person name \"marko\" age 29" << endl;
+    cout << "    v software name \"lop\"" << endl;
+    cout << "    e $0 $1 created weight 0.4" << endl;
+    cout << endl;
+}
+
 bool Client::trim_str(string& str) {
     size_t pos = str.find_first_not_of(" \t");  // trim blanks from head
     if (pos == string::npos) return false;
@@ -279,6 +337,16 @@ void Client::run_console(string query_fname) {
             continue;
         }
 
+        if (cmd == "help prepare") {
+            print_prepare_help();
+            continue;
+        }
+
+        if (cmd == "help ingest") {
+            print_ingest_help();
+            continue;
+        }
+
         // General usage
         if (cmd == "help" || cmd == "h") {
           print_help();
@@ -427,6 +495,25 @@ void Client::run_console(string query_fname) {
                 cout << "[Client] result: " << result << endl << endl;
               }
             }
+          } else if (token == "ingest") {
+            string fname;
+            if (!(cmd_ss >> fname)) goto failed;
+
+            ifstream file(fname.c_str());
+            if (!file) {
+              cout << "[Client][ERROR]: " << fname << " does not exist." << endl << endl;
+              goto next;
+            }
+
+            IngestBatch batch;
+            string error_msg;
+            if (!batch.ParseText(file, error_msg)) {
+              cout << "[Client][ERROR]: " << error_msg << endl << endl;
+              goto next;
+            }
+
+            RequestWorker();
+            cout << "[Client] result: " << CommitIngestBatch(batch, fname) << endl << endl;
           } else {  // if token != "gtran"
         failed:
             cout << "[Client][ERROR]: Failed to run the command: " << cmd << endl << endl;
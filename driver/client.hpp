@@ -32,6 +32,7 @@
 #include "utils/global.hpp"
 #include "utils/timer.hpp"
 #include "core/message.hpp"
+#include "layout/ingest_batch.hpp"
 
 #include "glog/logging.h"
 
@@ -55,6 +56,8 @@ class Client{
 
     void RequestWorker();
     string CommitQuery(string query);
+    string CommitIngestBatch(const IngestBatch& batch, const string& fname);
+    string RecvResult(const string& title);
 
     void run_query(string query, string& result, bool isBatch);
 
@@ -63,6 +66,8 @@ class Client{
     static void print_set_config_help();
     static void print_run_emu_help();
     static void print_display_status_help();
+    static void print_prepare_help();
+    static void print_ingest_help();
     static bool trim_str(string& str);
 };
 
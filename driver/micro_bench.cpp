@@ -0,0 +1,489 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <math.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/type.hpp"
+#include "core/transaction_status_table.hpp"
+#include "layout/concurrent_mem_pool.hpp"
+#include "layout/layout_type.hpp"
+#include "layout/mvcc_list.hpp"
+#include "layout/mvcc_value_store.hpp"
+#include "layout/property_row_list.hpp"
+#include "layout/topology_row_list.hpp"
+#include "utils/config.hpp"
+#include "utils/perf_counter.hpp"
+#include "utils/tid_pool_manager.hpp"
+#include "utils/timer.hpp"
+#include "utils/tool.hpp"
+
+#include "glog/logging.h"
+
+using namespace std;
+
+/*
+Micro-benchmarks of storage-layer primitives, running in a single process without MPI, HDFS or RDMA.
+-----------------------------------------------------------------------------------
+Usage: micro_bench [<key>=<value>]...
+    bench=all               comma-separated list of: mem_pool, value_store, mvcc_list, topology, property, trx_table
+    threads=1,2,4,8         thread counts to sweep
+    ops=1000000             operations per thread
+    seed=1
+    isolation=serializable  serializable|snapshot, for MVCCList::GetVisibleVersion
+    pool_batch=32           mem_pool: cells got before freeing them
+    value_bytes=16          value_store, property: size of each value_t
+    mvcc_lists=4096         mvcc_list: number of lists, fewer lists means more contention
+    write_ratio=0.05        mvcc_list: ratio of AppendVersion + CommitVersion, others are GetVisibleVersion
+    vertices=100000         topology, property: number of vertices
+    degree=16               topology: average out-degree
+    dist=powerlaw           topology: degree distribution, uniform|powerlaw
+    alpha=2.5               topology: exponent of the power law, > 2
+    props=16                property: properties per vertex
+    trx_table_mb=64         trx_table: size of TransactionStatusTable
+    trx_fill=0.5            trx_table: ratio of occupied slots in main buckets
+-----------------------------------------------------------------------------------
+For each benchmark and thread count, a line is printed with:
+    Mops/s      total throughput
+    items/op    vertices read per ReadConnectedVertex, empty for others
+    abort%      ratio of aborted operations (write-write conflicts or failed reads in mvcc_list)
+    llc-miss/op, l1d-miss/op
+                hardware counters from perf_event_open(2), empty if not permitted (see /proc/sys/kernel/perf_event_paranoid)
+No garbage collector runs in mvcc_list, thus version chains grow by (writes / mvcc_lists) during each run.
+*/
+
+namespace {
+
+map<string, string> options = {
+    {"bench", "all"}, {"threads", "1,2,4,8"}, {"ops", "1000000"}, {"seed", "1"},
+    {"isolation", "serializable"}, {"pool_batch", "32"}, {"value_bytes", "16"},
+    {"mvcc_lists", "4096"}, {"write_ratio", "0.05"}, {"vertices", "100000"}, {"degree", "16"},
+    {"dist", "powerlaw"}, {"alpha", "2.5"}, {"props", "16"}, {"trx_table_mb", "64"}, {"trx_fill", "0.5"}};
+
+vector<int> thread_counts;
+int max_threads;
+uint64_t ops_per_thread;
+uint64_t seed;
+
+// cells taken by thread-local blocks of ConcurrentMemPool and MVCCValueStore, in addition to cells in use
+size_t PoolSize(size_t cells_in_use, int block_size) {
+    return cells_in_use + (max_threads * 3 + 1) * static_cast<size_t>(block_size);
+}
+
+value_t MakeValue(int bytes, uint64_t seq) {
+    string s = to_string(seq);
+    s.resize(bytes, 'x');
+    value_t v;
+    Tool::str2str(s, v);
+    return v;
+}
+
+struct ThreadStat {
+    uint64_t ops = 0;
+    uint64_t items = 0;
+    uint64_t aborts = 0;
+    uint64_t llc_miss = 0;
+    uint64_t l1d_miss = 0;
+    bool perf_valid = false;
+};
+
+typedef function<void(int tid, mt19937_64& rng, ThreadStat& stat)> BenchBody;
+
+void PrintHeader() {
+    cout << left << setw(24) << "bench" << setw(9) << "threads" << setw(11) << "Mops/s" << setw(10) << "items/op"
+         << setw(9) << "abort%" << setw(13) << "llc-miss/op" << setw(13) << "l1d-miss/op" << endl;
+}
+
+// Run body on nthreads threads with tid in [0, nthreads), which start at the same time
+void RunThreads(const string& name, int nthreads, const BenchBody& body) {
+    vector<ThreadStat> stats(nthreads);
+    atomic<int> ready(0);
+    atomic<bool> go(false);
+
+    vector<thread> threads;
+    for (int tid = 0; tid < nthreads; tid++) {
+        threads.emplace_back([&, tid] {
+            TidPoolManager::GetInstance()->Register(TID_TYPE::CONTAINER, tid);
+            mt19937_64 rng(seed * 1000003 + tid);
+            PerfCounter llc_miss, l1d_miss;
+            ThreadStat& stat = stats[tid];
+            stat.perf_valid = llc_miss.Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES)
+                              && l1d_miss.Open(PERF_TYPE_HW_CACHE, PerfCounter::L1DReadMissConfig());
+
+            ready++;
+            while (!go) {}
+
+            llc_miss.Start();
+            l1d_miss.Start();
+            body(tid, rng, stat);
+            llc_miss.Stop();
+            l1d_miss.Stop();
+            stat.llc_miss = llc_miss.Read();
+            stat.l1d_miss = l1d_miss.Read();
+        });
+    }
+
+    while (ready < nthreads) {}
+    uint64_t start = timer::get_usec();
+    go = true;
+    for (auto& t : threads)
+        t.join();
+    double elapsed_sec = (timer::get_usec() - start) / 1e6;
+
+    ThreadStat total;
+    total.perf_valid = true;
+    for (auto& stat : stats) {
+        total.ops += stat.ops;
+        total.items += stat.items;
+        total.aborts += stat.aborts;
+        total.llc_miss += stat.llc_miss;
+        total.l1d_miss += stat.l1d_miss;
+        total.perf_valid = total.perf_valid && stat.perf_valid;
+    }
+
+    double ops = max<uint64_t>(total.ops, 1);
+    cout << left << setw(24) << name << setw(9) << nthreads << fixed << setprecision(3)
+         << setw(11) << total.ops / elapsed_sec / 1e6;
+    if (total.items > 0)
+        cout << setw(10) << setprecision(1) << total.items / ops;
+    else
+        cout << setw(10) << "-";
+    cout << setw(9) << setprecision(2) << 100.0 * total.aborts / ops;
+    if (total.perf_valid)
+        cout << setw(13) << total.llc_miss / ops << setw(13) << total.l1d_miss / ops << endl;
+    else
+        cout << setw(13) << "-" << setw(13) << "-" << endl;
+}
+
+// ConcurrentMemPool::Get/Free, an op is a pair of Get and Free
+struct BenchCell {
+    char data[64];
+};
+
+void BenchMemPool() {
+    int batch = stoi(options["pool_batch"]);
+    auto* pool = ConcurrentMemPool<BenchCell>::GetInstance(
+        nullptr, PoolSize(max_threads * batch, CONCURRENT_MEM_POOL_DEFAULT_BLOCK_SIZE), max_threads, false);
+
+    for (int nthreads : thread_counts) {
+        RunThreads("mem_pool", nthreads, [&](int tid, mt19937_64& rng, ThreadStat& stat) {
+            vector<BenchCell*> cells(batch);
+            for (uint64_t i = 0; i < ops_per_thread; i += batch) {
+                for (int j = 0; j < batch; j++) {
+                    cells[j] = pool->Get(tid);
+                    cells[j]->data[0] = j;
+                }
+                for (int j = 0; j < batch; j++)
+                    pool->Free(cells[j], tid);
+                stat.ops += batch;
+            }
+        });
+    }
+}
+
+// MVCCValueStore::InsertValue/ReadValue/FreeValue, in separated runs
+void BenchValueStore() {
+    int value_bytes = stoi(options["value_bytes"]);
+    size_t cells_per_value = ValueHeader(0, value_bytes + 1).GetCellCount();
+    auto* store = new MVCCValueStore(nullptr, PoolSize(max_threads * ops_per_thread * cells_per_value,
+                                     MVCCValueStore::BLOCK_SIZE), max_threads, false);
+
+    for (int nthreads : thread_counts) {
+        vector<vector<ValueHeader>> headers(nthreads, vector<ValueHeader>(ops_per_thread));
+
+        RunThreads("value_store.insert", nthreads, [&](int tid, mt19937_64& rng, ThreadStat& stat) {
+            value_t value = MakeValue(value_bytes, tid);
+            for (uint64_t i = 0; i < ops_per_thread; i++)
+                headers[tid][i] = store->InsertValue(value, tid);
+            stat.ops = ops_per_thread;
+        });
+
+        RunThreads("value_store.read", nthreads, [&](int tid, mt19937_64& rng, ThreadStat& stat) {
+            uniform_int_distribution<uint64_t> dist(0, ops_per_thread - 1);
+            value_t value;
+            for (uint64_t i = 0; i < ops_per_thread; i++)
+                store->ReadValue(headers[tid][dist(rng)], value);
+            stat.ops = ops_per_thread;
+        });
+
+        RunThreads("value_store.free", nthreads, [&](int tid, mt19937_64& rng, ThreadStat& stat) {
+            for (uint64_t i = 0; i < ops_per_thread; i++)
+                store->FreeValue(headers[tid][i], tid);
+            stat.ops = ops_per_thread;
+        });
+    }
+}
+
+// MVCCList::AppendVersion/GetVisibleVersion on shared lists
+void BenchMVCCList() {
+    int num_lists = stoi(options["mvcc_lists"]);
+    double write_ratio = stod(options["write_ratio"]);
+    size_t max_versions = num_lists + max_threads * ops_per_thread * write_ratio * 1.1 + 1024;
+    auto* pool = ConcurrentMemPool<VertexMVCCItem>::GetInstance(
+        nullptr, PoolSize(max_versions, CONCURRENT_MEM_POOL_DEFAULT_BLOCK_SIZE), max_threads, false);
+    MVCCList<VertexMVCCItem>::SetGlobalMemoryPool(pool);
+
+    for (int nthreads : thread_counts) {
+        auto* lists = new MVCCList<VertexMVCCItem>[num_lists];
+        for (int i = 0; i < num_lists; i++)
+            lists[i].AppendInitialVersion()[0] = true;
+
+        atomic<uint64_t> next_trx_id(1), timestamp(1);
+        RunThreads("mvcc_list", nthreads, [&](int tid, mt19937_64& rng, ThreadStat& stat) {
+            uniform_int_distribution<int> list_dist(0, num_lists - 1);
+            bernoulli_distribution write_dist(write_ratio);
+            for (uint64_t i = 0; i < ops_per_thread; i++) {
+                MVCCList<VertexMVCCItem>& list = lists[list_dist(rng)];
+                uint64_t trx_id = TRX_ID_MASK | (next_trx_id++ << QID_BITS);
+                uint64_t begin_time = timestamp;
+                if (write_dist(rng)) {
+                    bool* val = list.AppendVersion(trx_id, begin_time);
+                    if (val == nullptr) {
+                        stat.aborts++;
+                    } else {
+                        *val = true;
+                        list.CommitVersion(trx_id, ++timestamp);
+                    }
+                } else {
+                    bool val;
+                    if (!list.GetVisibleVersion(trx_id, begin_time, true, val).first)
+                        stat.aborts++;
+                }
+            }
+            stat.ops = ops_per_thread;
+        });
+
+        for (int i = 0; i < num_lists; i++)
+            lists[i].SelfGarbageCollect();
+        delete[] lists;
+    }
+}
+
+// TopologyRowList::ReadConnectedVertex of uniformly chosen vertices on a synthetic graph
+void BenchTopology() {
+    int num_vertices = stoi(options["vertices"]);
+    double degree = stod(options["degree"]);
+    double alpha = stod(options["alpha"]);
+    bool power_law = options["dist"] == "powerlaw";
+    CHECK(power_law || options["dist"] == "uniform") << "unexpected dist " << options["dist"];
+    CHECK(!power_law || alpha > 2) << "alpha should be > 2";
+
+    // pareto distribution with mean degree: d_min * (1 - u) ^ (-1 / (alpha - 1))
+    mt19937_64 rng(seed);
+    uniform_real_distribution<double> u_dist(0, 1);
+    double d_min = degree * (alpha - 2) / (alpha - 1);
+    vector<int> degrees(num_vertices);
+    size_t num_edges = 0, num_rows = 0, max_degree = 0;
+    for (int v = 0; v < num_vertices; v++) {
+        double d = power_law ? d_min * pow(1 - u_dist(rng), -1 / (alpha - 1)) : 2 * degree * u_dist(rng);
+        degrees[v] = min<double>(d + 0.5, num_vertices - 1);
+        num_edges += degrees[v];
+        num_rows += (degrees[v] + VE_ROW_CELL_COUNT - 1) / VE_ROW_CELL_COUNT;
+        max_degree = max<size_t>(max_degree, degrees[v]);
+    }
+
+    auto* row_pool = ConcurrentMemPool<VertexEdgeRow>::GetInstance(
+        nullptr, PoolSize(num_rows, CONCURRENT_MEM_POOL_DEFAULT_BLOCK_SIZE), max_threads, false);
+    auto* edge_pool = ConcurrentMemPool<EdgeMVCCItem>::GetInstance(
+        nullptr, PoolSize(num_edges, CONCURRENT_MEM_POOL_DEFAULT_BLOCK_SIZE), max_threads, false);
+    TopologyRowList::SetGlobalMemoryPool(row_pool);
+    MVCCList<EdgeMVCCItem>::SetGlobalMemoryPool(edge_pool);
+
+    auto* row_lists = new TopologyRowList[num_vertices];
+    uniform_int_distribution<int> v_dist(0, num_vertices - 1);
+    for (int v = 0; v < num_vertices; v++) {
+        row_lists[v].Init(vid_t(v));
+        for (int i = 0; i < degrees[v]; i++)
+            row_lists[v].InsertInitialCell(true, vid_t(v_dist(rng)), 1, nullptr);
+    }
+    LOG(INFO) << "[MicroBench] topology: " << num_vertices << " vertices, " << num_edges
+              << " edges, max degree " << max_degree;
+
+    for (int nthreads : thread_counts) {
+        RunThreads("topology", nthreads, [&](int tid, mt19937_64& rng, ThreadStat& stat) {
+            uint64_t trx_id = TRX_ID_MASK | ((tid + 1ull) << QID_BITS);
+            vector<vid_t> ret;
+            for (uint64_t i = 0; i < ops_per_thread; i++) {
+                ret.clear();
+                if (row_lists[v_dist(rng)].ReadConnectedVertex(OUT, 0, trx_id, 1, true, ret) != READ_STAT::SUCCESS)
+                    stat.aborts++;
+                stat.items += ret.size();
+            }
+            stat.ops = ops_per_thread;
+        });
+    }
+}
+
+// PropertyRowList::ReadProperty, with row lists filled by InsertInitialCell (linear scan)
+// and by ProcessModifyProperty (cell_map_ built once the row list has more than ROW_CELL_COUNT cells)
+void BenchProperty() {
+    int num_vertices = stoi(options["vertices"]);
+    int props = stoi(options["props"]);
+    int value_bytes = stoi(options["value_bytes"]);
+    if (props <= VertexPropertyRow::ROW_CELL_COUNT)
+        LOG(WARNING) << "[MicroBench] cell_map_ is not built with props <= " << VertexPropertyRow::ROW_CELL_COUNT;
+
+    size_t num_cells = 2ull * num_vertices * props;
+    size_t num_rows = 2ull * num_vertices * ((props + VertexPropertyRow::ROW_CELL_COUNT - 1) / VertexPropertyRow::ROW_CELL_COUNT);
+    size_t cells_per_value = ValueHeader(0, value_bytes + 1).GetCellCount();
+    auto* row_pool = ConcurrentMemPool<VertexPropertyRow>::GetInstance(
+        nullptr, PoolSize(num_rows, CONCURRENT_MEM_POOL_DEFAULT_BLOCK_SIZE), max_threads, false);
+    auto* mvcc_pool = ConcurrentMemPool<VPropertyMVCCItem>::GetInstance(
+        nullptr, PoolSize(num_cells, CONCURRENT_MEM_POOL_DEFAULT_BLOCK_SIZE), max_threads, false);
+    auto* store = new MVCCValueStore(nullptr, PoolSize(num_cells * cells_per_value, MVCCValueStore::BLOCK_SIZE),
+                                     max_threads, false);
+    PropertyRowList<VertexPropertyRow>::SetGlobalMemoryPool(row_pool);
+    PropertyRowList<VertexPropertyRow>::SetGlobalValueStore(store);
+    MVCCList<VPropertyMVCCItem>::SetGlobalMemoryPool(mvcc_pool);
+    VPropertyMVCCItem::SetGlobalValueStore(store);
+
+    auto* scan_lists = new PropertyRowList<VertexPropertyRow>[num_vertices];
+    auto* map_lists = new PropertyRowList<VertexPropertyRow>[num_vertices];
+    uint64_t timestamp = 1, trx_seq = 1;
+    for (int v = 0; v < num_vertices; v++) {
+        scan_lists[v].Init();
+        map_lists[v].Init();
+        for (int p = 1; p <= props; p++) {
+            value_t value = MakeValue(value_bytes, p), old_value;
+            scan_lists[v].InsertInitialCell(vpid_t(v, p), value);
+
+            uint64_t trx_id = TRX_ID_MASK | (trx_seq++ << QID_BITS);
+            auto ret = map_lists[v].ProcessModifyProperty(vpid_t(v, p), value, old_value, trx_id, timestamp);
+            CHECK(ret.second != nullptr);
+            ret.second->CommitVersion(trx_id, ++timestamp);
+        }
+    }
+
+    vector<pair<string, PropertyRowList<VertexPropertyRow>*>> variants = {
+        {"property.scan", scan_lists}, {"property.map", map_lists}};
+    for (auto& variant : variants) {
+        for (int nthreads : thread_counts) {
+            RunThreads(variant.first, nthreads, [&](int tid, mt19937_64& rng, ThreadStat& stat) {
+                uniform_int_distribution<int> v_dist(0, num_vertices - 1), p_dist(1, props);
+                uint64_t trx_id = TRX_ID_MASK | ((trx_seq + tid) << QID_BITS);
+                value_t value;
+                for (uint64_t i = 0; i < ops_per_thread; i++) {
+                    int v = v_dist(rng);
+                    if (variant.second[v].ReadProperty(vpid_t(v, p_dist(rng)), trx_id, timestamp + 1, true, value)
+                            != READ_STAT::SUCCESS)
+                        stat.aborts++;
+                }
+                stat.ops = ops_per_thread;
+            });
+        }
+    }
+}
+
+// TransactionStatusTable::query_status of existing and absent transactions
+void BenchTrxTable() {
+    Config* config = Config::GetInstance();
+    config->trx_table_sz = MiB2B(stoull(options["trx_table_mb"]));
+    config->trx_table = new char[config->trx_table_sz]();
+    config->trx_num_total_buckets = config->trx_table_sz / (config->ASSOCIATIVITY * sizeof(TidStatus));
+    config->trx_num_main_buckets = config->trx_num_total_buckets * config->MI_RATIO / 100;
+    config->trx_num_indirect_buckets = config->trx_num_total_buckets - config->trx_num_main_buckets;
+    config->trx_num_slots = config->trx_num_total_buckets * config->ASSOCIATIVITY;
+
+    // the last slot of each bucket links to the next bucket
+    TransactionStatusTable* table = TransactionStatusTable::GetInstance();
+    uint64_t num_trxs = config->trx_num_main_buckets * (config->ASSOCIATIVITY - 1) * stod(options["trx_fill"]);
+    for (uint64_t i = 1; i <= num_trxs; i++)
+        table->insert_single_trx(TRX_ID_MASK | (i << QID_BITS), i, false);
+
+    for (int nthreads : thread_counts) {
+        RunThreads("trx_table.hit", nthreads, [&](int tid, mt19937_64& rng, ThreadStat& stat) {
+            uniform_int_distribution<uint64_t> dist(1, num_trxs);
+            TRX_STAT status;
+            for (uint64_t i = 0; i < ops_per_thread; i++)
+                CHECK(table->query_status(TRX_ID_MASK | (dist(rng) << QID_BITS), status));
+            stat.ops = ops_per_thread;
+        });
+    }
+    for (int nthreads : thread_counts) {
+        RunThreads("trx_table.miss", nthreads, [&](int tid, mt19937_64& rng, ThreadStat& stat) {
+            uniform_int_distribution<uint64_t> dist(num_trxs + 1, 2 * num_trxs);
+            TRX_STAT status;
+            for (uint64_t i = 0; i < ops_per_thread; i++)
+                CHECK(!table->query_status(TRX_ID_MASK | (dist(rng) << QID_BITS), status));
+            stat.ops = ops_per_thread;
+        });
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    google::InitGoogleLogging(argv[0]);
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        size_t pos = arg.find('=');
+        if (pos == string::npos || options.count(arg.substr(0, pos)) == 0) {
+            cout << "Usage: " << argv[0] << " [<key>=<value>]..., see driver/micro_bench.cpp for options" << endl;
+            return 1;
+        }
+        options[arg.substr(0, pos)] = arg.substr(pos + 1);
+    }
+
+    string token;
+    istringstream threads_ss(options["threads"]);
+    while (getline(threads_ss, token, ','))
+        thread_counts.emplace_back(stoi(token));
+    CHECK(!thread_counts.empty());
+    max_threads = *max_element(thread_counts.begin(), thread_counts.end());
+    ops_per_thread = stoull(options["ops"]);
+    seed = stoull(options["seed"]);
+
+    // Only fields used by the benchmarked primitives are set
+    Config* config = Config::GetInstance();
+    CHECK(options["isolation"] == "serializable" || options["isolation"] == "snapshot");
+    config->isolation_level = options["isolation"] == "serializable" ? ISOLATION_LEVEL::SERIALIZABLE
+                                                                     : ISOLATION_LEVEL::SNAPSHOT;
+    // pre-read queries the remote transaction table, which is not available here
+    config->global_enable_opt_preread = false;
+
+    // for initializing containers in the main thread
+    TidPoolManager::GetInstance()->Register(TID_TYPE::CONTAINER, 0);
+
+    map<string, function<void()>> benches = {
+        {"mem_pool", BenchMemPool}, {"value_store", BenchValueStore}, {"mvcc_list", BenchMVCCList},
+        {"topology", BenchTopology}, {"property", BenchProperty}, {"trx_table", BenchTrxTable}};
+    vector<string> selected;
+    if (options["bench"] == "all") {
+        selected = {"mem_pool", "value_store", "mvcc_list", "topology", "property", "trx_table"};
+    } else {
+        istringstream bench_ss(options["bench"]);
+        while (getline(bench_ss, token, ',')) {
+            CHECK(benches.count(token) != 0) << "unexpected bench " << token;
+            selected.emplace_back(token);
+        }
+    }
+
+    PrintHeader();
+    for (auto& name : selected)
+        benches[name]();
+    return 0;
+}
@@ -15,7 +15,10 @@
 #ifndef WORKER_HPP_
 #define WORKER_HPP_
 
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -25,10 +28,12 @@
 #include "base/core_affinity.hpp"
 #include "base/node.hpp"
 #include "base/type.hpp"
+#include "base/async_protocol.hpp"
 #include "base/thread_safe_queue.hpp"
 #include "base/throughput_monitor.hpp"
 #include "utils/config.hpp"
 #include "utils/global.hpp"
+#include "utils/metrics.hpp"
 #include "utils/tid_pool_manager.hpp"
 
 #include "core/buffer.hpp"
@@ -42,6 +47,7 @@
 #include "core/RCT.hpp"
 #include "core/rdma_mailbox.hpp"
 #include "core/result_collector.hpp"
+#include "core/shm_mailbox.hpp"
 #include "core/tcp_mailbox.hpp"
 #include "core/transaction_status_table.hpp"
 #include "core/trx_table_stub_rdma.hpp"
@@ -50,6 +56,7 @@
 #include "layout/data_storage.hpp"
 #include "layout/garbage_collector.hpp"
 #include "layout/index_store.hpp"
+#include "layout/ingest_batch.hpp"
 #include "layout/pmt_rct_table.hpp"
 
 
@@ -92,12 +99,31 @@ struct ParseTrxReq {
     string client_host;
     int trx_type;
     bool is_emu_mode;
+    // from AsyncClient if reply_endpoint is not empty
+    string reply_endpoint;
+    uint64_t req_id = 0;
 
     ParseTrxReq() {}
     ParseTrxReq(string _trx_str, string _client_host, int _trx_type, bool _is_emu_mode) :
         trx_str(_trx_str), client_host(_client_host), trx_type(_trx_type), is_emu_mode(_is_emu_mode) {}
 };
 
+// Bulk ingestion batch from client
+struct IngestBatchReq {
+    string client_host;
+    IngestBatch batch;
+};
+
+// Bulk ingestion messages from the worker coordinating the batch
+struct IngestPartReq {
+    enum Type { PART, COMMIT, ABORT };
+    Type type;
+    int sender_rank;
+    uint64_t trx_id;
+    uint64_t timestamp;  // bt for PART, ct for COMMIT
+    IngestPart part;
+};
+
 //======================  End  ======================//
 //==============intermediate structures==============//
 
@@ -241,6 +267,7 @@ class Worker {
             in << emu_host;
             in << cmd;
 
+            lock_guard<mutex> lock(senders_mutex_);
             for (int i = 0; i < senders_.size(); i++) {
                 zmq::message_t msg(in.size());
                 memcpy((void *)msg.data(), in.get_buf(), in.size());
@@ -688,6 +715,17 @@ class Worker {
      * Send the results of Transaction back to the Client
      */
     void ReplyClient(TrxPlan& plan) {
+        if (!plan.reply_endpoint.empty()) {
+            AsyncReply reply;
+            reply.req_id = plan.req_id;
+            reply.status = plan.isAbort() ? TRX_STAT::ABORT : TRX_STAT::COMMITTED;
+            plan.GetResult(reply.results);
+            reply.time = timer::get_usec() - plan.start_time;
+            pending_async_replies_.Push(make_pair(plan.reply_endpoint, move(reply)));
+            monitor_->IncreaseCounter(1);
+            return;
+        }
+
         ibinstream m;
         vector<value_t> results;
         plan.GetResult(results);
@@ -761,6 +799,148 @@ class Worker {
             validaton_query_pkgs_map_.erase(accessor);
         }
     }
+
+    // senders_ does not include the socket to this worker
+    void SendToWorker(int rank, ibinstream& in) {
+        int idx = rank < my_node_.get_local_rank() ? rank : rank - 1;
+        zmq::message_t msg(in.size());
+        memcpy(reinterpret_cast<void*>(msg.data()), in.get_buf(), in.size());
+        lock_guard<mutex> lock(senders_mutex_);
+        senders_[idx]->send(msg);
+    }
+
+    // Request a timestamp for a bulk ingestion and wait until it is allocated
+    uint64_t WaitIngestTimestamp(uint64_t trx_id, TIMESTAMP_TYPE ts_type) {
+        {
+            lock_guard<mutex> lock(ingest_mutex_);
+            ingest_states_[trx_id].timestamp = 0;
+        }
+        TimestampRequest req(trx_id, ts_type);
+        pending_timestamp_request_.Push(req);
+
+        unique_lock<mutex> lock(ingest_mutex_);
+        ingest_cv_.wait(lock, [&] {return ingest_states_[trx_id].timestamp != 0;});
+        return ingest_states_[trx_id].timestamp;
+    }
+
+    // Called by ProcessAllocatedTimestamp, return false if the timestamp is not for a bulk ingestion
+    bool DeliverIngestTimestamp(const AllocatedTimestamp& allocated_ts) {
+        {
+            lock_guard<mutex> lock(ingest_mutex_);
+            auto itr = ingest_states_.find(allocated_ts.trx_id);
+            if (itr == ingest_states_.end())
+                return false;
+            itr->second.timestamp = allocated_ts.timestamp;
+        }
+        ingest_cv_.notify_all();
+        return true;
+    }
+
+    /* Apply the part of a bulk ingestion batch on this worker, without validation.
+     * Return false if any modification fails (e.g., the endpoint of an edge is dropped), then the trx should be aborted.
+     */
+    bool ApplyIngestPart(const IngestPart& part, const uint64_t& trx_id, const uint64_t& bt) {
+        for (int i = 0; i < part.vids.size(); i++) {
+            vid_t vid;
+            uint2vid_t(part.vids[i], vid);
+            data_storage_->ProcessAddV(vid, part.v_labels[i], trx_id, bt);
+        }
+
+        // Edges after vertices, and edge properties after outE
+        for (int i = 0; i < part.out_eids.size(); i++) {
+            eid_t eid;
+            uint2eid_t(part.out_eids[i], eid);
+            if (data_storage_->ProcessAddE(eid, part.out_e_labels[i], true, trx_id, bt) != PROCESS_STAT::SUCCESS)
+                return false;
+        }
+        for (int i = 0; i < part.in_eids.size(); i++) {
+            eid_t eid;
+            uint2eid_t(part.in_eids[i], eid);
+            if (data_storage_->ProcessAddE(eid, part.in_e_labels[i], false, trx_id, bt) != PROCESS_STAT::SUCCESS)
+                return false;
+        }
+
+        value_t old_value;
+        for (int i = 0; i < part.vpids.size(); i++) {
+            vpid_t vpid;
+            uint2vpid_t(part.vpids[i], vpid);
+            if (data_storage_->ProcessModifyVP(vpid, part.vp_values[i], old_value, trx_id, bt) != PROCESS_STAT::SUCCESS)
+                return false;
+        }
+        for (int i = 0; i < part.epids.size(); i++) {
+            epid_t epid;
+            uint2epid_t(part.epids[i], epid);
+            if (data_storage_->ProcessModifyEP(epid, part.ep_values[i], old_value, trx_id, bt) != PROCESS_STAT::SUCCESS)
+                return false;
+        }
+
+        // Before commit time is allocated, so that validation of concurrent transactions can find them
+        PrimitiveRCTTable* pmt_rct_table = PrimitiveRCTTable::GetInstance();
+        pmt_rct_table->InsertRecentActionSet(Primitive_T::IV, trx_id, part.vids);
+        pmt_rct_table->InsertRecentActionSet(Primitive_T::IE, trx_id, part.out_eids);
+        pmt_rct_table->InsertRecentActionSet(Primitive_T::IVP, trx_id, part.vpids);
+        pmt_rct_table->InsertRecentActionSet(Primitive_T::IEP, trx_id, part.epids);
+        return true;
+    }
+
+    void CommitIngestPart(const IngestPart& part, const uint64_t& trx_id, const uint64_t& ct) {
+        data_storage_->Commit(trx_id, ct);
+
+        // Topology of an edge is indexed on the worker of src_v, same as AddEdgeExpert
+        index_store_->InsertCommittedToUpdateRegion(trx_id, ct, part.vids, ID_T::VID);
+        index_store_->InsertCommittedToUpdateRegion(trx_id, ct, part.out_eids, ID_T::EID);
+        index_store_->InsertCommittedToUpdateRegion(trx_id, ct, part.vpids, ID_T::VPID, &part.vp_values);
+        index_store_->InsertCommittedToUpdateRegion(trx_id, ct, part.epids, ID_T::EPID, &part.ep_values);
+    }
+
+    void ReplyIngest(TrxPlan& plan, const string& msg, const vector<vid_t>& vids) {
+        vector<value_t> vec(1);
+        Tool::str2str(msg, vec[0]);
+        for (auto& vid : vids) {
+            vec.emplace_back();
+            Tool::uint64_t2value_t(vid.value(), vec.back());
+        }
+        plan.FillResult(-1, vec);
+        ReplyClient(plan);
+    }
+
+    /* Messages among workers for bulk ingestion:
+     *      part:   trx_id, sender_rank, bt, IngestPart     (to the worker of part)
+     *      ack:    trx_id, success                         (to the sender of part)
+     *      commit: trx_id, ct
+     *      abort:  trx_id
+     * called by RecvRequest()
+     */
+    void RecvIngestMessage(const string& type, obinstream& um) {
+        if (type == "ack") {
+            uint64_t trx_id;
+            bool success;
+            um >> trx_id >> success;
+            {
+                lock_guard<mutex> lock(ingest_mutex_);
+                IngestState& state = ingest_states_[trx_id];
+                state.pending_acks--;
+                state.success = state.success && success;
+            }
+            ingest_cv_.notify_all();
+            return;
+        }
+
+        IngestPartReq req;
+        um >> req.trx_id;
+        if (type == "part") {
+            req.type = IngestPartReq::PART;
+            um >> req.sender_rank >> req.timestamp >> req.part;
+        } else if (type == "commit") {
+            req.type = IngestPartReq::COMMIT;
+            um >> req.timestamp;
+        } else if (type == "abort") {
+            req.type = IngestPartReq::ABORT;
+        } else {
+            CHECK(false) << "[Worker] Unexpected ingestion message " << type;
+        }
+        pending_ingest_parts_.Push(req);
+    }
 //=====================  End  =======================//
 //================== Helper Functions ===============//
 
@@ -780,6 +960,23 @@ class Worker {
         pending_parse_trx_req_.Push(req);
     }
 
+    /**
+     * Unpack the transactions submitted by AsyncClient in one frame
+     * called by RecvRequest() in below
+     */
+    void RequestParsingAsyncTrxs(const string& client_host, obinstream& um) {
+        string reply_endpoint;
+        vector<AsyncRequest> reqs;
+        um >> reply_endpoint >> reqs;
+
+        for (auto& async_req : reqs) {
+            ParseTrxReq req(async_req.query, client_host, -1, false);
+            req.reply_endpoint = reply_endpoint;
+            req.req_id = async_req.req_id;
+            pending_parse_trx_req_.Push(req);
+        }
+    }
+
     /**
      * Regular recv thread for transaction processing request sent from clients
      * Driven by one thread in Worker::Start()
@@ -798,11 +995,34 @@ class Worker {
 
             um >> client_host;
             um >> query;
+
+            if (client_host == ingest_host_) {
+                // forwarded from the worker coordinating a bulk ingestion
+                RecvIngestMessage(query, um);
+                continue;
+            }
+
+            if (client_host == prepare_host_) {
+                // forwarded from the worker preparing a transaction
+                RecvPrepareMessage(query, um);
+                continue;
+            }
+
+            if (query == ASYNC_QUERY_TAG) {
+                RequestParsingAsyncTrxs(client_host, um);
+                continue;
+            }
+
             cout << "worker_node" << my_node_.get_local_rank()
                     << " gets one QUERY: \"" << query << "\" from host "
                     << client_host << endl;
 
-            if (query.find("emu") == 0) {
+            if (query == "ingest") {
+                IngestBatchReq req;
+                req.client_host = client_host;
+                um >> req.batch;
+                pending_ingest_batches_.Push(req);
+            } else if (query.find("emu") == 0) {
                 RunEMU(query, client_host);
             } else {
                 // parse and insert into trx_plans_map_
@@ -815,15 +1035,28 @@ class Worker {
      * Parse the transaction string into TrxPlan
      * called by ProcessingParseTrxReq() in below
      */
-    void ParseTransaction(string trx_str, string client_host, int trx_type, bool is_emu_mode) {
+    void ParseTransaction(string trx_str, string client_host, int trx_type, bool is_emu_mode,
+                          const string& reply_endpoint = "", uint64_t req_id = 0) {
+        if (trx_str.find("prepare") == 0) {
+            PrepareTransaction(trx_str, client_host, reply_endpoint, req_id);
+            return;
+        }
+
         uint64_t trxid;
         coordinator_->RegisterTrx(trxid);
 
         TrxPlan plan(trxid, client_host);
+        plan.reply_endpoint = reply_endpoint;
+        plan.req_id = req_id;
         if (is_emu_mode_) { thpt_monitor_->RecordStart(trxid, trx_type, trx_str); }
 
         string error_msg;
-        bool success = parser_->Parse(trx_str, plan, error_msg);
+        bool success;
+        if (trx_str.find("execute") == 0) {
+            success = parser_->Execute(trx_str.substr(string("execute").size()), plan, error_msg);
+        } else {
+            success = parser_->Parse(trx_str, plan, error_msg);
+        }
 
         if (success) {
             // valid transaction, insert the TrxPlan into trx_plans_map_, and request its BT
@@ -848,6 +1081,100 @@ class Worker {
         }
     }
 
+    /**
+     * Parse the transaction template and cache its TrxPlan in parser of all workers,
+     * so that the prepared transaction could be executed on any worker.
+     * Reply the statement id to client after all workers have acked, which is used by "execute <stmt_id>(<params>)"
+     * called by ParseTransaction() in above
+     */
+    void PrepareTransaction(string trx_str, string client_host, const string& reply_endpoint = "", uint64_t req_id = 0) {
+        string trx_template = trx_str.substr(string("prepare").size());
+        Tool::trim(trx_template, " \n");
+
+        uint64_t stmt_id;
+        string error_msg;
+        bool success = parser_->Prepare(trx_template, stmt_id, error_msg);
+
+        uint64_t trxid;
+        coordinator_->RegisterTrx(trxid);
+        TrxPlan plan(trxid, client_host);
+        plan.reply_endpoint = reply_endpoint;
+        plan.req_id = req_id;
+
+        if (success && my_node_.get_local_size() > 1) {
+            {
+                lock_guard<mutex> lock(prepare_mutex_);
+                PrepareState& state = prepare_states_[trxid];
+                state.pending_acks = my_node_.get_local_size() - 1;
+                state.stmt_id = stmt_id;
+                state.plan = move(plan);
+            }
+
+            ibinstream in;
+            in << prepare_host_ << string("prepare") << my_node_.get_local_rank() << trxid << trx_template;
+            for (int rank = 0; rank < my_node_.get_local_size(); rank++) {
+                if (rank != my_node_.get_local_rank())
+                    SendToWorker(rank, in);
+            }
+            return;
+        }
+
+        ReplyPrepare(plan, success, stmt_id, error_msg);
+    }
+
+    void ReplyPrepare(TrxPlan& plan, bool success, uint64_t stmt_id, const string& error_msg) {
+        value_t v;
+        if (success) {
+            Tool::str2str("Prepared transaction id: " + to_string(stmt_id), v);
+        } else {
+            Tool::str2str(error_msg, v);
+        }
+        vector<value_t> vec = {v};
+        plan.FillResult(-1, vec);
+        ReplyClient(plan);
+    }
+
+    /* Messages among workers for prepared transactions:
+     *      prepare:    sender_rank, trx_id, trx_template   (to other workers)
+     *      ack:        trx_id, success, error_msg          (to the sender of prepare)
+     * called by RecvRequest()
+     */
+    void RecvPrepareMessage(const string& type, obinstream& um) {
+        if (type == "prepare") {
+            int sender_rank;
+            uint64_t trx_id, stmt_id;
+            string trx_template, error_msg;
+            um >> sender_rank >> trx_id >> trx_template;
+            bool success = parser_->Prepare(trx_template, stmt_id, error_msg);
+
+            ibinstream in;
+            in << prepare_host_ << string("ack") << trx_id << success << error_msg;
+            SendToWorker(sender_rank, in);
+        } else if (type == "ack") {
+            uint64_t trx_id;
+            bool success;
+            string error_msg;
+            um >> trx_id >> success >> error_msg;
+
+            PrepareState state;
+            {
+                lock_guard<mutex> lock(prepare_mutex_);
+                auto itr = prepare_states_.find(trx_id);
+                CHECK(itr != prepare_states_.end());
+                itr->second.pending_acks--;
+                if (!success && itr->second.error_msg.empty())
+                    itr->second.error_msg = error_msg;
+                if (itr->second.pending_acks > 0)
+                    return;
+                state = move(itr->second);
+                prepare_states_.erase(itr);
+            }
+            ReplyPrepare(state.plan, state.error_msg.empty(), state.stmt_id, state.error_msg);
+        } else {
+            CHECK(false) << "[Worker] Unexpected prepare message " << type;
+        }
+    }
+
     /**
      * Driven by threads taking in charge of the trx parser
      */
@@ -856,7 +1183,251 @@ class Worker {
             ParseTrxReq req;
             pending_parse_trx_req_.WaitAndPop(req);
             // Parse the transaction, and push the transaction to be executed
-            ParseTransaction(req.trx_str, req.client_host, req.trx_type, req.is_emu_mode);
+            ParseTransaction(req.trx_str, req.client_host, req.trx_type, req.is_emu_mode, req.reply_endpoint, req.req_id);
+        }
+    }
+
+    /**
+     * Send replies to AsyncClients. Replies queued at the same time are sent in one frame per client,
+     * through sockets kept for each client.
+     * Sending never blocks: frames to a client whose queue is full are kept in a bounded backlog and retried,
+     * so that a slow client does not stall the others. Sockets of clients inactive too long are closed,
+     * and replies that cannot be kept are logged, after which AsyncClient fails the requests on its deadline.
+     */
+    void ProcessAsyncReplies() {
+        const int max_batch_size = 1024;
+        const int send_hwm = 1024;  // frames queued for each client by zmq
+        const size_t max_backlog_size = 65536;  // replies kept for each client when zmq queue is full
+        const uint64_t retry_interval_us = 10000;
+        const uint64_t idle_timeout_us = 60 * 1000000ULL;
+
+        struct ReplySender {
+            zmq::socket_t* socket = nullptr;
+            deque<vector<AsyncReply>> backlog;  // frames not accepted by socket yet, sent in order
+            size_t backlog_size = 0;  // number of replies in backlog
+            uint64_t last_active = 0;  // last time replies were queued or sent
+        };
+        unordered_map<string, ReplySender> reply_senders;
+        auto close_sender = [&](unordered_map<string, ReplySender>::iterator itr) {
+            itr->second.socket->close();
+            delete itr->second.socket;
+            return reply_senders.erase(itr);
+        };
+
+        // Send frames in backlog until the queue of socket is full
+        auto flush_sender = [&](const string& endpoint, ReplySender& sender, uint64_t now) {
+            while (!sender.backlog.empty()) {
+                ibinstream m;
+                m << sender.backlog.front();
+                zmq::message_t msg(m.size());
+                memcpy(reinterpret_cast<void*>(msg.data()), m.get_buf(), m.size());
+                try {
+                    if (!sender.socket->send(msg, ZMQ_DONTWAIT)) {
+                        return;
+                    }
+                } catch (zmq::error_t& e) {
+                    LOG(WARNING) << "[Worker] failed to send async replies to " << endpoint << ": " << e.what();
+                    return;
+                }
+                sender.backlog_size -= sender.backlog.front().size();
+                sender.backlog.pop_front();
+                sender.last_active = now;
+            }
+        };
+
+        bool has_backlog = false;
+        while (true) {
+            unordered_map<string, vector<AsyncReply>> batches;
+            pair<string, AsyncReply> reply;
+            // retry backlog periodically if no reply comes
+            bool popped = true;
+            if (has_backlog) {
+                popped = pending_async_replies_.WaitAndPop(reply, retry_interval_us);
+            } else {
+                pending_async_replies_.WaitAndPop(reply);
+            }
+            if (popped) {
+                batches[reply.first].emplace_back(move(reply.second));
+                for (int i = 1; i < max_batch_size && pending_async_replies_.Size() != 0; i++) {
+                    pending_async_replies_.WaitAndPop(reply);
+                    batches[reply.first].emplace_back(move(reply.second));
+                }
+            }
+
+            uint64_t now = timer::get_usec();
+            for (auto& kv : batches) {
+                ReplySender& sender = reply_senders[kv.first];
+                if (sender.socket == nullptr) {
+                    int linger_ms = 0;
+                    sender.socket = new zmq::socket_t(context_, ZMQ_PUSH);
+                    sender.socket->setsockopt(ZMQ_SNDHWM, &send_hwm, sizeof(send_hwm));
+                    sender.socket->setsockopt(ZMQ_LINGER, &linger_ms, sizeof(linger_ms));
+                    sender.socket->connect(kv.first.c_str());
+                }
+                sender.last_active = now;
+
+                if (sender.backlog_size + kv.second.size() > max_backlog_size) {
+                    LOG(WARNING) << "[Worker] dropped " << kv.second.size() << " async replies to " << kv.first
+                                 << ": its backlog is full";
+                    continue;
+                }
+                sender.backlog_size += kv.second.size();
+                sender.backlog.emplace_back(move(kv.second));
+            }
+
+            has_backlog = false;
+            for (auto itr = reply_senders.begin(); itr != reply_senders.end();) {
+                ReplySender& sender = itr->second;
+                flush_sender(itr->first, sender, now);
+                if (now - sender.last_active > idle_timeout_us) {
+                    if (sender.backlog_size != 0) {
+                        LOG(WARNING) << "[Worker] dropped " << sender.backlog_size << " async replies to " << itr->first
+                                     << ": it has not read replies for " << idle_timeout_us / 1000000 << " s";
+                    }
+                    itr = close_sender(itr);
+                    continue;
+                }
+                has_backlog |= !sender.backlog.empty();
+                itr++;
+            }
+        }
+    }
+
+    /**
+     * Coordinate bulk ingestion batches sent to this worker.
+     * Each batch is one transaction: vids are assigned in bulk, the batch is applied on all workers
+     * without validation, and committed with one commit time.
+     * Driven by one thread in Worker::Start()
+     */
+    void ProcessIngestBatches() {
+        tid_pool_manager_->Register(TID_TYPE::RDMA, config_->global_num_threads + Config::ingest_batch_tid);
+        tid_pool_manager_->Register(TID_TYPE::CONTAINER, config_->global_num_threads + config_->num_gc_consumer + 1);
+        while (true) {
+            IngestBatchReq req;
+            pending_ingest_batches_.WaitAndPop(req);
+            ProcessIngestBatch(req.batch, req.client_host);
+        }
+    }
+
+    void ProcessIngestBatch(const IngestBatch& batch, const string& client_host) {
+        int my_rank = my_node_.get_local_rank();
+
+        // vids of an invalid or aborted batch are not reused, same as dropped vertices
+        vector<vid_t> vids;
+        data_storage_->AssignVIDs(batch.vertices.size(), vids);
+
+        // Validate before the trx is registered, so that an invalid batch leaves nothing to finish
+        string error_msg;
+        vector<IngestPart> parts(my_node_.get_local_size());
+        if (!SplitIngestBatch(batch, data_storage_->indexes_, vids, SimpleIdMapper::GetInstance(), parts, error_msg)) {
+            TrxPlan plan(0, client_host);
+            ReplyIngest(plan, "Error: " + error_msg, vector<vid_t>());
+            return;
+        }
+
+        // Once registered, every path below reaches FinishIngestTrx
+        uint64_t trx_id;
+        coordinator_->RegisterTrx(trx_id);
+        TrxPlan plan(trx_id, client_host);
+        uint64_t bt = WaitIngestTimestamp(trx_id, TIMESTAMP_TYPE::BEGIN_TIME);
+        running_trx_list_->InsertTrx(bt);
+        trx_table_->insert_single_trx(trx_id, bt, false);
+
+        // Send parts to other workers, and apply the local part meanwhile
+        vector<int> remote_ranks;
+        for (int i = 0; i < parts.size(); i++) {
+            if (i != my_rank && !parts[i].Empty())
+                remote_ranks.emplace_back(i);
+        }
+        {
+            lock_guard<mutex> lock(ingest_mutex_);
+            ingest_states_[trx_id].pending_acks = remote_ranks.size();
+        }
+        for (int rank : remote_ranks) {
+            ibinstream in;
+            in << ingest_host_ << string("part") << trx_id << my_rank << bt << parts[rank];
+            SendToWorker(rank, in);
+        }
+
+        bool success = ApplyIngestPart(parts[my_rank], trx_id, bt);
+        {
+            unique_lock<mutex> lock(ingest_mutex_);
+            IngestState& state = ingest_states_[trx_id];
+            ingest_cv_.wait(lock, [&] {return state.pending_acks == 0;});
+            success = success && state.success;
+        }
+
+        FinishIngestTrx(trx_id, bt, success, parts[my_rank], remote_ranks);
+
+        if (success) {
+            ReplyIngest(plan, "Ingested " + to_string(batch.vertices.size()) + " vertices and "
+                        + to_string(batch.edges.size()) + " edges, vids of new vertices:", vids);
+        } else {
+            ReplyIngest(plan, "Ingestion aborted", vector<vid_t>());
+        }
+    }
+
+    // Commit or abort a registered bulk ingestion on all workers, then remove it from RunningTrxList
+    void FinishIngestTrx(const uint64_t& trx_id, const uint64_t& bt, bool success, const IngestPart& local_part,
+                         const vector<int>& remote_ranks) {
+        ibinstream in;
+        if (success) {
+            uint64_t ct = WaitIngestTimestamp(trx_id, TIMESTAMP_TYPE::COMMIT_TIME);
+            if (config_->isolation_level == ISOLATION_LEVEL::SERIALIZABLE) {
+                rct_->insert_trx(ct, trx_id);
+            }
+            trx_table_->modify_status(trx_id, TRX_STAT::VALIDATING, ct);
+            trx_table_stub_->update_status(trx_id, TRX_STAT::COMMITTED);
+
+            CommitIngestPart(local_part, trx_id, ct);
+            in << ingest_host_ << string("commit") << trx_id << ct;
+        } else {
+            trx_table_stub_->update_status(trx_id, TRX_STAT::ABORT);
+            data_storage_->Abort(trx_id);
+            in << ingest_host_ << string("abort") << trx_id;
+        }
+        for (int rank : remote_ranks) {
+            SendToWorker(rank, in);
+        }
+
+        {
+            lock_guard<mutex> lock(ingest_mutex_);
+            ingest_states_.erase(trx_id);
+        }
+        NotifyTrxFinished(bt);
+        TimestampRequest req(trx_id, TIMESTAMP_TYPE::END_TIME);
+        pending_timestamp_request_.Push(req);
+    }
+
+    /**
+     * Apply and commit parts of bulk ingestion batches coordinated by other workers.
+     * Separated from ProcessIngestBatches, which may be waiting for acks while other workers send parts here.
+     * Driven by one thread in Worker::Start()
+     */
+    void ProcessIngestParts() {
+        tid_pool_manager_->Register(TID_TYPE::RDMA, config_->global_num_threads + Config::ingest_part_tid);
+        tid_pool_manager_->Register(TID_TYPE::CONTAINER, config_->global_num_threads + config_->num_gc_consumer + 2);
+
+        // trx_id -> applied part, waiting for commit or abort
+        unordered_map<uint64_t, IngestPart> applied_parts;
+        while (true) {
+            IngestPartReq req;
+            pending_ingest_parts_.WaitAndPop(req);
+
+            if (req.type == IngestPartReq::PART) {
+                bool success = ApplyIngestPart(req.part, req.trx_id, req.timestamp);
+                applied_parts[req.trx_id] = move(req.part);
+
+                ibinstream in;
+                in << ingest_host_ << string("ack") << req.trx_id << success;
+                SendToWorker(req.sender_rank, in);
+            } else if (req.type == IngestPartReq::COMMIT) {
+                CommitIngestPart(applied_parts.at(req.trx_id), req.trx_id, req.timestamp);
+                applied_parts.erase(req.trx_id);
+            } else {
+                data_storage_->Abort(req.trx_id);
+                applied_parts.erase(req.trx_id);
+            }
         }
     }
 
@@ -873,6 +1444,10 @@ class Worker {
             pending_allocated_timestamp_.WaitAndPop(allocated_ts);
             uint64_t trx_id = allocated_ts.trx_id;
 
+            if (allocated_ts.ts_type != TIMESTAMP_TYPE::END_TIME && DeliverIngestTimestamp(allocated_ts)) {
+                continue;
+            }
+
             if (allocated_ts.ts_type == TIMESTAMP_TYPE::COMMIT_TIME) {
                 // Non-readonly transactions, CT allocated
                 uint64_t ct = allocated_ts.timestamp;
@@ -997,6 +1572,41 @@ class Worker {
 //=========== Thread Registered Functions ===========//
 
 
+    // Metrics of transactions and queues of this worker, exported with those registered by other modules
+    void RegisterMetrics() {
+        MetricsRegistry* registry = MetricsRegistry::GetInstance();
+        committed_trx_ = registry->GetCounter("gtran_trx_total", "Finished transactions", "result=\"commit\"");
+        aborted_trx_ = registry->GetCounter("gtran_trx_total", "Finished transactions", "result=\"abort\"");
+        commit_latency_ = registry->GetHistogram("gtran_trx_latency_us", "Latency of transactions on this worker",
+                                                 "result=\"commit\"");
+        abort_latency_ = registry->GetHistogram("gtran_trx_latency_us", "Latency of transactions on this worker",
+                                                "result=\"abort\"");
+
+        registry->RegisterGauge("gtran_running_trx", "Transactions in processing on this worker",
+                                [this](vector<pair<string, double>>& samples) {
+            samples.emplace_back("", trx_plans_map_.size());
+        });
+        registry->RegisterGauge("gtran_worker_queue_depth", "Requests waiting in queues of worker threads",
+                                [this](vector<pair<string, double>>& samples) {
+            samples.emplace_back("queue=\"parse\"", pending_parse_trx_req_.Size());
+            samples.emplace_back("queue=\"timestamp\"", pending_timestamp_request_.Size());
+            samples.emplace_back("queue=\"trx_updates\"", pending_trx_updates_.Size());
+            samples.emplace_back("queue=\"trx_reads\"", pending_trx_reads_.Size());
+            samples.emplace_back("queue=\"rct_query\"", pending_rct_query_request_.Size());
+            samples.emplace_back("queue=\"async_replies\"", pending_async_replies_.Size());
+        });
+        registry->RegisterGauge("gtran_container_used", "Used elements of ConcurrentMemPools and MVCCValueStores",
+                                [this](vector<pair<string, double>>& samples) {
+            for (auto& p : data_storage_->GetContainerUsageMap())
+                samples.emplace_back("pool=\"" + p.first + "\"", p.second.first);
+        });
+        registry->RegisterGauge("gtran_container_capacity", "Capacity of ConcurrentMemPools and MVCCValueStores",
+                                [this](vector<pair<string, double>>& samples) {
+            for (auto& p : data_storage_->GetContainerUsageMap())
+                samples.emplace_back("pool=\"" + p.first + "\"", p.second.second);
+        });
+    }
+
     void Start() {
         //The main thread id should be config_->global_num_threads + Config::main_thread_tid
         // =================IdMapper========================
@@ -1041,6 +1651,9 @@ class Worker {
         } else {
             mailbox_ = new TCPMailbox(my_node_);
         }
+        if (config_->global_enable_shm_mailbox) {
+            mailbox_ = new ShmMailbox(my_node_, mailbox_);
+        }
         mailbox_->Init(workers_);
         cout << "[Worker" << my_node_.get_local_rank() << "]: DONE -> Mailbox->Init()" << endl;
 
@@ -1086,6 +1699,9 @@ class Worker {
         thread timestamp_generator(&Coordinator::ProcessTimestampRequest, coordinator_);
         cout << "[Worker" << my_node_.get_local_rank() << "]: " << "Waiting for init of timestamp generator" << endl;
         coordinator_->WaitForDistributedClockInit();
+        // Replayed redo records are committed at rebased times, which must be older than any new BT
+        while ((DistributedClock::GetInstance()->GetRefinedNS() << TIMESTAMP_MACHINE_ID_BITS) <= data_storage_->GetReplayEndTime())
+            usleep(1000);
 
         // =================Other threads=================
         // Recv&Send Thread
@@ -1096,6 +1712,10 @@ class Worker {
             parser_threads.emplace_back(&Worker::ProcessingParseTrxReq, this);
         // Deal with allocated timestamps
         thread timestamp_consumer(&Worker::ProcessAllocatedTimestamp, this);
+        // Bulk ingestion
+        thread ingest_batch_processor(&Worker::ProcessIngestBatches, this);
+        thread ingest_part_processor(&Worker::ProcessIngestParts, this);
+        thread async_reply_sender(&Worker::ProcessAsyncReplies, this);
         // Process notification msgs among workers in case of TCP-enabled version
         thread recvnotification(&Worker::RecvNotification, this);
 
@@ -1132,6 +1752,15 @@ class Worker {
         garbage_collector_->Init();
         cout << "[Worker" << my_node_.get_local_rank() << "]: DONE -> garbage_collector->Start()" << endl;
 
+        // =================Metrics=========================
+        RegisterMetrics();
+        if (config_->metrics_port > 0) {
+            int port = config_->metrics_port + my_node_.get_local_rank();
+            if (MetricsRegistry::GetInstance()->StartServer(port))
+                cout << "[Worker" << my_node_.get_local_rank() << "]: DONE -> Serve metrics on port " << port << endl;
+            else
+                cout << "[Worker" << my_node_.get_local_rank() << "]: Failed to serve metrics on port " << port << endl;
+        }
 
         worker_barrier(my_node_);
         fflush(stdout);
@@ -1177,6 +1806,14 @@ class Worker {
             }
 
             if (!RegisterQuery(plan)) {
+                if (plan.isAbort()) {
+                    aborted_trx_->Inc();
+                    abort_latency_->Observe(timer::get_usec() - plan.start_time);
+                } else {
+                    committed_trx_->Inc();
+                    commit_latency_->Observe(timer::get_usec() - plan.start_time);
+                }
+
                 // Reply to client when transaction is finished
                 if (!is_emu_mode_) { // If Running EMU, do NOT send result back
                     ReplyClient(plan);
@@ -1196,6 +1833,8 @@ class Worker {
                     }
                 }
                 NotifyTrxFinished(plan.GetStartTime());
+                // query plans of the trx are no longer requested by other workers
+                QueryPlanStore::GetInstance()->Unpin(qid.trxid);
                 // if not readonly, abtain its finished time
                 if (plan.GetTrxType() != TRX_READONLY) {
                     TimestampRequest req(qid.trxid, TIMESTAMP_TYPE::END_TIME);
@@ -1215,6 +1854,9 @@ class Worker {
         trx_table_write_executor.join();
         timestamp_generator.join();
         timestamp_consumer.join();
+        ingest_batch_processor.join();
+        ingest_part_processor.join();
+        async_reply_sender.join();
         process_rct_query_request.join();
         if (!config_->global_use_rdma) {
             trx_table_tcp_read_listener->join();
@@ -1253,12 +1895,44 @@ class Worker {
 
     vector<zmq::socket_t *> senders_;
 
+    // senders_ are shared by RecvRequest and ingestion threads
+    mutex senders_mutex_;
+
+    // client host of prepare request forwarded among workers
+    const string prepare_host_ = "PREPAREWORKER";
+    // client host of bulk ingestion messages among workers
+    const string ingest_host_ = "INGESTWORKER";
+
+    // State of prepare requests waiting for acks from other workers, indexed with trx_id
+    struct PrepareState {
+        int pending_acks = 0;
+        uint64_t stmt_id = 0;
+        string error_msg;  // the first error reported by other workers
+        TrxPlan plan;  // to reply client
+    };
+    mutex prepare_mutex_;
+    unordered_map<uint64_t, PrepareState> prepare_states_;
+
+    // State of bulk ingestion batches coordinated by this worker, indexed with trx_id
+    struct IngestState {
+        int pending_acks = 0;  // workers that have not acked their parts
+        bool success = true;
+        uint64_t timestamp = 0;  // the last allocated timestamp
+    };
+    mutex ingest_mutex_;
+    condition_variable ingest_cv_;
+    unordered_map<uint64_t, IngestState> ingest_states_;
+    ThreadSafeQueue<IngestBatchReq> pending_ingest_batches_;
+    ThreadSafeQueue<IngestPartReq> pending_ingest_parts_;
+
     DataStorage* data_storage_ = nullptr;
     TrxTableStub * trx_table_stub_;
 
     RCTable* rct_;
     TransactionStatusTable* trx_table_;
     ThreadSafeQueue<ParseTrxReq> pending_parse_trx_req_;
+    // (reply_endpoint, reply) to AsyncClients
+    ThreadSafeQueue<pair<string, AsyncReply>> pending_async_replies_;
 
     //the following five queues will be internally managed by Coordinator
     ThreadSafeQueue<UpdateTrxStatusReq> pending_trx_updates_;
@@ -1272,5 +1946,11 @@ class Worker {
 
     Coordinator* coordinator_;
     RunningTrxList* running_trx_list_;
+
+    // Runtime metrics
+    ShardedCounter* committed_trx_;
+    ShardedCounter* aborted_trx_;
+    ShardedHistogram* commit_latency_;
+    ShardedHistogram* abort_latency_;
 };
 #endif /* WORKER_HPP_ */
@@ -23,6 +23,7 @@
 #include "base/core_affinity.hpp"
 #include "core/message.hpp"
 #include "layout/data_storage.hpp"
+#include "utils/metrics.hpp"
 #include "utils/tid_pool_manager.hpp"
 
 class AbstractExpert {
@@ -33,6 +34,7 @@ class AbstractExpert {
         core_affinity_(core_affinity) {
         // instance initialized in worker.hpp
         data_storage_ = DataStorage::GetInstance();
+        ProcessAbortCounters();
     }
 
     virtual ~AbstractExpert() {}
@@ -43,6 +45,31 @@ class AbstractExpert {
     virtual void clean_trx_data(uint64_t TrxID) {}
 
  protected:
+    // Count abort in processing phase by PROCESS_STAT in runtime metrics
+    static void CountProcessAbort(PROCESS_STAT stat) {
+        ProcessAbortCounters()[static_cast<int>(stat)]->Inc();
+    }
+
+    // Counter of each abort PROCESS_STAT indexed by its value, registered once by the first expert
+    static const vector<ShardedCounter*>& ProcessAbortCounters() {
+        static const vector<ShardedCounter*> counters = [] {
+            int size = 0;
+            for (auto& item : abort_reason_map)
+                size = max(size, static_cast<int>(item.first) + 1);
+
+            vector<ShardedCounter*> vec(size, nullptr);
+            for (auto& item : abort_reason_map) {
+                // "[REASON]" -> "REASON"
+                const string& reason = item.second;
+                vec[static_cast<int>(item.first)] = MetricsRegistry::GetInstance()->GetCounter(
+                    "gtran_process_aborts_total", "Transactions aborted in processing phase, by reason",
+                    "reason=\"" + reason.substr(1, reason.size() - 2) + "\"");
+            }
+            return vec;
+        }();
+        return counters;
+    }
+
     // Data Storage
     DataStorage* data_storage_;
 
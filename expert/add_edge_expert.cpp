@@ -49,6 +49,7 @@ void AddEdgeExpert::process(const QueryPlan & qplan, Message & msg) {
                     abort_info = "Abort with [Processing][DataStorage::ProcessAddE<OutE>(" +
                                          to_string(e_id.src_v) + "->" + to_string(e_id.dst_v) + ")]" +
                                          abort_reason_map[process_stat];
+                    CountProcessAbort(process_stat);
                 }
             }
 
@@ -61,6 +62,7 @@ void AddEdgeExpert::process(const QueryPlan & qplan, Message & msg) {
                     abort_info = "Abort with [Processing][DataStorage::ProcessAddE<InE>(" +
                                          to_string(e_id.src_v) + "->" + to_string(e_id.dst_v) + ")]" +
                                          abort_reason_map[process_stat];
+                    CountProcessAbort(process_stat);
                 }
             }
 
@@ -42,8 +42,11 @@ void EndExpert::do_work(int tid, const QueryPlan & qplan, Message & msg,
                             std::make_move_iterator(pair.second.end()));
             }
 
-            if (isReady)
+            if (isReady) {
+                if (qplan.profile)
+                    Profiler::GetInstance()->Collect(qplan, msg.meta.qid, data);
                 rc_->InsertResult(msg.meta.qid, data);
+            }
         }
     }
 }
@@ -283,15 +286,30 @@ void DedupExpert::do_work(int tid, const QueryPlan & qplan, Message & msg,
 void GroupExpert::do_work(int tid, const QueryPlan & qplan, Message & msg,
         BarrierDataTable::accessor& ac, bool isReady) {
     auto& data_map = ac->second.data_map;
+    auto& count_map = ac->second.count_map;
     int branch_key = get_branch_key(msg.meta);
 
     // get expert params
     const Expert_Object& expert = qplan.experts[msg.meta.step];
     CHECK(expert.params.size() == 2);
+    bool isCount = Tool::value_t2int(expert.params[0]);
     int label_step = Tool::value_t2int(expert.params[1]);
 
     // process msg data
     for (auto& p : msg.data) {
+        if (msg.meta.is_combined) {
+            // partial result from sender: key1, count1, key2, count2 ...
+            int branch_value = get_branch_value(p.first, branch_key);
+            if (data_map.find(branch_value) == data_map.end()) {
+                data_map.insert({branch_value, {move(p.first), map<string, vector<value_t>>()}});
+            }
+            auto& counter = count_map[branch_value];
+            for (int i = 0; i + 1 < p.second.size(); i += 2) {
+                counter[Tool::value_t2string(p.second[i])] += Tool::value_t2int(p.second[i + 1]);
+            }
+            continue;
+        }
+
         // Get projected key if any
         value_t k;
         string key;
@@ -312,13 +330,16 @@ void GroupExpert::do_work(int tid, const QueryPlan & qplan, Message & msg,
             if (label_step == -1) {
                 key = val.DebugString();
             }
-            map_[key].push_back(move(val));
+            if (isCount) {
+                count_map[branch_value][key]++;
+            } else {
+                map_[key].push_back(move(val));
+            }
         }
     }
 
     // all msg are collected
     if (isReady) {
-        bool isCount = Tool::value_t2int(expert.params[0]);
         vector<pair<history_t, vector<value_t>>> msg_data;
 
         for (auto& p : data_map) {
@@ -326,14 +347,15 @@ void GroupExpert::do_work(int tid, const QueryPlan & qplan, Message & msg,
             // max msg size - sizeof(data_vec) - sizeof(current history) - sizeof(empty value_t)
             size_t max_size = msg.max_data_size - MemSize(msg_data) - MemSize(p.second.first) - MemSize(value_t());
 
-            vector<value_t> vec_val;
-            for (auto& item : p.second.second) {
-                string map_string;
-                // construct string
-                if (isCount) {
-                    map_string = item.first + ":" + to_string(item.second.size());
-                } else {
-                    map_string = item.first + ":[";
+            // construct string
+            vector<string> map_strings;
+            if (isCount) {
+                for (auto& item : count_map[p.first]) {
+                    map_strings.push_back(item.first + ":" + to_string(item.second));
+                }
+            } else {
+                for (auto& item : p.second.second) {
+                    string map_string = item.first + ":[";
                     for (auto& v : item.second) {
                         map_string += v.DebugString() + ", ";
                     }
@@ -343,8 +365,12 @@ void GroupExpert::do_work(int tid, const QueryPlan & qplan, Message & msg,
                         map_string.pop_back();
                     }
                     map_string += "]";
+                    map_strings.push_back(move(map_string));
                 }
+            }
 
+            vector<value_t> vec_val;
+            for (auto& map_string : map_strings) {
                 while (true) {
                     value_t v;
                     // each value_t should have at most max_size
@@ -375,78 +401,74 @@ void GroupExpert::do_work(int tid, const QueryPlan & qplan, Message & msg,
 void OrderExpert::do_work(int tid, const QueryPlan & qplan, Message & msg,
         BarrierDataTable::accessor& ac, bool isReady) {
     auto& data_map = ac->second.data_map;
-    auto& data_set = ac->second.data_set;
     int branch_key = get_branch_key(msg.meta);
 
     // get expert params
     const Expert_Object& expert = qplan.experts[msg.meta.step];
     CHECK(expert.params.size() == 2);
     int label_step = Tool::value_t2int(expert.params[0]);
+    Order_T order = (Order_T)Tool::value_t2int(expert.params[1]);
+    int limit = get_limit(qplan.experts, msg.meta.step);
+
+    // elements in front are ordered before elements in back
+    auto less = label_step >= 0 ? less_than : less_than_by_value;
+    auto cmp = [order, less](const BarrierData::order_elem_t& a, const BarrierData::order_elem_t& b) {
+        return order == Order_T::INCR ? less(a, b) : less(b, a);
+    };
 
     // process msg data
     for (auto& p : msg.data) {
+        // empty string if not found, so that keys always have a valid type
         value_t key;
-        get_history_value(p.first, label_step, key);
+        Tool::str2str("", key);
+        if (label_step >= 0) {
+            get_history_value(p.first, label_step, key);
+        }
         int branch_value = get_branch_value(p.first, branch_key);
-        if (label_step < 0) {
-            // get <history_t, multiset<value_t>> pair by branch_value
-            auto itr_data = data_set.find(branch_value);
-            if (itr_data == data_set.end()) {
-                itr_data = data_set.insert(itr_data, {branch_value, {move(p.first), multiset<value_t>()}});
-            }
-            auto& set_ = itr_data->second.second;
-            set_.insert(make_move_iterator(p.second.begin()), make_move_iterator(p.second.end()));
-        } else {
-            // get <history_t, map<value_t, multiset<value_t>>> pair by branch_value
-            auto itr_data = data_map.find(branch_value);
-            if (itr_data == data_map.end()) {
-                itr_data = data_map.insert(itr_data, {branch_value,
-                                    {move(p.first), map<value_t, multiset<value_t>>()}});
+
+        // get <history_t, vector<order_elem_t>> pair by branch_value
+        auto itr_data = data_map.find(branch_value);
+        if (itr_data == data_map.end()) {
+            itr_data = data_map.insert(itr_data, {branch_value, {move(p.first), vector<BarrierData::order_elem_t>()}});
+        }
+        auto& elems = itr_data->second.second;
+
+        for (auto& val : p.second) {
+            BarrierData::order_elem_t elem(key, move(val));
+            if (limit < 0) {
+                elems.push_back(move(elem));
+                continue;
             }
-            auto& map_ = itr_data->second.second;
 
-            map_[key].insert(make_move_iterator(p.second.begin()), make_move_iterator(p.second.end()));
+            // bounded heap with the last ordered element on top
+            if (elems.size() < limit) {
+                elems.push_back(move(elem));
+                push_heap(elems.begin(), elems.end(), cmp);
+            } else if (limit > 0 && cmp(elem, elems.front())) {
+                pop_heap(elems.begin(), elems.end(), cmp);
+                elems.back() = move(elem);
+                push_heap(elems.begin(), elems.end(), cmp);
+            }
         }
     }
 
     // all msg are collected
     if (isReady) {
-        Order_T order = (Order_T)Tool::value_t2int(expert.params[1]);
         vector<pair<history_t, vector<value_t>>> msg_data;
-        if (label_step < 0) {
-            for (auto& p : data_set) {
-                vector<value_t> val_vec;
-                auto& set_ = p.second.second;
-                if (order == Order_T::INCR) {
-                    val_vec.insert(val_vec.end(),
-                                   make_move_iterator(set_.begin()),
-                                   make_move_iterator(set_.end()));
-                } else {
-                    val_vec.insert(val_vec.end(),
-                                   make_move_iterator(set_.rbegin()),
-                                   make_move_iterator(set_.rend()));
-                }
-                msg_data.emplace_back(move(p.second.first), move(val_vec));
+        for (auto& p : data_map) {
+            auto& elems = p.second.second;
+            if (limit < 0) {
+                sort_elems(elems, label_step < 0, order);
+            } else {
+                sort_heap(elems.begin(), elems.end(), cmp);
             }
-        } else {
-            for (auto& p : data_map) {
-                vector<value_t> val_vec;
-                auto& m = p.second.second;
-                if (order == Order_T::INCR) {
-                    for (auto itr = m.begin(); itr != m.end(); itr++) {
-                        val_vec.insert(val_vec.end(),
-                                       make_move_iterator(itr->second.begin()),
-                                       make_move_iterator(itr->second.end()));
-                    }
-                } else {
-                    for (auto itr = m.rbegin(); itr != m.rend(); itr++) {
-                        val_vec.insert(val_vec.end(),
-                                       make_move_iterator(itr->second.rbegin()),
-                                       make_move_iterator(itr->second.rend()));
-                    }
-                }
-                msg_data.emplace_back(move(p.second.first), move(val_vec));
+
+            vector<value_t> val_vec;
+            val_vec.reserve(elems.size());
+            for (auto& elem : elems) {
+                val_vec.push_back(move(elem.second));
             }
+            msg_data.emplace_back(move(p.second.first), move(val_vec));
         }
 
         if (is_next_barrier(qplan.experts, msg.meta.step)) {
@@ -461,6 +483,78 @@ void OrderExpert::do_work(int tid, const QueryPlan & qplan, Message & msg,
     }
 }
 
+int OrderExpert::get_limit(const vector<Expert_Object>& experts, int step) {
+    int next = experts[step].next_expert;
+    if (next >= experts.size() || experts[next].expert_type != EXPERT_T::RANGE) {
+        return -1;
+    }
+    // range end is inclusive, -1 for unbounded
+    int end = Tool::value_t2int(experts[next].params[1]);
+    return end == -1 ? -1 : end + 1;
+}
+
+void OrderExpert::sort_elems(vector<BarrierData::order_elem_t>& elems, bool use_value, Order_T order) {
+    if (elems.size() == 0) {
+        return;
+    }
+
+    // check if all keys have the same numeric type
+    int type = use_value ? elems[0].second.type : elems[0].first.type;
+    for (auto& elem : elems) {
+        if ((use_value ? elem.second.type : elem.first.type) != type) {
+            type = -1;
+            break;
+        }
+    }
+
+    switch (type) {
+      case 1:
+        sort_by_typed_key<int>(elems, use_value, order, Tool::value_t2int); break;
+      case 2:
+        sort_by_typed_key<double>(elems, use_value, order, Tool::value_t2double); break;
+      case 5:
+        sort_by_typed_key<uint64_t>(elems, use_value, order, Tool::value_t2uint64_t); break;
+      default:
+        auto less = use_value ? less_than_by_value : less_than;
+        if (order == Order_T::INCR) {
+            sort(elems.begin(), elems.end(), less);
+        } else {
+            sort(elems.rbegin(), elems.rend(), less);
+        }
+    }
+}
+
+template<class T>
+void OrderExpert::sort_by_typed_key(vector<BarrierData::order_elem_t>& elems, bool use_value, Order_T order,
+                                    T (*convert)(const value_t&)) {
+    // <typed key, index in elems>
+    vector<pair<T, int>> keys;
+    keys.reserve(elems.size());
+    for (int i = 0; i < elems.size(); i++) {
+        keys.emplace_back(convert(use_value ? elems[i].second : elems[i].first), i);
+    }
+
+    // data with same key is still ordered by value
+    auto cmp = [&elems, &use_value](const pair<T, int>& a, const pair<T, int>& b) {
+        if (a.first != b.first) {
+            return a.first < b.first;
+        }
+        return !use_value && elems[a.second].second < elems[b.second].second;
+    };
+    if (order == Order_T::INCR) {
+        sort(keys.begin(), keys.end(), cmp);
+    } else {
+        sort(keys.rbegin(), keys.rend(), cmp);
+    }
+
+    vector<BarrierData::order_elem_t> sorted;
+    sorted.reserve(elems.size());
+    for (auto& k : keys) {
+        sorted.push_back(move(elems[k.second]));
+    }
+    elems = move(sorted);
+}
+
 void PostValidationExpert::do_work(int tid, const QueryPlan & qplan, Message & msg,
         BarrierDataTable::accessor& ac, bool isReady) {
     if (msg.meta.msg_type == MSG_T::ABORT) {
@@ -556,6 +650,21 @@ void RangeExpert::do_work(int tid, const QueryPlan & qplan, Message & msg,
         }
     }
 
+    // Range is fulfilled, notify upstream experts on all nodes to drop their data
+    // Not applied inside branch since each branch value has its own range
+    if (!isReady && !ac->second.is_cancelled && branch_key == -1 && end != INT_MAX) {
+        auto itr_cp = counter_map.find(-1);
+        if (itr_cp != counter_map.end() && itr_cp->second.first > end
+            && can_cancel_upstream(qplan, msg.meta.step)) {
+            ac->second.is_cancelled = true;
+            vector<Message> v;
+            msg.CreateCancelMsg(msg.meta.step, num_nodes_, v);
+            for (auto& m : v) {
+                mailbox_->Send(tid, m);
+            }
+        }
+    }
+
     // all msg are collected
     if (isReady) {
         vector<pair<history_t, vector<value_t>>> msg_data;
@@ -577,6 +686,19 @@ void RangeExpert::do_work(int tid, const QueryPlan & qplan, Message & msg,
     }
 }
 
+bool RangeExpert::can_cancel_upstream(const QueryPlan& qplan, int step) {
+    for (int i = 0; i < step; i++) {
+        switch (qplan.experts[i].expert_type) {
+          case EXPERT_T::ADDE: case EXPERT_T::ADDV: case EXPERT_T::DROP: case EXPERT_T::PROPERTY:
+            // updates should be applied to all data
+            return false;
+          default:
+            break;
+        }
+    }
+    return true;
+}
+
 void CoinExpert::do_work(int tid, const QueryPlan & qplan, Message & msg,
         BarrierDataTable::accessor& ac, bool isReady) {
     auto& counter_map = ac->second.counter_map;
@@ -690,6 +812,16 @@ void MathExpert::do_work(int tid, const QueryPlan & qplan, Message & msg,
             itr_data->second.count = 0;
         }
 
+        if (msg.meta.is_combined) {
+            // partial result from sender: value, count
+            if (p.second.size() == 2) {
+                int count = Tool::value_t2int(p.second[1]);
+                op(itr_data->second, p.second[0]);
+                itr_data->second.count += count - 1;
+            }
+            continue;
+        }
+
         for (auto& val : p.second) {
             op(itr_data->second, val);   // operate on new value
         }
@@ -24,6 +24,7 @@
 #include <utility>
 
 #include "core/factory.hpp"
+#include "core/profiler.hpp"
 #include "core/result_collector.hpp"
 #include "expert/abstract_expert.hpp"
 #include "expert/expert_validation_object.hpp"
@@ -235,6 +236,9 @@ struct group_data : barrier_data_base {
     //        history_t:                 histroy of data
     //        map<string,value_t>:    record key and values of grouped data
     unordered_map<int, pair<history_t, map<string, vector<value_t>>>> data_map;
+    // int: assigned branch value by labelled branch step
+    // map<string, int>: record key and count of grouped data, only for count mode
+    unordered_map<int, map<string, int>> count_map;
 };
 }  // namespace BarrierData
 
@@ -258,18 +262,15 @@ class GroupExpert : public BarrierExpertBase<BarrierData::group_data> {
 };
 
 namespace BarrierData {
+// <key for ordering, real data>, key is empty for order without mapping
+typedef pair<value_t, value_t> order_elem_t;
+
 struct order_data : barrier_data_base {
     // int: assigned branch value by labelled branch step
     // pair:
     //  history_t:                            histroy of data
-    //  map<value_t, multiset<value_t>>:
-    //      value_t:                          key for ordering
-    //      multiset<value_t>:                store real data
-
-    // for order with mapping
-    unordered_map<int, pair<history_t, map<value_t, multiset<value_t>>>> data_map;
-    // for order without mapping
-    unordered_map<int, pair<history_t, multiset<value_t>>> data_set;
+    //  vector<order_elem_t>:                 collected data, kept as bounded heap if limit is given
+    unordered_map<int, pair<history_t, vector<order_elem_t>>> data_map;
 };
 }  // namespace BarrierData
 
@@ -282,9 +283,30 @@ class OrderExpert : public BarrierExpertBase<BarrierData::order_data> {
         BarrierExpertBase<BarrierData::order_data>(id, core_affinity, mailbox),
         num_thread_(num_thread) {}
 
+    // Compare by key first, then by data
+    static inline bool less_than(const BarrierData::order_elem_t& a, const BarrierData::order_elem_t& b) {
+        return a.first < b.first || (!(b.first < a.first) && a.second < b.second);
+    }
+
+    // Compare by data only, for order without mapping where keys are not set
+    static inline bool less_than_by_value(const BarrierData::order_elem_t& a, const BarrierData::order_elem_t& b) {
+        return a.second < b.second;
+    }
+
+    // Get max number of data needed per branch when followed by range expert, -1 if unbounded
+    static int get_limit(const vector<Expert_Object>& experts, int step);
+
  private:
     int num_thread_;
 
+    // Sort elements in given order
+    // Use typed key array when all keys have the same numeric type
+    static void sort_elems(vector<BarrierData::order_elem_t>& elems, bool use_value, Order_T order);
+
+    template<class T>
+    static void sort_by_typed_key(vector<BarrierData::order_elem_t>& elems, bool use_value, Order_T order,
+                                  T (*convert)(const value_t&));
+
     void do_work(int tid,
             const QueryPlan& qplan,
             Message & msg,
@@ -329,19 +351,24 @@ struct range_data : barrier_data_base{
     //        int: counter, record num of incoming data
     //        vec: record data in given range
     unordered_map<int, pair<int, vector<pair<history_t, vector<value_t>>>>> counter_map;
+    // True if cancel msg is sent to upstream experts
+    bool is_cancelled = false;
 };
 }  // namespace BarrierData
 
 class RangeExpert : public BarrierExpertBase<BarrierData::range_data> {
  public:
     RangeExpert(int id,
+            int num_nodes,
             int num_thread,
             AbstractMailbox * mailbox,
             CoreAffinity* core_affinity) :
         BarrierExpertBase<BarrierData::range_data>(id, core_affinity, mailbox),
+        num_nodes_(num_nodes),
         num_thread_(num_thread) {}
 
  private:
+    int num_nodes_;
     int num_thread_;
 
     void do_work(int tid,
@@ -349,6 +376,9 @@ class RangeExpert : public BarrierExpertBase<BarrierData::range_data> {
             Message & msg,
             BarrierDataTable::accessor& ac,
             bool isReady);
+
+    // Limit can be pushed down if there is no update before range step
+    static bool can_cancel_upstream(const QueryPlan& qplan, int step);
 };
 
 class CoinExpert : public BarrierExpertBase<BarrierData::range_data> {
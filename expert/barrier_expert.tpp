@@ -47,6 +47,7 @@ void BarrierExpertBase<T>::process(const QueryPlan & qplan, Message & msg) {
         if (is_next_barrier(qplan.experts, msg.meta.step)) {
             // move to next expert
             msg.meta.step = qplan.experts[msg.meta.step].next_expert;
+            msg.meta.is_combined = false;
             if (qplan.experts[msg.meta.step].expert_type == EXPERT_T::COUNT) {
                 for (auto& p : msg.data) {
                     value_t v;
@@ -54,6 +54,7 @@ void DropExpert::process(const QueryPlan & qplan, Message & msg) {
         msg.CreateNextMsg(qplan.experts, msg.data, num_thread_, core_affinity_, msg_vec);
     } else {
         string abort_info = "Abort with [Processing][DropExpert::process]" + abort_reason_map[process_stat];
+        CountProcessAbort(process_stat);
         msg.CreateAbortMsg(qplan.experts, msg_vec, abort_info);
     }
 
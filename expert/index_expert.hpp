@@ -50,25 +50,46 @@ class IndexExpert : public AbstractExpert {
         Expert_Object expert_obj = qplan.experts[m.step];
 
         // Get Params
-        CHECK(expert_obj.params.size() == 2);  // make sure input format
+        CHECK(expert_obj.params.size() >= 2);  // make sure input format
         Element_T inType = (Element_T) Tool::value_t2int(expert_obj.params[0]);
-        int pid = Tool::value_t2int(expert_obj.params[1]);
+        // More than one pid for composite index
+        vector<int> pids;
+        for (int i = 1; i < expert_obj.params.size(); i++) {
+            pids.push_back(Tool::value_t2int(expert_obj.params[i]));
+        }
 
-        bool enabled = false;
-        switch (inType) {
-          case Element_T::VERTEX:
-            enabled = BuildIndexVtx(qplan, pid);
-            break;
-          case Element_T::EDGE:
-            enabled = BuildIndexEdge(qplan, pid);
-            break;
-          default:
+        if (inType != Element_T::VERTEX && inType != Element_T::EDGE) {
             cout << "Wrong inType" << endl;
             return;
         }
 
-        string ena = (enabled? "enabled":"disabled");
-        string s = "Index is " + ena + " in node" + to_string(m.recver_nid);
+        string s;
+        switch (index_store_->GetIndexBuildStat(inType, pids)) {
+          case IndexStore::IndexBuildStat::NOT_BUILT:
+            // build index in background, without blocking query processing
+            if (index_store_->StartIndexBuild(inType, pids, qplan.trxid, qplan.st)) {
+                s = "Index is building in node" + to_string(m.recver_nid);
+            } else {
+                s = "Index is disabled in node" + to_string(m.recver_nid);
+            }
+            break;
+          case IndexStore::IndexBuildStat::BUILDING:
+            s = "Index is still building in node" + to_string(m.recver_nid);
+            break;
+          case IndexStore::IndexBuildStat::BUILT:
+          {
+            bool enabled;
+            if (pids.size() == 1) {
+                enabled = index_store_->SetIndexMapEnable(inType, pids[0], true);
+            } else {
+                enabled = index_store_->SetCompositeIndexEnable(inType, pids, true);
+            }
+            string ena = (enabled? "enabled":"disabled");
+            s = "Index is " + ena + " in node" + to_string(m.recver_nid);
+            break;
+          }
+        }
+
         value_t v;
         Tool::str2str(s, v);
         msg.data.emplace_back(history_t(), vector<value_t>{v});
@@ -93,82 +114,6 @@ class IndexExpert : public AbstractExpert {
     AbstractMailbox * mailbox_;
 
     IndexStore * index_store_;
-
-    map<int, bool> vtx_enabled_map;
-    map<int, bool> edge_enabled_map;
-
-    bool BuildIndexVtx(const QueryPlan & qplan, int pid) {
-        if (vtx_enabled_map.find(pid) != vtx_enabled_map.end()) {
-            return index_store_->SetIndexMapEnable(Element_T::VERTEX, pid, true);
-        }
-        vector<vid_t> vid_list;
-        data_storage_->GetAllVertices(qplan.trxid, qplan.st, qplan.trx_type == TRX_READONLY, vid_list);
-
-        map<value_t, vector<uint64_t>> index_map;
-        vector<uint64_t> no_key_vec;
-
-        for (auto& vid : vid_list) {
-            uint64_t vtx = vid_t2uint(vid);
-            value_t val;
-            if (pid == 0) {
-                label_t label;
-                data_storage_->GetVL(vid, qplan.trxid, qplan.st, qplan.trx_type == TRX_READONLY, label);
-                Tool::str2int(to_string(label), val);
-                index_map[val].push_back(move(vtx));
-            } else {
-                vpid_t vp_id(vid, pid);
-                bool found = data_storage_->GetVPByPKey(vp_id, qplan.trxid, qplan.st, qplan.trx_type == TRX_READONLY, val)
-                             == READ_STAT::SUCCESS;
-                if (!found) {
-                    no_key_vec.push_back(move(vtx));
-                } else {
-                    index_map[val].push_back(move(vtx));
-                }
-            }
-        }
-
-        index_store_->SetIndexMap(Element_T::VERTEX, pid, index_map, no_key_vec);
-        vtx_enabled_map[pid] = true;
-
-        return index_store_->SetIndexMapEnable(Element_T::VERTEX, pid);
-    }
-
-    bool BuildIndexEdge(const QueryPlan & qplan, int pid) {
-        if (edge_enabled_map.find(pid) != edge_enabled_map.end()) {
-            return index_store_->SetIndexMapEnable(Element_T::EDGE, pid, true);
-        }
-        vector<eid_t> eid_list;
-        data_storage_->GetAllEdges(qplan.trxid, qplan.st, qplan.trx_type == TRX_READONLY, eid_list);
-
-        map<value_t, vector<uint64_t>> index_map;
-        vector<uint64_t> no_key_vec;
-
-        for (auto& eid : eid_list) {
-            uint64_t edge = eid_t2uint(eid);
-            value_t val;
-
-            if (pid == 0) {
-                label_t label;
-                data_storage_->GetEL(eid, qplan.trxid, qplan.st, qplan.trx_type == TRX_READONLY, label);
-                Tool::str2int(to_string(label), val);
-                index_map[val].push_back(move(edge));
-            } else {
-                epid_t ep_id(eid, pid);
-                bool found = data_storage_->GetEPByPKey(ep_id, qplan.trxid, qplan.st, qplan.trx_type == TRX_READONLY, val)
-                             == READ_STAT::SUCCESS;
-                if (!found) {
-                    no_key_vec.push_back(move(edge));
-                } else {
-                    index_map[val].push_back(move(edge));
-                }
-            }
-        }
-
-        index_store_->SetIndexMap(Element_T::EDGE, pid, index_map, no_key_vec);
-        edge_enabled_map[pid] = true;
-
-        return index_store_->SetIndexMapEnable(Element_T::EDGE, pid);
-    }
 };
 
 #endif  // EXPERT_INDEX_EXPERT_HPP_
@@ -68,7 +68,7 @@ class InitExpert : public AbstractExpert {
         } else if (expert_obj.params.size() == 2) {
             InitWithoutIndex(tid, qplan, init_data, msg, next_count);
         } else {
-            InitWithIndex(tid, qplan.experts, init_data, msg, next_count);
+            InitWithIndex(tid, qplan, init_data, msg, next_count);
             if (qplan.trx_type != TRX_READONLY && config_->isolation_level == ISOLATION_LEVEL::SERIALIZABLE) {
                 Element_T inType = (Element_T) Tool::value_t2int(expert_obj.params.at(0));
                 v_obj.RecordInputSetValueT(qplan.trxid, 0, inType, init_data.at(0).second, false);
@@ -188,62 +188,76 @@ class InitExpert : public AbstractExpert {
     }
 
     void InitVtxData(const Meta& m, const QueryPlan& qplan, vector<pair<history_t, vector<value_t>>> & init_data, bool & next_count) {
+        topo_snapshot_t<vid_t> vid_snapshot;
         vector<vid_t> vid_list;
         uint64_t start_time = timer::get_usec();
         if (config_->global_enable_indexing) {
-            index_store_->ReadVtxTopoIndex(qplan.trxid, qplan.st, qplan.trx_type == TRX_READONLY, vid_list);
+            // read chunks of index by reference
+            index_store_->ReadVtxTopoIndex(qplan.trxid, qplan.st, qplan.trx_type == TRX_READONLY, vid_snapshot);
         } else {
             data_storage_->GetAllVertices(qplan.trxid, qplan.st, qplan.trx_type == TRX_READONLY, vid_list);
         }
         uint64_t end_time = timer::get_usec();
         // cout << "[Timer] " << (end_time - start_time) << " us for GetAllVertices()" << endl;
-        uint64_t count = vid_list.size();
 
         // vector<pair<history_t, vector<value_t>>> data;
         init_data.clear();
         init_data.emplace_back(history_t(), vector<value_t>());
-        init_data[0].second.reserve(count);
 
         if (next_count) {
+            uint64_t count = config_->global_enable_indexing ? vid_snapshot.Count() : vid_list.size();
             value_t v; 
             Tool::str2int(to_string(count), v);
             init_data[0].second.emplace_back(v);
         } else {
-            for (auto& vid : vid_list) {
+            init_data[0].second.reserve(config_->global_enable_indexing ? vid_snapshot.MaxCount() : vid_list.size());
+            auto insert_func = [&init_data](const vid_t& vid) {
                 value_t v;
                 Tool::str2int(to_string(vid.value()), v);
                 init_data[0].second.emplace_back(v);
+            };
+            if (config_->global_enable_indexing) {
+                vid_snapshot.ForEach(insert_func);
+            } else {
+                for_each(vid_list.begin(), vid_list.end(), insert_func);
             }
         }
         vector<vid_t>().swap(vid_list);
     }
 
     void InitEdgeData(const Meta& m, const QueryPlan& qplan, vector<pair<history_t, vector<value_t>>>& init_data, bool & next_count) {
+        topo_snapshot_t<eid_t> eid_snapshot;
         vector<eid_t> eid_list;
         uint64_t start_time = timer::get_usec();
         if (config_->global_enable_indexing) {
-            index_store_->ReadEdgeTopoIndex(qplan.trxid, qplan.st, qplan.trx_type == TRX_READONLY, eid_list);
+            // read chunks of index by reference
+            index_store_->ReadEdgeTopoIndex(qplan.trxid, qplan.st, qplan.trx_type == TRX_READONLY, eid_snapshot);
         } else {
             data_storage_->GetAllEdges(qplan.trxid, qplan.st, qplan.trx_type == TRX_READONLY, eid_list);
         }
         uint64_t end_time = timer::get_usec();
         // cout << "[Timer] " << (end_time - start_time) << " us for GetAllEdges()" << endl;
-        uint64_t count = eid_list.size();
 
         // vector<pair<history_t, vector<value_t>>> data;
         init_data.clear();
         init_data.emplace_back(history_t(), vector<value_t>());
-        init_data[0].second.reserve(count);
 
         if (next_count) {
+            uint64_t count = config_->global_enable_indexing ? eid_snapshot.Count() : eid_list.size();
             value_t v; 
             Tool::str2int(to_string(count), v);
             init_data[0].second.emplace_back(v);
         } else {
-            for (auto& eid : eid_list) {
+            init_data[0].second.reserve(config_->global_enable_indexing ? eid_snapshot.MaxCount() : eid_list.size());
+            auto insert_func = [&init_data](const eid_t& eid) {
                 value_t v;
                 Tool::str2uint64_t(to_string(eid.value()), v);
                 init_data[0].second.push_back(v);
+            };
+            if (config_->global_enable_indexing) {
+                eid_snapshot.ForEach(insert_func);
+            } else {
+                for_each(eid_list.begin(), eid_list.end(), insert_func);
             }
         }
         vector<eid_t>().swap(eid_list);
@@ -270,9 +284,9 @@ class InitExpert : public AbstractExpert {
         }
     }
 
-    void InitWithIndex(int tid, const vector<Expert_Object> & expert_objs, vector<pair<history_t, vector<value_t>>>& init_data, Message & msg, bool& next_count) {
+    void InitWithIndex(int tid, const QueryPlan& qplan, vector<pair<history_t, vector<value_t>>>& init_data, Message & msg, bool& next_count) {
         Meta m = msg.meta;
-        const Expert_Object& expert_obj = expert_objs[m.step];
+        const Expert_Object& expert_obj = qplan.experts[m.step];
 
         // store all predicate
         vector<pair<int, PredicateValue>> pred_chain;
@@ -298,7 +312,7 @@ class InitExpert : public AbstractExpert {
         msg.data.emplace_back(history_t(), vector<value_t>());
         init_data.clear();
         init_data.emplace_back(history_t(), vector<value_t>());
-        index_store_->ReadPropIndex(inType, pred_chain, init_data[0].second);
+        index_store_->ReadPropIndex(inType, pred_chain, init_data[0].second, qplan.trxid, qplan.st, qplan.trx_type == TRX_READONLY);
 
         if (next_count) {
             int size = init_data[0].second.size();
@@ -60,7 +60,9 @@ class PropertyExpert : public AbstractExpert {
         int pid = static_cast<int>(Tool::value_t2int(expert_obj.params.at(1)));
         value_t new_val = expert_obj.params.at(2);
 
-        bool index_updatable = index_store_->IsIndexEnabled(elem_type, pid);
+        // Also buffer updates of composite index keys, and during background index build,
+        //  they are merged after the build is published
+        bool index_updatable = index_store_->IsIndexTracked(elem_type, pid);
 
         PROCESS_STAT process_stat = PROCESS_STAT::SUCCESS;
         switch (elem_type) {
@@ -104,6 +106,7 @@ class PropertyExpert : public AbstractExpert {
             msg.CreateNextMsg(qplan.experts, msg.data, num_thread_, core_affinity_, msg_vec);
         } else {
             string abort_info = "Abort with [Processing][PropertyExpert::process]" + abort_reason_map[process_stat];
+            CountProcessAbort(process_stat);
             msg.CreateAbortMsg(qplan.experts, msg_vec, abort_info);
         }
 
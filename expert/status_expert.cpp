@@ -15,6 +15,8 @@
 
 #include "expert/status_expert.hpp"
 #include "layout/garbage_collector.hpp"
+#include "layout/index_store.hpp"
+#include "utils/metrics.hpp"
 
 void StatusExpert::process(const QueryPlan & qplan, Message & msg) {
     int tid = TidPoolManager::GetInstance()->GetTid(TID_TYPE::RDMA);
@@ -33,6 +35,12 @@ void StatusExpert::process(const QueryPlan & qplan, Message & msg) {
         ret = data_storage_->GetContainerUsageString();
     } else if (status_key == "gc") {
         ret = GarbageCollector::GetInstance()->GetDepGCTaskStatusStatistics();
+    } else if (status_key == "index") {
+        // display progress of background index build
+        ret = IndexStore::GetInstance()->GetIndexBuildStatus();
+    } else if (status_key == "metrics") {
+        // display runtime metrics, as served on METRICS_PORT
+        ret = MetricsRegistry::GetInstance()->ExportText();
     } else {
         // undefined status key
         ret = "[Error] Invalid status key \"" + status_key;
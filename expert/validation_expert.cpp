@@ -15,6 +15,7 @@
 #include "expert/validation_expert.hpp"
 void ValidationExpert::process(const QueryPlan & qplan, Message & msg) {
     int tid = TidPoolManager::GetInstance()->GetTid(TID_TYPE::RDMA);
+    uint64_t start_time = timer::get_usec();
 
     // Move Update Data of Transaction from IndexBuffer to IndexRegion
     uint64_t self_ct; TRX_STAT stat;
@@ -84,6 +85,8 @@ void ValidationExpert::process(const QueryPlan & qplan, Message & msg) {
         valid_optimistic_read(homo_dep_read, isAbort);
     }
 
+    (isAbort ? abort_latency_ : commit_latency_)->Observe(timer::get_usec() - start_time);
+
     // Create Message
     vector<Message> msg_vec;
     msg.CreateNextMsg(qplan.experts, msg.data, num_thread_, core_affinity_, msg_vec);
@@ -35,6 +35,7 @@
 #include "expert/abstract_expert.hpp"
 #include "layout/index_store.hpp"
 #include "layout/pmt_rct_table.hpp"
+#include "utils/metrics.hpp"
 #include "utils/tool.hpp"
 #include "utils/mymath.hpp"
 
@@ -61,6 +62,12 @@ class ValidationExpert : public AbstractExpert {
         trx_table_stub_ = TrxTableStubFactory::GetTrxTableStub();
         index_store_ = IndexStore::GetInstance();
         prepare_primitive_list();
+
+        MetricsRegistry* registry = MetricsRegistry::GetInstance();
+        commit_latency_ = registry->GetHistogram("gtran_validation_latency_us", "Latency of validation on this worker",
+                                                 "result=\"commit\"");
+        abort_latency_ = registry->GetHistogram("gtran_validation_latency_us", "Latency of validation on this worker",
+                                                "result=\"abort\"");
     }
 
     void process(const QueryPlan & qplan, Message & msg);
@@ -91,6 +98,10 @@ class ValidationExpert : public AbstractExpert {
     // Primitive -> RCT Table
     PrimitiveRCTTable * pmt_rct_table_;
 
+    // Runtime metrics
+    ShardedHistogram * commit_latency_;
+    ShardedHistogram * abort_latency_;
+
     // TIMEOUT
     static const uint64_t OPT_VALID_TIMEOUT_ = 1;
     static const uint64_t OPT_VALID_SLEEP_TIME_ = 100;
@@ -0,0 +1,151 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+
+/*
+Arena snapshot is the on-disk format of ConcurrentMemPool and MVCCValueStore.
+-----------------------------------------------------------------------------------
+File layout:
+    [ArenaSnapshotHeader][ThreadLocalBlock * nthreads] ... [next_offset_] ... [attached_mem_]
+    next_offset_ and attached_mem_ are written verbatim, starting at page-aligned positions,
+    so that both of them can be directly mmap-ed when restoring.
+    Pages of attached_mem_ that are all zero (e.g., never touched) are skipped, leaving holes in the file.
+-----------------------------------------------------------------------------------
+Pointers stored inside the arena still point to the address space of the dumping process.
+mem_base records the dumped address of attached_mem_, so that the owner can relocate them.
+*/
+
+constexpr uint64_t ARENA_SNAPSHOT_MAGIC = 0x47545241524e4131;  // "GTRARNA1"
+constexpr uint64_t ARENA_SNAPSHOT_PAGE_SIZE = 4096;
+
+struct ArenaSnapshotHeader {
+    uint64_t magic;
+    uint64_t cell_size;
+    uint64_t offset_size;
+    uint64_t cell_count;
+    uint64_t nthreads;
+    uint64_t block_size;  // sizeof(ThreadLocalBlock)
+    uint64_t head;
+    uint64_t tail;
+    uint64_t mem_base;
+    uint64_t next_offset_pos;
+    uint64_t mem_pos;
+    uint64_t file_size;
+
+    bool Match(uint64_t _cell_size, uint64_t _offset_size, uint64_t _cell_count,
+               uint64_t _nthreads, uint64_t _block_size) const {
+        return magic == ARENA_SNAPSHOT_MAGIC && cell_size == _cell_size && offset_size == _offset_size &&
+               cell_count == _cell_count && nthreads == _nthreads && block_size == _block_size;
+    }
+};
+
+inline uint64_t AlignArenaSnapshotPos(uint64_t pos) {
+    return (pos + ARENA_SNAPSHOT_PAGE_SIZE - 1) / ARENA_SNAPSHOT_PAGE_SIZE * ARENA_SNAPSHOT_PAGE_SIZE;
+}
+
+inline bool PWriteAll(int fd, const char* buf, uint64_t len, uint64_t pos) {
+    while (len > 0) {
+        ssize_t written = pwrite(fd, buf, len, pos);
+        if (written <= 0)
+            return false;
+        buf += written;
+        len -= written;
+        pos += written;
+    }
+    return true;
+}
+
+// Write buf to fd, skipping all-zero pages
+inline bool PWriteSparse(int fd, const char* buf, uint64_t len, uint64_t pos) {
+    static const char zero_page[ARENA_SNAPSHOT_PAGE_SIZE] = {0};
+    uint64_t off = 0;
+    while (off < len) {
+        uint64_t sz = len - off < ARENA_SNAPSHOT_PAGE_SIZE ? len - off : ARENA_SNAPSHOT_PAGE_SIZE;
+        if (memcmp(buf + off, zero_page, sz) != 0 && !PWriteAll(fd, buf + off, sz, pos + off))
+            return false;
+        off += sz;
+    }
+    return true;
+}
+
+// header.next_offset_pos, header.mem_pos and header.file_size are filled in this function
+inline bool WriteArenaSnapshot(const std::string& path, ArenaSnapshotHeader& header, const void* blocks,
+                               const void* next_offset, const void* mem) {
+    uint64_t blocks_sz = header.block_size * header.nthreads;
+    uint64_t next_offset_sz = header.offset_size * header.cell_count;
+    uint64_t mem_sz = header.cell_size * header.cell_count;
+
+    header.magic = ARENA_SNAPSHOT_MAGIC;
+    header.next_offset_pos = AlignArenaSnapshotPos(sizeof(ArenaSnapshotHeader) + blocks_sz);
+    header.mem_pos = AlignArenaSnapshotPos(header.next_offset_pos + next_offset_sz);
+    header.file_size = header.mem_pos + mem_sz;
+
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+
+    // the file is extended first, so that skipped pages become holes
+    bool success = ftruncate(fd, header.file_size) == 0
+                   && PWriteAll(fd, reinterpret_cast<const char*>(&header), sizeof(ArenaSnapshotHeader), 0)
+                   && PWriteAll(fd, reinterpret_cast<const char*>(blocks), blocks_sz, sizeof(ArenaSnapshotHeader))
+                   && PWriteAll(fd, reinterpret_cast<const char*>(next_offset), next_offset_sz, header.next_offset_pos)
+                   && PWriteSparse(fd, reinterpret_cast<const char*>(mem), mem_sz, header.mem_pos);
+    close(fd);
+    return success;
+}
+
+inline bool ReadArenaSnapshotHeader(const std::string& path, ArenaSnapshotHeader& header) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    bool success = pread(fd, &header, sizeof(ArenaSnapshotHeader), 0) == sizeof(ArenaSnapshotHeader)
+                   && fstat(fd, &st) == 0
+                   && header.magic == ARENA_SNAPSHOT_MAGIC
+                   && static_cast<uint64_t>(st.st_size) == header.file_size;
+    close(fd);
+    return success;
+}
+
+/* Map the whole file privately: modifications after restoring are copy-on-write and never reach the file.
+ * Pages are loaded lazily; readahead is only advised.
+ * Returns nullptr on failure.
+ */
+inline char* MapArenaSnapshot(const std::string& path, ArenaSnapshotHeader& header) {
+    if (!ReadArenaSnapshotHeader(path, header))
+        return nullptr;
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+
+    void* addr = mmap(nullptr, header.file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return nullptr;
+
+    madvise(addr, header.file_size, MADV_WILLNEED);
+    return reinterpret_cast<char*>(addr);
+}
@@ -29,6 +29,8 @@
 #include <cstdio>
 #include <string>
 
+#include "layout/arena_snapshot.hpp"
+
 constexpr int CONCURRENT_MEM_POOL_DEFAULT_BLOCK_SIZE = 2048;  // 2K
 constexpr int CONCURRENT_MEM_POOL_ARRAY_MEMORY_ALIGNMENT = 4096;  // 4KB
 
@@ -69,6 +71,9 @@ Usage:
     3. Thread count (N) and the size of the memory pool need to be specified during initialization.
     4. When calling Get() and Free() function, a valid thread id in [0, N - 1] is needed:
         One tid should be only used by one thread. The undefined behavior will occur if multiple threads use the same tid in Get() or Free().
+    5. WriteSnapshot() dumps the pool verbatim (see arena_snapshot.hpp), and GetInstance() with snapshot_path maps it back.
+        Pointers stored in cells of a mapped pool are still in the address space of the dumping process; use Relocate() to translate them.
+        WriteSnapshot() should only be called when no thread is using the pool.
 */
 
 
@@ -91,6 +96,9 @@ class ConcurrentMemPool {
     */
     void Init(CellT* mem, size_t cell_count, int nthreads, bool utilization_record);
 
+    // Map memories and blocks from a file written by WriteSnapshot(). Returns false if the file does not match.
+    bool InitFromSnapshot(const std::string& path, size_t cell_count, int nthreads, bool utilization_record);
+
     bool mem_allocated_ __attribute__((aligned(16))) = false;
     CellT* attached_mem_ __attribute__((aligned(16))) = nullptr;
     OffsetT* next_offset_ __attribute__((aligned(16))) = nullptr;
@@ -117,19 +125,40 @@ class ConcurrentMemPool {
 
     ThreadLocalBlock* thread_local_block_ __attribute__((aligned(64)));
 
+    // The whole snapshot file if the pool is restored from it
+    char* mapped_file_ = nullptr;
+    size_t mapped_size_ = 0;
+    // attached_mem_ in the process that wrote the snapshot
+    CellT* dumped_mem_ = nullptr;
+
  public:
-    static ConcurrentMemPool* GetInstance(CellT* mem, size_t cell_count,
-                                          int nthreads, bool utilization_record) {
+    // If snapshot_path is not empty, the pool is mapped from that file, and nullptr is returned if the file does not match
+    static ConcurrentMemPool* GetInstance(CellT* mem, size_t cell_count, int nthreads,
+                                          bool utilization_record, const std::string& snapshot_path = "") {
         static ConcurrentMemPool* p = nullptr;
 
         if (p == nullptr && cell_count > 0) {
             p = new ConcurrentMemPool();
-            p->Init(mem, cell_count, nthreads, utilization_record);
+            if (snapshot_path.empty()) {
+                p->Init(mem, cell_count, nthreads, utilization_record);
+            } else if (!p->InitFromSnapshot(snapshot_path, cell_count, nthreads, utilization_record)) {
+                delete p;
+                p = nullptr;
+            }
         }
 
         return p;
     }
 
+    bool WriteSnapshot(const std::string& path);
+    // Check if the file written by WriteSnapshot() can be mapped to a pool with given capacity and thread count
+    static bool CheckSnapshot(const std::string& path, size_t cell_count, int nthreads);
+
+    // Translate a pointer in the dumping process to the mapped memory; identical if the pool is not restored
+    inline CellT* Relocate(CellT* dumped_ptr) const {
+        return dumped_ptr == nullptr ? nullptr : attached_mem_ + (dumped_ptr - dumped_mem_);
+    }
+
     CellT * Get(int tid = 0);
     void Free(CellT* cell, int tid = 0);
 
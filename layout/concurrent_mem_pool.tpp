@@ -14,6 +14,11 @@
 
 template<class CellT, class OffsetT, int BLOCK_SIZE>
 ConcurrentMemPool<CellT, OffsetT, BLOCK_SIZE>::~ConcurrentMemPool() {
+    if (mapped_file_ != nullptr) {
+        // next_offset_ and attached_mem_ are in the mapped file
+        munmap(mapped_file_, mapped_size_);
+        return;
+    }
     if (next_offset_ != nullptr)
         _mm_free(next_offset_);
     if (mem_allocated_)
@@ -66,6 +71,65 @@ void ConcurrentMemPool<CellT, OffsetT, BLOCK_SIZE>::Init(CellT* mem, size_t cell
 
     nthreads_ = nthreads;
     utilization_record_ = utilization_record;
+    dumped_mem_ = attached_mem_;
+}
+
+template<class CellT, class OffsetT, int BLOCK_SIZE>
+bool ConcurrentMemPool<CellT, OffsetT, BLOCK_SIZE>::InitFromSnapshot(const std::string& path, size_t cell_count,
+                                                                     int nthreads, bool utilization_record) {
+    ArenaSnapshotHeader header;
+    char* file = MapArenaSnapshot(path, header);
+    if (file == nullptr)
+        return false;
+
+    if (!header.Match(sizeof(CellT), sizeof(OffsetT), cell_count, nthreads, sizeof(ThreadLocalBlock))) {
+        munmap(file, header.file_size);
+        return false;
+    }
+
+    mapped_file_ = file;
+    mapped_size_ = header.file_size;
+
+    cell_count_ = cell_count;
+    attached_mem_ = reinterpret_cast<CellT*>(file + header.mem_pos);
+    mem_allocated_ = false;
+    next_offset_ = reinterpret_cast<OffsetT*>(file + header.next_offset_pos);
+    dumped_mem_ = reinterpret_cast<CellT*>(header.mem_base);
+
+    head_ = header.head;
+    tail_ = header.tail;
+
+    // thread-local blocks are modified frequently, copy them out of the file
+    thread_local_block_ = reinterpret_cast<ThreadLocalBlock*>(_mm_malloc(sizeof(ThreadLocalBlock) * nthreads, CONCURRENT_MEM_POOL_ARRAY_MEMORY_ALIGNMENT));
+    memcpy(thread_local_block_, file + sizeof(ArenaSnapshotHeader), sizeof(ThreadLocalBlock) * nthreads);
+
+    pthread_spin_init(&lock_, 0);
+
+    nthreads_ = nthreads;
+    utilization_record_ = utilization_record;
+    return true;
+}
+
+template<class CellT, class OffsetT, int BLOCK_SIZE>
+bool ConcurrentMemPool<CellT, OffsetT, BLOCK_SIZE>::WriteSnapshot(const std::string& path) {
+    ArenaSnapshotHeader header;
+    header.cell_size = sizeof(CellT);
+    header.offset_size = sizeof(OffsetT);
+    header.cell_count = cell_count_;
+    header.nthreads = nthreads_;
+    header.block_size = sizeof(ThreadLocalBlock);
+    header.head = head_;
+    header.tail = tail_;
+    header.mem_base = reinterpret_cast<uint64_t>(attached_mem_);
+
+    return WriteArenaSnapshot(path, header, thread_local_block_, next_offset_, attached_mem_);
+}
+
+template<class CellT, class OffsetT, int BLOCK_SIZE>
+bool ConcurrentMemPool<CellT, OffsetT, BLOCK_SIZE>::CheckSnapshot(const std::string& path, size_t cell_count, int nthreads) {
+    ArenaSnapshotHeader header;
+    return ReadArenaSnapshotHeader(path, header)
+           && header.Match(sizeof(CellT), sizeof(OffsetT), cell_count, nthreads, sizeof(ThreadLocalBlock));
 }
 
 template<class CellT, class OffsetT, int BLOCK_SIZE>
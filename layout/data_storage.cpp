@@ -14,6 +14,7 @@
 
 #include "layout/data_storage.hpp"
 #include "layout/garbage_collector.hpp"
+#include "core/profiler.hpp"
 
 // defined in mvcc_list.hpp, for recording reading dependencies
 tbb::concurrent_hash_map<uint64_t, depend_trx_lists> dep_trx_map;
@@ -33,8 +34,8 @@ void DataStorage::Init() {
     id_mapper_ = SimpleIdMapper::GetInstance();
     worker_rank_ = node_.get_local_rank();
     worker_size_ = node_.get_local_size();
-    // allow the main thread and GCConsumer threads to use memory pool
-    container_nthreads_ = config_->global_num_threads + 1 + config_->num_gc_consumer;
+    // allow the main thread, GCConsumer threads and ingestion threads to use memory pool
+    container_nthreads_ = config_->global_num_threads + config_->num_gc_consumer + Config::extra_container_thread_count;
 
     node_.Rank0PrintfWithWorkerBarrier(
                       "VE_ROW_CELL_COUNT = %d, sizeof(EdgeHeader) = %d, sizeof(VertexEdgeRow) = %d\n",
@@ -49,55 +50,81 @@ void DataStorage::Init() {
                        "sizeof(PropertyMVCCItem) = %d, sizeof(VertexMVCCItem) = %d, sizeof(EdgeMVCCItem) = %d\n",
                        sizeof(PropertyMVCCItem), sizeof(VertexMVCCItem), sizeof(EdgeMVCCItem));
 
-    CreateContainer();
-
     hdfs_data_loader_ = HDFSDataLoader::GetInstance();
 
     hdfs_data_loader_->GetStringIndexes();
+    indexes_ = hdfs_data_loader_->indexes_;
+
+    if (!ReadContainerSnapshot()) {
+        CreateContainer();
 
-    hdfs_data_loader_->LoadVertexData();
-    if (config_->predict_container_usage)
-        PredictVertexContainerUsage();
-    FillVertexContainer();
-    hdfs_data_loader_->FreeVertexMemory();
+        hdfs_data_loader_->LoadVertexData();
+        if (config_->predict_container_usage)
+            PredictVertexContainerUsage();
+        FillVertexContainer();
+        hdfs_data_loader_->FreeVertexMemory();
 
-    hdfs_data_loader_->LoadEdgeData();
-    if (config_->predict_container_usage)
-        PredictEdgeContainerUsage();
-    FillEdgeContainer();
-    hdfs_data_loader_->FreeEdgeMemory();
+        hdfs_data_loader_->LoadEdgeData();
+        if (config_->predict_container_usage)
+            PredictEdgeContainerUsage();
+        FillEdgeContainer();
+        hdfs_data_loader_->FreeEdgeMemory();
+
+        WriteContainerSnapshot();
+    }
 
+    if (config_->enable_redo_log)
+        CHECK(MPISnapshotManager::GetInstance()->GetRawDataPath("DataStorage::redo_log", true, redo_log_path_))
+            << "redo log needs SNAPSHOT_PATH";
+
+    // snapshot manager is deleted with the loader
     delete hdfs_data_loader_;
 
     garbage_collector_ = GarbageCollector::GetInstance();
 
     trx_table_stub_ = TrxTableStubFactory::GetTrxTableStub();
 
+    if (config_->enable_redo_log)
+        ReplayRedoLog();
+
     node_.Rank0PrintfWithWorkerBarrier("DataStorage::Init() all finished\n");
 }
 
-void DataStorage::CreateContainer() {
+void DataStorage::CreateContainer(bool from_snapshot) {
+    // empty path ==> create the container from scratch
+    auto snapshot_path = [&](const string& key) {
+        string path;
+        if (from_snapshot)
+            GetContainerSnapshotPath(key, false, path);
+        return path;
+    };
+
     ve_row_pool_ = ConcurrentMemPool<VertexEdgeRow>::GetInstance(
                             nullptr, config_->global_ve_row_pool_size, container_nthreads_,
-                            config_->global_enable_mem_pool_utilization_record);
+                            config_->global_enable_mem_pool_utilization_record, snapshot_path("ve_row_pool_"));
     vp_row_pool_ = ConcurrentMemPool<VertexPropertyRow>::GetInstance(
                             nullptr, config_->global_vp_row_pool_size, container_nthreads_,
-                            config_->global_enable_mem_pool_utilization_record);
+                            config_->global_enable_mem_pool_utilization_record, snapshot_path("vp_row_pool_"));
     ep_row_pool_ = ConcurrentMemPool<EdgePropertyRow>::GetInstance(
                             nullptr, config_->global_ep_row_pool_size, container_nthreads_,
-                            config_->global_enable_mem_pool_utilization_record);
+                            config_->global_enable_mem_pool_utilization_record, snapshot_path("ep_row_pool_"));
     vp_mvcc_pool_ = ConcurrentMemPool<VPropertyMVCCItem>::GetInstance(
                             nullptr, config_->global_vp_mvcc_pool_size, container_nthreads_,
-                            config_->global_enable_mem_pool_utilization_record);
+                            config_->global_enable_mem_pool_utilization_record, snapshot_path("vp_mvcc_pool_"));
     ep_mvcc_pool_ = ConcurrentMemPool<EPropertyMVCCItem>::GetInstance(
                             nullptr, config_->global_ep_mvcc_pool_size, container_nthreads_,
-                            config_->global_enable_mem_pool_utilization_record);
+                            config_->global_enable_mem_pool_utilization_record, snapshot_path("ep_mvcc_pool_"));
     vertex_mvcc_pool_ = ConcurrentMemPool<VertexMVCCItem>::GetInstance(
                             nullptr, config_->global_v_mvcc_pool_size, container_nthreads_,
-                            config_->global_enable_mem_pool_utilization_record);
+                            config_->global_enable_mem_pool_utilization_record, snapshot_path("vertex_mvcc_pool_"));
     edge_mvcc_pool_ = ConcurrentMemPool<EdgeMVCCItem>::GetInstance(
                             nullptr, config_->global_e_mvcc_pool_size, container_nthreads_,
-                            config_->global_enable_mem_pool_utilization_record);
+                            config_->global_enable_mem_pool_utilization_record, snapshot_path("edge_mvcc_pool_"));
+
+    // files have been checked in CheckContainerSnapshot
+    CHECK(ve_row_pool_ != nullptr && vp_row_pool_ != nullptr && ep_row_pool_ != nullptr
+          && vp_mvcc_pool_ != nullptr && ep_mvcc_pool_ != nullptr
+          && vertex_mvcc_pool_ != nullptr && edge_mvcc_pool_ != nullptr);
 
     MVCCList<VPropertyMVCCItem>::SetGlobalMemoryPool(vp_mvcc_pool_);
     MVCCList<EPropertyMVCCItem>::SetGlobalMemoryPool(ep_mvcc_pool_);
@@ -109,10 +136,18 @@ void DataStorage::CreateContainer() {
 
     uint64_t vp_sz = GiB2B(config_->global_vertex_property_kv_sz_gb);
     uint64_t ep_sz = GiB2B(config_->global_edge_property_kv_sz_gb);
-    vp_store_ = new MVCCValueStore(nullptr, vp_sz / (MEM_CELL_SIZE + sizeof(OffsetT)), container_nthreads_,
-                                   config_->global_enable_mem_pool_utilization_record);
-    ep_store_ = new MVCCValueStore(nullptr, ep_sz / (MEM_CELL_SIZE + sizeof(OffsetT)), container_nthreads_,
-                                   config_->global_enable_mem_pool_utilization_record);
+    if (from_snapshot) {
+        vp_store_ = MVCCValueStore::MapSnapshot(snapshot_path("vp_store_"), vp_sz / (MEM_CELL_SIZE + sizeof(OffsetT)),
+                                                container_nthreads_, config_->global_enable_mem_pool_utilization_record);
+        ep_store_ = MVCCValueStore::MapSnapshot(snapshot_path("ep_store_"), ep_sz / (MEM_CELL_SIZE + sizeof(OffsetT)),
+                                                container_nthreads_, config_->global_enable_mem_pool_utilization_record);
+        CHECK(vp_store_ != nullptr && ep_store_ != nullptr);
+    } else {
+        vp_store_ = new MVCCValueStore(nullptr, vp_sz / (MEM_CELL_SIZE + sizeof(OffsetT)), container_nthreads_,
+                                       config_->global_enable_mem_pool_utilization_record);
+        ep_store_ = new MVCCValueStore(nullptr, ep_sz / (MEM_CELL_SIZE + sizeof(OffsetT)), container_nthreads_,
+                                       config_->global_enable_mem_pool_utilization_record);
+    }
     PropertyRowList<VertexPropertyRow>::SetGlobalValueStore(vp_store_);
     PropertyRowList<EdgePropertyRow>::SetGlobalValueStore(ep_store_);
     VPropertyMVCCItem::SetGlobalValueStore(vp_store_);
@@ -330,43 +365,48 @@ double DataStorage::GetContainerUsage() {
 }
 
 void DataStorage::FillVertexContainer() {
-    indexes_ = hdfs_data_loader_->indexes_;
-
-    int max_vid = worker_rank_;
-    int v_printed_progress = 0;
+    const vector<TMPVertex>& shuffled_vtx = hdfs_data_loader_->shuffled_vtx_;
+    vector<int> max_vids(container_nthreads_, worker_rank_);
 
     InitPrintFillVProgress();
-    for (int i = 0; i < hdfs_data_loader_->shuffled_vtx_.size(); i++) {
-        PrintFillingProgress(i, v_printed_progress, threshold_print_progress_v_, "DataStorage::FillVertexContainer");
+    // Vertices are independent, thread i fills the i-th of every container_nthreads_ vertices
+    RunFillThreads([&](int tid) {
+        int v_printed_progress = 0;
+        for (size_t i = tid; i < shuffled_vtx.size(); i += container_nthreads_) {
+            if (tid == 0)
+                PrintFillingProgress(i, v_printed_progress, threshold_print_progress_v_, "DataStorage::FillVertexContainer");
 
-        const TMPVertex& vtx = hdfs_data_loader_->shuffled_vtx_[i];
+            const TMPVertex& vtx = shuffled_vtx[i];
 
-        // std::pair<VertexIterator iterator_to_inserted_item, bool insert_occurred>
-        auto insert_result = vertex_map_.insert(pair<uint32_t, Vertex>(vtx.id.value(), Vertex()));
-        VertexIterator v_itr = insert_result.first;
+            // std::pair<VertexIterator iterator_to_inserted_item, bool insert_occurred>
+            auto insert_result = vertex_map_.insert(pair<uint32_t, Vertex>(vtx.id.value(), Vertex()));
+            VertexIterator v_itr = insert_result.first;
 
-        if (max_vid < vtx.id.value())
-            max_vid = vtx.id.value();
+            if (max_vids[tid] < vtx.id.value())
+                max_vids[tid] = vtx.id.value();
 
-        v_itr->second.label = vtx.label;
-        // create row lists that attached to the Vertex
-        v_itr->second.vp_row_list = new PropertyRowList<VertexPropertyRow>;
-        v_itr->second.ve_row_list = new TopologyRowList;
+            v_itr->second.label = vtx.label;
+            // create row lists that attached to the Vertex
+            v_itr->second.vp_row_list = new PropertyRowList<VertexPropertyRow>;
+            v_itr->second.ve_row_list = new TopologyRowList;
 
-        v_itr->second.vp_row_list->Init();
-        v_itr->second.ve_row_list->Init(vtx.id);
+            v_itr->second.vp_row_list->Init();
+            v_itr->second.ve_row_list->Init(vtx.id);
 
-        v_itr->second.mvcc_list = new MVCCList<VertexMVCCItem>;
-        *(v_itr->second.mvcc_list->AppendInitialVersion()) = true;  // true ==> visible
+            v_itr->second.mvcc_list = new MVCCList<VertexMVCCItem>;
+            *(v_itr->second.mvcc_list->AppendInitialVersion()) = true;  // true ==> visible
 
-        // Insert vertex properties
-        for (int i = 0; i < vtx.vp_label_list.size(); i++) {
-            v_itr->second.vp_row_list->InsertInitialCell(vpid_t(vtx.id, vtx.vp_label_list[i]),
-                                                                vtx.vp_value_list[i]);
+            // Insert vertex properties
+            for (int j = 0; j < vtx.vp_label_list.size(); j++) {
+                v_itr->second.vp_row_list->InsertInitialCell(vpid_t(vtx.id, vtx.vp_label_list[j]),
+                                                             vtx.vp_value_list[j]);
+            }
         }
-    }
-    PrintFillingProgress(hdfs_data_loader_->shuffled_vtx_.size(), v_printed_progress, threshold_print_progress_v_, "DataStorage::FillVertexContainer");
+        if (tid == 0)
+            PrintFillingProgress(shuffled_vtx.size(), v_printed_progress, threshold_print_progress_v_, "DataStorage::FillVertexContainer");
+    });
 
+    int max_vid = *max_element(max_vids.begin(), max_vids.end());
     num_of_vertex_local_ = (max_vid - worker_rank_) / worker_size_;
 
     node_.LocalSequentialDebugPrint("vp_row_pool_: " + vp_row_pool_->UsageString());
@@ -378,40 +418,74 @@ void DataStorage::FillVertexContainer() {
 }
 
 void DataStorage::FillEdgeContainer() {
-    int out_e_printed_progress = 0;
-    int in_e_printed_progress = 0;
+    const vector<TMPOutEdge>& shuffled_out_edge = hdfs_data_loader_->shuffled_out_edge_;
+    const vector<TMPInEdge>& shuffled_in_edge = hdfs_data_loader_->shuffled_in_edge_;
 
     InitPrintFillEProgress();
 
-    // Insert edge properties and outE
-    for (int i = 0; i < hdfs_data_loader_->shuffled_out_edge_.size(); i++) {
-        PrintFillingProgress(i, out_e_printed_progress,
-                             threshold_print_progress_out_e_, "DataStorage::FillEdgeContainer, out edge");
+    // TopologyRowList of a vertex is not thread safe during loading,
+    // thus each thread only inserts cells to vertices with fill_tid(vid) == tid.
+    //  Local vids are worker_rank_ modulo worker_size_, thus partition by the local index of vid
+    auto fill_tid = [&](uint64_t vid) { return static_cast<int>((vid / worker_size_) % container_nthreads_); };
+    RunFillThreads([&](int tid) {
+        int out_e_printed_progress = 0;
+        int in_e_printed_progress = 0;
 
-        const TMPOutEdge& edge = hdfs_data_loader_->shuffled_out_edge_[i];
+        // Insert edge properties and outE
+        for (size_t i = 0; i < shuffled_out_edge.size(); i++) {
+            if (tid == 0)
+                PrintFillingProgress(i, out_e_printed_progress,
+                                     threshold_print_progress_out_e_, "DataStorage::FillEdgeContainer, out edge");
 
-        VertexIterator v_itr = vertex_map_.find(edge.id.src_v);
+            const TMPOutEdge& edge = shuffled_out_edge[i];
 
-        auto* ep_row_list = new PropertyRowList<EdgePropertyRow>;
-        ep_row_list->Init();
+            if (fill_tid(edge.id.src_v) == tid) {
+                VertexIterator v_itr = vertex_map_.find(edge.id.src_v);
 
-        // "true" means that is_out = true, as this edge is an outE for the Vertex
-        auto* mvcc_list = v_itr->second.ve_row_list->InsertInitialCell(true, edge.id.dst_v, edge.label, ep_row_list);
+                auto* ep_row_list = new PropertyRowList<EdgePropertyRow>;
+                ep_row_list->Init();
 
-        // edge map will have pointer of MVCCList<EdgeMVCCItem> in ve_row_list, similarly hereinafter.
-        OutEdgeIterator out_e_itr = out_edge_map_.insert(pair<uint64_t, OutEdge>(edge.id.value(), OutEdge())).first;
-        out_e_itr->second.mvcc_list = mvcc_list;
+                // "true" means that is_out = true, as this edge is an outE for the Vertex
+                auto* mvcc_list = v_itr->second.ve_row_list->InsertInitialCell(true, edge.id.dst_v, edge.label, ep_row_list);
 
-        EdgeVersion edge_version;
-        out_e_itr->second.mvcc_list->GetVisibleVersion(0, 0, true, edge_version);
+                // edge map will have pointer of MVCCList<EdgeMVCCItem> in ve_row_list, similarly hereinafter.
+                OutEdgeIterator out_e_itr = out_edge_map_.insert(pair<uint64_t, OutEdge>(edge.id.value(), OutEdge())).first;
+                out_e_itr->second.mvcc_list = mvcc_list;
 
-        // insert ep to out edge
-        for (int i = 0; i < edge.ep_label_list.size(); i++) {
-            edge_version.ep_row_list->InsertInitialCell(epid_t(edge.id, edge.ep_label_list[i]), edge.ep_value_list[i]);
+                EdgeVersion edge_version;
+                out_e_itr->second.mvcc_list->GetVisibleVersion(0, 0, true, edge_version);
+
+                // insert ep to out edge
+                for (int j = 0; j < edge.ep_label_list.size(); j++) {
+                    edge_version.ep_row_list->InsertInitialCell(epid_t(edge.id, edge.ep_label_list[j]), edge.ep_value_list[j]);
+                }
+            }
+
+            // check if the dst_v on this worker
+            if (fill_tid(edge.id.dst_v) == tid && id_mapper_->IsVertexLocal(edge.id.dst_v)) {
+                VertexIterator v_itr = vertex_map_.find(edge.id.dst_v);
+
+                // "false" => is_out = false => inE
+                auto* mvcc_list = v_itr->second.ve_row_list
+                                  ->InsertInitialCell(false, edge.id.src_v, edge.label, nullptr);
+
+                InEdgeIterator in_e_itr = in_edge_map_.insert(pair<uint64_t, InEdge>(edge.id.value(), InEdge())).first;
+                in_e_itr->second.mvcc_list = mvcc_list;
+            }
         }
+        if (tid == 0)
+            PrintFillingProgress(shuffled_out_edge.size(), out_e_printed_progress,
+                                 threshold_print_progress_out_e_, "DataStorage::FillEdgeContainer, out edge");
+
+        for (size_t i = 0; i < shuffled_in_edge.size(); i++) {
+            if (tid == 0)
+                PrintFillingProgress(i, in_e_printed_progress,
+                                     threshold_print_progress_in_e_, "DataStorage::FillEdgeContainer, in edge");
+
+            const TMPInEdge& edge = shuffled_in_edge[i];
+            if (fill_tid(edge.id.dst_v) != tid)
+                continue;
 
-        // check if the dst_v on this worker
-        if (id_mapper_->IsVertexLocal(edge.id.dst_v)) {
             VertexIterator v_itr = vertex_map_.find(edge.id.dst_v);
 
             // "false" => is_out = false => inE
@@ -421,36 +495,225 @@ void DataStorage::FillEdgeContainer() {
             InEdgeIterator in_e_itr = in_edge_map_.insert(pair<uint64_t, InEdge>(edge.id.value(), InEdge())).first;
             in_e_itr->second.mvcc_list = mvcc_list;
         }
+        if (tid == 0)
+            PrintFillingProgress(shuffled_in_edge.size(), in_e_printed_progress,
+                                 threshold_print_progress_in_e_, "DataStorage::FillEdgeContainer, in edge");
+    });
+
+    node_.LocalSequentialDebugPrint("ve_row_pool_: " + ve_row_pool_->UsageString());
+    node_.LocalSequentialDebugPrint("ep_row_pool_: " + ep_row_pool_->UsageString());
+    node_.LocalSequentialDebugPrint("ep_mvcc_pool_: " + ep_mvcc_pool_->UsageString());
+    node_.LocalSequentialDebugPrint("edge_mvcc_pool_: " + edge_mvcc_pool_->UsageString());
+    node_.LocalSequentialDebugPrint("ep_store_: " + ep_store_->UsageString());
+
+    node_.Rank0PrintfWithWorkerBarrier("DataStorage::FillEdgeContainer() finished\n");
+}
+
+void DataStorage::RunFillThreads(const function<void(int)>& fill_func) {
+    // Worker threads and GC threads are not started during loading,
+    // so all container tids can be borrowed by fill threads
+    vector<thread> threads;
+    for (int tid = 0; tid < container_nthreads_; tid++) {
+        threads.emplace_back([&, tid]() {
+            TidPoolManager::GetInstance()->Register(TID_TYPE::CONTAINER, tid);
+            fill_func(tid);
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
     }
-    PrintFillingProgress(hdfs_data_loader_->shuffled_out_edge_.size(), out_e_printed_progress,
-                         threshold_print_progress_out_e_, "DataStorage::FillEdgeContainer, out edge");
+}
 
-    for (int i = 0; i < hdfs_data_loader_->shuffled_in_edge_.size(); i++) {
-        PrintFillingProgress(i, in_e_printed_progress,
-                             threshold_print_progress_in_e_, "DataStorage::FillEdgeContainer, in edge");
+namespace {
 
-        const TMPInEdge& edge = hdfs_data_loader_->shuffled_in_edge_[i];
-    
+// A table is stored as [size][uint64_t * size]
+bool WriteSnapshotTable(const string& path, const vector<uint64_t>& table) {
+    ofstream out_f(path, ios::binary);
+    if (!out_f.is_open())
+        return false;
 
-        VertexIterator v_itr = vertex_map_.find(edge.id.dst_v);
+    uint64_t sz = table.size();
+    out_f.write(reinterpret_cast<const char*>(&sz), sizeof(uint64_t));
+    out_f.write(reinterpret_cast<const char*>(table.data()), sizeof(uint64_t) * sz);
+    out_f.close();
+    return out_f.good();
+}
 
-        // "false" => is_out = false => inE
-        auto* mvcc_list = v_itr->second.ve_row_list
-                          ->InsertInitialCell(false, edge.id.src_v, edge.label, nullptr);
+bool ReadSnapshotTable(const string& path, vector<uint64_t>& table) {
+    ifstream in_f(path, ios::binary);
+    if (!in_f.is_open())
+        return false;
+
+    uint64_t sz;
+    if (!in_f.read(reinterpret_cast<char*>(&sz), sizeof(uint64_t)))
+        return false;
+    table.resize(sz);
+    return static_cast<bool>(in_f.read(reinterpret_cast<char*>(table.data()), sizeof(uint64_t) * sz));
+}
+
+}  // namespace
+
+bool DataStorage::GetContainerSnapshotPath(const string& key, bool for_write, string& path) {
+    return MPISnapshotManager::GetInstance()->GetRawDataPath("DataStorage::" + key, for_write, path);
+}
+
+// Check the meta and headers of all container files, without mapping them
+bool DataStorage::CheckContainerSnapshot(vector<uint64_t>& meta) {
+    string path;
+    if (!GetContainerSnapshotPath("container_meta", false, path) || !ReadSnapshotTable(path, meta))
+        return false;
 
-        InEdgeIterator in_e_itr = in_edge_map_.insert(pair<uint64_t, InEdge>(edge.id.value(), InEdge())).first;
-        in_e_itr->second.mvcc_list = mvcc_list;
+    // {version, container_nthreads_, num_of_vertex_local_, row cell counts}, see WriteContainerSnapshot
+    if (meta.size() != 6 || meta[0] != CONTAINER_SNAPSHOT_VERSION || meta[1] != container_nthreads_
+        || meta[3] != VE_ROW_CELL_COUNT || meta[4] != VP_ROW_CELL_COUNT || meta[5] != EP_ROW_CELL_COUNT)
+        return false;
+
+    for (int tid = 0; tid < container_nthreads_; tid++) {
+        GetContainerSnapshotPath("container_table_" + to_string(tid), false, path);
+        if (access(path.c_str(), R_OK) != 0)
+            return false;
     }
-    PrintFillingProgress(hdfs_data_loader_->shuffled_in_edge_.size(), in_e_printed_progress,
-                         threshold_print_progress_in_e_, "DataStorage::FillEdgeContainer, in edge");
 
-    node_.LocalSequentialDebugPrint("ve_row_pool_: " + ve_row_pool_->UsageString());
-    node_.LocalSequentialDebugPrint("ep_row_pool_: " + ep_row_pool_->UsageString());
-    node_.LocalSequentialDebugPrint("ep_mvcc_pool_: " + ep_mvcc_pool_->UsageString());
-    node_.LocalSequentialDebugPrint("edge_mvcc_pool_: " + edge_mvcc_pool_->UsageString());
-    node_.LocalSequentialDebugPrint("ep_store_: " + ep_store_->UsageString());
+    uint64_t vp_store_cell_count = GiB2B(config_->global_vertex_property_kv_sz_gb) / (MEM_CELL_SIZE + sizeof(OffsetT));
+    uint64_t ep_store_cell_count = GiB2B(config_->global_edge_property_kv_sz_gb) / (MEM_CELL_SIZE + sizeof(OffsetT));
+
+    // a pool or store does not match if its capacity or cell layout has changed
+    bool success = true;
+    success &= GetContainerSnapshotPath("ve_row_pool_", false, path) && ConcurrentMemPool<VertexEdgeRow>::CheckSnapshot(
+                            path, config_->global_ve_row_pool_size, container_nthreads_);
+    success &= GetContainerSnapshotPath("vp_row_pool_", false, path) && ConcurrentMemPool<VertexPropertyRow>::CheckSnapshot(
+                            path, config_->global_vp_row_pool_size, container_nthreads_);
+    success &= GetContainerSnapshotPath("ep_row_pool_", false, path) && ConcurrentMemPool<EdgePropertyRow>::CheckSnapshot(
+                            path, config_->global_ep_row_pool_size, container_nthreads_);
+    success &= GetContainerSnapshotPath("vp_mvcc_pool_", false, path) && ConcurrentMemPool<VPropertyMVCCItem>::CheckSnapshot(
+                            path, config_->global_vp_mvcc_pool_size, container_nthreads_);
+    success &= GetContainerSnapshotPath("ep_mvcc_pool_", false, path) && ConcurrentMemPool<EPropertyMVCCItem>::CheckSnapshot(
+                            path, config_->global_ep_mvcc_pool_size, container_nthreads_);
+    success &= GetContainerSnapshotPath("vertex_mvcc_pool_", false, path) && ConcurrentMemPool<VertexMVCCItem>::CheckSnapshot(
+                            path, config_->global_v_mvcc_pool_size, container_nthreads_);
+    success &= GetContainerSnapshotPath("edge_mvcc_pool_", false, path) && ConcurrentMemPool<EdgeMVCCItem>::CheckSnapshot(
+                            path, config_->global_e_mvcc_pool_size, container_nthreads_);
+    success &= GetContainerSnapshotPath("vp_store_", false, path) && MVCCValueStore::CheckSnapshot(
+                            path, vp_store_cell_count, container_nthreads_);
+    success &= GetContainerSnapshotPath("ep_store_", false, path) && MVCCValueStore::CheckSnapshot(
+                            path, ep_store_cell_count, container_nthreads_);
+    return success;
+}
 
-    node_.Rank0PrintfWithWorkerBarrier("DataStorage::FillEdgeContainer() finished\n");
+bool DataStorage::ReadContainerSnapshot() {
+    vector<uint64_t> meta;
+    bool success = config_->enable_container_snapshot && CheckContainerSnapshot(meta);
+
+    // Make sure that all workers can restore from the snapshot
+    MPI_Allreduce(MPI_IN_PLACE, &success, 1, MPI_C_BOOL, MPI_LAND, node_.local_comm);
+
+    if (!success) {
+        if (config_->enable_container_snapshot)
+            node_.Rank0PrintfWithWorkerBarrier("!DataStorage::ReadContainerSnapshot()\n");
+        return false;
+    }
+
+    CreateContainer(true);
+    num_of_vertex_local_ = meta[2];
+
+    // The table of each thread is a sequence of vertex entries:
+    //   [vid, label, initial version, vp_row_list entries, ve_row_list entries]
+    RunFillThreads([&](int tid) {
+        string path;
+        vector<uint64_t> table;
+        GetContainerSnapshotPath("container_table_" + to_string(tid), false, path);
+        CHECK(ReadSnapshotTable(path, table)) << "failed to read " << path;
+
+        const uint64_t* pos = table.data();
+        const uint64_t* end = pos + table.size();
+        while (pos < end) {
+            vid_t vid = *pos++;
+            VertexIterator v_itr = vertex_map_.insert(pair<uint32_t, Vertex>(vid.value(), Vertex())).first;
+
+            v_itr->second.label = *pos++;
+            v_itr->second.mvcc_list = new MVCCList<VertexMVCCItem>;
+            v_itr->second.mvcc_list->RestoreInitialVersion(reinterpret_cast<VertexMVCCItem*>(*pos++));
+
+            v_itr->second.vp_row_list = new PropertyRowList<VertexPropertyRow>;
+            pos = v_itr->second.vp_row_list->RestoreInitialCells(pos);
+
+            // edge maps hold pointers of MVCCList<EdgeMVCCItem> in ve_row_list, as in FillEdgeContainer
+            v_itr->second.ve_row_list = new TopologyRowList;
+            pos = v_itr->second.ve_row_list->RestoreInitialCells(vid, pos,
+                    [&](const bool& is_out, const vid_t& conn_vtx_id, MVCCList<EdgeMVCCItem>* mvcc_list) {
+                if (is_out) {
+                    eid_t eid(conn_vtx_id.value(), vid.value());
+                    out_edge_map_.insert(pair<uint64_t, OutEdge>(eid.value(), OutEdge())).first->second.mvcc_list = mvcc_list;
+                } else {
+                    eid_t eid(vid.value(), conn_vtx_id.value());
+                    in_edge_map_.insert(pair<uint64_t, InEdge>(eid.value(), InEdge())).first->second.mvcc_list = mvcc_list;
+                }
+            });
+        }
+    });
+
+    node_.LocalSequentialDebugPrint("Restored containers:\n" + GetContainerUsageString());
+    node_.Rank0PrintfWithWorkerBarrier("DataStorage::ReadContainerSnapshot() finished\n");
+    return true;
+}
+
+// Called right after filling, when every row list holds initial cells only and no thread uses the containers
+void DataStorage::WriteContainerSnapshot() {
+    string meta_path;
+    if (!config_->enable_container_snapshot || !GetContainerSnapshotPath("container_meta", true, meta_path))
+        return;
+
+    // invalidate the previous snapshot first, meta is written only if all files are written
+    unlink(meta_path.c_str());
+
+    auto snapshot_path = [&](const string& key) {
+        string path;
+        GetContainerSnapshotPath(key, true, path);
+        return path;
+    };
+
+    bool success = true;
+    success &= ve_row_pool_->WriteSnapshot(snapshot_path("ve_row_pool_"));
+    success &= vp_row_pool_->WriteSnapshot(snapshot_path("vp_row_pool_"));
+    success &= ep_row_pool_->WriteSnapshot(snapshot_path("ep_row_pool_"));
+    success &= vp_mvcc_pool_->WriteSnapshot(snapshot_path("vp_mvcc_pool_"));
+    success &= ep_mvcc_pool_->WriteSnapshot(snapshot_path("ep_mvcc_pool_"));
+    success &= vertex_mvcc_pool_->WriteSnapshot(snapshot_path("vertex_mvcc_pool_"));
+    success &= edge_mvcc_pool_->WriteSnapshot(snapshot_path("edge_mvcc_pool_"));
+    success &= vp_store_->WriteSnapshot(snapshot_path("vp_store_"));
+    success &= ep_store_->WriteSnapshot(snapshot_path("ep_store_"));
+
+    vector<uint32_t> vids;
+    vids.reserve(vertex_map_.size());
+    for (auto& v_pair : vertex_map_)
+        vids.push_back(v_pair.first);
+
+    // vector<bool> cannot be written concurrently
+    vector<char> table_written(container_nthreads_);
+    RunFillThreads([&](int tid) {
+        vector<uint64_t> table;
+        for (size_t i = tid; i < vids.size(); i += container_nthreads_) {
+            Vertex& vtx = vertex_map_.find(vids[i])->second;
+            table.push_back(vids[i]);
+            table.push_back(vtx.label);
+            table.push_back(reinterpret_cast<uint64_t>(vtx.mvcc_list->GetHead()));
+            vtx.vp_row_list->DumpInitialCells(table);
+            vtx.ve_row_list->DumpInitialCells(table);
+        }
+        table_written[tid] = WriteSnapshotTable(snapshot_path("container_table_" + to_string(tid)), table);
+    });
+
+    for (char written : table_written)
+        success &= static_cast<bool>(written);
+
+    if (success) {
+        vector<uint64_t> meta = {CONTAINER_SNAPSHOT_VERSION, static_cast<uint64_t>(container_nthreads_),
+                                 static_cast<uint64_t>(num_of_vertex_local_),
+                                 VE_ROW_CELL_COUNT, VP_ROW_CELL_COUNT, EP_ROW_CELL_COUNT};
+        success = WriteSnapshotTable(meta_path, meta);
+    }
+
+    node_.LocalSequentialDebugPrint(string("DataStorage::WriteContainerSnapshot() ") + (success ? "finished" : "failed"));
 }
 
 READ_STAT DataStorage::CheckVertexVisibility(const VertexConstIterator& v_iterator, const uint64_t& trx_id,
@@ -472,6 +735,11 @@ READ_STAT DataStorage::CheckVertexVisibility(const VertexConstIterator& v_iterat
     return READ_STAT::SUCCESS;
 }
 
+void DataStorage::AbortOnRead(const uint64_t& trx_id) {
+    trx_table_stub_->update_status(trx_id, TRX_STAT::ABORT);
+    Profiler::RecordStorageAbort();
+}
+
 READ_STAT DataStorage::GetVertexIterator(VertexConstIterator& v_iterator, const vid_t& vid, const uint64_t& trx_id,
                                          const uint64_t& begin_time, const bool& read_only) {
     v_iterator = vertex_map_.find(vid.value());
@@ -485,7 +753,7 @@ READ_STAT DataStorage::GetVertexIterator(VertexConstIterator& v_iterator, const
      */
     auto read_stat = CheckVertexVisibility(v_iterator, trx_id, begin_time, read_only);
     if (read_stat == READ_STAT::ABORT) {
-        trx_table_stub_->update_status(trx_id, TRX_STAT::ABORT);
+        AbortOnRead(trx_id);
         return READ_STAT::ABORT;
     }
 
@@ -504,7 +772,7 @@ READ_STAT DataStorage::GetOutEdgeVersion(const eid_t& eid, const uint64_t& trx_i
     pair<bool, bool> is_visible = out_e_iterator->second.mvcc_list->GetVisibleVersion(trx_id, begin_time, read_only, version_ref);
 
     if (!is_visible.first) {
-        trx_table_stub_->update_status(trx_id, TRX_STAT::ABORT);
+        AbortOnRead(trx_id);
         return READ_STAT::ABORT;
     }
 
@@ -521,6 +789,7 @@ READ_STAT DataStorage::GetOutEdgeVersion(const eid_t& eid, const uint64_t& trx_i
 
 READ_STAT DataStorage::GetVPByPKey(const vpid_t& pid, const uint64_t& trx_id, const uint64_t& begin_time,
                                    const bool& read_only, value_t& ret) {
+    Profiler::RecordStorageRead();
     ReaderLockGuard reader_lock_guard(vertex_map_erase_rwlock_);
     VertexConstIterator v_iterator;
     auto read_stat = GetVertexIterator(v_iterator, pid.vid, trx_id, begin_time, read_only);
@@ -530,13 +799,14 @@ READ_STAT DataStorage::GetVPByPKey(const vpid_t& pid, const uint64_t& trx_id, co
     auto stat = v_iterator->second.vp_row_list->ReadProperty(pid, trx_id, begin_time, read_only, ret);
 
     if (stat == READ_STAT::ABORT)
-        trx_table_stub_->update_status(trx_id, TRX_STAT::ABORT);
+        AbortOnRead(trx_id);
 
     return stat;
 }
 
 READ_STAT DataStorage::GetAllVP(const vid_t& vid, const uint64_t& trx_id, const uint64_t& begin_time,
                                 const bool& read_only, vector<pair<label_t, value_t>>& ret) {
+    Profiler::RecordStorageRead();
     ReaderLockGuard reader_lock_guard(vertex_map_erase_rwlock_);
     VertexConstIterator v_iterator;
     auto read_stat = GetVertexIterator(v_iterator, vid, trx_id, begin_time, read_only);
@@ -546,7 +816,7 @@ READ_STAT DataStorage::GetAllVP(const vid_t& vid, const uint64_t& trx_id, const
     auto stat = v_iterator->second.vp_row_list->ReadAllProperty(trx_id, begin_time, read_only, ret);
 
     if (stat == READ_STAT::ABORT)
-        trx_table_stub_->update_status(trx_id, TRX_STAT::ABORT);
+        AbortOnRead(trx_id);
 
     return stat;
 }
@@ -554,6 +824,7 @@ READ_STAT DataStorage::GetAllVP(const vid_t& vid, const uint64_t& trx_id, const
 READ_STAT DataStorage::GetVPByPKeyList(const vid_t& vid, const vector<label_t>& p_key,
                                        const uint64_t& trx_id, const uint64_t& begin_time,
                                        const bool& read_only, vector<pair<label_t, value_t>>& ret) {
+    Profiler::RecordStorageRead();
     ReaderLockGuard reader_lock_guard(vertex_map_erase_rwlock_);
     VertexConstIterator v_iterator;
     auto read_stat = GetVertexIterator(v_iterator, vid, trx_id, begin_time, read_only);
@@ -563,13 +834,14 @@ READ_STAT DataStorage::GetVPByPKeyList(const vid_t& vid, const vector<label_t>&
     auto stat = v_iterator->second.vp_row_list->ReadPropertyByPKeyList(p_key, trx_id, begin_time, read_only, ret);
 
     if (stat == READ_STAT::ABORT)
-        trx_table_stub_->update_status(trx_id, TRX_STAT::ABORT);
+        AbortOnRead(trx_id);
 
     return stat;
 }
 
 READ_STAT DataStorage::GetVPidList(const vid_t& vid, const uint64_t& trx_id, const uint64_t& begin_time,
                                    const bool& read_only, vector<vpid_t>& ret) {
+    Profiler::RecordStorageRead();
     ReaderLockGuard reader_lock_guard(vertex_map_erase_rwlock_);
     VertexConstIterator v_iterator;
     auto read_stat = GetVertexIterator(v_iterator, vid, trx_id, begin_time, read_only);
@@ -579,13 +851,14 @@ READ_STAT DataStorage::GetVPidList(const vid_t& vid, const uint64_t& trx_id, con
     auto stat = v_iterator->second.vp_row_list->ReadPidList(trx_id, begin_time, read_only, ret);
 
     if (stat == READ_STAT::ABORT)
-        trx_table_stub_->update_status(trx_id, TRX_STAT::ABORT);
+        AbortOnRead(trx_id);
 
     return stat;
 }
 
 READ_STAT DataStorage::GetVL(const vid_t& vid, const uint64_t& trx_id,
                              const uint64_t& begin_time, const bool& read_only, label_t& ret) {
+    Profiler::RecordStorageRead();
     ReaderLockGuard reader_lock_guard(vertex_map_erase_rwlock_);
     VertexConstIterator v_iterator;
     auto read_stat = GetVertexIterator(v_iterator, vid, trx_id, begin_time, read_only);
@@ -599,6 +872,7 @@ READ_STAT DataStorage::GetVL(const vid_t& vid, const uint64_t& trx_id,
 
 READ_STAT DataStorage::GetEPByPKey(const epid_t& pid, const uint64_t& trx_id, const uint64_t& begin_time,
                                    const bool& read_only, value_t& ret) {
+    Profiler::RecordStorageRead();
     eid_t eid = eid_t(pid.dst_vid, pid.src_vid);
 
     EdgeVersion edge_version;
@@ -609,13 +883,14 @@ READ_STAT DataStorage::GetEPByPKey(const epid_t& pid, const uint64_t& trx_id, co
     auto stat = edge_version.ep_row_list->ReadProperty(pid, trx_id, begin_time, read_only, ret);
 
     if (stat == READ_STAT::ABORT)
-        trx_table_stub_->update_status(trx_id, TRX_STAT::ABORT);
+        AbortOnRead(trx_id);
 
     return stat;
 }
 
 READ_STAT DataStorage::GetAllEP(const eid_t& eid, const uint64_t& trx_id, const uint64_t& begin_time,
                                 const bool& read_only, vector<pair<label_t, value_t>>& ret) {
+    Profiler::RecordStorageRead();
     EdgeVersion edge_version;
     auto read_stat = GetOutEdgeVersion(eid, trx_id, begin_time, read_only, edge_version);
     if (read_stat != READ_STAT::SUCCESS)
@@ -624,7 +899,7 @@ READ_STAT DataStorage::GetAllEP(const eid_t& eid, const uint64_t& trx_id, const
    auto stat = edge_version.ep_row_list->ReadAllProperty(trx_id, begin_time, read_only, ret);
 
    if (stat == READ_STAT::ABORT)
-        trx_table_stub_->update_status(trx_id, TRX_STAT::ABORT);
+        AbortOnRead(trx_id);
 
     return stat;
 }
@@ -632,6 +907,7 @@ READ_STAT DataStorage::GetAllEP(const eid_t& eid, const uint64_t& trx_id, const
 READ_STAT DataStorage::GetEPByPKeyList(const eid_t& eid, const vector<label_t>& p_key,
                                        const uint64_t& trx_id, const uint64_t& begin_time,
                                        const bool& read_only, vector<pair<label_t, value_t>>& ret) {
+    Profiler::RecordStorageRead();
     EdgeVersion edge_version;
     auto read_stat = GetOutEdgeVersion(eid, trx_id, begin_time, read_only, edge_version);
     if (read_stat != READ_STAT::SUCCESS)
@@ -640,13 +916,14 @@ READ_STAT DataStorage::GetEPByPKeyList(const eid_t& eid, const vector<label_t>&
     auto stat = edge_version.ep_row_list->ReadPropertyByPKeyList(p_key, trx_id, begin_time, read_only, ret);
 
     if (stat == READ_STAT::ABORT)
-        trx_table_stub_->update_status(trx_id, TRX_STAT::ABORT);
+        AbortOnRead(trx_id);
 
     return stat;
 }
 
 READ_STAT DataStorage::GetEPidList(const eid_t& eid, const uint64_t& trx_id, const uint64_t& begin_time,
                                    const bool& read_only, vector<epid_t>& ret) {
+    Profiler::RecordStorageRead();
     EdgeVersion edge_version;
     auto read_stat = GetOutEdgeVersion(eid, trx_id, begin_time, read_only, edge_version);
     if (read_stat != READ_STAT::SUCCESS)
@@ -655,13 +932,14 @@ READ_STAT DataStorage::GetEPidList(const eid_t& eid, const uint64_t& trx_id, con
     auto stat = edge_version.ep_row_list->ReadPidList(trx_id, begin_time, read_only, ret);
 
     if (stat == READ_STAT::ABORT)
-        trx_table_stub_->update_status(trx_id, TRX_STAT::ABORT);
+        AbortOnRead(trx_id);
 
     return stat;
 }
 
 READ_STAT DataStorage::GetEL(const eid_t& eid, const uint64_t& trx_id,
                              const uint64_t& begin_time, const bool& read_only, label_t& ret) {
+    Profiler::RecordStorageRead();
     EdgeVersion edge_version;
     auto read_stat = GetOutEdgeVersion(eid, trx_id, begin_time, read_only, edge_version);
     if (read_stat != READ_STAT::SUCCESS)
@@ -674,6 +952,7 @@ READ_STAT DataStorage::GetEL(const eid_t& eid, const uint64_t& trx_id,
 READ_STAT DataStorage::GetConnectedVertexList(const vid_t& vid, const label_t& edge_label, const Direction_T& direction,
                                               const uint64_t& trx_id, const uint64_t& begin_time,
                                               const bool& read_only, vector<vid_t>& ret) {
+    Profiler::RecordStorageRead();
     ReaderLockGuard reader_lock_guard(vertex_map_erase_rwlock_);
     VertexConstIterator v_iterator;
     auto read_stat = GetVertexIterator(v_iterator, vid, trx_id, begin_time, read_only);
@@ -684,7 +963,7 @@ READ_STAT DataStorage::GetConnectedVertexList(const vid_t& vid, const label_t& e
                                                                     trx_id, begin_time, read_only, ret);
 
     if (stat == READ_STAT::ABORT)
-        trx_table_stub_->update_status(trx_id, TRX_STAT::ABORT);
+        AbortOnRead(trx_id);
 
     return stat;
 }
@@ -692,6 +971,7 @@ READ_STAT DataStorage::GetConnectedVertexList(const vid_t& vid, const label_t& e
 READ_STAT DataStorage::GetConnectedEdgeList(const vid_t& vid, const label_t& edge_label, const Direction_T& direction,
                                             const uint64_t& trx_id, const uint64_t& begin_time,
                                             const bool& read_only, vector<eid_t>& ret, bool need_read_lock) {
+    Profiler::RecordStorageRead();
     WritePriorRWLock* lock_ptr = need_read_lock ? &vertex_map_erase_rwlock_ : nullptr;
     ReaderLockGuard reader_lock_guard(*lock_ptr);
     VertexConstIterator v_iterator;
@@ -703,13 +983,14 @@ READ_STAT DataStorage::GetConnectedEdgeList(const vid_t& vid, const label_t& edg
                                                                   trx_id, begin_time, read_only, ret);
 
     if (stat == READ_STAT::ABORT)
-        trx_table_stub_->update_status(trx_id, TRX_STAT::ABORT);
+        AbortOnRead(trx_id);
 
     return stat;
 }
 
 READ_STAT DataStorage::GetAllVertices(const uint64_t& trx_id, const uint64_t& begin_time,
                                       const bool& read_only, vector<vid_t>& ret) {
+    Profiler::RecordStorageRead();
     ReaderLockGuard reader_lock_guard(vertex_map_erase_rwlock_);
     for (auto v_pair = vertex_map_.begin(); v_pair != vertex_map_.end(); v_pair++) {
         auto& v_item = v_pair->second;
@@ -723,7 +1004,7 @@ READ_STAT DataStorage::GetAllVertices(const uint64_t& trx_id, const uint64_t& be
 
         pair<bool, bool> is_visible = mvcc_list->GetVisibleVersion(trx_id, begin_time, read_only, exists);
         if (!is_visible.first) {
-            trx_table_stub_->update_status(trx_id, TRX_STAT::ABORT);
+            AbortOnRead(trx_id);
             return READ_STAT::ABORT;
         }
 
@@ -740,6 +1021,7 @@ READ_STAT DataStorage::GetAllVertices(const uint64_t& trx_id, const uint64_t& be
 
 READ_STAT DataStorage::GetAllEdges(const uint64_t& trx_id, const uint64_t& begin_time,
                                    const bool& read_only, vector<eid_t>& ret) {
+    Profiler::RecordStorageRead();
     ReaderLockGuard reader_lock_guard(out_edge_erase_rwlock_);
     for (auto e_pair = out_edge_map_.begin(); e_pair != out_edge_map_.end(); e_pair++) {
         EdgeMVCCItem* visible_version;
@@ -753,7 +1035,7 @@ READ_STAT DataStorage::GetAllEdges(const uint64_t& trx_id, const uint64_t& begin
 
         pair<bool, bool> is_visible = mvcc_list->GetVisibleVersion(trx_id, begin_time, read_only, edge_version);
         if (!is_visible.first) {
-            trx_table_stub_->update_status(trx_id, TRX_STAT::ABORT);
+            AbortOnRead(trx_id);
             return READ_STAT::ABORT;
         }
 
@@ -892,11 +1174,19 @@ vid_t DataStorage::AssignVID() {
     return vid_t(local_vid * worker_size_ + worker_rank_);
 }
 
+void DataStorage::AssignVIDs(const int& count, vector<vid_t>& vids) {
+    int first_local_vid = (num_of_vertex_local_ += count) - count + 1;
+    vids.reserve(vids.size() + count);
+    for (int i = 0; i < count; i++)
+        vids.emplace_back((first_local_vid + i) * worker_size_ + worker_rank_);
+}
+
 /* For each Process function (function call in the processing phase that will modify the database), an MVCCList
  * instance will be modified. InsertTrxProcessHistory will record the pointer of MVCCList in corresponding trx's
  * TrxProcessHistory, used when calling Abort or Commit.
  */
-void DataStorage::InsertTrxProcessHistory(const uint64_t& trx_id, const TrxProcessHistory::ProcessType& type, void* mvcc_list) {
+void DataStorage::InsertTrxProcessHistory(const uint64_t& trx_id, const TrxProcessHistory::ProcessType& type,
+                                          void* mvcc_list, const vid_t& vid) {
     CHECK(type != TrxProcessHistory::PROCESS_ADD_V);
     TransactionAccessor t_accessor;
     transaction_process_history_map_.insert(t_accessor, trx_id);
@@ -906,6 +1196,7 @@ void DataStorage::InsertTrxProcessHistory(const uint64_t& trx_id, const TrxProce
     q_item.mvcc_list = mvcc_list;
 
     t_accessor->second.process_vector.emplace_back(q_item);
+    t_accessor->second.touched_vids.emplace(vid.value());
 }
 
 /* However, if we want to abort AddV, the pointer of MVCCList is not enough, since we need to free vp_row_list
@@ -926,10 +1217,33 @@ void DataStorage::InsertTrxAddVHistory(const uint64_t& trx_id, void* mvcc_list,
     t_accessor->second.mvcclist_to_vid_map[mvcc_list] = vid.value();
 }
 
+template<class... Args>
+void DataStorage::InsertTrxRedoRecord(const uint64_t& trx_id, const RedoLogger::RecordType& type, const Args&... args) {
+    if (redo_logger_ == nullptr)
+        return;
+
+    TransactionAccessor t_accessor;
+    transaction_process_history_map_.insert(t_accessor, trx_id);
+
+    ibinstream& m = t_accessor->second.redo_log;
+    m << static_cast<uint8_t>(type);
+    ((m << args), ...);
+}
+
 vid_t DataStorage::ProcessAddV(const label_t& label, const uint64_t& trx_id, const uint64_t& begin_time) {
+    vid_t vid = AssignVID();
+    ProcessAddV(vid, label, trx_id, begin_time);
+    return vid;
+}
+
+void DataStorage::ProcessAddV(const vid_t& vid, const label_t& label, const uint64_t& trx_id, const uint64_t& begin_time) {
+    AddVertex(vid, label, trx_id, begin_time);
+    InsertTrxRedoRecord(trx_id, RedoLogger::ADD_V, static_cast<uint32_t>(vid.value()), label);
+}
+
+vid_t DataStorage::AddVertex(const vid_t& vid, const label_t& label, const uint64_t& trx_id, const uint64_t& begin_time) {
     // Guaranteed that the vid is identical in the whole system, it's impossible to insert two vertices with the same vid
     ReaderLockGuard reader_lock_guard(vertex_map_erase_rwlock_);
-    vid_t vid = AssignVID();
 
     // std::pair<VertexIterator iterator, bool insert_occurred>
     auto insert_result = vertex_map_.insert(pair<uint32_t, Vertex>(vid.value(), Vertex()));
@@ -982,7 +1296,8 @@ PROCESS_STAT DataStorage::ProcessDropV(const vid_t& vid, const uint64_t& trx_id,
     // false ==> invisible
     *mvcc_value_ptr = false;
 
-    InsertTrxProcessHistory(trx_id, TrxProcessHistory::PROCESS_DROP_V, v_iterator->second.mvcc_list);
+    InsertTrxProcessHistory(trx_id, TrxProcessHistory::PROCESS_DROP_V, v_iterator->second.mvcc_list, vid);
+    InsertTrxRedoRecord(trx_id, RedoLogger::DROP_V, static_cast<uint32_t>(vid.value()));
 
     for (auto eid : all_connected_edge) {
         if (eid.src_v == vid.value()) {
@@ -1105,7 +1420,8 @@ PROCESS_STAT DataStorage::ProcessAddE(const eid_t& eid, const label_t& label, co
         e_item->ep_row_list = ep_row_list;
     }
 
-    InsertTrxProcessHistory(trx_id, TrxProcessHistory::PROCESS_ADD_E, mvcc_list);
+    InsertTrxProcessHistory(trx_id, TrxProcessHistory::PROCESS_ADD_E, mvcc_list, vid);
+    InsertTrxRedoRecord(trx_id, RedoLogger::ADD_E, eid, label, is_out);
 
     return PROCESS_STAT::SUCCESS;
 }
@@ -1161,7 +1477,8 @@ PROCESS_STAT DataStorage::ProcessDropE(const eid_t& eid, const bool& is_out,
     e_item->label = 0;
     e_item->ep_row_list = nullptr;
 
-    InsertTrxProcessHistory(trx_id, TrxProcessHistory::PROCESS_DROP_E, mvcc_list);
+    InsertTrxProcessHistory(trx_id, TrxProcessHistory::PROCESS_DROP_E, mvcc_list, is_out ? src_vid : dst_vid);
+    InsertTrxRedoRecord(trx_id, RedoLogger::DROP_E, eid, is_out);
 
     return PROCESS_STAT::SUCCESS;
 }
@@ -1193,7 +1510,8 @@ PROCESS_STAT DataStorage::ProcessModifyVP(const vpid_t& pid, const value_t& valu
     else
         process_type = TrxProcessHistory::PROCESS_ADD_VP;
 
-    InsertTrxProcessHistory(trx_id, process_type, ret.second);
+    InsertTrxProcessHistory(trx_id, process_type, ret.second, pid.vid);
+    InsertTrxRedoRecord(trx_id, RedoLogger::MODIFY_VP, pid, value);
 
     return PROCESS_STAT::SUCCESS;
 }
@@ -1223,7 +1541,8 @@ PROCESS_STAT DataStorage::ProcessModifyEP(const epid_t& pid, const value_t& valu
     else
         process_type = TrxProcessHistory::PROCESS_ADD_EP;
 
-    InsertTrxProcessHistory(trx_id, process_type, ret.second);
+    InsertTrxProcessHistory(trx_id, process_type, ret.second, pid.src_vid);
+    InsertTrxRedoRecord(trx_id, RedoLogger::MODIFY_EP, pid, value);
 
     return PROCESS_STAT::SUCCESS;
 }
@@ -1247,7 +1566,8 @@ PROCESS_STAT DataStorage::ProcessDropVP(const vpid_t& pid, const uint64_t& trx_i
         return PROCESS_STAT::ABORT_DROP_VP_DROP;
     }
 
-    InsertTrxProcessHistory(trx_id, TrxProcessHistory::PROCESS_DROP_VP, ret);
+    InsertTrxProcessHistory(trx_id, TrxProcessHistory::PROCESS_DROP_VP, ret, pid.vid);
+    InsertTrxRedoRecord(trx_id, RedoLogger::DROP_VP, pid);
 
     return PROCESS_STAT::SUCCESS;
 }
@@ -1269,7 +1589,8 @@ PROCESS_STAT DataStorage::ProcessDropEP(const epid_t& pid, const uint64_t& trx_i
         return PROCESS_STAT::ABORT_DROP_EP_DROP;
     }
 
-    InsertTrxProcessHistory(trx_id, TrxProcessHistory::PROCESS_DROP_EP, ret);
+    InsertTrxProcessHistory(trx_id, TrxProcessHistory::PROCESS_DROP_EP, ret, pid.src_vid);
+    InsertTrxRedoRecord(trx_id, RedoLogger::DROP_EP, pid);
 
     return PROCESS_STAT::SUCCESS;
 }
@@ -1286,6 +1607,13 @@ void DataStorage::Commit(const uint64_t& trx_id, const uint64_t& commit_time) {
 
     auto& process_vector = t_accessor->second.process_vector;
 
+    // The record is appended before versions become visible. Thus, any transaction reading
+    // these versions commits later, and its record is behind this one in the log.
+    uint64_t redo_lsn = 0;
+    ibinstream& redo_log = t_accessor->second.redo_log;
+    if (redo_logger_ != nullptr && redo_log.size() > 0)
+        redo_lsn = redo_logger_->Append(commit_time, redo_log.get_buf(), redo_log.size());
+
     // An MVCCList can be modified for multiple times and thus repeadedly occurs in the process_vector.
     // However, only one Commit()/Abort() calling is needed. Similarly in DataStorage::Abort().
     unordered_set<TrxProcessHistory::ProcessRecord, TrxProcessHistory::ProcessRecordHash> touched_mvcclist_set;
@@ -1321,7 +1649,14 @@ void DataStorage::Commit(const uint64_t& trx_id, const uint64_t& commit_time) {
         }
     }
 
+    // Versions superseded by this transaction become garbage once the global min BT passes commit_time
+    garbage_collector_->PushLimboVids(commit_time, t_accessor->second.touched_vids);
+
     transaction_process_history_map_.erase(t_accessor);
+
+    // Return (and thus reply to the client) only after the transaction is durable
+    if (redo_lsn > 0)
+        redo_logger_->WaitDurable(redo_lsn);
 }
 
 /* Abort the transaction with trx_id on this worker.
@@ -1411,5 +1746,116 @@ void DataStorage::Abort(const uint64_t& trx_id) {
         }
     }
 
+    // Aborted versions are already freed, while MVCCLists emptied by the abort can be reclaimed at once
+    garbage_collector_->PushLimboVids(0, t_accessor->second.touched_vids);
+
     transaction_process_history_map_.erase(t_accessor);
 }
+
+/* Records are replayed in the order of commit time, each as a transaction with a local trx_id
+ * and begin_time == commit_time, thus all previously replayed versions are visible to it.
+ * Commit times are rebased to 1, 2, ..., so that they are older than any timestamp of this launch.
+ * Replayed transactions are not logged again, since redo_logger_ is created afterwards.
+ */
+void DataStorage::ReplayRedoLog() {
+    vector<RedoLogger::Record> records;
+    uint64_t valid_end = RedoLogger::ReadLog(redo_log_path_, records);
+    replay_end_time_ = RedoLogger::RebaseCommitTimes(records);
+
+    uint64_t trx_id = TRX_ID_MASK;
+    for (auto& record : records) {
+        trx_id++;
+        const uint64_t& begin_time = record.commit_time;
+
+        // obinstream takes the ownership of buf
+        char* buf = new char[record.payload.size()];
+        memcpy(buf, record.payload.data(), record.payload.size());
+        obinstream m(buf, record.payload.size());
+
+        while (!m.end()) {
+            uint8_t type;
+            m >> type;
+
+            PROCESS_STAT stat = PROCESS_STAT::SUCCESS;
+            switch (type) {
+                case RedoLogger::ADD_V: {
+                    uint32_t vid;
+                    label_t label;
+                    m >> vid >> label;
+                    AddVertex(vid, label, trx_id, begin_time);
+
+                    // keep AssignVID from reusing replayed vids
+                    int local_vid = (vid - worker_rank_) / worker_size_;
+                    if (num_of_vertex_local_ < local_vid)
+                        num_of_vertex_local_ = local_vid;
+                    break;
+                }
+                case RedoLogger::DROP_V: {
+                    uint32_t vid;
+                    vector<eid_t> in_eids, out_eids;
+                    m >> vid;
+                    // connected edges are dropped by their own records
+                    stat = ProcessDropV(vid, trx_id, begin_time, in_eids, out_eids);
+                    break;
+                }
+                case RedoLogger::ADD_E: {
+                    eid_t eid;
+                    label_t label;
+                    bool is_out;
+                    m >> eid >> label >> is_out;
+                    stat = ProcessAddE(eid, label, is_out, trx_id, begin_time);
+                    break;
+                }
+                case RedoLogger::DROP_E: {
+                    eid_t eid;
+                    bool is_out;
+                    m >> eid >> is_out;
+                    stat = ProcessDropE(eid, is_out, trx_id, begin_time);
+                    break;
+                }
+                case RedoLogger::MODIFY_VP: {
+                    vpid_t pid;
+                    value_t value, old_value;
+                    m >> pid >> value;
+                    stat = ProcessModifyVP(pid, value, old_value, trx_id, begin_time);
+                    break;
+                }
+                case RedoLogger::DROP_VP: {
+                    vpid_t pid;
+                    value_t old_value;
+                    m >> pid;
+                    stat = ProcessDropVP(pid, trx_id, begin_time, old_value);
+                    break;
+                }
+                case RedoLogger::MODIFY_EP: {
+                    epid_t pid;
+                    value_t value, old_value;
+                    m >> pid >> value;
+                    stat = ProcessModifyEP(pid, value, old_value, trx_id, begin_time);
+                    break;
+                }
+                case RedoLogger::DROP_EP: {
+                    epid_t pid;
+                    value_t old_value;
+                    m >> pid;
+                    stat = ProcessDropEP(pid, trx_id, begin_time, old_value);
+                    break;
+                }
+                default:
+                    CHECK(false) << "[DataStorage] Unknown redo record type " << static_cast<int>(type);
+            }
+
+            CHECK(stat == PROCESS_STAT::SUCCESS) << "[DataStorage] Failed to replay redo record of type "
+                                                 << static_cast<int>(type);
+        }
+
+        Commit(trx_id, record.commit_time);
+    }
+
+    redo_logger_ = new RedoLogger(redo_log_path_, valid_end);
+
+    // Replayed versions are read by transactions of any worker, thus no worker serves until every replay ends
+    MPI_Allreduce(MPI_IN_PLACE, &replay_end_time_, 1, MPI_UINT64_T, MPI_MAX, node_.local_comm);
+
+    node_.LocalSequentialDebugPrint("DataStorage::ReplayRedoLog() replayed " + to_string(records.size()) + " transactions");
+}
@@ -16,7 +16,9 @@
 #pragma once
 
 #include <cstdio>
+#include <functional>
 #include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -26,6 +28,7 @@
 #include "core/factory.hpp"
 #include "layout/hdfs_data_loader.hpp"
 #include "layout/layout_type.hpp"
+#include "layout/redo_logger.hpp"
 #include "utils/config.hpp"
 #include "utils/mymath.hpp"
 
@@ -77,6 +80,16 @@ struct TrxProcessHistory {
      * Used in DataStorage::Abort.
      */
     std::unordered_map<void*, uint32_t> mvcclist_to_vid_map;
+
+    /* Local vertices whose attached MVCCLists are modified (e.g., vid of the VP, src_v of the outE and EP).
+     * Passed to GarbageCollector as limbo entries in DataStorage::Commit/Abort, so that GC only scans these vertices.
+     */
+    std::unordered_set<uint32_t> touched_vids;
+
+    /* Logical effects of the transaction, appended to the RedoLogger in DataStorage::Commit.
+     * Only recorded when the redo log is enabled. See RedoLogger::RecordType for the format.
+     */
+    ibinstream redo_log;
 };
 
 class GCProducer;
@@ -90,9 +103,25 @@ class DataStorage {
     DataStorage(const DataStorage&);
 
     // ================ Creating and filling containers ================
-    void CreateContainer();
+    // If from_snapshot, containers are mapped from the container snapshot instead of being allocated
+    void CreateContainer(bool from_snapshot = false);
     void FillVertexContainer();
     void FillEdgeContainer();
+    // Run fill_func(tid) in container_nthreads_ threads, each registered with container tid
+    void RunFillThreads(const function<void(int)>& fill_func);
+
+
+    // ================ Container snapshot ================
+    /* After filling, pools and value stores are dumped verbatim (see arena_snapshot.hpp). Objects on the heap
+     * (vertex/edge maps, row lists and MVCCLists) are described by one table per fill thread, holding
+     * dumped pointers of row heads and initial versions. On restart, containers are mapped, and heap objects
+     * are rebuilt from the tables by relocating those pointers, without touching the loader.
+     */
+    static constexpr uint64_t CONTAINER_SNAPSHOT_VERSION = 1;
+    bool GetContainerSnapshotPath(const string& key, bool for_write, string& path);
+    bool CheckContainerSnapshot(vector<uint64_t>& meta);
+    bool ReadContainerSnapshot();
+    void WriteContainerSnapshot();
 
 
     // ================ Printing the loading progress ================
@@ -163,7 +192,7 @@ class DataStorage {
 
 
     // ================ Vid assignment ================
-    std::atomic_int num_of_vertex_local_;  // the number of vertices on this worker, modified in AssignVID
+    std::atomic_int num_of_vertex_local_;  // the number of vertices on this worker, modified in AssignVID(s)
     // Notice that even if a vertex is dropped, num_of_vertex_local_ will not decrease.
     vid_t AssignVID();
 
@@ -175,9 +204,23 @@ class DataStorage {
     typedef tbb::concurrent_hash_map<uint64_t, TrxProcessHistory>::const_accessor TransactionConstAccessor;
 
     // Record process type and pointer of MVCCList for non-readonly transaction.
-    void InsertTrxProcessHistory(const uint64_t& trx_id, const TrxProcessHistory::ProcessType& type, void* mvcc_list);
+    void InsertTrxProcessHistory(const uint64_t& trx_id, const TrxProcessHistory::ProcessType& type, void* mvcc_list, const vid_t& vid);
     // Specifically, for AddV operation, vid need to be recorded in addition
     void InsertTrxAddVHistory(const uint64_t& trx_id, void* mvcc_list, vid_t vid);
+    // Record the logical effect of a successful Process function for the redo log
+    template<class... Args>
+    void InsertTrxRedoRecord(const uint64_t& trx_id, const RedoLogger::RecordType& type, const Args&... args);
+
+
+    // ================ Redo log ================
+    RedoLogger* redo_logger_ = nullptr;  // nullptr if the redo log is disabled, or during replaying
+    string redo_log_path_;
+    // Replay committed transactions in the redo log on top of loaded data, then start the logger
+    void ReplayRedoLog();
+    uint64_t replay_end_time_ = 0;  // the last commit time of replayed transactions on all workers
+
+    // Insert a vertex with given vid, called by ProcessAddV and ReplayRedoLog
+    vid_t AddVertex(const vid_t& vid, const label_t& label, const uint64_t& trx_id, const uint64_t& begin_time);
 
 
     // ================ Locate a vertex or an edge in the maps ================
@@ -188,6 +231,8 @@ class DataStorage {
     // for an eid, there can be multiple versions of edges
     READ_STAT GetOutEdgeVersion(const eid_t& eid, const uint64_t& trx_id, const uint64_t& begin_time,
                                 const bool& read_only, EdgeVersion& item_ref);
+    // Abort the transaction on read conflict
+    void AbortOnRead(const uint64_t& trx_id);
 
 
     // ================ Aggregated data related ================
@@ -253,6 +298,8 @@ class DataStorage {
 
     // ================ Data modification ================
     vid_t ProcessAddV(const label_t& label, const uint64_t& trx_id, const uint64_t& begin_time);
+    // For bulk ingestion, the vid is assigned by AssignVIDs in advance
+    void ProcessAddV(const vid_t& vid, const label_t& label, const uint64_t& trx_id, const uint64_t& begin_time);
     PROCESS_STAT ProcessDropV(const vid_t& vid, const uint64_t& trx_id, const uint64_t& begin_time,
                               vector<eid_t>& in_eids, vector<eid_t>& out_eids);
     PROCESS_STAT ProcessAddE(const eid_t& eid, const label_t& label, const bool& is_out,
@@ -266,6 +313,8 @@ class DataStorage {
     // Transaction abort or commit. For each transaction, on each worker, Commit or Abort will need to be called only once.
     void Commit(const uint64_t& trx_id, const uint64_t& commit_time);
     void Abort(const uint64_t& trx_id);
+    // Timestamps handed out must be larger than it, 0 if nothing replayed
+    uint64_t GetReplayEndTime() const { return replay_end_time_; }
 
 
     // ================ Data modification ================
@@ -287,6 +336,9 @@ class DataStorage {
     // Initialization related
     void Init();
 
+    // Assign count vids on this worker with one atomic add, for bulk ingestion
+    void AssignVIDs(const int& count, vector<vid_t>& vids);
+
     // Dependency Read
     void GetDepReadTrxList(uint64_t trxID, set<uint64_t> & homoTrxDList, set<uint64_t> & heteroTrxIDList);
     void CleanDepReadTrxList(uint64_t trxID);
@@ -15,6 +15,8 @@
 #include "layout/garbage_collector.hpp"
 #include "layout/gc_producer.hpp"
 #include "layout/gc_consumer.hpp"
+#include "utils/simple_spinlock_guard.hpp"
+#include "utils/tid_pool_manager.hpp"
 
 const unordered_map<TaskStatus, string, EnumClassHash<TaskStatus>> task_status_string_map = {
     {TaskStatus::ACTIVE, "ACTIVE"},
@@ -67,6 +69,17 @@ GarbageCollector::GarbageCollector() {
     gc_producer_ = GCProducer::GetInstance();
     gc_consumer_ = GCConsumer::GetInstance();
     config_ = Config::GetInstance();
+    pending_job_seq_ = 0;
+    for (int i = 0; i < (int)JobType::COUNT; i++) {
+        pending_jobs_[i] = 0;
+        pending_cost_[i] = 0;
+    }
+
+    // Created before Init(), since transactions replayed from the redo log also produce garbage
+    if (config_->global_enable_garbage_collect) {
+        limbo_lists_ = vector<LimboList>(config_->global_num_threads + config_->num_gc_consumer
+                                         + Config::extra_container_thread_count);
+    }
 }
 
 void GarbageCollector::Init() {
@@ -88,9 +101,29 @@ void GarbageCollector::Init() {
         producer_jobs_[(int)DepGCTaskType::VP_ROW_LIST_DEFRAG] = &gc_producer_->vp_row_list_defrag_job;
         producer_jobs_[(int)DepGCTaskType::EP_ROW_LIST_GC] = &gc_producer_->ep_row_list_gc_job;
         producer_jobs_[(int)DepGCTaskType::EP_ROW_LIST_DEFRAG] = &gc_producer_->ep_row_list_defrag_job;
+
+        RegisterMetrics();
     }
 }
 
+void GarbageCollector::RegisterMetrics() {
+    MetricsRegistry* registry = MetricsRegistry::GetInstance();
+    for (int i = 0; i < (int)JobType::COUNT; i++) {
+        finished_jobs_[i] = registry->GetCounter("gtran_gc_finished_jobs_total", "GC jobs executed by GCConsumer",
+                                                 "type=\"" + string(JobTypeName[i]) + "\"");
+    }
+    registry->RegisterGauge("gtran_gc_pending_jobs", "GC jobs waiting for GCConsumer",
+                            [this](vector<pair<string, double>>& samples) {
+        for (int i = 0; i < (int)JobType::COUNT; i++)
+            samples.emplace_back("type=\"" + string(JobTypeName[i]) + "\"", pending_jobs_[i].load());
+    });
+    registry->RegisterGauge("gtran_gc_pending_cost", "Sum of costs of GC jobs waiting for GCConsumer",
+                            [this](vector<pair<string, double>>& samples) {
+        for (int i = 0; i < (int)JobType::COUNT; i++)
+            samples.emplace_back("type=\"" + string(JobTypeName[i]) + "\"", pending_cost_[i].load());
+    });
+}
+
 void GarbageCollector::Stop() {
     if (config_->global_enable_garbage_collect) {
         gc_producer_->Stop();
@@ -106,19 +139,42 @@ void GarbageCollector::PushJobToPendingQueue(DependentGCJob* job_ptr) {
             CHECK(task->GetTaskStatus() == TaskStatus::INVALID) << task->GetTaskInfoStr();
         }
     }
-    pending_job_queue.push(job_ptr);
+    PushPendingJob(job_ptr);
 }
 
 void GarbageCollector::PushJobToPendingQueue(IndependentGCJob* job_ptr) {
-    pending_job_queue.push(job_ptr);
+    PushPendingJob(job_ptr);
+}
+
+void GarbageCollector::PushPendingJob(AbstractGCJob* job_ptr) {
+    PendingGCJob pending_job;
+    pending_job.job = job_ptr;
+    pending_job.priority = static_cast<double>(job_ptr->sum_of_cost_) / max(job_ptr->COST_THRESHOLD, 1);
+    pending_job.seq = pending_job_seq_++;
+    pending_jobs_[(int)job_ptr->job_t_]++;
+    pending_cost_[(int)job_ptr->job_t_] += job_ptr->sum_of_cost_;
+    pending_job_queue.push(pending_job);
+
+    // Lock before notifying, otherwise the notification may be lost
+    // between the failed pop and the wait of a consumer
+    lock_guard<mutex> lock(pending_job_mutex_);
+    pending_job_cv_.notify_one();
 }
 
 void GarbageCollector::PushJobToFinishedQueue(AbstractGCJob* job_ptr) {
+    finished_jobs_[(int)job_ptr->job_t_]->Inc();
     finished_job_queue.push(job_ptr);
 }
 
-bool GarbageCollector::PopJobFromPendingQueue(AbstractGCJob*& job) {
-    return pending_job_queue.try_pop(job);
+void GarbageCollector::WaitAndPopJobFromPendingQueue(AbstractGCJob*& job) {
+    PendingGCJob pending_job;
+    while (!pending_job_queue.try_pop(pending_job)) {
+        unique_lock<mutex> lock(pending_job_mutex_);
+        pending_job_cv_.wait(lock, [&] {return !pending_job_queue.empty();});
+    }
+    job = pending_job.job;
+    pending_jobs_[(int)job->job_t_]--;
+    pending_cost_[(int)job->job_t_] -= job->sum_of_cost_;
 }
 
 bool GarbageCollector::PopJobFromFinishedQueue(AbstractGCJob*& job) {
@@ -141,6 +197,31 @@ bool GarbageCollector::PopGCAbleVidFromQueue(vid_t& vid) {
     return gcable_vid_queue.try_pop(vid);
 }
 
+void GarbageCollector::PushLimboVids(const uint64_t& end_time, const unordered_set<uint32_t>& vids) {
+    if (limbo_lists_.empty() || vids.empty())
+        return;
+
+    int tid = TidPoolManager::GetInstance()->GetTid(TID_TYPE::CONTAINER);
+    CHECK_LT(tid, limbo_lists_.size());
+    LimboList& limbo_list = limbo_lists_[tid];
+
+    SimpleSpinLockGuard lock_guard(&limbo_list.lock);
+    for (auto& vid : vids)
+        limbo_list.entries.emplace_back(end_time, vid);
+}
+
+void GarbageCollector::PopLimboVids(vector<pair<uint64_t, uint32_t>>& entries) {
+    vector<pair<uint64_t, uint32_t>> tmp;
+    for (auto& limbo_list : limbo_lists_) {
+        {
+            SimpleSpinLockGuard lock_guard(&limbo_list.lock);
+            tmp.swap(limbo_list.entries);
+        }
+        entries.insert(entries.end(), tmp.begin(), tmp.end());
+        tmp.clear();
+    }
+}
+
 string GarbageCollector::GetDepGCTaskStatusStatistics() {
     string ret;
     for (int i = 0; i < (int)DepGCTaskType::COUNT; i++) {
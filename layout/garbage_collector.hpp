@@ -14,10 +14,20 @@
 
 #pragma once
 
+#include <pthread.h>
+#include <tbb/concurrent_priority_queue.h>
 #include <tbb/concurrent_queue.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
 #include "layout/gc_task.hpp"
 #include "utils/config.hpp"
+#include "utils/metrics.hpp"
 
 class GCProducer;
 class GCConsumer;
@@ -38,7 +48,8 @@ class GarbageCollector {
     void PushJobToPendingQueue(IndependentGCJob*);
     void PushJobToPendingQueue(DependentGCJob*);
     void PushJobToFinishedQueue(AbstractGCJob*);
-    bool PopJobFromPendingQueue(AbstractGCJob*&);
+    // Block until a job is pending
+    void WaitAndPopJobFromPendingQueue(AbstractGCJob*&);
     bool PopJobFromFinishedQueue(AbstractGCJob*&);
 
     void PushGCAbleEidToQueue(vector<pair<eid_t, bool>>*);
@@ -46,6 +57,11 @@ class GarbageCollector {
     void PushGCAbleVidToQueue(vid_t);
     bool PopGCAbleVidFromQueue(vid_t&);
 
+    // Called in DataStorage::Commit/Abort. end_time: the commit time of the transaction, 0 for abort
+    void PushLimboVids(const uint64_t& end_time, const unordered_set<uint32_t>& vids);
+    // Move all limbo entries (end_time, vid) to entries
+    void PopLimboVids(vector<pair<uint64_t, uint32_t>>& entries);
+
     // Used in StatusExpert
     string GetDepGCTaskStatusStatistics();
 
@@ -56,7 +72,26 @@ class GarbageCollector {
 
     Config * config_;
 
-    tbb::concurrent_queue<AbstractGCJob*> pending_job_queue;
+    /* Pending jobs are popped in the order of sum_of_cost_ / COST_THRESHOLD, i.e., jobs reclaiming more garbage
+     * relative to their threshold first. Jobs with the same priority are popped in FIFO order.
+     */
+    struct PendingGCJob {
+        AbstractGCJob* job;
+        double priority;
+        uint64_t seq;
+    };
+    struct PendingGCJobCompare {
+        bool operator()(const PendingGCJob& a, const PendingGCJob& b) const {
+            return a.priority < b.priority || (a.priority == b.priority && a.seq > b.seq);
+        }
+    };
+    void PushPendingJob(AbstractGCJob*);
+
+    tbb::concurrent_priority_queue<PendingGCJob, PendingGCJobCompare> pending_job_queue;
+    atomic<uint64_t> pending_job_seq_;
+    // idle GCConsumer threads park on pending_job_cv_ instead of polling
+    mutex pending_job_mutex_;
+    condition_variable pending_job_cv_;
     tbb::concurrent_queue<AbstractGCJob*> finished_job_queue;
 
     // For TopoRowListGCTask and TopoRowListDefragTask, both of them
@@ -65,9 +100,28 @@ class GarbageCollector {
     tbb::concurrent_queue<vector<pair<eid_t, bool>>*> gcable_eid_queue;
     tbb::concurrent_queue<vid_t> gcable_vid_queue;
 
+    /* Vertices with versions superseded (or MVCCLists emptied) by committed (or aborted) transactions.
+     * One list per container thread, thus the committing thread only contends with GCProducer.
+     * GCProducer only scans a vertex after the global min BT passes its end_time, instead of scanning the whole vertex map.
+     */
+    struct LimboList {
+        pthread_spinlock_t lock;
+        vector<pair<uint64_t, uint32_t>> entries;
+
+        LimboList() { pthread_spin_init(&lock, 0); }
+        ~LimboList() { pthread_spin_destroy(&lock); }
+    };
+    vector<LimboList> limbo_lists_;
+
     // the pointer of job instances in GCProducer
     DependentGCJob* producer_jobs_[(int)DepGCTaskType::COUNT];
 
+    // GC backlog by JobType, i.e., jobs (and the sum of their costs) in pending_job_queue
+    atomic<int64_t> pending_jobs_[(int)JobType::COUNT];
+    atomic<int64_t> pending_cost_[(int)JobType::COUNT];
+    ShardedCounter* finished_jobs_[(int)JobType::COUNT];
+    void RegisterMetrics();
+
     friend class GCProducer;
     friend class GCConsumer;
 };
@@ -43,12 +43,7 @@ void GCConsumer::Execute() {
     tid_pool_manager_->Register(TID_TYPE::CONTAINER);
     while (true) {
         AbstractGCJob * job;
-        if (!garbage_collector_->PopJobFromPendingQueue(job)) {
-            // Give a sleep to GCConsumer rather than urgent pop
-            // to reduce lock contention
-            usleep(POP_PERIOD);
-            continue;
-        }
+        garbage_collector_->WaitAndPopJobFromPendingQueue(job);
 
         switch (job->job_t_) {
           case JobType::EraseV:
@@ -37,7 +37,7 @@ class GCConsumer {
     void Stop();
 
     // Each thread as GCConsumer will use Execute()
-    // to try pop Jobs from GarbageCollector
+    // to pop Jobs from GarbageCollector, and park when no job is pending
     void Execute();
 
  private:
@@ -56,10 +56,6 @@ class GCConsumer {
     RCTable * rct_table_;
     TransactionStatusTable * trx_table_;
 
-    // Sleep period for GCConsumer to rest
-    // (unit : us)
-    const int POP_PERIOD = 5000;
-
     // ===========Execute Function for each Job===========
     void ExecuteEraseVJob(EraseVJob*);
     void ExecuteEraseOutEJob(EraseOutEJob*);
@@ -497,7 +497,8 @@ void GCProducer::Execute() {
         uint64_t start_time = timer::get_usec();
         running_trx_list_->UpdateGlobalMinBT();
 
-        scan_vertex_map();
+        // Only vertices modified by committed or aborted transactions are scanned
+        scan_limbo_vertices();
 
         // Scan Index Store
         scan_topo_index_update_region();
@@ -509,7 +510,8 @@ void GCProducer::Execute() {
         uint64_t end_time = timer::get_usec();
 
         cout << "[Node " << node_.get_local_rank() << "][GCProducer] Scan Time: " << ((end_time - start_time) / 1000)
-             << "ms, container usage: " << data_storage_->GetContainerUsage() * 100 << "%" << endl;
+             << "ms, limbo entries: " << limbo_entries_.size()
+             << ", container usage: " << data_storage_->GetContainerUsage() * 100 << "%" << endl;
 
         // Currently, sleep for a while and the do next scan
         sleep(SCAN_PERIOD);
@@ -523,49 +525,71 @@ void GCProducer::Execute() {
 }
 
 
-void GCProducer::scan_vertex_map() {
-    // Scan the vertex map
-    ReaderLockGuard reader_lock_guard(data_storage_->vertex_map_erase_rwlock_);
-    for (auto v_pair = data_storage_->vertex_map_.begin(); v_pair != data_storage_->vertex_map_.end(); v_pair++) {
-        auto& v_item = v_pair->second;
-
-        MVCCList<VertexMVCCItem>* mvcc_list = v_item.mvcc_list;
-        if (mvcc_list == nullptr) { continue; }  // the insertion is not finished
-
-        SimpleSpinLockGuard lock_guard(&(mvcc_list->lock_));
+void GCProducer::scan_limbo_vertices() {
+    garbage_collector_->PopLimboVids(limbo_entries_);
 
-        VertexMVCCItem* mvcc_item = mvcc_list->GetHead();
-        if (mvcc_item == nullptr) { continue; }  // already marked to be erased
+    // Entries whose end_time is not passed by the global min BT are kept for the next round
+    unordered_set<uint32_t> gc_vids;
+    int kept_count = 0;
+    for (auto& entry : limbo_entries_) {
+        if (entry.first < running_trx_list_->GetGlobalMinBT())
+            gc_vids.emplace(entry.second);
+        else
+            limbo_entries_[kept_count++] = entry;
+    }
+    limbo_entries_.resize(kept_count);
 
-        // Uncommitted new vertex, ignore
-        if (mvcc_item->GetTransactionID() != 0) { continue; }
+    ReaderLockGuard reader_lock_guard(data_storage_->vertex_map_erase_rwlock_);
+    for (auto& vid_value : gc_vids) {
+        auto v_pair = data_storage_->vertex_map_.find(vid_value);
+        if (v_pair == data_storage_->vertex_map_.end()) { continue; }  // already erased
 
-        // VertexMVCCList is different with other MVCCList since it only has at most
-        // two versions and the second version must be deleted version
-        // Therefore, if the first version is unvisible to any transaction
-        // (i.e. version->end_time < MINIMUM_ACTIVE_TRANSACTION_BT), the vertex can be GC.
         vid_t vid;
         uint2vid_t(v_pair->first, vid);
-
-        if (mvcc_item->GetEndTime() < running_trx_list_->GetGlobalMinBT()) {
-            // Deleted vertex, GCable
-            mvcc_list->head_ = nullptr;
-            mvcc_list->tail_ = nullptr;
-            mvcc_list->pre_tail_ = nullptr;
-            mvcc_list->tmp_pre_tail_ = nullptr;
-
-            spawn_erase_vertex_gctask(vid);
-            spawn_v_mvcc_gctask(mvcc_item);
-            spawn_vp_row_list_gctask(v_item.vp_row_list, vid);
-            spawn_topo_row_list_gctask(v_item.ve_row_list, vid);
-        } else {
-            // go deeper, to prop first and then topo
-            scan_prop_row_list(vid.value(), v_item.vp_row_list);
-            scan_topo_row_list(vid, v_item.ve_row_list);
+        scan_deferred_ = false;
+        if (!scan_vertex(vid, v_pair->second) || scan_deferred_) {
+            // Garbage may be left, scan again in the next round.
+            //  Kept in limbo_entries_ instead of PushLimboVids, since this thread has no container tid
+            limbo_entries_.emplace_back(0, vid_value);
         }
     }
 }
 
+bool GCProducer::scan_vertex(vid_t& vid, Vertex& v_item) {
+    MVCCList<VertexMVCCItem>* mvcc_list = v_item.mvcc_list;
+    if (mvcc_list == nullptr) { return false; }  // the insertion is not finished
+
+    SimpleSpinLockGuard lock_guard(&(mvcc_list->lock_));
+
+    VertexMVCCItem* mvcc_item = mvcc_list->GetHead();
+    if (mvcc_item == nullptr) { return true; }  // already marked to be erased
+
+    // Uncommitted new vertex, ignore
+    if (mvcc_item->GetTransactionID() != 0) { return false; }
+
+    // VertexMVCCList is different with other MVCCList since it only has at most
+    // two versions and the second version must be deleted version
+    // Therefore, if the first version is unvisible to any transaction
+    // (i.e. version->end_time < MINIMUM_ACTIVE_TRANSACTION_BT), the vertex can be GC.
+    if (mvcc_item->GetEndTime() < running_trx_list_->GetGlobalMinBT()) {
+        // Deleted vertex, GCable
+        mvcc_list->head_ = nullptr;
+        mvcc_list->tail_ = nullptr;
+        mvcc_list->pre_tail_ = nullptr;
+        mvcc_list->tmp_pre_tail_ = nullptr;
+
+        spawn_erase_vertex_gctask(vid);
+        spawn_v_mvcc_gctask(mvcc_item);
+        spawn_vp_row_list_gctask(v_item.vp_row_list, vid);
+        spawn_topo_row_list_gctask(v_item.ve_row_list, vid);
+    } else {
+        // go deeper, to prop first and then topo
+        scan_prop_row_list(vid.value(), v_item.vp_row_list);
+        scan_topo_row_list(vid, v_item.ve_row_list);
+    }
+    return true;
+}
+
 void GCProducer::scan_topo_row_list(const vid_t& vid, TopologyRowList* topo_row_list) {
     if (topo_row_list == nullptr) { return; }
     ReaderLockGuard reader_lock_guard(topo_row_list->gc_rwlock_);
@@ -623,7 +647,7 @@ void GCProducer::scan_topo_index_update_region() {
 
         // When mergable update element exceeding a ratio of all data,
         // task spawns
-        if (mergable_update_count > index_store_->topo_vtx_data.size() * ratio) {
+        if (mergable_update_count > index_store_->topo_vtx_size * ratio) {
             spawn_topo_index_gctask(Element_T::VERTEX);
         }
     }
@@ -641,7 +665,7 @@ void GCProducer::scan_topo_index_update_region() {
 
         // When mergable update element exceeding a ratio of all data,
         // task spawns
-        if (mergable_update_count > index_store_->topo_edge_data.size() * ratio) {
+        if (mergable_update_count > index_store_->topo_edge_size * ratio) {
             spawn_topo_index_gctask(Element_T::EDGE);
         }
     }
@@ -667,6 +691,28 @@ void GCProducer::scan_prop_index_update_region() {
                 }
             }
         }
+
+        // Keys only indexed by composite index
+        set<int> spawned_pids;
+        for (auto & pair : index_store_->vtx_composite_index) {
+            for (auto & pid : pair.first) {
+                if (index_store_->vtx_prop_index.count(pid) != 0 || spawned_pids.count(pid) != 0) {
+                    continue;
+                }
+                IndexStore::prop_up_map_const_accessor pcac;
+                if (index_store_->vp_update_map.find(pcac, pid)) {
+                    int up_elem_counter = 0;
+                    for (auto & update_pair : pcac->second) {
+                        up_elem_counter += update_pair.second.size();
+                    }
+
+                    if (up_elem_counter > pair.second.element_keys.size() * ratio) {
+                        spawn_prop_index_gctask(Element_T::VERTEX, pid, up_elem_counter);
+                        spawned_pids.emplace(pid);
+                    }
+                }
+            }
+        }
     }
 
     {
@@ -688,6 +734,28 @@ void GCProducer::scan_prop_index_update_region() {
                 }
             }
         }
+
+        // Keys only indexed by composite index
+        set<int> spawned_pids;
+        for (auto & pair : index_store_->edge_composite_index) {
+            for (auto & pid : pair.first) {
+                if (index_store_->edge_prop_index.count(pid) != 0 || spawned_pids.count(pid) != 0) {
+                    continue;
+                }
+                IndexStore::prop_up_map_const_accessor pcac;
+                if (index_store_->ep_update_map.find(pcac, pid)) {
+                    int up_elem_counter = 0;
+                    for (auto & update_pair : pcac->second) {
+                        up_elem_counter += update_pair.second.size();
+                    }
+
+                    if (up_elem_counter > pair.second.element_keys.size() * ratio) {
+                        spawn_prop_index_gctask(Element_T::EDGE, pid, up_elem_counter);
+                        spawned_pids.emplace(pid);
+                    }
+                }
+            }
+        }
     }
 }
 
@@ -818,6 +886,7 @@ void GCProducer::spawn_topo_row_list_gctask(TopologyRowList* topo_row_list, vid_
     if (task != nullptr) {
         topo_row_list_gc_job.AddTask(task);
     } else {
+        scan_deferred_ = true;
         return;
     }
 
@@ -837,6 +906,7 @@ void GCProducer::spawn_topo_row_list_defrag_gctask(TopologyRowList* row_list,
     if (task != nullptr) {
         topo_row_list_defrag_job.AddTask(task);
     } else {
+        scan_deferred_ = true;
         return;
     }
 
@@ -855,6 +925,7 @@ void GCProducer::spawn_vp_row_list_gctask(PropertyRowList<VertexPropertyRow>* pr
     if (task != nullptr) {
         vp_row_list_gc_job.AddTask(task);
     } else {
+        scan_deferred_ = true;
         return;
     }
 
@@ -876,6 +947,7 @@ void GCProducer::spawn_vp_row_defrag_gctask(PropertyRowList<VertexPropertyRow>*
     if (task != nullptr) {
         vp_row_list_defrag_job.AddTask(task);
     } else {
+        scan_deferred_ = true;
         return;
     }
 
@@ -895,6 +967,7 @@ void GCProducer::spawn_ep_row_list_gctask(PropertyRowList<EdgePropertyRow>* row_
     if (task != nullptr) {
         ep_row_list_gc_job.AddTask(task);
     } else {
+        scan_deferred_ = true;
         return;
     }
 
@@ -917,6 +990,7 @@ void GCProducer::spawn_ep_row_defrag_gctask(PropertyRowList<EdgePropertyRow>* ro
     if (task != nullptr) {
         ep_row_list_defrag_job.AddTask(task);
     } else {
+        scan_deferred_ = true;
         return;
     }
 
@@ -16,6 +16,9 @@
 
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 #include <unistd.h>
 
 #include "base/node.hpp"
@@ -27,10 +30,12 @@
 #include "utils/simple_spinlock_guard.hpp"
 #include "utils/timer.hpp"
 
-/* GCProducer encapsulates methods to scan the whole data layout and generate garbage collection tasks to
+/* GCProducer encapsulates methods to scan the data layout and generate garbage collection tasks to
  * free memory allocated for those objects that are invisible to all transactions in the system.
  *
- * In GCProducer, a single thread will regularly scan the whole data layout and generates GC tasks.
+ * In GCProducer, a single thread will regularly scan vertices in limbo lists (i.e., modified by committed or
+ * aborted transactions, see GarbageCollector::LimboList) and generates GC tasks. Thus, the cost of scanning is
+ * proportional to the update rate rather than the size of the graph.
  * If the sum of costs of a specific type of GC task has reach the given threshold, all tasks of this
  * type will be packed as a Job and push to GCConsumer.
  *
@@ -133,7 +138,7 @@ class GCTaskDAG {
 /*
 This is the scanning process of in GCProducer::Execute(): (||: one to many, |: one to one)
 
-    vertex_map
+    limbo vids (end_time < global min BT)
         ||
         ||
         ||
@@ -294,8 +299,16 @@ class GCProducer {
     // For every SCAN_PERIOD, producer scan once;
     const int SCAN_PERIOD = 5;
 
+    // Limbo entries (end_time, vid) popped from GarbageCollector, but not passed by the global min BT yet
+    //  or to be scanned again
+    vector<pair<uint64_t, uint32_t>> limbo_entries_;
+    // Set when a task of the scanned vertex is not spawned since a task on the same target exists
+    bool scan_deferred_ = false;
+
     // -------Scanning Function---------
-    void scan_vertex_map();
+    void scan_limbo_vertices();
+    // Return false if the vertex is not scanned, i.e., its insertion is not finished or not committed
+    bool scan_vertex(vid_t&, Vertex&);
     void scan_topo_row_list(const vid_t&, TopologyRowList*);
     // Scan RowList && MVCCList
     template <class PropertyRow>
@@ -585,6 +585,12 @@ void HDFSDataLoader::LoadVertexData() {
     if (!success) {
         node_.Rank0PrintfWithWorkerBarrier("!HDFSDataLoader::ReadVertexSnapshot()\n");
         vector<TMPVertex>().swap(shuffled_vtx_);
+        if (config_->HDFS_BINARY_INPUT) {
+            LoadBinaryVertexData();
+            WriteVertexSnapshot();
+            node_.Rank0PrintfWithWorkerBarrier("HDFSDataLoader::LoadVertexData() finished\n");
+            return;
+        }
         GetVertices();
         node_.Rank0PrintfWithWorkerBarrier("HDFSDataLoader::GetVertices() finished\n");
         GetVPList();
@@ -606,6 +612,12 @@ void HDFSDataLoader::LoadEdgeData() {
         node_.Rank0PrintfWithWorkerBarrier("!HDFSDataLoader::ReadEdgeSnapshot()\n");
         vector<TMPOutEdge>().swap(shuffled_out_edge_);
         vector<TMPInEdge>().swap(shuffled_in_edge_);
+        if (config_->HDFS_BINARY_INPUT) {
+            LoadBinaryEdgeData();
+            WriteEdgeSnapshot();
+            node_.Rank0PrintfWithWorkerBarrier("HDFSDataLoader::LoadEdgeData() finished\n");
+            return;
+        }
         GetEPList();
         node_.Rank0PrintfWithWorkerBarrier("HDFSDataLoader::GetEPList() finished\n");
         ShuffleEdge();
@@ -820,6 +832,459 @@ void HDFSDataLoader::ShuffleEdge() {
     vector<EProperty*>().swap(eplist_);
 }
 
+/* =================== Binary columnar input =================== */
+
+namespace {
+
+// Sequential reader of a binary split, each array is padded to 8 bytes
+struct BinaryReader {
+    const char* pos;
+    const char* end;
+
+    explicit BinaryReader(const vector<char>& buf) : pos(buf.data()), end(buf.data() + buf.size()) {}
+
+    template <class T>
+    const T* Read(uint64_t count) {
+        const T* ret = reinterpret_cast<const T*>(pos);
+        pos += ceil(sizeof(T) * count, sizeof(uint64_t));
+        CHECK(pos <= end) << "Unexpected end of binary split";
+        return ret;
+    }
+};
+
+// One property column of a binary split
+struct PropColumn {
+    int pid;
+    uint8_t type;
+    uint64_t num_rows;
+    const uint32_t* rows;  // ascending row index of elements having this property
+    const uint64_t* offsets;  // offsets[i]: start of value of rows[i] in content
+    const char* content;
+    uint64_t cursor = 0;  // next row to visit
+
+    void Read(BinaryReader& reader) {
+        pid = *reader.Read<int32_t>(1);
+        type = *reader.Read<uint8_t>(1);
+        num_rows = *reader.Read<uint64_t>(1);
+        rows = reader.Read<uint32_t>(num_rows);
+        offsets = reader.Read<uint64_t>(num_rows + 1);
+        content = reader.Read<char>(offsets[num_rows]);
+    }
+};
+
+// Property of one element to be packed
+struct PackedProp {
+    int pid;
+    uint8_t type;
+    uint32_t len;
+    const char* content;
+};
+
+template <class T>
+inline void Pack(vector<char>& buf, const T* data, uint64_t count) {
+    uint64_t old_size = buf.size();
+    buf.resize(old_size + sizeof(T) * count);
+    memcpy(&buf[old_size], data, sizeof(T) * count);
+}
+
+template <class T>
+inline void Unpack(const char*& pos, T* data, uint64_t count) {
+    memcpy(data, pos, sizeof(T) * count);
+    pos += sizeof(T) * count;
+}
+
+// Pack props with [pid, type, len, content]
+inline void PackProps(vector<char>& buf, const vector<const PackedProp*>& props) {
+    uint32_t num_props = props.size();
+    Pack(buf, &num_props, 1);
+    for (auto prop : props) {
+        Pack(buf, &prop->pid, 1);
+        Pack(buf, &prop->type, 1);
+        Pack(buf, &prop->len, 1);
+        Pack(buf, prop->content, prop->len);
+    }
+}
+
+// Unpack one prop packed by PackProps
+inline void UnpackProp(const char*& pos, int& pid, value_t& value) {
+    uint32_t len;
+    Unpack(pos, &pid, 1);
+    Unpack(pos, &value.type, 1);
+    Unpack(pos, &len, 1);
+    value.content.assign(pos, pos + len);
+    pos += len;
+}
+
+// Skip num_props props packed by PackProps
+inline void SkipProps(const char*& pos, uint32_t num_props) {
+    for (uint32_t i = 0; i < num_props; i++) {
+        uint32_t len;
+        pos += sizeof(int) + sizeof(uint8_t);
+        Unpack(pos, &len, 1);
+        pos += len;
+    }
+}
+
+// Collect props of row from all columns, columns are visited in row order
+inline void CollectProps(uint64_t row, vector<PropColumn>& columns, vector<PackedProp>& props) {
+    for (auto& col : columns) {
+        if (col.cursor < col.num_rows && col.rows[col.cursor] == row) {
+            uint64_t begin = col.offsets[col.cursor];
+            uint64_t end = col.offsets[col.cursor + 1];
+            props.push_back(PackedProp{col.pid, col.type, (uint32_t)(end - begin), col.content + begin});
+            col.cursor++;
+        }
+    }
+}
+
+}  // namespace
+
+void HDFSDataLoader::RunInParallel(int num_tasks, const function<void(int)>& func) {
+    int num_threads = min(config_->global_num_threads, num_tasks);
+    atomic<int> next_task(0);
+    vector<thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&]() {
+            int task;
+            while ((task = next_task++) < num_tasks) {
+                func(task);
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+}
+
+void HDFSDataLoader::GetAssignedSplits(const char* indir, vector<string>& assigned_splits) {
+    if (node_.get_local_rank() == MASTER_RANK) {
+        vector<vector<string>> arrangement = dispatch_locality(indir, node_.get_local_size());
+        master_scatter(node_, false, arrangement);
+        assigned_splits.swap(arrangement[0]);
+    } else {
+        slave_scatter(node_, false, assigned_splits);
+    }
+}
+
+void HDFSDataLoader::ParseSplits(const char* indir, SplitParser parser, vector<vector<char>>& parts) {
+    vector<string> assigned_splits;
+    GetAssignedSplits(indir, assigned_splits);
+
+    // each thread packs parsed elements into its own buffers
+    int np = node_.get_local_size();
+    int num_threads = config_->global_num_threads;
+    vector<vector<vector<char>>> thread_parts(num_threads, vector<vector<char>>(np));
+    atomic<int> next_split(0);
+    vector<thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+            int i;
+            while ((i = next_split++) < assigned_splits.size()) {
+                (this->*parser)(assigned_splits[i].c_str(), thread_parts[t]);
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    // concatenate buffers of all threads
+    parts.resize(np);
+    RunInParallel(np, [&](int i) {
+        uint64_t size = 0;
+        for (int t = 0; t < num_threads; t++) {
+            size += thread_parts[t][i].size();
+        }
+        parts[i].clear();
+        parts[i].reserve(size);
+        for (int t = 0; t < num_threads; t++) {
+            parts[i].insert(parts[i].end(), thread_parts[t][i].begin(), thread_parts[t][i].end());
+            vector<char>().swap(thread_parts[t][i]);
+        }
+    });
+}
+
+// Format
+// uint64 num_vtx, uint32 vid[num_vtx],
+// uint64 in_offsets[num_vtx + 1], uint32 in_nbs[in_offsets[num_vtx]],
+// uint64 out_offsets[num_vtx + 1], uint32 out_nbs[out_offsets[num_vtx]]
+// Packed as [vid, num_in_nbs, num_out_nbs, in_nbs..., out_nbs...]
+void HDFSDataLoader::ParseVertexSplit(const char* inpath, vector<vector<char>>& parts) {
+    hdfsFS fs = get_hdfs_fs();
+    vector<char> buf;
+    read_file(inpath, fs, buf);
+    hdfsDisconnect(fs);
+
+    BinaryReader reader(buf);
+    uint64_t num_vtx = *reader.Read<uint64_t>(1);
+    const uint32_t* vids = reader.Read<uint32_t>(num_vtx);
+    const uint64_t* in_offsets = reader.Read<uint64_t>(num_vtx + 1);
+    const uint32_t* in_nbs = reader.Read<uint32_t>(in_offsets[num_vtx]);
+    const uint64_t* out_offsets = reader.Read<uint64_t>(num_vtx + 1);
+    const uint32_t* out_nbs = reader.Read<uint32_t>(out_offsets[num_vtx]);
+
+    for (uint64_t i = 0; i < num_vtx; i++) {
+        vector<char>& part = parts[id_mapper_->GetMachineIdForVertex(vid_t(vids[i]))];
+        uint32_t header[3] = {vids[i], (uint32_t)(in_offsets[i + 1] - in_offsets[i]),
+                              (uint32_t)(out_offsets[i + 1] - out_offsets[i])};
+        Pack(part, header, 3);
+        Pack(part, in_nbs + in_offsets[i], header[1]);
+        Pack(part, out_nbs + out_offsets[i], header[2]);
+    }
+}
+
+// Format
+// uint64 num_vtx, uint32 vid[num_vtx], uint32 label[num_vtx], uint32 num_columns, columns...
+// Column: int32 pid, uint8 type, uint64 num_rows, uint32 rows[num_rows],
+//         uint64 offsets[num_rows + 1], char content[offsets[num_rows]]
+// Packed as [vid, num_props, (pid, type, len, content)...], label is prop with pid 0
+void HDFSDataLoader::ParseVPSplit(const char* inpath, vector<vector<char>>& parts) {
+    hdfsFS fs = get_hdfs_fs();
+    vector<char> buf;
+    read_file(inpath, fs, buf);
+    hdfsDisconnect(fs);
+
+    BinaryReader reader(buf);
+    uint64_t num_vtx = *reader.Read<uint64_t>(1);
+    const uint32_t* vids = reader.Read<uint32_t>(num_vtx);
+    const uint32_t* labels = reader.Read<uint32_t>(num_vtx);
+    uint32_t num_columns = *reader.Read<uint32_t>(1);
+    vector<PropColumn> columns(num_columns);
+    for (auto& col : columns) {
+        col.Read(reader);
+    }
+
+    vector<PackedProp> props;
+    map<int, vector<const PackedProp*>> node_map;
+    for (uint64_t i = 0; i < num_vtx; i++) {
+        props.clear();
+        node_map.clear();
+        // label, stored as int
+        props.push_back(PackedProp{0, 1, sizeof(int), reinterpret_cast<const char*>(labels + i)});
+        CollectProps(i, columns, props);
+
+        vid_t vid(vids[i]);
+        for (auto& prop : props) {
+            node_map[id_mapper_->GetMachineIdForVProperty(vpid_t(vid, prop.pid))].push_back(&prop);
+        }
+        for (auto& item : node_map) {
+            vector<char>& part = parts[item.first];
+            Pack(part, vids + i, 1);
+            PackProps(part, item.second);
+        }
+    }
+}
+
+// Format
+// uint64 num_edges, uint32 src_vid[num_edges], uint32 dst_vid[num_edges], uint32 label[num_edges],
+// uint32 num_columns, columns... (same as ParseVPSplit)
+// Packed as [src_vid, dst_vid, num_props, (pid, type, len, content)...], label is prop with pid 0
+void HDFSDataLoader::ParseEPSplit(const char* inpath, vector<vector<char>>& parts) {
+    hdfsFS fs = get_hdfs_fs();
+    vector<char> buf;
+    read_file(inpath, fs, buf);
+    hdfsDisconnect(fs);
+
+    BinaryReader reader(buf);
+    uint64_t num_edges = *reader.Read<uint64_t>(1);
+    const uint32_t* src_vids = reader.Read<uint32_t>(num_edges);
+    const uint32_t* dst_vids = reader.Read<uint32_t>(num_edges);
+    const uint32_t* labels = reader.Read<uint32_t>(num_edges);
+    uint32_t num_columns = *reader.Read<uint32_t>(1);
+    vector<PropColumn> columns(num_columns);
+    for (auto& col : columns) {
+        col.Read(reader);
+    }
+
+    vector<PackedProp> props;
+    map<int, vector<const PackedProp*>> node_map;
+    for (uint64_t i = 0; i < num_edges; i++) {
+        props.clear();
+        node_map.clear();
+        props.push_back(PackedProp{0, 1, sizeof(int), reinterpret_cast<const char*>(labels + i)});
+        CollectProps(i, columns, props);
+
+        for (auto& prop : props) {
+            int src_v_node_id = id_mapper_->GetMachineIdForEProperty(epid_t(dst_vids[i], src_vids[i], prop.pid));
+            node_map[src_v_node_id].push_back(&prop);
+            // label should be stored on two side
+            if (prop.pid == 0) {
+                int dst_v_node_id = id_mapper_->GetMachineIdForVertex(vid_t(dst_vids[i]));
+                if (dst_v_node_id != src_v_node_id) {
+                    node_map[dst_v_node_id].push_back(&prop);
+                }
+            }
+        }
+        for (auto& item : node_map) {
+            vector<char>& part = parts[item.first];
+            Pack(part, src_vids + i, 1);
+            Pack(part, dst_vids + i, 1);
+            PackProps(part, item.second);
+        }
+    }
+}
+
+void HDFSDataLoader::UnpackVertex(vector<vector<char>>& vtx_parts, vector<vector<char>>& vp_parts) {
+    int np = vtx_parts.size();
+
+    // count vertices in each part to place them without lock
+    vector<uint64_t> offsets(np + 1, 0);
+    RunInParallel(np, [&](int i) {
+        const char* pos = vtx_parts[i].data();
+        const char* end = pos + vtx_parts[i].size();
+        while (pos < end) {
+            uint32_t header[3];
+            Unpack(pos, header, 3);
+            pos += sizeof(uint32_t) * (header[1] + header[2]);
+            offsets[i + 1]++;
+        }
+    });
+    for (int i = 0; i < np; i++) {
+        offsets[i + 1] += offsets[i];
+    }
+    shuffled_vtx_.resize(offsets[np]);
+
+    RunInParallel(np, [&](int i) {
+        const char* pos = vtx_parts[i].data();
+        const char* end = pos + vtx_parts[i].size();
+        for (uint64_t k = offsets[i]; pos < end; k++) {
+            TMPVertex& vtx_ref = shuffled_vtx_[k];
+            uint32_t header[3];
+            Unpack(pos, header, 3);
+            vtx_ref.id = vid_t(header[0]);
+            vtx_ref.in_nbs.resize(header[1]);
+            vtx_ref.out_nbs.resize(header[2]);
+            Unpack(pos, vtx_ref.in_nbs.data(), header[1]);
+            Unpack(pos, vtx_ref.out_nbs.data(), header[2]);
+        }
+        vector<char>().swap(vtx_parts[i]);
+    });
+
+    for (auto& vtx : shuffled_vtx_) {
+        vtx_part_map_[vtx.id.vid] = &vtx;
+    }
+
+    // all properties of a vertex come from the same split, so parts never share vertices
+    RunInParallel(np, [&](int i) {
+        const char* pos = vp_parts[i].data();
+        const char* end = pos + vp_parts[i].size();
+        while (pos < end) {
+            uint32_t vid, num_props;
+            Unpack(pos, &vid, 1);
+            Unpack(pos, &num_props, 1);
+            TMPVertex& vtx_ref = *(vtx_part_map_.find(vid)->second);
+            for (uint32_t j = 0; j < num_props; j++) {
+                int pid;
+                value_t value;
+                UnpackProp(pos, pid, value);
+                if (pid == 0) {
+                    vtx_ref.label = Tool::value_t2int(value);
+                } else {
+                    vtx_ref.vp_label_list.push_back(pid);
+                    vtx_ref.vp_value_list.push_back(move(value));
+                }
+            }
+        }
+        vector<char>().swap(vp_parts[i]);
+    });
+
+    vtx_part_map_.clear();
+}
+
+void HDFSDataLoader::UnpackEdge(vector<vector<char>>& ep_parts) {
+    int np = ep_parts.size();
+
+    // For an edge, if src_v and dst_v are both on this node, it will be stored in out_edge_map_
+    vector<uint64_t> out_offsets(np + 1, 0), in_offsets(np + 1, 0);
+    RunInParallel(np, [&](int i) {
+        const char* pos = ep_parts[i].data();
+        const char* end = pos + ep_parts[i].size();
+        while (pos < end) {
+            uint32_t header[3];
+            Unpack(pos, header, 3);
+            SkipProps(pos, header[2]);
+            if (id_mapper_->IsVertexLocal(vid_t(header[0]))) {
+                out_offsets[i + 1]++;
+            } else {
+                in_offsets[i + 1]++;
+            }
+        }
+    });
+    for (int i = 0; i < np; i++) {
+        out_offsets[i + 1] += out_offsets[i];
+        in_offsets[i + 1] += in_offsets[i];
+    }
+    shuffled_out_edge_.resize(out_offsets[np]);
+    shuffled_in_edge_.resize(in_offsets[np]);
+
+    RunInParallel(np, [&](int i) {
+        const char* pos = ep_parts[i].data();
+        const char* end = pos + ep_parts[i].size();
+        uint64_t out_idx = out_offsets[i], in_idx = in_offsets[i];
+        while (pos < end) {
+            uint32_t header[3];
+            Unpack(pos, header, 3);
+            eid_t eid(header[1], header[0]);
+            if (id_mapper_->IsVertexLocal(vid_t(header[0]))) {
+                auto& edge_ref = shuffled_out_edge_[out_idx++];
+                edge_ref.id = eid;
+                for (uint32_t j = 0; j < header[2]; j++) {
+                    int pid;
+                    value_t value;
+                    UnpackProp(pos, pid, value);
+                    if (pid == 0) {
+                        // label
+                        edge_ref.label = Tool::value_t2int(value);
+                    } else {
+                        edge_ref.ep_label_list.push_back(pid);
+                        edge_ref.ep_value_list.push_back(move(value));
+                    }
+                }
+            } else {
+                // only label is sent to dst side
+                auto& edge_ref = shuffled_in_edge_[in_idx++];
+                edge_ref.id = eid;
+                for (uint32_t j = 0; j < header[2]; j++) {
+                    int pid;
+                    value_t value;
+                    UnpackProp(pos, pid, value);
+                    if (pid == 0) {
+                        edge_ref.label = Tool::value_t2int(value);
+                    }
+                }
+            }
+        }
+        vector<char>().swap(ep_parts[i]);
+    });
+}
+
+void HDFSDataLoader::LoadBinaryVertexData() {
+    vector<vector<char>> vtx_parts, vp_parts;
+    ParseSplits(config_->HDFS_VTX_SUBFOLDER.c_str(), &HDFSDataLoader::ParseVertexSplit, vtx_parts);
+    node_.Rank0PrintfWithWorkerBarrier("HDFSDataLoader::ParseVertexSplit() finished\n");
+    ParseSplits(config_->HDFS_VP_SUBFOLDER.c_str(), &HDFSDataLoader::ParseVPSplit, vp_parts);
+    node_.Rank0PrintfWithWorkerBarrier("HDFSDataLoader::ParseVPSplit() finished\n");
+
+    all_to_all_bytes(node_, false, vtx_parts);
+    all_to_all_bytes(node_, false, vp_parts);
+    node_.Rank0PrintfWithWorkerBarrier("HDFSDataLoader Shuffle vertices and vp done\n");
+
+    UnpackVertex(vtx_parts, vp_parts);
+    node_.Rank0PrintfWithWorkerBarrier("HDFSDataLoader::UnpackVertex() finished\n");
+}
+
+void HDFSDataLoader::LoadBinaryEdgeData() {
+    vector<vector<char>> ep_parts;
+    ParseSplits(config_->HDFS_EP_SUBFOLDER.c_str(), &HDFSDataLoader::ParseEPSplit, ep_parts);
+    node_.Rank0PrintfWithWorkerBarrier("HDFSDataLoader::ParseEPSplit() finished\n");
+
+    all_to_all_bytes(node_, false, ep_parts);
+    node_.Rank0PrintfWithWorkerBarrier("HDFSDataLoader Shuffle ep done\n");
+
+    UnpackEdge(ep_parts);
+    node_.Rank0PrintfWithWorkerBarrier("HDFSDataLoader::UnpackEdge() finished\n");
+}
+
 void HDFSDataLoader::FreeVertexMemory() {
     vector<TMPVertex>().swap(shuffled_vtx_);
 }
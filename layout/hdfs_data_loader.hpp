@@ -14,7 +14,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdio>
+#include <functional>
+#include <thread>
 
 #include "base/communication.hpp"
 #include "base/node.hpp"
@@ -143,6 +146,22 @@ class HDFSDataLoader {
     void ShuffleVertex();
     void ShuffleEdge();
 
+    // Binary columnar input (HDFS_INPUT_FORMAT = binary), see docs/Tutorial.md
+    //  Each split is parsed into one packed buffer per worker, shuffled by all_to_all_bytes
+    //  and unpacked into shuffled_vtx_/shuffled_out_edge_/shuffled_in_edge_ in parallel
+    typedef void (HDFSDataLoader::*SplitParser)(const char*, vector<vector<char>>&);
+    void GetAssignedSplits(const char* indir, vector<string>& assigned_splits);
+    void ParseSplits(const char* indir, SplitParser parser, vector<vector<char>>& parts);
+    void ParseVertexSplit(const char* inpath, vector<vector<char>>& parts);
+    void ParseVPSplit(const char* inpath, vector<vector<char>>& parts);
+    void ParseEPSplit(const char* inpath, vector<vector<char>>& parts);
+    void UnpackVertex(vector<vector<char>>& vtx_parts, vector<vector<char>>& vp_parts);
+    void UnpackEdge(vector<vector<char>>& ep_parts);
+    void LoadBinaryVertexData();
+    void LoadBinaryEdgeData();
+    // Run func(i) for i in [0, num_tasks) by global_num_threads threads
+    void RunInParallel(int num_tasks, const function<void(int)>& func);
+
  public:
     static HDFSDataLoader* GetInstance() {
         static HDFSDataLoader* hdfs_data_loader_instance_ptr = nullptr;
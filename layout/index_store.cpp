@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "core/running_trx_list.hpp"
 #include "layout/index_store.hpp"
 
 void IndexStore::Init() {
@@ -61,6 +62,30 @@ bool IndexStore::IsIndexEnabled(Element_T type, int pid, PredicateValue* pred =
     return false;
 }
 
+bool IndexStore::IsIndexTracked(Element_T type, int pid) {
+    if (!config_->global_enable_indexing) {
+        return false;
+    }
+
+    // Check builds first, a build is marked BUILT only after its index is published
+    {
+        lock_guard<mutex> lock(build_mutex_);
+        for (auto& item : index_builds_) {
+            const vector<int>& pids = item.first.second;
+            if (item.first.first == type && item.second->stat == IndexBuildStat::BUILDING &&
+                find(pids.begin(), pids.end(), pid) != pids.end()) {
+                return true;
+            }
+        }
+    }
+    if (IsIndexEnabled(type, pid)) {
+        return true;
+    }
+
+    ReaderLockGuard reader_guard_lock(type == Element_T::VERTEX ? vtx_prop_gc_rwlock_ : edge_prop_gc_rwlock_);
+    return has_composite_index(type, pid);
+}
+
 //    type:             VERTEX / EDGE
 //    property_key:     key
 //    index_map:        alreay constructed index map
@@ -77,24 +102,32 @@ bool IndexStore::SetIndexMap(Element_T type, int pid, map<value_t, vector<uint64
             rw_lock = &edge_prop_gc_rwlock_;
         }
 
-        ReaderLockGuard reader_guard_lock(*rw_lock);
-        index_ &idx = (*m)[pid];
+        // construct index without lock
+        index_ idx;
+        idx.isEnabled = false;
 
         uint64_t sum = 0;
         // sort each vector for better searching performance
         for (auto& item : index_map) {
-            set<uint64_t> temp(std::make_move_iterator(item.second.begin()),
-                            std::make_move_iterator(item.second.end()));
-            uint64_t count = temp.size();
-            sum += count;
-            auto itr = idx.index_map.insert(idx.index_map.end(), {move(item.first), move(temp)});
-            idx.count_map[item.first] = count;
+            vector<uint64_t>& temp = item.second;
+            sort(temp.begin(), temp.end());
+            temp.erase(unique(temp.begin(), temp.end()), temp.end());
+            sum += temp.size();
+            auto itr = idx.index_map.insert(idx.index_map.end(), {item.first, move(temp)});
+            idx.hash_index[itr->first] = &(itr->second);
             idx.values.push_back(&(itr->first));
         }
 
         idx.no_key = set<uint64_t>(make_move_iterator(no_key_vec.begin()), make_move_iterator(no_key_vec.end()));
         sum += idx.no_key.size();
         idx.total = sum;
+        build_prefix_count(idx);
+
+        // publish index, nodes of index_map are moved so pointers keep valid
+        WriterLockGuard writer_lock_guard(*rw_lock);
+        thread_mutex_.lock();
+        (*m)[pid] = move(idx);
+        thread_mutex_.unlock();
 
         return true;
     }
@@ -128,12 +161,366 @@ bool IndexStore::SetIndexMapEnable(Element_T type, int pid, bool inverse = false
     return false;
 }
 
-void IndexStore::ReadPropIndex(Element_T type, vector<pair<int, PredicateValue>>& pred_chain, vector<value_t>& data) {
+bool IndexStore::SetCompositeIndexMap(Element_T type, const vector<int>& pids,
+                                      map<vector<value_t>, vector<uint64_t>>& index_map) {
+    if (config_->global_enable_indexing) {
+        WritePriorRWLock * rw_lock;
+        map<vector<int>, composite_index_>* m;
+        tbb::concurrent_hash_map<int, map<value_t, vector<update_element>>>* up_region;
+        if (type == Element_T::VERTEX) {
+            m = &vtx_composite_index;
+            up_region = &vp_update_map;
+            rw_lock = &vtx_prop_gc_rwlock_;
+        } else {
+            m = &edge_composite_index;
+            up_region = &ep_update_map;
+            rw_lock = &edge_prop_gc_rwlock_;
+        }
+
+        // construct index without lock
+        composite_index_ idx;
+        idx.isEnabled = false;
+        idx.delta = make_shared<composite_delta_>();
+        for (auto& item : index_map) {
+            vector<uint64_t>& temp = item.second;
+            sort(temp.begin(), temp.end());
+            temp.erase(unique(temp.begin(), temp.end()), temp.end());
+            for (auto& id : temp) {
+                idx.element_keys[id] = item.first;
+            }
+            idx.index_map.emplace(item.first, move(temp));
+        }
+
+        // publish index
+        WriterLockGuard writer_lock_guard(*rw_lock);
+        // updates already in update region are not in index_map yet
+        //  later ones are counted on insertion, which holds reader lock
+        for (auto& pid : pids) {
+            prop_up_map_const_accessor pcac;
+            if (up_region->find(pcac, pid)) {
+                for (auto& pair : pcac->second) {
+                    for (auto& up_elem : pair.second) {
+                        idx.delta->pending[up_elem.element_id]++;
+                    }
+                }
+            }
+        }
+        (*m)[pids] = move(idx);
+        return true;
+    }
+    return false;
+}
+
+bool IndexStore::SetCompositeIndexEnable(Element_T type, const vector<int>& pids, bool inverse) {
+    if (config_->global_enable_indexing) {
+        WritePriorRWLock * rw_lock;
+        map<vector<int>, composite_index_>* m;
+        if (type == Element_T::VERTEX) {
+            m = &vtx_composite_index;
+            rw_lock = &vtx_prop_gc_rwlock_;
+        } else {
+            m = &edge_composite_index;
+            rw_lock = &edge_prop_gc_rwlock_;
+        }
+
+        WriterLockGuard writer_lock_guard(*rw_lock);
+        auto itr = m->find(pids);
+        if (itr == m->end()) {
+            return false;
+        }
+        itr->second.isEnabled = inverse ? !itr->second.isEnabled : true;
+        return itr->second.isEnabled;
+    }
+    return false;
+}
+
+void IndexStore::GetCompositeIndexes(Element_T type, vector<vector<int>>& pids_list) {
+    if (!config_->global_enable_indexing) {
+        return;
+    }
+
+    WritePriorRWLock * rw_lock;
+    map<vector<int>, composite_index_>* m;
+    if (type == Element_T::VERTEX) {
+        m = &vtx_composite_index;
+        rw_lock = &vtx_prop_gc_rwlock_;
+    } else {
+        m = &edge_composite_index;
+        rw_lock = &edge_prop_gc_rwlock_;
+    }
+
+    ReaderLockGuard reader_guard_lock(*rw_lock);
+    for (auto& item : *m) {
+        if (item.second.isEnabled) {
+            pids_list.push_back(item.first);
+        }
+    }
+}
+
+bool IndexStore::GetCompositeCount(Element_T type, const vector<int>& pids, vector<pair<int, PredicateValue>>& pred_chain,
+                                   uint64_t& count, vector<int>* matched_preds) {
+    vector<int> matched;
+    if (!match_composite_index(pids, pred_chain, matched)) {
+        return false;
+    }
+
+    WritePriorRWLock * rw_lock;
+    map<vector<int>, composite_index_>* m;
+    if (type == Element_T::VERTEX) {
+        m = &vtx_composite_index;
+        rw_lock = &vtx_prop_gc_rwlock_;
+    } else {
+        m = &edge_composite_index;
+        rw_lock = &edge_prop_gc_rwlock_;
+    }
+
+    ReaderLockGuard reader_guard_lock(*rw_lock);
+    auto itr = m->find(pids);
+    if (itr == m->end() || !itr->second.isEnabled) {
+        return false;
+    }
+
+    count = count_composite_index(itr->second, pred_chain, matched);
+    if (matched_preds != NULL) {
+        matched_preds->swap(matched);
+    }
+    return true;
+}
+
+bool IndexStore::StartIndexBuild(Element_T type, const vector<int>& pids, const uint64_t & trx_id, const uint64_t & begin_time) {
+    if (!config_->global_enable_indexing || pids.size() == 0) {
+        return false;
+    }
+
+    shared_ptr<index_build_> build;
+    {
+        lock_guard<mutex> lock(build_mutex_);
+        auto key = make_pair(type, pids);
+        if (index_builds_.find(key) != index_builds_.end()) {
+            return false;
+        }
+        build = make_shared<index_build_>();
+        index_builds_[key] = build;
+    }
+
+    // The trx may finish before the build, keep versions visible at begin_time from GC until published
+    RunningTrxList::GetInstance()->HoldBT(begin_time);
+
+    lock_guard<mutex> lock(build_mutex_);
+    build->builder = thread(&IndexStore::build_prop_index, this, type, pids, trx_id, begin_time, build);
+    return true;
+}
+
+IndexStore::~IndexStore() {
+    stop_builds_ = true;
+    vector<shared_ptr<index_build_>> builds;
+    {
+        lock_guard<mutex> lock(build_mutex_);
+        for (auto& item : index_builds_) {
+            builds.push_back(item.second);
+        }
+    }
+    // builders lock build_mutex_, thus join without it
+    for (auto& build : builds) {
+        if (build->builder.joinable()) {
+            build->builder.join();
+        }
+    }
+}
+
+IndexStore::IndexBuildStat IndexStore::GetIndexBuildStat(Element_T type, const vector<int>& pids) {
+    lock_guard<mutex> lock(build_mutex_);
+    auto itr = index_builds_.find(make_pair(type, pids));
+    if (itr == index_builds_.end()) {
+        return IndexBuildStat::NOT_BUILT;
+    }
+    return itr->second->stat;
+}
+
+string IndexStore::GetIndexBuildStatus() {
+    lock_guard<mutex> lock(build_mutex_);
+    if (index_builds_.size() == 0) {
+        return "No index built\n";
+    }
+
+    string ret;
+    for (auto& item : index_builds_) {
+        index_build_& build = *item.second;
+        ret += (item.first.first == Element_T::VERTEX ? "V" : "E");
+        ret += " pid";
+        for (auto& pid : item.first.second) {
+            ret += " " + to_string(pid);
+        }
+        ret += ": ";
+        if (build.stat == IndexBuildStat::BUILDING) {
+            ret += "building, scanned " + to_string(build.scanned.load()) + "/" + to_string(build.total);
+            ret += " in " + to_string((timer::get_usec() - build.start_time) / 1000) + " ms";
+        } else {
+            ret += "built with " + to_string(build.total) + " elements";
+            ret += " in " + to_string((build.end_time - build.start_time) / 1000) + " ms";
+        }
+        ret += "\n";
+    }
+    return ret;
+}
+
+void IndexStore::build_prop_index(Element_T type, vector<int> pids, uint64_t trx_id, uint64_t begin_time,
+                                  shared_ptr<index_build_> build) {
+    // Scan at fixed snapshot
+    vector<uint64_t> ids;
+    if (type == Element_T::VERTEX) {
+        vector<vid_t> vid_list;
+        data_storage_->GetAllVertices(trx_id, begin_time, true, vid_list);
+        ids.reserve(vid_list.size());
+        for (auto& vid : vid_list) {
+            ids.emplace_back(vid_t2uint(vid));
+        }
+    } else {
+        vector<eid_t> eid_list;
+        data_storage_->GetAllEdges(trx_id, begin_time, true, eid_list);
+        ids.reserve(eid_list.size());
+        for (auto& eid : eid_list) {
+            ids.emplace_back(eid_t2uint(eid));
+        }
+    }
+    {
+        lock_guard<mutex> lock(build_mutex_);
+        build->total = ids.size();
+    }
+
+    // Scan property in parallel chunks
+    //  key of index map has only one value for single key index
+    int num_threads = config_->index_build_threads;
+    vector<map<vector<value_t>, vector<uint64_t>>> index_maps(num_threads);
+    vector<vector<uint64_t>> no_key_vecs(num_threads);
+    vector<thread> threads;
+    size_t chunk_size = (ids.size() + num_threads - 1) / num_threads;
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+            size_t begin = min(ids.size(), t * chunk_size);
+            size_t end = min(ids.size(), begin + chunk_size);
+            for (size_t i = begin; i < end && !stop_builds_; i++) {
+                vector<value_t> vals;
+                if (get_prop_values(type, pids, ids[i], trx_id, begin_time, true, vals)) {
+                    index_maps[t][move(vals)].push_back(ids[i]);
+                } else {
+                    no_key_vecs[t].push_back(ids[i]);
+                }
+                build->scanned++;
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    if (stop_builds_) {
+        RunningTrxList::GetInstance()->ReleaseBT(begin_time);
+        return;
+    }
+
+    // Merge results of all chunks
+    for (int t = 1; t < num_threads; t++) {
+        for (auto& item : index_maps[t]) {
+            vector<uint64_t>& vec = index_maps[0][item.first];
+            vec.insert(vec.end(), item.second.begin(), item.second.end());
+        }
+        no_key_vecs[0].insert(no_key_vecs[0].end(), no_key_vecs[t].begin(), no_key_vecs[t].end());
+    }
+
+    // Publish index, updates after snapshot are read from update region
+    // and merged into index by GC
+    if (pids.size() == 1) {
+        map<value_t, vector<uint64_t>> index_map;
+        for (auto& item : index_maps[0]) {
+            index_map.emplace(move(item.first[0]), move(item.second));
+        }
+        SetIndexMap(type, pids[0], index_map, no_key_vecs[0]);
+        SetIndexMapEnable(type, pids[0]);
+    } else {
+        // elements without any of the keys are not indexed
+        SetCompositeIndexMap(type, pids, index_maps[0]);
+        SetCompositeIndexEnable(type, pids);
+    }
+    RunningTrxList::GetInstance()->ReleaseBT(begin_time);
+
+    lock_guard<mutex> lock(build_mutex_);
+    build->stat = IndexBuildStat::BUILT;
+    build->end_time = timer::get_usec();
+}
+
+bool IndexStore::get_prop_values(Element_T type, const vector<int>& pids, uint64_t id, const uint64_t & trx_id,
+                                 const uint64_t & begin_time, const bool & read_only, vector<value_t> & vals) {
+    vals.resize(pids.size());
+    for (int i = 0; i < pids.size(); i++) {
+        if (!get_prop_value(type, pids[i], id, trx_id, begin_time, vals[i], read_only)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IndexStore::get_prop_value(Element_T type, int pid, uint64_t id, const uint64_t & trx_id,
+                                const uint64_t & begin_time, value_t & val, const bool & read_only) {
+    if (type == Element_T::VERTEX) {
+        vid_t vid;
+        uint2vid_t(id, vid);
+        if (pid == 0) {
+            label_t label;
+            if (data_storage_->GetVL(vid, trx_id, begin_time, read_only, label) != READ_STAT::SUCCESS) {
+                return false;
+            }
+            Tool::str2int(to_string(label), val);
+            return true;
+        }
+        vpid_t vp_id(vid, pid);
+        return data_storage_->GetVPByPKey(vp_id, trx_id, begin_time, read_only, val) == READ_STAT::SUCCESS;
+    } else {
+        eid_t eid;
+        uint2eid_t(id, eid);
+        if (pid == 0) {
+            label_t label;
+            if (data_storage_->GetEL(eid, trx_id, begin_time, read_only, label) != READ_STAT::SUCCESS) {
+                return false;
+            }
+            Tool::str2int(to_string(label), val);
+            return true;
+        }
+        epid_t ep_id(eid, pid);
+        return data_storage_->GetEPByPKey(ep_id, trx_id, begin_time, read_only, val) == READ_STAT::SUCCESS;
+    }
+}
+
+void IndexStore::ReadPropIndex(Element_T type, vector<pair<int, PredicateValue>>& pred_chain, vector<value_t>& data,
+                               const uint64_t & trx_id, const uint64_t & begin_time, const bool & read_only) {
     bool is_first = true;
-    bool need_sort = pred_chain.size() != 1;
     vector<uint64_t> tmp_data;
 
-    for (auto& pred_pair : pred_chain) {
+    // Predicates covered by composite indexes are not read by single key index
+    vector<bool> covered(pred_chain.size(), false);
+    while (true) {
+        vector<uint64_t> vec;
+        if (!read_composite_prop_index(type, pred_chain, trx_id, begin_time, read_only, covered, vec)) {
+            break;
+        }
+
+        if (is_first) {
+            tmp_data.swap(vec);
+            is_first = false;
+        } else {
+            vector<uint64_t> temp;
+            set_intersection(tmp_data.begin(), tmp_data.end(), vec.begin(), vec.end(), back_inserter(temp));
+            tmp_data.swap(temp);
+        }
+    }
+    vector<pair<int, PredicateValue>> rest_chain;
+    for (int i = 0; i < pred_chain.size(); i++) {
+        if (!covered[i]) {
+            rest_chain.push_back(pred_chain[i]);
+        }
+    }
+    bool need_sort = !is_first || rest_chain.size() != 1;
+
+    for (auto& pred_pair : rest_chain) {
         vector<uint64_t> vec;
         // get sorted vector of all elements satisfying current predicate
         get_elements_by_predicate(type, pred_pair.first, pred_pair.second, need_sort, vec);
@@ -159,6 +546,93 @@ void IndexStore::ReadPropIndex(Element_T type, vector<pair<int, PredicateValue>>
     }
 }
 
+bool IndexStore::read_composite_prop_index(Element_T type, vector<pair<int, PredicateValue>>& pred_chain,
+                                           const uint64_t & trx_id, const uint64_t & begin_time, const bool & read_only,
+                                           vector<bool>& covered, vector<uint64_t>& vec) {
+    if (!config_->global_enable_indexing) {
+        return false;
+    }
+
+    WritePriorRWLock * rw_lock;
+    map<vector<int>, composite_index_>* m;
+    if (type == Element_T::VERTEX) {
+        m = &vtx_composite_index;
+        rw_lock = &vtx_prop_gc_rwlock_;
+    } else {
+        m = &edge_composite_index;
+        rw_lock = &edge_prop_gc_rwlock_;
+    }
+
+    ReaderLockGuard reader_guard_lock(*rw_lock);
+
+    // Choose the enabled composite index covering most uncovered predicates
+    composite_index_* idx = NULL;
+    const vector<int>* pids = NULL;
+    vector<int> matched;
+    int max_new = 0;
+    for (auto& item : *m) {
+        vector<int> cur_matched;
+        if (!item.second.isEnabled || !match_composite_index(item.first, pred_chain, cur_matched)) {
+            continue;
+        }
+        int num_new = 0;
+        for (auto& i : cur_matched) {
+            if (!covered[i]) { num_new++; }
+        }
+        if (num_new > max_new) {
+            idx = &item.second;
+            pids = &item.first;
+            matched.swap(cur_matched);
+            max_new = num_new;
+        }
+    }
+    if (idx == NULL) {
+        return false;
+    }
+
+    read_composite_index(*idx, pred_chain, matched, vec);
+
+    // Elements in update region are not merged yet, re-read their keys with current trx
+    vector<uint64_t> dirty_ids;
+    {
+        lock_guard<mutex> lock(idx->delta->mu);
+        dirty_ids.reserve(idx->delta->pending.size());
+        for (auto& item : idx->delta->pending) {
+            dirty_ids.emplace_back(item.first);
+        }
+    }
+
+    if (dirty_ids.size() != 0) {
+        sort(dirty_ids.begin(), dirty_ids.end());
+        vector<uint64_t> temp;
+        for (auto& id : vec) {
+            if (!binary_search(dirty_ids.begin(), dirty_ids.end(), id)) {
+                temp.emplace_back(id);
+            }
+        }
+        for (auto& id : dirty_ids) {
+            vector<value_t> vals;
+            if (!get_prop_values(type, *pids, id, trx_id, begin_time, read_only, vals)) {
+                continue;
+            }
+            bool is_match = true;
+            for (int i = 0; i < matched.size() && is_match; i++) {
+                is_match = Evaluate(pred_chain[matched[i]].second, &vals[i]);
+            }
+            if (is_match) {
+                temp.emplace_back(id);
+            }
+        }
+        sort(temp.begin(), temp.end());
+        vec.swap(temp);
+    }
+
+    for (auto& i : matched) {
+        covered[i] = true;
+    }
+    return true;
+}
+
 bool IndexStore::GetRandomValue(Element_T type, int pid, string& value_str, const bool& is_update) {
     WritePriorRWLock * rw_lock;
     unordered_map<int, index_>* m;
@@ -246,8 +720,8 @@ void IndexStore::CleanRandomCount() {
 void IndexStore::VtxSelfGarbageCollect(const uint64_t& threshold) {
     WriterLockGuard writer_lock_guard(vtx_topo_gc_rwlock_);
 
-    vector<vid_t> addV_vec;
-    set<vid_t> delV_set;
+    set<vid_t> addV_set;
+    unordered_set<uint64_t> delV_set;
     // tbb::concurrent_vector does NOT support erase store
     // un-mergable elements into new vector and swap
     tbb::concurrent_vector<update_element> new_update_list;
@@ -267,9 +741,9 @@ void IndexStore::VtxSelfGarbageCollect(const uint64_t& threshold) {
             uint2vid_t(up_elem.element_id, vid);
             if (trx_stat == TRX_STAT::COMMITTED) {
                 if (up_elem.isAdd) {
-                    addV_vec.emplace_back(vid);
+                    addV_set.emplace(vid);
                 } else {
-                    delV_set.emplace(vid);
+                    delV_set.emplace(vid.value());
                 }
 
                 tac->second.second--;
@@ -288,18 +762,7 @@ void IndexStore::VtxSelfGarbageCollect(const uint64_t& threshold) {
         }
     }
 
-    auto checkFunc = [&](vid_t& vid) {
-        if (delV_set.find(vid) != delV_set.end()) {
-            // Need to delete, erase
-            return true;
-        }
-        return false;
-    };
-
-    if (delV_set.size() != 0) {
-        topo_vtx_data.erase(remove_if(topo_vtx_data.begin(), topo_vtx_data.end(), checkFunc), topo_vtx_data.end());
-    }
-    topo_vtx_data.insert(topo_vtx_data.end(), addV_vec.begin(), addV_vec.end());
+    merge_topo_chunks(addV_set, delV_set, topo_vtx_chunks, topo_vtx_size);
     vtx_update_list.swap(new_update_list);
 }
 
@@ -307,7 +770,7 @@ void IndexStore::EdgeSelfGarbageCollect(const uint64_t& threshold) {
     WriterLockGuard writer_lock_guard(edge_topo_gc_rwlock_);
 
     set<eid_t> addE_set;
-    set<eid_t> delE_set;
+    unordered_set<uint64_t> delE_set;
     // tbb::concurrent_vector does NOT support erase store
     // un-mergable elements into new vector and swap
     tbb::concurrent_vector<update_element> new_update_list;
@@ -329,7 +792,7 @@ void IndexStore::EdgeSelfGarbageCollect(const uint64_t& threshold) {
                 if (up_elem.isAdd) {
                     addE_set.emplace(eid);
                 } else {
-                    delE_set.emplace(eid);
+                    delE_set.emplace(eid.value());
                 }
             } else {
                 if (trx_stat != TRX_STAT::ABORT) {
@@ -342,22 +805,7 @@ void IndexStore::EdgeSelfGarbageCollect(const uint64_t& threshold) {
         }
     }
 
-    auto checkFunc = [&](eid_t& eid) {
-        if (addE_set.find(eid) != addE_set.end()) {
-            addE_set.erase(eid);
-        }
-
-        if (delE_set.find(eid) != delE_set.end()) {
-            // Need to delete, erase
-            return true;
-        }
-        return false;
-    };
-
-    if (delE_set.size() != 0) {
-        topo_edge_data.erase(remove_if(topo_edge_data.begin(), topo_edge_data.end(), checkFunc), topo_edge_data.end());
-    }
-    topo_edge_data.insert(topo_edge_data.end(), addE_set.begin(), addE_set.end());
+    merge_topo_chunks(addE_set, delE_set, topo_edge_chunks, topo_edge_size);
     edge_update_list.swap(new_update_list);
 }
 
@@ -378,12 +826,15 @@ void IndexStore::PropSelfGarbageCollect(const uint64_t& threshold, const int& pi
     // Lock Here, Lock outside is hard
     WriterLockGuard writer_lock_guard(*rw_lock);
 
-    if (m->find(pid) == m->end()) {
+    // pid may only be indexed by composite index
+    index_ * cur_index = NULL;
+    if (m->find(pid) != m->end()) {
+        cur_index = &(m->at(pid));
+    } else if (!has_composite_index(type, pid)) {
         // There is no such key in index
         cout << "[IndexStore] Unexpected PropertyKey when try to gc" << endl;
         return;
     }
-    index_ * cur_index = &(m->at(pid));
 
     prop_up_map_accessor pac;
     if (!up_region->find(pac, pid)) {
@@ -391,15 +842,21 @@ void IndexStore::PropSelfGarbageCollect(const uint64_t& threshold, const int& pi
         return;
     }
 
+    set<uint64_t> merged_ids;
+    vector<uint64_t> erased_ids;  // one per erased update element
     for (auto & pair : pac->second) {
         auto up_elem_itr = pair.second.begin();
         while (up_elem_itr != pair.second.end()) {
             if (up_elem_itr->ct < threshold && up_elem_itr->ct != 0) {
                 uint64_t eid_value = up_elem_itr->element_id;
+                merged_ids.emplace(eid_value);
+                erased_ids.emplace_back(eid_value);
 
-                if (up_elem_itr->update_type == PropertyUpdateT::ADD) {
+                if (cur_index == NULL) {
+                    // Only merged into composite index
+                } else if (up_elem_itr->update_type == PropertyUpdateT::ADD) {
                     // Add a new property for this vertex
-                    // Need to modify index_map, no_key and count_map
+                    // Need to modify index_map and no_key
                     // index_.no_key
                     auto itr = cur_index->no_key.find(eid_value);
                     if (itr != cur_index->no_key.end()) { cur_index->no_key.erase(itr); }
@@ -407,7 +864,7 @@ void IndexStore::PropSelfGarbageCollect(const uint64_t& threshold, const int& pi
                     modify_index(cur_index, eid_value, up_elem_itr->value, true);
                 } else if (up_elem_itr->update_type == PropertyUpdateT::DROP) {
                     // property dropped from this vertex
-                    // Need to modify index_map, no_key and count_map
+                    // Need to modify index_map and no_key
 
                     // index_.no_key
                     cur_index->no_key.emplace(eid_value);
@@ -415,7 +872,7 @@ void IndexStore::PropSelfGarbageCollect(const uint64_t& threshold, const int& pi
                     modify_index(cur_index, eid_value, up_elem_itr->value, false);
                 } else if (up_elem_itr->update_type == PropertyUpdateT::MODIFY) {
                     // Property value changed from this vertex
-                    // Need to modify index_map, count_map
+                    // Need to modify index_map
                     modify_index(cur_index, eid_value, up_elem_itr->value, up_elem_itr->isAdd);
                 }
 
@@ -426,6 +883,11 @@ void IndexStore::PropSelfGarbageCollect(const uint64_t& threshold, const int& pi
             up_elem_itr++;
         }
     }
+    if (cur_index != NULL) {
+        build_prefix_count(*cur_index);
+    }
+    update_composite_index(type, pid, merged_ids, threshold);
+    add_composite_delta(type, pid, erased_ids, -1);
 }
 
 void IndexStore::InsertToUpdateBuffer(const uint64_t& trx_id, vector<uint64_t>& ids, ID_T type, bool isAdd,
@@ -518,12 +980,16 @@ void IndexStore::MovePropBufferToRegion(const uint64_t & trx_id, const uint64_t
     up_buf_accessor ac;
     // VP
     if (vp_update_buffers.find(ac, trx_id)) {
+        // Exclude GC and composite index publish until deltas are counted
+        ReaderLockGuard reader_guard_lock(vtx_prop_gc_rwlock_);
+        map<int, vector<uint64_t>> pid_ids;
         prop_up_map_accessor pac;
         for (auto & up_elem : ac->second) {
             vpid_t vpid;
             uint2vpid_t(up_elem.element_id, vpid);
             up_elem.set_ct(ct);
             up_elem.element_id = vpid.vid;
+            pid_ids[vpid.pid].emplace_back(up_elem.element_id);
 
             vp_update_map.insert(pac, vpid.pid);
 
@@ -533,17 +999,24 @@ void IndexStore::MovePropBufferToRegion(const uint64_t & trx_id, const uint64_t
                 pac->second.emplace(up_elem.value, vector<update_element>{up_elem});
             }
         }
+        pac.release();
+        for (auto & pair : pid_ids) {
+            add_composite_delta(Element_T::VERTEX, pair.first, pair.second, 1);
+        }
         vp_update_buffers.erase(ac);
     }
 
     // EP
     if (ep_update_buffers.find(ac, trx_id)) {
+        ReaderLockGuard reader_guard_lock(edge_prop_gc_rwlock_);
+        map<int, vector<uint64_t>> pid_ids;
         prop_up_map_accessor pac;
         for (auto & up_elem : ac->second) {
             uint64_t eid = up_elem.element_id >> PID_BITS;
             uint64_t pid = up_elem.element_id - (eid << PID_BITS);
             up_elem.set_ct(ct);
             up_elem.element_id = eid;
+            pid_ids[pid].emplace_back(eid);
 
             ep_update_map.insert(pac, pid);
 
@@ -553,6 +1026,10 @@ void IndexStore::MovePropBufferToRegion(const uint64_t & trx_id, const uint64_t
                 pac->second.emplace(up_elem.value, vector<update_element>{up_elem});
             }
         }
+        pac.release();
+        for (auto & pair : pid_ids) {
+            add_composite_delta(Element_T::EDGE, pair.first, pair.second, 1);
+        }
         ep_update_buffers.erase(ac);
     }
 }
@@ -564,43 +1041,109 @@ void IndexStore::UpdateTrxStatus(const uint64_t & trx_id, TRX_STAT stat) {
     }
 }
 
+void IndexStore::InsertCommittedToUpdateRegion(const uint64_t & trx_id, const uint64_t & ct, const vector<uint64_t>& ids,
+                                               ID_T type, const vector<value_t>* vals) {
+    if (ids.size() == 0) { return; }
+
+    if (type == ID_T::VID || type == ID_T::EID) {
+        vector<update_element> up_list;
+        up_list.reserve(ids.size());
+        for (auto & id : ids) {
+            update_element up_elem(id, true, trx_id);
+            up_elem.set_ct(ct);
+            up_list.emplace_back(up_elem);
+        }
+
+        // Register the trx before elements are visible to GC
+        trx_sc_accessor tac;
+        if (trx_status_and_count_table.insert(tac, trx_id)) {
+            tac->second = make_pair(TRX_STAT::COMMITTED, up_list.size());
+        } else {
+            tac->second.second += up_list.size();
+        }
+        tac.release();
+
+        // Append with one allocation, rather than one emplace_back per element
+        if (type == ID_T::VID) {
+            vtx_update_list.grow_by(up_list.begin(), up_list.end());
+        } else {
+            edge_update_list.grow_by(up_list.begin(), up_list.end());
+        }
+        return;
+    }
+
+    CHECK(vals != NULL && vals->size() == ids.size());
+    Element_T elem_type = type == ID_T::VPID ? Element_T::VERTEX : Element_T::EDGE;
+    tbb::concurrent_hash_map<int, map<value_t, vector<update_element>>>& up_region =
+        type == ID_T::VPID ? vp_update_map : ep_update_map;
+
+    // Group by pid, so that the update map of each pid is locked once
+    map<int, vector<pair<uint64_t, const value_t*>>> pid_elems;
+    for (int i = 0; i < ids.size(); i++) {
+        uint64_t element_id, pid;
+        if (type == ID_T::VPID) {
+            vpid_t vpid;
+            uint2vpid_t(ids[i], vpid);
+            element_id = vpid.vid;
+            pid = vpid.pid;
+        } else {
+            element_id = ids[i] >> PID_BITS;
+            pid = ids[i] - (element_id << PID_BITS);
+        }
+        pid_elems[pid].emplace_back(element_id, &vals->at(i));
+    }
+
+    // IsIndexTracked takes reader lock itself
+    set<int> tracked_pids;
+    for (auto & pair : pid_elems) {
+        if (IsIndexTracked(elem_type, pair.first)) { tracked_pids.emplace(pair.first); }
+    }
+
+    ReaderLockGuard reader_guard_lock(type == ID_T::VPID ? vtx_prop_gc_rwlock_ : edge_prop_gc_rwlock_);
+    for (auto & pair : pid_elems) {
+        if (tracked_pids.count(pair.first) == 0) { continue; }
+
+        vector<uint64_t> element_ids;
+        element_ids.reserve(pair.second.size());
+        {
+            prop_up_map_accessor pac;
+            up_region.insert(pac, pair.first);
+            for (auto & elem : pair.second) {
+                update_element up_elem(elem.first, true, trx_id);
+                up_elem.set_modify_value(*elem.second, PropertyUpdateT::ADD);
+                up_elem.set_ct(ct);
+                pac->second[*elem.second].emplace_back(move(up_elem));
+                element_ids.emplace_back(elem.first);
+            }
+        }
+        add_composite_delta(elem_type, pair.first, element_ids, 1);
+    }
+}
+
 void IndexStore::ReadVtxTopoIndex(const uint64_t & trx_id, const uint64_t & begin_time,
-                                  const bool & read_only, vector<vid_t> & data) {
-    vector<vid_t> addV_vec;
-    set<vid_t> delV_set;
+                                  const bool & read_only, topo_snapshot_t<vid_t> & data) {
+    // Hold lock while scanning update list, so that GC will not merge it concurrently
+    ReaderLockGuard reader_lock_guard(vtx_topo_gc_rwlock_);
     for (int i = 0; i < vtx_update_list.size(); i++) {
-        // Risk Here : what if the iteration cannot stop
-        update_element up_elem = vtx_update_list[i];
+        const update_element& up_elem = vtx_update_list[i];
         if (up_elem.element_id == 0) { continue; }
         vid_t vid;
         uint2vid_t(up_elem.element_id, vid);
         if (data_storage_->CheckVertexVisibilityWithVid(trx_id, begin_time, read_only, vid)) {
             // Visible (For Add)
             if (up_elem.isAdd) {
-                addV_vec.emplace_back(vid);
+                data.add_vec.emplace_back(vid);
             }
         } else {
             // Invisible (For Del)
             if (!up_elem.isAdd) {
-                delV_set.emplace(vid);
+                data.del_set.emplace(vid.value());
             }
         }
     }
 
-    auto checkFunc = [&](vid_t& vid) {
-        if (delV_set.find(vid) != delV_set.end()) {
-            // Need to delete, erase
-            return true;
-        }
-        return false;
-    };
-
-    ReaderLockGuard reader_lock_guard(vtx_topo_gc_rwlock_);
-    data = topo_vtx_data;
-    if (delV_set.size() != 0) {
-        data.erase(remove_if(data.begin(), data.end(), checkFunc), data.end());
-    }
-    data.insert(data.end(), addV_vec.begin(), addV_vec.end());
+    // Share chunks rather than copy
+    data.chunks = topo_vtx_chunks;
 
     // Check Update Buffer to Read self-updated data
     up_buf_const_accessor cac;
@@ -608,18 +1151,18 @@ void IndexStore::ReadVtxTopoIndex(const uint64_t & trx_id, const uint64_t & begi
         for (auto & up_elem : cac->second) {
             vid_t vid;
             uint2vid_t(up_elem.element_id, vid);
-            data.emplace_back(vid);
+            data.add_vec.emplace_back(vid);
         }
     }
 }
 
 void IndexStore::ReadEdgeTopoIndex(const uint64_t & trx_id, const uint64_t & begin_time,
-                                   const bool & read_only, vector<eid_t> & data) {
+                                   const bool & read_only, topo_snapshot_t<eid_t> & data) {
     set<eid_t> addE_set;
-    set<eid_t> delE_set;
+    // Hold lock while scanning update list, so that GC will not merge it concurrently
+    ReaderLockGuard reader_lock_guard(edge_topo_gc_rwlock_);
     for (int i = 0; i < edge_update_list.size(); i++) {
-        // Risk Here : what if the iteration cannot stop
-        update_element up_elem = edge_update_list[i];
+        const update_element& up_elem = edge_update_list[i];
         if (up_elem.element_id == 0) { continue; }
         eid_t eid;
         uint2eid_t(up_elem.element_id, eid);
@@ -632,29 +1175,14 @@ void IndexStore::ReadEdgeTopoIndex(const uint64_t & trx_id, const uint64_t & beg
         } else {
             // Invisible (For Del)
             if (!up_elem.isAdd) {
-                delE_set.emplace(eid);
+                data.del_set.emplace(eid.value());
             }
         }
     }
 
-    auto checkFunc = [&](eid_t& eid) {
-        if (addE_set.find(eid) != addE_set.end()) {
-            addE_set.erase(eid);
-        }
-
-        if (delE_set.find(eid) != delE_set.end()) {
-            // Need to delete, erase
-            return true;
-        }
-        return false;
-    };
-
-    ReaderLockGuard reader_lock_guard(edge_topo_gc_rwlock_);
-    data = topo_edge_data;
-    if (delE_set.size() != 0) {
-        data.erase(remove_if(data.begin(), data.end(), checkFunc), data.end());
-    }
-    data.insert(data.end(), addE_set.begin(), addE_set.end());
+    // Share chunks rather than copy
+    data.chunks = topo_edge_chunks;
+    data.add_vec.assign(addE_set.begin(), addE_set.end());
 
     // Check Update Buffer to Read self-updated data
     up_buf_const_accessor cac;
@@ -662,7 +1190,7 @@ void IndexStore::ReadEdgeTopoIndex(const uint64_t & trx_id, const uint64_t & beg
         for (auto & up_elem : cac->second) {
             eid_t eid;
             uint2eid_t(up_elem.element_id, eid);
-            data.emplace_back(eid);
+            data.add_vec.emplace_back(eid);
         }
     }
 }
@@ -686,7 +1214,7 @@ void IndexStore::get_elements_by_predicate(Element_T type, int pid,
     index_ &idx = (*m)[pid];
 
     auto &index_map = idx.index_map;
-    map<value_t, set<uint64_t>>::iterator itr;
+    const vector<uint64_t>* posting;
     int num_set = 0;
 
     // Updated Region
@@ -731,9 +1259,9 @@ void IndexStore::get_elements_by_predicate(Element_T type, int pid,
         break;
       case Predicate_T::EQ:
         // Get elements with single value
-        itr = index_map.find(pred.values[0]);
-        if (itr != index_map.end()) {
-            vec.assign(itr->second.begin(), itr->second.end());
+        posting = find_posting_list(idx, pred.values[0]);
+        if (posting != NULL) {
+            vec.assign(posting->begin(), posting->end());
             num_set++;
         }
 
@@ -748,9 +1276,9 @@ void IndexStore::get_elements_by_predicate(Element_T type, int pid,
       case Predicate_T::WITHIN:
         // Get elements with given values
         for (auto& val : pred.values) {
-            itr = index_map.find(val);
-            if (itr != index_map.end()) {
-                vec.insert(vec.end(), itr->second.begin(), itr->second.end());
+            posting = find_posting_list(idx, val);
+            if (posting != NULL) {
+                vec.insert(vec.end(), posting->begin(), posting->end());
                 num_set++;
             }
         }
@@ -831,10 +1359,9 @@ uint64_t IndexStore::get_count_by_predicate(Element_T type, int pid, PredicateVa
     }
 
     index_ &idx = (*m)[pid];
-    auto& count_map = idx.count_map;
     uint64_t count = 0;
 
-    map<value_t, uint64_t>::iterator itr;
+    const vector<uint64_t>* posting;
     switch (pred.pred_type) {
       case Predicate_T::ANY:
         count = idx.total - idx.no_key.size();
@@ -842,25 +1369,25 @@ uint64_t IndexStore::get_count_by_predicate(Element_T type, int pid, PredicateVa
       case Predicate_T::NEQ:
       case Predicate_T::WITHOUT:
         // Search though whole index map to find matched values
-        for (auto& item : count_map) {
+        for (auto& item : idx.index_map) {
             if (Evaluate(pred, &item.first)) {
-                count += item.second;
+                count += item.second.size();
             }
         }
         break;
       case Predicate_T::EQ:
         // Get elements with single value
-        itr = count_map.find(pred.values[0]);
-        if (itr != count_map.end()) {
-            count += itr->second;
+        posting = find_posting_list(idx, pred.values[0]);
+        if (posting != NULL) {
+            count += posting->size();
         }
         break;
       case Predicate_T::WITHIN:
         // Get elements with given values
         for (auto& val : pred.values) {
-            itr = count_map.find(val);
-            if (itr != count_map.end()) {
-                count += itr->second;
+            posting = find_posting_list(idx, val);
+            if (posting != NULL) {
+                count += posting->size();
             }
         }
         break;
@@ -872,35 +1399,32 @@ uint64_t IndexStore::get_count_by_predicate(Element_T type, int pid, PredicateVa
       case Predicate_T::OUTSIDE:
         // find less than
         pred.pred_type = Predicate_T::LT;
-        build_range_count(count_map, pred, count);
+        build_range_count(idx, pred, count);
         // find greater than
         pred.pred_type = Predicate_T::GT;
         swap(pred.values[0], pred.values[1]);
-        build_range_count(count_map, pred, count);
+        build_range_count(idx, pred, count);
         break;
       default:
         // LT, LTE, GT, GTE, BETWEEN, INSIDE
-        build_range_count(count_map, pred, count);
+        build_range_count(idx, pred, count);
         break;
     }
     return count;
 }
 
-void IndexStore::build_range_count(map<value_t, uint64_t>& m, PredicateValue& pred, uint64_t& count) {
-    map<value_t, uint64_t>::iterator itr_low;
-    map<value_t, uint64_t>::iterator itr_high;
-
-    build_range(m, pred, itr_low, itr_high);
+void IndexStore::build_range_count(index_& idx, PredicateValue& pred, uint64_t& count) {
+    size_t low, high;
+    build_range(idx.sorted_keys, pred, low, high);
 
-    for (auto itr = itr_low; itr != itr_high; itr++) {
-        count += itr->second;
-    }
+    // count in O(log n) by prefix sum
+    count += idx.prefix_count[high] - idx.prefix_count[low];
 }
 
-void IndexStore::build_range_elements(map<value_t, set<uint64_t>>& m, PredicateValue& pred,
+void IndexStore::build_range_elements(map<value_t, vector<uint64_t>>& m, PredicateValue& pred,
         vector<uint64_t>& vec, int& num_set) {
-    map<value_t, set<uint64_t>>::iterator itr_low;
-    map<value_t, set<uint64_t>>::iterator itr_high;
+    map<value_t, vector<uint64_t>>::iterator itr_low;
+    map<value_t, vector<uint64_t>>::iterator itr_high;
 
     build_range(m, pred, itr_low, itr_high);
 
@@ -915,46 +1439,231 @@ void IndexStore::build_topo_data() {
 
     start_t = timer::get_usec();
     // Build Vertex Init Data
-    data_storage_->GetAllVertices(0, 0, true, topo_vtx_data);
+    vector<vid_t> vtx_data;
+    data_storage_->GetAllVertices(0, 0, true, vtx_data);
+    build_topo_chunks(vtx_data, topo_vtx_chunks, topo_vtx_size);
     end_t = timer::get_usec();
-    cout << "[InitData] Got Vertex with size " << topo_vtx_data.size() << endl;
+    cout << "[InitData] Got Vertex with size " << topo_vtx_size << endl;
     cout << "[Timer] " << (end_t - start_t) / 1000 << " ms for Building InitVData in init_expert" << endl;
 
     start_t = timer::get_usec();
     // Build Edge Init Data
-    data_storage_->GetAllEdges(0, 0, true, topo_edge_data);
+    vector<eid_t> edge_data;
+    data_storage_->GetAllEdges(0, 0, true, edge_data);
+    build_topo_chunks(edge_data, topo_edge_chunks, topo_edge_size);
     end_t = timer::get_usec();
-    cout << "[InitData] Got Egde with size " << topo_edge_data.size() << endl;
+    cout << "[InitData] Got Egde with size " << topo_edge_size << endl;
     cout << "[Timer] " << (end_t - start_t) / 1000 << " ms for Building InitEData in init_expert" << endl;
 }
 
+const vector<uint64_t>* IndexStore::find_posting_list(index_& idx, const value_t& val) {
+    auto itr = idx.hash_index.find(val);
+    if (itr != idx.hash_index.end()) {
+        return itr->second;
+    }
+
+    // int and double with same number are equal but have different hash
+    if (val.type == 1 || val.type == 2) {
+        auto m_itr = idx.index_map.find(val);
+        if (m_itr != idx.index_map.end()) {
+            return &(m_itr->second);
+        }
+    }
+    return NULL;
+}
+
+void IndexStore::build_prefix_count(index_& idx) {
+    idx.sorted_keys.clear();
+    idx.prefix_count.clear();
+    idx.sorted_keys.reserve(idx.index_map.size());
+    idx.prefix_count.reserve(idx.index_map.size() + 1);
+
+    uint64_t sum = 0;
+    idx.prefix_count.push_back(sum);
+    for (auto& item : idx.index_map) {
+        idx.sorted_keys.push_back(item.first);
+        sum += item.second.size();
+        idx.prefix_count.push_back(sum);
+    }
+}
+
 // id: uint64_t(vid), uint64_t(eid)
 // val_value_t: value_t(property_value)
 void IndexStore::modify_index(index_ * idx, uint64_t& id, value_t& val_value_t, bool isAdd) {
     if (isAdd) {
-        // index_.index_map
-        if (idx->index_map.find(val_value_t) != idx->index_map.end()) {
-            idx->index_map.at(val_value_t).emplace(id);
-        } else {
-            idx->index_map.emplace(val_value_t, set<uint64_t>{id});
+        // index_.index_map, keep posting list sorted
+        auto itr = idx->index_map.find(val_value_t);
+        if (itr == idx->index_map.end()) {
+            itr = idx->index_map.emplace(val_value_t, vector<uint64_t>()).first;
+            idx->hash_index[itr->first] = &(itr->second);
         }
-
-        // index_.count_map
-        if (idx->count_map.find(val_value_t) != idx->count_map.end()) {
-            idx->count_map.at(val_value_t)++;
-        } else {
-            idx->count_map.emplace(val_value_t, 1);
+        vector<uint64_t>& posting = itr->second;
+        auto p_itr = lower_bound(posting.begin(), posting.end(), id);
+        if (p_itr == posting.end() || *p_itr != id) {
+            posting.insert(p_itr, id);
         }
     } else {
-        bool exists = false;
         // index_.index_map
-        if (idx->index_map.find(val_value_t) != idx->index_map.end()) {
-            idx->index_map.at(val_value_t).erase(id);
+        auto itr = idx->index_map.find(val_value_t);
+        if (itr != idx->index_map.end()) {
+            vector<uint64_t>& posting = itr->second;
+            auto p_itr = lower_bound(posting.begin(), posting.end(), id);
+            if (p_itr != posting.end() && *p_itr == id) {
+                posting.erase(p_itr);
+            }
+        }
+    }
+}
+
+bool IndexStore::match_composite_index(const vector<int>& pids, const vector<pair<int, PredicateValue>>& pred_chain,
+                                       vector<int>& matched) {
+    matched.clear();
+    for (int i = 0; i < pids.size(); i++) {
+        bool is_last = (i == pids.size() - 1);
+        int pred_idx = -1;
+        for (int j = 0; j < pred_chain.size(); j++) {
+            const PredicateValue& pred = pred_chain[j].second;
+            if (pred_chain[j].first != pids[i]) {
+                continue;
+            }
+            if (is_last) {
+                if (pred.pred_type != Predicate_T::NONE) {
+                    pred_idx = j;
+                    break;
+                }
+            } else if (pred.pred_type == Predicate_T::EQ
+                    || (pred.pred_type == Predicate_T::WITHIN && pred.values.size() == 1)) {
+                pred_idx = j;
+                break;
+            }
+        }
+        if (pred_idx == -1) {
+            return false;
+        }
+        matched.push_back(pred_idx);
+    }
+    return true;
+}
+
+void IndexStore::read_composite_index(composite_index_& idx, vector<pair<int, PredicateValue>>& pred_chain,
+                                      const vector<int>& matched, vector<uint64_t>& vec) {
+    // Values of all keys except the last one are fixed
+    vector<value_t> prefix;
+    for (int i = 0; i < matched.size() - 1; i++) {
+        prefix.push_back(pred_chain[matched[i]].second.values[0]);
+    }
+    PredicateValue& last_pred = pred_chain[matched.back()].second;
+
+    for (auto itr = idx.index_map.lower_bound(prefix); itr != idx.index_map.end(); itr++) {
+        const vector<value_t>& key = itr->first;
+        if (!equal(prefix.begin(), prefix.end(), key.begin())) {
+            break;
+        }
+        if (Evaluate(last_pred, &key.back())) {
+            vec.insert(vec.end(), itr->second.begin(), itr->second.end());
+        }
+    }
+    sort(vec.begin(), vec.end());
+}
+
+uint64_t IndexStore::count_composite_index(composite_index_& idx, vector<pair<int, PredicateValue>>& pred_chain,
+                                           const vector<int>& matched) {
+    vector<value_t> prefix;
+    for (int i = 0; i < matched.size() - 1; i++) {
+        prefix.push_back(pred_chain[matched[i]].second.values[0]);
+    }
+    PredicateValue& last_pred = pred_chain[matched.back()].second;
+
+    // Each element is in one posting list only
+    uint64_t count = 0;
+    for (auto itr = idx.index_map.lower_bound(prefix); itr != idx.index_map.end(); itr++) {
+        const vector<value_t>& key = itr->first;
+        if (!equal(prefix.begin(), prefix.end(), key.begin())) {
+            break;
         }
+        if (Evaluate(last_pred, &key.back())) {
+            count += itr->second.size();
+        }
+    }
+    return count;
+}
 
-        // index_.count_map
-        if (idx->count_map.find(val_value_t) != idx->count_map.end() && exists) {
-            idx->count_map.at(val_value_t)--;
+void IndexStore::add_composite_delta(Element_T type, int pid, const vector<uint64_t>& ids, int n) {
+    if (ids.size() == 0) {
+        return;
+    }
+    map<vector<int>, composite_index_>* m = (type == Element_T::VERTEX) ? &vtx_composite_index : &edge_composite_index;
+    for (auto& item : *m) {
+        if (find(item.first.begin(), item.first.end(), pid) == item.first.end()) {
+            continue;
         }
+        composite_delta_& delta = *item.second.delta;
+        lock_guard<mutex> lock(delta.mu);
+        for (auto& id : ids) {
+            int& pending = delta.pending[id];
+            pending += n;
+            if (pending <= 0) {
+                delta.pending.erase(id);
+            }
+        }
+    }
+}
+
+bool IndexStore::has_composite_index(Element_T type, int pid) {
+    map<vector<int>, composite_index_>* m = (type == Element_T::VERTEX) ? &vtx_composite_index : &edge_composite_index;
+    for (auto& item : *m) {
+        if (find(item.first.begin(), item.first.end(), pid) != item.first.end()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void IndexStore::update_composite_index(Element_T type, int pid, const set<uint64_t>& ids, const uint64_t& threshold) {
+    map<vector<int>, composite_index_>* m = (type == Element_T::VERTEX) ? &vtx_composite_index : &edge_composite_index;
+    for (auto& item : *m) {
+        if (find(item.first.begin(), item.first.end(), pid) == item.first.end()) {
+            continue;
+        }
+        for (auto& id : ids) {
+            // Read keys visible at threshold, elements lacking any key are removed
+            vector<value_t> vals;
+            if (get_prop_values(type, item.first, id, 0, threshold, true, vals)) {
+                modify_composite_index(item.second, id, &vals);
+            } else {
+                modify_composite_index(item.second, id, NULL);
+            }
+        }
+    }
+}
+
+void IndexStore::modify_composite_index(composite_index_& idx, uint64_t id, const vector<value_t>* new_keys) {
+    // Remove from old posting list
+    auto k_itr = idx.element_keys.find(id);
+    if (k_itr != idx.element_keys.end()) {
+        auto itr = idx.index_map.find(k_itr->second);
+        if (itr != idx.index_map.end()) {
+            vector<uint64_t>& posting = itr->second;
+            auto p_itr = lower_bound(posting.begin(), posting.end(), id);
+            if (p_itr != posting.end() && *p_itr == id) {
+                posting.erase(p_itr);
+            }
+            if (posting.size() == 0) {
+                idx.index_map.erase(itr);
+            }
+        }
+        idx.element_keys.erase(k_itr);
+    }
+
+    if (new_keys == NULL) {
+        return;
+    }
+
+    // Insert into new posting list, keep sorted
+    vector<uint64_t>& posting = idx.index_map[*new_keys];
+    auto p_itr = lower_bound(posting.begin(), posting.end(), id);
+    if (p_itr == posting.end() || *p_itr != id) {
+        posting.insert(p_itr, id);
     }
+    idx.element_keys[id] = *new_keys;
 }
@@ -13,7 +13,12 @@
 // limitations under the License.
 
 #include <unordered_map>
+#include <unordered_set>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <algorithm>
 #include <utility>
 #include <vector>
@@ -34,10 +39,57 @@
 #pragma once
 
 #define INDEX_THRESHOLD_RATIO 0.2
+// Number of elements in one chunk of topology index
+#define TOPO_CHUNK_SIZE 65536
 
 class GCProducer;
 class GCConsumer;
 
+// Snapshot of topology index for one transaction
+//  Chunks are shared with IndexStore and never modified after built,
+//  so reading a snapshot does not copy merged data
+template <class T>
+struct topo_snapshot_t {
+    // Merged data, visible to all running transactions
+    vector<shared_ptr<const vector<T>>> chunks;
+    // Visible added elements from update region and update buffer
+    vector<T> add_vec;
+    // Invisible deleted elements in update region, by T.value()
+    unordered_set<uint64_t> del_set;
+
+    // Number of elements without considering del_set
+    uint64_t MaxCount() const {
+        uint64_t count = add_vec.size();
+        for (auto& chunk : chunks) {
+            count += chunk->size();
+        }
+        return count;
+    }
+
+    uint64_t Count() const {
+        if (del_set.size() == 0) {
+            return MaxCount();
+        }
+        uint64_t count = 0;
+        ForEach([&count](const T& e) { count++; });
+        return count;
+    }
+
+    template <class Func>
+    void ForEach(Func func) const {
+        for (auto& chunk : chunks) {
+            for (auto& e : *chunk) {
+                if (del_set.size() == 0 || del_set.find(e.value()) == del_set.end()) {
+                    func(e);
+                }
+            }
+        }
+        for (auto& e : add_vec) {
+            func(e);
+        }
+    }
+};
+
 /**
  * IndexStore is used to store all index related data to accelerate processing,
  * including 1.Topology Index (i.e. Init Message) 2.Property Index
@@ -48,8 +100,12 @@ class IndexStore {
         config_ = Config::GetInstance();
         data_storage_ = DataStorage::GetInstance();
         srand(time(NULL));
+        stop_builds_ = false;
     }
 
+    // Stop and join background index builds
+    ~IndexStore();
+
     static IndexStore* GetInstance() {
         static IndexStore* index_store_ptr = nullptr;
         if (index_store_ptr == nullptr) {
@@ -107,16 +163,44 @@ class IndexStore {
     void MoveTopoBufferToRegion(const uint64_t & trx_id, const uint64_t & ct);  // Invoke when validation begins
     void MovePropBufferToRegion(const uint64_t & trx_id, const uint64_t & ct);  // Invoke when commit successfully
     void UpdateTrxStatus(const uint64_t & trx_id, TRX_STAT stat);  // Update trx status in trx_status_and_count_table
+    // Bulk ingestion: insert elements of a committed trx into update region directly, skipping update buffer
+    //  vals: property values, only for VPID/EPID
+    void InsertCommittedToUpdateRegion(const uint64_t & trx_id, const uint64_t & ct, const vector<uint64_t>& ids, ID_T type,
+                                       const vector<value_t>* vals = NULL);
 
     // Prop Index Related
     bool IsIndexEnabled(Element_T type, int pid, PredicateValue* pred = NULL, uint64_t* count = NULL);
+    // Whether updates of pid should be inserted into update region,
+    //  i.e. its index is enabled or being built, or pid is a key of composite index
+    bool IsIndexTracked(Element_T type, int pid);
     bool SetIndexMap(Element_T type, int pid, map<value_t, vector<uint64_t>>& index_map, vector<uint64_t>& no_key_vec);
     bool SetIndexMapEnable(Element_T type, int pid, bool inverse = false);
 
+    // Composite Index Related
+    //  Index on values of multiple property keys, pid 0 stands for label
+    //  Lookup requires EQ on all keys except the last one
+    bool SetCompositeIndexMap(Element_T type, const vector<int>& pids, map<vector<value_t>, vector<uint64_t>>& index_map);
+    bool SetCompositeIndexEnable(Element_T type, const vector<int>& pids, bool inverse = false);
+    void GetCompositeIndexes(Element_T type, vector<vector<int>>& pids_list);  // Enabled composite indexes
+    // Count elements satisfying pred_chain by composite index, return false if not matched
+    //  matched_preds: index in pred_chain for each key of composite index
+    bool GetCompositeCount(Element_T type, const vector<int>& pids, vector<pair<int, PredicateValue>>& pred_chain,
+                           uint64_t& count, vector<int>* matched_preds = NULL);
+
+    // Background Index Build
+    enum IndexBuildStat { NOT_BUILT, BUILDING, BUILT };
+    // Build index of pids in background with snapshot of given trx, composite index if more than one pid
+    //  Updates committed after begin_time are captured by update region
+    //  Return false if index is being built or already built
+    bool StartIndexBuild(Element_T type, const vector<int>& pids, const uint64_t & trx_id, const uint64_t & begin_time);
+    IndexBuildStat GetIndexBuildStat(Element_T type, const vector<int>& pids);
+    string GetIndexBuildStatus();  // Progress of all index builds
+
     // Read Index
-    void ReadVtxTopoIndex(const uint64_t & trx_id, const uint64_t & begin_time, const bool & read_only, vector<vid_t> & data);
-    void ReadEdgeTopoIndex(const uint64_t & trx_id, const uint64_t & begin_time, const bool & read_only, vector<eid_t> & data);
-    void ReadPropIndex(Element_T type, vector<pair<int, PredicateValue>>& pred_chain, vector<value_t>& data);  // For Prop
+    void ReadVtxTopoIndex(const uint64_t & trx_id, const uint64_t & begin_time, const bool & read_only, topo_snapshot_t<vid_t> & data);
+    void ReadEdgeTopoIndex(const uint64_t & trx_id, const uint64_t & begin_time, const bool & read_only, topo_snapshot_t<eid_t> & data);
+    void ReadPropIndex(Element_T type, vector<pair<int, PredicateValue>>& pred_chain, vector<value_t>& data,
+                       const uint64_t & trx_id = 0, const uint64_t & begin_time = 0, const bool & read_only = true);  // For Prop
     bool GetRandomValue(Element_T type, int pid, string& value_str, const bool& is_update);
     void CleanRandomCount();
 
@@ -143,9 +227,11 @@ class IndexStore {
     struct index_{  // One Index for One PropertyKey (e.g. age)
         bool isEnabled;
         uint64_t total;  // Number of objs in total {i.e. all vertices or edges}
-        map<value_t, set<uint64_t>> index_map;  // Map for (value, set<element>) (e.g. (13 -> [v1, v2]) {g.V().has("age", 13)}
+        map<value_t, vector<uint64_t>> index_map;  // Map for (value, sorted elements) (e.g. (13 -> [v1, v2]) {g.V().has("age", 13)}
+        unordered_map<value_t, vector<uint64_t>*, ValueTContentHash> hash_index;  // Hash from value to posting list in index_map, for EQ/WITHIN
         set<uint64_t> no_key;  // Set for all elements that does not have propertyKey; {g.V().hasNot("age")}
-        map<value_t, uint64_t> count_map;  // Number of each 'age' values (e.g. (13 -> 2)) {g.V().has("age", 13).count()}
+        vector<value_t> sorted_keys;  // Sorted keys of index_map, for range count
+        vector<uint64_t> prefix_count;  // prefix_count[i]: Number of elements with value < sorted_keys[i] {g.V().has("age", gt(13)).count()}
         vector<const value_t *> values;  // Used when creating random values; Not for normal index
 
         string DebugString() {
@@ -154,20 +240,57 @@ class IndexStore {
             ret += "\ttotal: " + to_string(total) + "\n";
             ret += "\tsize of index_map: " + to_string(index_map.size()) + "\n";
             ret += "\tsize of no_key:" + to_string(no_key.size()) + "\n";
-            ret += "\tsize of count_map: " + to_string(count_map.size()) + "\n";
+            ret += "\tsize of hash_index: " + to_string(hash_index.size()) + "\n";
             ret += "\tsize of values: " + to_string(values.size()) + "\n";
 
             return ret;
         }
     };
 
-    // Original init data
-    //  Read Only except during GC
-    vector<vid_t> topo_vtx_data;
-    vector<eid_t> topo_edge_data;
+    // Original init data, split into chunks of TOPO_CHUNK_SIZE
+    //  Chunks are immutable, GC replaces modified chunks with new ones
+    vector<shared_ptr<const vector<vid_t>>> topo_vtx_chunks;
+    vector<shared_ptr<const vector<eid_t>>> topo_edge_chunks;
+    uint64_t topo_vtx_size = 0;
+    uint64_t topo_edge_size = 0;
     unordered_map<int, index_> vtx_prop_index;  // key: PropertyKey
     unordered_map<int, index_> edge_prop_index;  // key: PropertyKey
 
+    struct index_build_ {
+        IndexBuildStat stat;
+        uint64_t total;  // Number of elements to scan
+        atomic<uint64_t> scanned;  // Number of elements scanned
+        uint64_t start_time;
+        uint64_t end_time;
+        thread builder;  // joined in ~IndexStore
+
+        index_build_() : stat(BUILDING), total(0), scanned(0), start_time(timer::get_usec()), end_time(0) {}
+    };
+
+    // (type, pids) -> build progress
+    mutex build_mutex_;
+    map<pair<Element_T, vector<int>>, shared_ptr<index_build_>> index_builds_;
+    // Set on destruction, unfinished builds stop scanning and are not published
+    atomic<bool> stop_builds_;
+
+    // Elements with unmerged updates of any key of a composite index
+    //  Updated under reader lock when inserted into update region, thus guarded by mu
+    struct composite_delta_ {
+        mutex mu;
+        unordered_map<uint64_t, int> pending;  // element id -> number of update elements in update region
+    };
+
+    struct composite_index_ {  // One Index for a list of PropertyKeys (e.g. [label, city])
+        bool isEnabled;
+        map<vector<value_t>, vector<uint64_t>> index_map;  // Map for (values of keys, sorted elements)
+        unordered_map<uint64_t, vector<value_t>> element_keys;  // Values of keys of each element, for update
+        shared_ptr<composite_delta_> delta;
+    };
+
+    // key: PropertyKeys
+    map<vector<int>, composite_index_> vtx_composite_index;
+    map<vector<int>, composite_index_> edge_composite_index;
+
     // random count for each pid
     unordered_map<int, unordered_set<int>> vtx_rand_count;
     unordered_map<int, unordered_set<int>> edge_rand_count;
@@ -208,12 +331,55 @@ class IndexStore {
 
     void build_topo_data();
 
+    // Scan all elements and set index map, run in background thread
+    void build_prop_index(Element_T type, vector<int> pids, uint64_t trx_id, uint64_t begin_time, shared_ptr<index_build_> build);
+    // Get values of all pids of element, return false if any property not exists
+    bool get_prop_values(Element_T type, const vector<int>& pids, uint64_t id, const uint64_t & trx_id,
+                         const uint64_t & begin_time, const bool & read_only, vector<value_t> & vals);
+    // Get property value of element, return false if no such property
+    bool get_prop_value(Element_T type, int pid, uint64_t id, const uint64_t & trx_id, const uint64_t & begin_time,
+                        value_t & val, const bool & read_only = true);
+
+    // Read sorted elements by composite index covering most uncovered predicates, and mark them covered
+    //  Return false if no index covers any uncovered predicate
+    bool read_composite_prop_index(Element_T type, vector<pair<int, PredicateValue>>& pred_chain,
+                                   const uint64_t & trx_id, const uint64_t & begin_time, const bool & read_only,
+                                   vector<bool>& covered, vector<uint64_t>& vec);
+    bool has_composite_index(Element_T type, int pid);
+    // Find pred index for each key of composite index, return false if not matched
+    bool match_composite_index(const vector<int>& pids, const vector<pair<int, PredicateValue>>& pred_chain, vector<int>& matched);
+    // Get sorted elements satisfying matched predicates from composite index
+    void read_composite_index(composite_index_& idx, vector<pair<int, PredicateValue>>& pred_chain,
+                              const vector<int>& matched, vector<uint64_t>& vec);
+    // Sum of posting list sizes satisfying matched predicates, without reading elements
+    uint64_t count_composite_index(composite_index_& idx, vector<pair<int, PredicateValue>>& pred_chain,
+                                   const vector<int>& matched);
+    // Add n to pending count of ids in composite indexes containing pid, caller holds prop gc lock
+    void add_composite_delta(Element_T type, int pid, const vector<uint64_t>& ids, int n);
+    // Re-read keys of updated elements and update composite indexes containing pid
+    void update_composite_index(Element_T type, int pid, const set<uint64_t>& ids, const uint64_t& threshold);
+    void modify_composite_index(composite_index_& idx, uint64_t id, const vector<value_t>* new_keys);
+
+    // Split data into chunks
+    template <class T>
+    void build_topo_chunks(vector<T>& data, vector<shared_ptr<const vector<T>>>& chunks, uint64_t& size);
+    // Merge committed updates into chunks, only chunks containing deleted elements are rebuilt
+    //  For elements in add_set which already exist in chunks, remove from add_set
+    template <class T>
+    void merge_topo_chunks(set<T>& add_set, const unordered_set<uint64_t>& del_set,
+                           vector<shared_ptr<const vector<T>>>& chunks, uint64_t& size);
+
     void get_elements_by_predicate(Element_T type, int pid, PredicateValue& pred, bool need_sort, vector<uint64_t>& vec);
     uint64_t get_count_by_predicate(Element_T type, int pid, PredicateValue& pred);
     void read_prop_update_data(const update_element & up_elem, vector<uint64_t> & vec);
 
-    void build_range_count(map<value_t, uint64_t>& m, PredicateValue& pred, uint64_t& count);
-    void build_range_elements(map<value_t, set<uint64_t>>& m, PredicateValue& pred, vector<uint64_t>& vec, int& num_set);
+    void build_range_count(index_& idx, PredicateValue& pred, uint64_t& count);
+    void build_range_elements(map<value_t, vector<uint64_t>>& m, PredicateValue& pred, vector<uint64_t>& vec, int& num_set);
+
+    // Get posting list of given value, NULL if not found
+    const vector<uint64_t>* find_posting_list(index_& idx, const value_t& val);
+    // Rebuild sorted_keys and prefix_count after index_map modified
+    void build_prefix_count(index_& idx);
 
     void modify_index(index_ * idx, uint64_t& id, value_t& val_value_t, bool isAdd);
 
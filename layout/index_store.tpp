@@ -59,3 +59,117 @@ void build_range(map<value_t, T>& m, PredicateValue& pred, Iterator& low, Iterat
         }
     }
 }
+
+// Same as build_range, but on sorted array
+//  [low, high) is the index range of matched keys
+inline void build_range(const vector<value_t>& keys, PredicateValue& pred, size_t& low, size_t& high) {
+    low = 0;
+    high = keys.size();
+
+    // get lower bound
+    switch (pred.pred_type) {
+      case Predicate_T::GT:
+      case Predicate_T::GTE:
+      case Predicate_T::INSIDE:
+      case Predicate_T::BETWEEN:
+        low = lower_bound(keys.begin(), keys.end(), pred.values[0]) - keys.begin();
+    }
+
+    // remove "EQ"
+    switch (pred.pred_type) {
+      case Predicate_T::GT:
+      case Predicate_T::INSIDE:
+        if (low != keys.size() && keys[low] == pred.values[0]) {
+            low++;
+        }
+    }
+
+    int param = 1;
+    // get upper_bound
+    switch (pred.pred_type) {
+      case Predicate_T::LT:
+      case Predicate_T::LTE:
+        param = 0;
+      case Predicate_T::INSIDE:
+      case Predicate_T::BETWEEN:
+        high = upper_bound(keys.begin(), keys.end(), pred.values[param]) - keys.begin();
+    }
+
+    // remove "EQ"
+    switch (pred.pred_type) {
+      case Predicate_T::LT:
+      case Predicate_T::INSIDE:
+        // exclude last one if match
+        if (high > low && keys[high - 1] == pred.values[param]) {
+            high--;
+        }
+    }
+
+    if (high < low) {
+        high = low;
+    }
+}
+
+template <class T>
+void IndexStore::build_topo_chunks(vector<T>& data, vector<shared_ptr<const vector<T>>>& chunks, uint64_t& size) {
+    chunks.clear();
+    for (size_t i = 0; i < data.size(); i += TOPO_CHUNK_SIZE) {
+        size_t end = min(data.size(), i + TOPO_CHUNK_SIZE);
+        chunks.emplace_back(make_shared<const vector<T>>(data.begin() + i, data.begin() + end));
+    }
+    size = data.size();
+}
+
+template <class T>
+void IndexStore::merge_topo_chunks(set<T>& add_set, const unordered_set<uint64_t>& del_set,
+                                   vector<shared_ptr<const vector<T>>>& chunks, uint64_t& size) {
+    if (del_set.size() != 0) {
+        vector<shared_ptr<const vector<T>>> new_chunks;
+        for (auto& chunk : chunks) {
+            bool modified = false;
+            for (auto& e : *chunk) {
+                if (add_set.find(e) != add_set.end()) {
+                    add_set.erase(e);
+                }
+                if (del_set.find(e.value()) != del_set.end()) {
+                    modified = true;
+                }
+            }
+
+            if (!modified) {
+                new_chunks.push_back(chunk);
+                continue;
+            }
+
+            // copy on write
+            auto new_chunk = make_shared<vector<T>>();
+            new_chunk->reserve(chunk->size());
+            for (auto& e : *chunk) {
+                if (del_set.find(e.value()) == del_set.end()) {
+                    new_chunk->push_back(e);
+                }
+            }
+            size -= chunk->size() - new_chunk->size();
+            if (new_chunk->size() != 0) {
+                new_chunks.push_back(move(new_chunk));
+            }
+        }
+        chunks.swap(new_chunks);
+    }
+
+    // append added elements, fill up the last chunk first
+    vector<T> add_vec(add_set.begin(), add_set.end());
+    size_t pos = 0;
+    if (chunks.size() != 0 && chunks.back()->size() < TOPO_CHUNK_SIZE && add_vec.size() != 0) {
+        auto last_chunk = make_shared<vector<T>>(*chunks.back());
+        size_t n = min(add_vec.size(), TOPO_CHUNK_SIZE - last_chunk->size());
+        last_chunk->insert(last_chunk->end(), add_vec.begin(), add_vec.begin() + n);
+        chunks.back() = move(last_chunk);
+        pos = n;
+    }
+    for (; pos < add_vec.size(); pos += TOPO_CHUNK_SIZE) {
+        size_t end = min(add_vec.size(), pos + TOPO_CHUNK_SIZE);
+        chunks.emplace_back(make_shared<const vector<T>>(add_vec.begin() + pos, add_vec.begin() + end));
+    }
+    size += add_vec.size();
+}
@@ -0,0 +1,208 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "layout/ingest_batch.hpp"
+
+#include <sstream>
+
+#include "glog/logging.h"
+#include "utils/tool.hpp"
+
+using namespace std;
+
+namespace {
+
+bool ParseEndpoint(const string& token, uint64_t& ref) {
+    if (token.size() > 1 && token[0] == '$' && Tool::checktype(token.substr(1)) == 1) {
+        ref = stoull(token.substr(1)) | INGEST_NEW_VERTEX_FLAG;
+        return true;
+    }
+    if (Tool::checktype(token) == 1 || Tool::checktype(token) == 5) {
+        ref = stoull(token);
+        return !(ref & INGEST_NEW_VERTEX_FLAG);
+    }
+    return false;
+}
+
+bool ParseProperties(istringstream& iss, vector<pair<string, value_t>>& properties, string& error_msg) {
+    string key, value_str;
+    while (iss >> key) {
+        value_t value;
+        if (!(iss >> value_str) || !Tool::str2value_t(value_str, value)) {
+            error_msg = "invalid value of property " + key;
+            return false;
+        }
+        properties.emplace_back(key, move(value));
+    }
+    return true;
+}
+
+bool ResolveKey(const unordered_map<string, label_t>& str2key, const unordered_map<string, uint8_t>& str2type,
+                const pair<string, value_t>& property, label_t& pid, string& error_msg) {
+    auto itr = str2key.find(property.first);
+    if (itr == str2key.end()) {
+        error_msg = "unexpected property key " + property.first;
+        return false;
+    }
+    pid = itr->second;
+    if (str2type.at(to_string(pid)) != property.second.type) {
+        error_msg = "property key type no match with value type of " + property.first;
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+bool IngestBatch::ParseText(istream& in, string& error_msg) {
+    string line;
+    int line_no = 0;
+    while (getline(in, line)) {
+        line_no++;
+        istringstream iss(line);
+        string type;
+        if (!(iss >> type) || type[0] == '#')
+            continue;
+
+        if (type == "v") {
+            VertexRecord v;
+            if (!(iss >> v.label) || !ParseProperties(iss, v.properties, error_msg)) {
+                error_msg = "line " + to_string(line_no) + ": " + (error_msg.empty() ? "expect label" : error_msg);
+                return false;
+            }
+            vertices.emplace_back(move(v));
+        } else if (type == "e") {
+            EdgeRecord e;
+            string src, dst;
+            if (!(iss >> src >> dst >> e.label) || !ParseEndpoint(src, e.src) || !ParseEndpoint(dst, e.dst)
+                || !ParseProperties(iss, e.properties, error_msg)) {
+                error_msg = "line " + to_string(line_no) + ": " + (error_msg.empty() ? "expect <src> <dst> <label>" : error_msg);
+                return false;
+            }
+            edges.emplace_back(move(e));
+        } else {
+            error_msg = "line " + to_string(line_no) + ": unexpected type " + type;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SplitIngestBatch(const IngestBatch& batch, const string_index* indexes, const vector<vid_t>& vids,
+                      AbstractIdMapper* id_mapper, vector<IngestPart>& parts, string& error_msg) {
+    CHECK_EQ(vids.size(), batch.vertices.size());
+
+    for (size_t i = 0; i < batch.vertices.size(); i++) {
+        const IngestBatch::VertexRecord& v = batch.vertices[i];
+        auto itr = indexes->str2vl.find(v.label);
+        if (itr == indexes->str2vl.end()) {
+            error_msg = "unexpected vertex label " + v.label;
+            return false;
+        }
+
+        IngestPart& part = parts[id_mapper->GetMachineIdForVertex(vids[i])];
+        part.vids.emplace_back(vids[i].value());
+        part.v_labels.emplace_back(itr->second);
+
+        for (auto& property : v.properties) {
+            label_t pid;
+            if (!ResolveKey(indexes->str2vpk, indexes->str2vptype, property, pid, error_msg))
+                return false;
+            part.vpids.emplace_back(vpid_t(vids[i], pid).value());
+            part.vp_values.emplace_back(property.second);
+        }
+    }
+
+    auto get_vid = [&](uint64_t ref, vid_t& vid) {
+        if (ref & INGEST_NEW_VERTEX_FLAG) {
+            uint64_t idx = ref & ~INGEST_NEW_VERTEX_FLAG;
+            if (idx >= vids.size())
+                return false;
+            vid = vids[idx];
+            return true;
+        }
+        vid = vid_t(ref);
+        return vid.value() == ref;  // not truncated
+    };
+
+    for (auto& e : batch.edges) {
+        auto itr = indexes->str2el.find(e.label);
+        if (itr == indexes->str2el.end()) {
+            error_msg = "unexpected edge label " + e.label;
+            return false;
+        }
+
+        vid_t src_v, dst_v;
+        if (!get_vid(e.src, src_v) || !get_vid(e.dst, dst_v) || src_v == dst_v) {
+            error_msg = "invalid endpoints of edge with label " + e.label;
+            return false;
+        }
+        eid_t eid(dst_v.value(), src_v.value());
+
+        IngestPart& out_part = parts[id_mapper->GetMachineIdForVertex(src_v)];
+        out_part.out_eids.emplace_back(eid.value());
+        out_part.out_e_labels.emplace_back(itr->second);
+
+        IngestPart& in_part = parts[id_mapper->GetMachineIdForVertex(dst_v)];
+        in_part.in_eids.emplace_back(eid.value());
+        in_part.in_e_labels.emplace_back(itr->second);
+
+        // edge properties are only attached to outE
+        for (auto& property : e.properties) {
+            label_t pid;
+            if (!ResolveKey(indexes->str2epk, indexes->str2eptype, property, pid, error_msg))
+                return false;
+            out_part.epids.emplace_back(epid_t(eid, pid).value());
+            out_part.ep_values.emplace_back(property.second);
+        }
+    }
+    return true;
+}
+
+ibinstream& operator<<(ibinstream& m, const IngestBatch& batch) {
+    m << batch.vertices.size();
+    for (auto& v : batch.vertices)
+        m << v.label << v.properties;
+    m << batch.edges.size();
+    for (auto& e : batch.edges)
+        m << e.src << e.dst << e.label << e.properties;
+    return m;
+}
+
+obinstream& operator>>(obinstream& m, IngestBatch& batch) {
+    size_t size;
+    m >> size;
+    batch.vertices.resize(size);
+    for (auto& v : batch.vertices)
+        m >> v.label >> v.properties;
+    m >> size;
+    batch.edges.resize(size);
+    for (auto& e : batch.edges)
+        m >> e.src >> e.dst >> e.label >> e.properties;
+    return m;
+}
+
+ibinstream& operator<<(ibinstream& m, const IngestPart& part) {
+    m << part.vids << part.v_labels << part.vpids << part.vp_values
+      << part.out_eids << part.out_e_labels << part.in_eids << part.in_e_labels
+      << part.epids << part.ep_values;
+    return m;
+}
+
+obinstream& operator>>(obinstream& m, IngestPart& part) {
+    m >> part.vids >> part.v_labels >> part.vpids >> part.vp_values
+      >> part.out_eids >> part.out_e_labels >> part.in_eids >> part.in_e_labels
+      >> part.epids >> part.ep_values;
+    return m;
+}
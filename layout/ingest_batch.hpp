@@ -0,0 +1,92 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <istream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/serialization.hpp"
+#include "base/type.hpp"
+#include "core/abstract_id_mapper.hpp"
+
+/*
+IngestBatch is the binary format of bulk ingestion, which appends vertices and edges without parsing Gremlin.
+-----------------------------------------------------------------------------------
+Description:
+    1. The client sends an IngestBatch to one worker, which assigns vids for all new vertices in the batch.
+    2. The batch is split into one IngestPart per worker. New vertices stay on the receiving worker;
+       an edge goes to the worker of src_v (outE with properties) and the worker of dst_v (inE).
+    3. All parts are applied under one transaction without validation, and committed with one commit time.
+-----------------------------------------------------------------------------------
+Text format (used by the client to build a batch):
+    v <label> [<key> <value>]...
+    e <src> <dst> <label> [<key> <value>]...
+    where <src>/<dst> is $<i> for the i-th vertex in the batch (from 0), or the vid of an existing vertex.
+    Values follow the syntax of Gremlin queries (e.g., "marko", 29, 0.5). Lines starting with # are skipped.
+*/
+
+// With this flag, an endpoint of edge is the index of vertex in the same batch
+#define INGEST_NEW_VERTEX_FLAG (1ULL << 63)
+
+struct IngestBatch {
+    struct VertexRecord {
+        string label;
+        vector<pair<string, value_t>> properties;
+    };
+
+    struct EdgeRecord {
+        uint64_t src;
+        uint64_t dst;
+        string label;
+        vector<pair<string, value_t>> properties;
+    };
+
+    vector<VertexRecord> vertices;
+    vector<EdgeRecord> edges;
+
+    bool ParseText(istream& in, string& error_msg);
+};
+
+// Modifications of an IngestBatch on one worker, with labels and keys resolved
+struct IngestPart {
+    vector<uint64_t> vids;
+    vector<label_t> v_labels;
+    vector<uint64_t> vpids;
+    vector<value_t> vp_values;
+    vector<uint64_t> out_eids;
+    vector<label_t> out_e_labels;
+    vector<uint64_t> in_eids;
+    vector<label_t> in_e_labels;
+    vector<uint64_t> epids;
+    vector<value_t> ep_values;
+
+    bool Empty() const {
+        return vids.empty() && out_eids.empty() && in_eids.empty();
+    }
+};
+
+/* Resolve labels and keys of batch with indexes, and split it into parts[worker_id].
+ * vids: vids assigned to batch.vertices
+ * Returns false if the batch is invalid.
+ */
+bool SplitIngestBatch(const IngestBatch& batch, const string_index* indexes, const vector<vid_t>& vids,
+                      AbstractIdMapper* id_mapper, vector<IngestPart>& parts, string& error_msg);
+
+ibinstream& operator<<(ibinstream& m, const IngestBatch& batch);
+obinstream& operator>>(obinstream& m, IngestBatch& batch);
+ibinstream& operator<<(ibinstream& m, const IngestPart& part);
+obinstream& operator>>(obinstream& m, IngestPart& part);
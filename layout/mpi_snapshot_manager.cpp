@@ -86,3 +86,10 @@ void MPISnapshotManager::ConfirmConfig() {
 
     status_ = Status::CONFIG_CONFIRMED;
 }
+
+bool MPISnapshotManager::GetRawDataPath(string key, bool for_write, string& path) {
+    if (!(for_write ? write_enabled_ : read_enabled_) || status_ != Status::CONFIG_CONFIRMED)
+        return false;
+    path = path_ + key;
+    return true;
+}
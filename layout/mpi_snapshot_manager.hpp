@@ -80,6 +80,10 @@ class MPISnapshotManager {
     bool ReadData(string key, T& data);
     template<class T>
     bool WriteData(string key, T& data, bool force_write = false);  // if force_write == true, the snapshot will be written even after successfully reading
+
+    // For files that are written and read (e.g., mmap-ed) by the caller itself rather than serialized.
+    // Returns false if reading (or writing, if for_write == true) is not available.
+    bool GetRawDataPath(string key, bool for_write, string& path);
 };
 
 template<class T>
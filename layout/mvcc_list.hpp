@@ -69,6 +69,8 @@ class MVCCList {
     // If nullptr, then append failed.
     ValueType* AppendVersion(const uint64_t& trx_id, const uint64_t& begin_time, ValueType* old_val_header = nullptr, bool* old_val_exists = nullptr);
     ValueType* AppendInitialVersion();
+    // Invoked only when restoring a container snapshot, dumped_item is the initial version in the dumping process
+    ValueType* RestoreInitialVersion(Item* dumped_item);
     void CommitVersion(const uint64_t& trx_id, const uint64_t& commit_time);
     void AbortVersion(const uint64_t& trx_id);
 
@@ -281,6 +281,18 @@ decltype(Item::val)* MVCCList<Item>::AppendInitialVersion() {
     return &initial_mvcc->val;
 }
 
+template<class Item>
+decltype(Item::val)* MVCCList<Item>::RestoreInitialVersion(Item* dumped_item) {
+    // the initial version has no next version, only itself need to be relocated
+    Item* initial_mvcc = mem_pool_->Relocate(dumped_item);
+
+    head_ = initial_mvcc;
+    tail_ = initial_mvcc;
+    pre_tail_ = initial_mvcc;
+
+    return &initial_mvcc->val;
+}
+
 /* During commit stage, not only the tail_ need to be modified.
  * The end_time of the pre_tail_ need to be modified,
  * and it won't be visible to transaction with timestamp >= commit_time after Commit.
@@ -20,6 +20,11 @@ MVCCValueStore::MVCCValueStore(char* mem, size_t cell_count, int nthreads, bool
 }
 
 MVCCValueStore::~MVCCValueStore() {
+    if (mapped_file_ != nullptr) {
+        // next_offset_ and attached_mem_ are in the mapped file
+        munmap(mapped_file_, mapped_size_);
+        return;
+    }
     if (next_offset_ != nullptr)
         _mm_free(next_offset_);
     if (mem_allocated_)
@@ -71,6 +76,67 @@ void MVCCValueStore::Init(char* mem, size_t cell_count, int nthreads, bool utili
     utilization_record_ = utilization_record;
 }
 
+MVCCValueStore* MVCCValueStore::MapSnapshot(const std::string& path, size_t cell_count, int nthreads, bool utilization_record) {
+    MVCCValueStore* store = new MVCCValueStore();
+    if (!store->InitFromSnapshot(path, cell_count, nthreads, utilization_record)) {
+        delete store;
+        return nullptr;
+    }
+    return store;
+}
+
+bool MVCCValueStore::InitFromSnapshot(const std::string& path, size_t cell_count, int nthreads, bool utilization_record) {
+    ArenaSnapshotHeader header;
+    char* file = MapArenaSnapshot(path, header);
+    if (file == nullptr)
+        return false;
+
+    if (!header.Match(MEM_CELL_SIZE, sizeof(OffsetT), cell_count, nthreads, sizeof(ThreadLocalBlock))) {
+        munmap(file, header.file_size);
+        return false;
+    }
+
+    mapped_file_ = file;
+    mapped_size_ = header.file_size;
+
+    cell_count_ = cell_count;
+    attached_mem_ = file + header.mem_pos;
+    mem_allocated_ = false;
+    next_offset_ = reinterpret_cast<OffsetT*>(file + header.next_offset_pos);
+
+    head_ = header.head;
+    tail_ = header.tail;
+
+    thread_local_block_ = reinterpret_cast<ThreadLocalBlock*>(_mm_malloc(sizeof(ThreadLocalBlock) * nthreads, 4096));
+    memcpy(thread_local_block_, file + sizeof(ArenaSnapshotHeader), sizeof(ThreadLocalBlock) * nthreads);
+
+    pthread_spin_init(&lock_, 0);
+
+    nthreads_ = nthreads;
+    utilization_record_ = utilization_record;
+    return true;
+}
+
+bool MVCCValueStore::WriteSnapshot(const std::string& path) {
+    ArenaSnapshotHeader header;
+    header.cell_size = MEM_CELL_SIZE;
+    header.offset_size = sizeof(OffsetT);
+    header.cell_count = cell_count_;
+    header.nthreads = nthreads_;
+    header.block_size = sizeof(ThreadLocalBlock);
+    header.head = head_;
+    header.tail = tail_;
+    header.mem_base = reinterpret_cast<uint64_t>(attached_mem_);
+
+    return WriteArenaSnapshot(path, header, thread_local_block_, next_offset_, attached_mem_);
+}
+
+bool MVCCValueStore::CheckSnapshot(const std::string& path, size_t cell_count, int nthreads) {
+    ArenaSnapshotHeader header;
+    return ReadArenaSnapshotHeader(path, header)
+           && header.Match(MEM_CELL_SIZE, sizeof(OffsetT), cell_count, nthreads, sizeof(ThreadLocalBlock));
+}
+
 ValueHeader MVCCValueStore::InsertValue(const value_t& value, int tid) {
     ValueHeader ret;
     ret.byte_count = value.content.size() + 1;
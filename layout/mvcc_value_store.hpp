@@ -31,6 +31,7 @@
 #include <string>
 
 #include "base/type.hpp"
+#include "layout/arena_snapshot.hpp"
 
 #define OffsetT uint32_t
 #define MEM_CELL_SIZE 8
@@ -48,6 +49,7 @@ Usage:
     1. Use InsertValue() to insert a value_t into the MVCCValueStore. Insert() will return a ValueHeader.
     2. Use ReadValue() to get the inserted value_t by a ValueHeader.
     3. Use FreeValue() to free cells related to a ValueHeader.
+    4. Use WriteSnapshot() to dump the store verbatim, and MapSnapshot() to map it back. ValueHeader is offset-based, thus no relocation is needed.
 -----------------------------------------------------------------------------------
 Cautious: the same as ConcurrentMemoryPool, a thread id can only be used by one thread to avoid undefined behavior.
 */
@@ -71,6 +73,7 @@ struct ValueHeader {
 
 class MVCCValueStore {
  private:
+    MVCCValueStore() {}
     MVCCValueStore(const MVCCValueStore&);
     ~MVCCValueStore();
 
@@ -119,6 +122,13 @@ class MVCCValueStore {
     */
     void Init(char* mem, size_t cell_count, int nthreads, bool utilization_record);
 
+    // Map memories and blocks from a file written by WriteSnapshot(). Returns false if the file does not match.
+    bool InitFromSnapshot(const std::string& path, size_t cell_count, int nthreads, bool utilization_record);
+
+    // The whole snapshot file if the store is restored from it
+    char* mapped_file_ = nullptr;
+    size_t mapped_size_ = 0;
+
  public:
     // Insert a value_t to the MVCCValueStore, returns a ValueHeader used to fetch and free this value_t
     ValueHeader InsertValue(const value_t& value, int tid = 0);
@@ -129,6 +139,12 @@ class MVCCValueStore {
 
     MVCCValueStore(char* mem, size_t cell_count, int nthreads, bool utilization_record);
 
+    // Returns nullptr if the file does not match
+    static MVCCValueStore* MapSnapshot(const std::string& path, size_t cell_count, int nthreads, bool utilization_record);
+    // Should only be called when no thread is using the store
+    bool WriteSnapshot(const std::string& path);
+    static bool CheckSnapshot(const std::string& path, size_t cell_count, int nthreads);
+
     static constexpr int BLOCK_SIZE = 1024;
 
     std::string UsageString();
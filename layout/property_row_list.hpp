@@ -68,6 +68,12 @@ class PropertyRowList {
     // used when loading data from hdfs
     void InsertInitialCell(const PidType& pid, const value_t& value);
 
+    // Container snapshot, only valid when the row list holds initial cells only (i.e., right after loading).
+    // DumpInitialCells appends property_count_, head_ and the initial version of each cell to the table;
+    // RestoreInitialCells rebuilds the row list on the mapped rows and returns the position after its entries.
+    void DumpInitialCells(vector<uint64_t>& table);
+    const uint64_t* RestoreInitialCells(const uint64_t* table);
+
     READ_STAT ReadProperty(const PidType& pid, const uint64_t& trx_id,
                            const uint64_t& begin_time, const bool& read_only, value_t& ret);
     READ_STAT ReadPropertyByPKeyList(const vector<label_t>& p_key, const uint64_t& trx_id,
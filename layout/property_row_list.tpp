@@ -170,6 +170,48 @@ void PropertyRowList<PropertyRow>::InsertInitialCell(const PidType& pid, const v
     tail_->cells_[cell_id_in_row].mvcc_list = mvcc_list;
 }
 
+template <class PropertyRow>
+void PropertyRowList<PropertyRow>::DumpInitialCells(vector<uint64_t>& table) {
+    PropertyRow* current_row = head_;
+    table.push_back(property_count_);
+    table.push_back(reinterpret_cast<uint64_t>(current_row));
+
+    for (int i = 0; i < property_count_; i++) {
+        int cell_id_in_row = i % PropertyRow::ROW_CELL_COUNT;
+        if (i > 0 && cell_id_in_row == 0) {
+            current_row = current_row->next_;
+        }
+
+        MVCCListType* mvcc_list = current_row->cells_[cell_id_in_row].mvcc_list;
+        table.push_back(reinterpret_cast<uint64_t>(mvcc_list->GetHead()));
+    }
+}
+
+template <class PropertyRow>
+const uint64_t* PropertyRowList<PropertyRow>::RestoreInitialCells(const uint64_t* table) {
+    Init();
+    int property_count = *table++;
+    PropertyRow* current_row = mem_pool_->Relocate(reinterpret_cast<PropertyRow*>(*table++));
+    head_ = tail_ = current_row;
+
+    for (int i = 0; i < property_count; i++) {
+        int cell_id_in_row = i % PropertyRow::ROW_CELL_COUNT;
+        if (i > 0 && cell_id_in_row == 0) {
+            // only the next_ of non-tail rows are valid pointers
+            current_row->next_ = mem_pool_->Relocate(current_row->next_);
+            current_row = current_row->next_;
+            tail_ = current_row;
+        }
+
+        MVCCListType* mvcc_list = new MVCCListType;
+        mvcc_list->RestoreInitialVersion(reinterpret_cast<MVCCItemType*>(*table++));
+        current_row->cells_[cell_id_in_row].mvcc_list = mvcc_list;
+    }
+
+    property_count_ = property_count;
+    return table;
+}
+
 template <class PropertyRow>
 READ_STAT PropertyRowList<PropertyRow>::
         ReadProperty(const PidType& pid, const uint64_t& trx_id, const uint64_t& begin_time,
@@ -0,0 +1,209 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "layout/redo_logger.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__INTEL_COMPILER)
+#include <malloc.h>
+#else
+#include <mm_malloc.h>
+#endif  // defined(__GNUC__)
+
+#include <algorithm>
+#include <fstream>
+
+#include "glog/logging.h"
+
+using namespace std;
+
+RedoLogger::RedoLogger(const string& path, uint64_t valid_end) {
+    fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+    if (fd_ < 0 && errno == EINVAL) {
+        // e.g., tmpfs does not support O_DIRECT; writes are still block-aligned
+        fd_ = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    }
+    CHECK(fd_ >= 0) << "[RedoLogger] cannot open " << path << ": " << strerror(errno);
+
+    appended_lsn_ = durable_lsn_ = valid_end;
+    file_pos_ = valid_end / LOG_BLOCK_SIZE * LOG_BLOCK_SIZE;
+    tail_bytes_ = valid_end - file_pos_;
+
+    io_buf_cap_ = 256 * LOG_BLOCK_SIZE;
+    io_buf_ = reinterpret_cast<char*>(_mm_malloc(io_buf_cap_, LOG_BLOCK_SIZE));
+    memset(io_buf_, 0, io_buf_cap_);
+
+    if (tail_bytes_ > 0) {
+        CHECK(pread(fd_, io_buf_, LOG_BLOCK_SIZE, file_pos_) >= static_cast<ssize_t>(tail_bytes_));
+        // bytes after the valid records belong to a torn write
+        memset(io_buf_ + tail_bytes_, 0, LOG_BLOCK_SIZE - tail_bytes_);
+    }
+
+    // Drop torn blocks, otherwise an old complete record in them may be read after new records
+    CHECK(ftruncate(fd_, file_pos_ + (tail_bytes_ > 0 ? LOG_BLOCK_SIZE : 0)) == 0);
+
+    flusher_ = thread(&RedoLogger::FlushLoop, this);
+}
+
+RedoLogger::~RedoLogger() {
+    {
+        unique_lock<mutex> lock(mutex_);
+        stop_ = true;
+    }
+    flush_cv_.notify_one();
+    flusher_.join();
+
+    close(fd_);
+    _mm_free(io_buf_);
+}
+
+uint64_t RedoLogger::Checksum(const uint64_t& commit_time, const char* payload, uint32_t size) {
+    // FNV-1a, seeded with commit_time and size
+    uint64_t hash = 14695981039346656037ULL ^ commit_time ^ (static_cast<uint64_t>(size) << 32);
+    for (uint32_t i = 0; i < size; i++) {
+        hash ^= static_cast<uint8_t>(payload[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+uint64_t RedoLogger::Append(const uint64_t& commit_time, const char* payload, uint32_t size) {
+    RecordHeader header;
+    header.magic = RECORD_MAGIC;
+    header.size = size;
+    header.commit_time = commit_time;
+    header.checksum = Checksum(commit_time, payload, size);
+
+    uint64_t lsn;
+    {
+        unique_lock<mutex> lock(mutex_);
+        const char* header_ptr = reinterpret_cast<const char*>(&header);
+        pending_.insert(pending_.end(), header_ptr, header_ptr + sizeof(RecordHeader));
+        pending_.insert(pending_.end(), payload, payload + size);
+        appended_lsn_ += sizeof(RecordHeader) + size;
+        lsn = appended_lsn_;
+    }
+    flush_cv_.notify_one();
+    return lsn;
+}
+
+void RedoLogger::WaitDurable(const uint64_t& lsn) {
+    unique_lock<mutex> lock(mutex_);
+    durable_cv_.wait(lock, [&] {return durable_lsn_ >= lsn;});
+}
+
+/* Group commit: records appended while the previous batch is being written
+ * are written together in the next batch. Thus the batch size grows with the load,
+ * while a single commit waits for at most two fdatasync.
+ */
+void RedoLogger::FlushLoop() {
+    vector<char> batch;
+    while (true) {
+        uint64_t batch_lsn;
+        {
+            unique_lock<mutex> lock(mutex_);
+            flush_cv_.wait(lock, [&] {return stop_ || !pending_.empty();});
+            if (pending_.empty())
+                return;  // stop_ and nothing to write
+            batch.swap(pending_);
+            batch_lsn = appended_lsn_;
+        }
+
+        Flush(batch);
+        batch.clear();
+
+        {
+            unique_lock<mutex> lock(mutex_);
+            durable_lsn_ = batch_lsn;
+        }
+        durable_cv_.notify_all();
+    }
+}
+
+void RedoLogger::Flush(const vector<char>& batch) {
+    uint64_t total = tail_bytes_ + batch.size();
+    uint64_t aligned_total = (total + LOG_BLOCK_SIZE - 1) / LOG_BLOCK_SIZE * LOG_BLOCK_SIZE;
+
+    if (aligned_total > io_buf_cap_) {
+        uint64_t new_cap = io_buf_cap_;
+        while (new_cap < aligned_total)
+            new_cap *= 2;
+        char* new_buf = reinterpret_cast<char*>(_mm_malloc(new_cap, LOG_BLOCK_SIZE));
+        memcpy(new_buf, io_buf_, tail_bytes_);
+        _mm_free(io_buf_);
+        io_buf_ = new_buf;
+        io_buf_cap_ = new_cap;
+    }
+
+    memcpy(io_buf_ + tail_bytes_, batch.data(), batch.size());
+    memset(io_buf_ + total, 0, aligned_total - total);
+
+    uint64_t written = 0;
+    while (written < aligned_total) {
+        ssize_t ret = pwrite(fd_, io_buf_ + written, aligned_total - written, file_pos_ + written);
+        CHECK(ret > 0) << "[RedoLogger] write failed: " << strerror(errno);
+        written += ret;
+    }
+    CHECK(fdatasync(fd_) == 0) << "[RedoLogger] fdatasync failed: " << strerror(errno);
+
+    // keep the last partial block at the beginning of io_buf_
+    uint64_t full_bytes = total / LOG_BLOCK_SIZE * LOG_BLOCK_SIZE;
+    tail_bytes_ = total - full_bytes;
+    if (full_bytes > 0 && tail_bytes_ > 0)
+        memcpy(io_buf_, io_buf_ + full_bytes, tail_bytes_);
+    file_pos_ += full_bytes;
+}
+
+uint64_t RedoLogger::ReadLog(const string& path, vector<Record>& records) {
+    ifstream in_f(path, ios::binary);
+    if (!in_f.is_open())
+        return 0;
+
+    uint64_t valid_end = 0;
+    RecordHeader header;
+    while (in_f.read(reinterpret_cast<char*>(&header), sizeof(RecordHeader))) {
+        if (header.magic != RECORD_MAGIC)
+            break;
+
+        Record record;
+        record.commit_time = header.commit_time;
+        record.payload.resize(header.size);
+        if (!in_f.read(record.payload.data(), header.size))
+            break;
+        if (header.checksum != Checksum(header.commit_time, record.payload.data(), header.size))
+            break;
+
+        valid_end += sizeof(RecordHeader) + header.size;
+        records.emplace_back(move(record));
+    }
+
+    return valid_end;
+}
+
+uint64_t RedoLogger::RebaseCommitTimes(vector<Record>& records) {
+    // Only conflicting transactions are appended in the order of commit time
+    stable_sort(records.begin(), records.end(), [](const Record& r1, const Record& r2) {
+        return r1.commit_time < r2.commit_time;
+    });
+
+    uint64_t commit_time = 0;
+    for (auto& record : records)
+        record.commit_time = ++commit_time;
+    return commit_time;
+}
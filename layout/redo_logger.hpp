@@ -0,0 +1,113 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+RedoLogger persists the effects of committed transactions on this worker.
+-----------------------------------------------------------------------------------
+Description:
+    1. In the processing phase, DataStorage serializes the logical effect of each successful Process function
+       (e.g., AddV with vid and label, ModifyVP with pid and value) into the TrxProcessHistory of the transaction.
+    2. In DataStorage::Commit, the serialized effects are appended to the logger as one record, tagged with the commit time.
+    3. A flusher thread writes all appended records in one batch and calls fdatasync (group commit).
+       The committing thread waits until its record is durable before returning.
+    4. On startup, records are replayed in the order of commit time on top of the loaded data,
+       with commit times rebased onto the new clock epoch (see RebaseCommitTimes).
+-----------------------------------------------------------------------------------
+File format:
+    A sequence of [RecordHeader][payload]. The file is written in blocks of LOG_BLOCK_SIZE with O_DIRECT if available.
+    The partially filled last block is zero-padded, and rewritten in the next flush.
+    A record with wrong magic or checksum ends the log, so a torn write during crash is discarded.
+*/
+
+class RedoLogger {
+ public:
+    // Logical effects in the payload, each followed by its arguments
+    enum RecordType : uint8_t {
+        ADD_V,      // vid, label
+        DROP_V,     // vid
+        ADD_E,      // eid, label, is_out
+        DROP_E,     // eid, is_out
+        MODIFY_VP,  // pid, value (adding a new property is also a modification)
+        DROP_VP,    // pid
+        MODIFY_EP,  // pid, value
+        DROP_EP     // pid
+    };
+
+    struct Record {
+        uint64_t commit_time;
+        std::vector<char> payload;
+    };
+
+    static constexpr uint64_t LOG_BLOCK_SIZE = 4096;
+
+    // valid_end: the length of valid records in the file, returned by ReadLog
+    RedoLogger(const std::string& path, uint64_t valid_end);
+    ~RedoLogger();
+
+    // Returns the LSN (the end offset of the record) to wait for
+    uint64_t Append(const uint64_t& commit_time, const char* payload, uint32_t size);
+    // Block until all records before lsn are on disk
+    void WaitDurable(const uint64_t& lsn);
+
+    // Read all valid records in the file. Returns the length of valid records, 0 if the file does not exist.
+    static uint64_t ReadLog(const std::string& path, std::vector<Record>& records);
+
+    // The clock is calibrated again on each launch and restarts from 0, thus old commit times are meaningless.
+    // Sort records by commit time and replace the commit times with 1, 2, ..., returns the last one.
+    // Timestamps handed out after replaying must be larger than it.
+    static uint64_t RebaseCommitTimes(std::vector<Record>& records);
+
+ private:
+    struct RecordHeader {
+        uint32_t magic;
+        uint32_t size;
+        uint64_t commit_time;
+        uint64_t checksum;
+    };
+
+    static constexpr uint32_t RECORD_MAGIC = 0x52444f47;  // "RDOG"
+    static uint64_t Checksum(const uint64_t& commit_time, const char* payload, uint32_t size);
+
+    void FlushLoop();
+    void Flush(const std::vector<char>& batch);
+
+    int fd_;
+
+    std::mutex mutex_;
+    std::condition_variable flush_cv_;
+    std::condition_variable durable_cv_;
+    std::vector<char> pending_;  // appended but not written
+    uint64_t appended_lsn_;
+    uint64_t durable_lsn_;
+    bool stop_ = false;
+
+    // Only accessed by the flusher thread.
+    // io_buf_ always starts with the last (partial) block of the file at file_pos_, holding tail_bytes_ bytes
+    char* io_buf_ = nullptr;
+    uint64_t io_buf_cap_ = 0;
+    uint64_t file_pos_;
+    uint64_t tail_bytes_;
+
+    std::thread flusher_;
+};
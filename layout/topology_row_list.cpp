@@ -68,6 +68,61 @@ MVCCList<EdgeMVCCItem>* TopologyRowList::InsertInitialCell(const bool& is_out, c
     return mvcc_list;
 }
 
+void TopologyRowList::DumpInitialCells(vector<uint64_t>& table) {
+    VertexEdgeRow* current_row = head_;
+    table.push_back(edge_count_);
+    table.push_back(reinterpret_cast<uint64_t>(current_row));
+
+    for (int i = 0; i < edge_count_; i++) {
+        int cell_id_in_row = i % VE_ROW_CELL_COUNT;
+        if (i > 0 && cell_id_in_row == 0) {
+            current_row = current_row->next_;
+        }
+
+        MVCCList<EdgeMVCCItem>* mvcc_list = current_row->cells_[cell_id_in_row].mvcc_list;
+        table.push_back(reinterpret_cast<uint64_t>(mvcc_list->GetHead()));
+
+        EdgeVersion edge_version;
+        mvcc_list->GetVisibleVersion(0, 0, true, edge_version);
+        if (edge_version.ep_row_list != nullptr)
+            edge_version.ep_row_list->DumpInitialCells(table);
+    }
+}
+
+const uint64_t* TopologyRowList::RestoreInitialCells(const vid_t& my_vid, const uint64_t* table,
+        const function<void(const bool&, const vid_t&, MVCCList<EdgeMVCCItem>*)>& restored_edge) {
+    Init(my_vid);
+    int edge_count = *table++;
+    VertexEdgeRow* current_row = mem_pool_->Relocate(reinterpret_cast<VertexEdgeRow*>(*table++));
+    head_ = tail_ = current_row;
+
+    for (int i = 0; i < edge_count; i++) {
+        int cell_id_in_row = i % VE_ROW_CELL_COUNT;
+        if (i > 0 && cell_id_in_row == 0) {
+            current_row->next_ = mem_pool_->Relocate(current_row->next_);
+            current_row = current_row->next_;
+            tail_ = current_row;
+        }
+
+        auto& cell_ref = current_row->cells_[cell_id_in_row];
+        MVCCList<EdgeMVCCItem>* mvcc_list = new MVCCList<EdgeMVCCItem>;
+        EdgeVersion* edge_version = mvcc_list->RestoreInitialVersion(reinterpret_cast<EdgeMVCCItem*>(*table++));
+
+        // the dumped ep_row_list is a stale pointer, only telling whether the entries follow
+        if (edge_version->ep_row_list != nullptr) {
+            auto* ep_row_list = new PropertyRowList<EdgePropertyRow>;
+            table = ep_row_list->RestoreInitialCells(table);
+            edge_version->ep_row_list = ep_row_list;
+        }
+
+        cell_ref.mvcc_list = mvcc_list;
+        restored_edge(cell_ref.is_out, cell_ref.conn_vtx_id, mvcc_list);
+    }
+
+    edge_count_ = edge_count;
+    return table;
+}
+
 READ_STAT TopologyRowList::ReadConnectedVertex(const Direction_T& direction, const label_t& edge_label,
                                                const uint64_t& trx_id, const uint64_t& begin_time,
                                                const bool& read_only, vector<vid_t>& ret) {
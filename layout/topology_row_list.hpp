@@ -15,6 +15,7 @@
 #pragma once
 
 #include <atomic>
+#include <functional>
 
 #include "layout/mvcc_list.hpp"
 #include "tbb/atomic.h"
@@ -51,6 +52,13 @@ class TopologyRowList {
                                               const label_t& edge_label,
                                               PropertyRowList<EdgePropertyRow>* ep_row_list_ptr);
 
+    // Container snapshot, only valid right after loading. For each cell, the initial version is appended,
+    // followed by the entries of its ep_row_list for an out edge. See PropertyRowList::DumpInitialCells.
+    void DumpInitialCells(vector<uint64_t>& table);
+    // restored_edge is called with each restored cell, to rebuild edge maps
+    const uint64_t* RestoreInitialCells(const vid_t& my_vid, const uint64_t* table,
+                                        const function<void(const bool&, const vid_t&, MVCCList<EdgeMVCCItem>*)>& restored_edge);
+
     READ_STAT ReadConnectedVertex(const Direction_T& direction, const label_t& edge_label,
                                   const uint64_t& trx_id, const uint64_t& begin_time,
                                   const bool& read_only, vector<vid_t>& ret);
@@ -0,0 +1,138 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "core/abstract_mailbox.hpp"
+#include "expert/barrier_expert.hpp"
+#include "utils/tid_pool_manager.hpp"
+#include "utils/tool.hpp"
+
+#include "glog/logging.h"
+
+using namespace std;
+
+/*
+Test of OrderExpert for order() without by step, i.e., data are ordered by themselves and keys are never set.
+Each case runs a single msg through order with the next expert being a barrier, so that no msg is sent.
+*/
+
+namespace {
+
+// Any msg sent is unexpected
+class NoSendMailbox : public AbstractMailbox {
+ public:
+    void Init(vector<Node> & nodes) override {}
+    int Send(int tid, const Message & msg) override {
+        LOG(FATAL) << "unexpected msg " << msg.DebugString();
+        return 0;
+    }
+    bool TryRecv(int tid, Message & msg) override { return false; }
+    void Recv(int tid, Message & msg) override {}
+    void Sweep(int tid) override {}
+    void SendNotification(int dst_nid, ibinstream& in) override {}
+    void RecvNotification(obinstream& out) override {}
+};
+
+value_t IntValue(int i) {
+    value_t v;
+    Tool::str2int(to_string(i), v);
+    return v;
+}
+
+value_t StrValue(const string& s) {
+    value_t v;
+    Tool::str2str(s, v);
+    return v;
+}
+
+// order(order) followed by range(0, end) if end >= 0, or by end expert otherwise
+QueryPlan OrderPlan(Order_T order, int end) {
+    QueryPlan qplan;
+    qplan.trxid = 0x100;
+
+    Expert_Object order_expert(EXPERT_T::ORDER);
+    order_expert.params = {IntValue(-1), IntValue(order)};
+    order_expert.next_expert = 1;
+    qplan.experts.push_back(order_expert);
+
+    if (end >= 0) {
+        Expert_Object range_expert(EXPERT_T::RANGE);
+        range_expert.params = {IntValue(0), IntValue(end)};
+        range_expert.next_expert = 2;
+        qplan.experts.push_back(range_expert);
+    }
+    qplan.experts.emplace_back(EXPERT_T::END);
+    return qplan;
+}
+
+vector<value_t> RunOrder(OrderExpert& expert, const QueryPlan& qplan, uint64_t qid, const vector<value_t>& input) {
+    Message msg;
+    msg.meta.qid = qid;
+    msg.meta.step = 0;
+    msg.meta.msg_type = MSG_T::SPAWN;
+    msg.meta.msg_path = "1";
+    msg.data.emplace_back(history_t(), input);
+
+    expert.process(qplan, msg);
+    CHECK_EQ(msg.meta.step, 1);
+    CHECK_EQ(msg.data.size(), 1);
+    return msg.data[0].second;
+}
+
+void ExpectEqual(const vector<value_t>& actual, const vector<value_t>& expected) {
+    CHECK_EQ(actual.size(), expected.size());
+    for (int i = 0; i < actual.size(); i++) {
+        CHECK(actual[i] == expected[i]) << "at " << i << ": " << actual[i].DebugString()
+                                        << " != " << expected[i].DebugString();
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    google::InitGoogleLogging(argv[0]);
+    TidPoolManager::GetInstance()->Register(TID_TYPE::RDMA, 0);
+
+    NoSendMailbox mailbox;
+    OrderExpert expert(0, 1, &mailbox, nullptr);
+    uint64_t qid = 0x100;
+
+    vector<value_t> ints = {IntValue(5), IntValue(3), IntValue(9), IntValue(1), IntValue(7), IntValue(3)};
+
+    // with limit, top k through the bounded heap
+    ExpectEqual(RunOrder(expert, OrderPlan(Order_T::INCR, 2), qid++, ints), {IntValue(1), IntValue(3), IntValue(3)});
+    ExpectEqual(RunOrder(expert, OrderPlan(Order_T::DECR, 1), qid++, ints), {IntValue(9), IntValue(7)});
+    ExpectEqual(RunOrder(expert, OrderPlan(Order_T::INCR, 0), qid++, ints), {IntValue(1)});
+
+    // without limit, sorted by typed key
+    ExpectEqual(RunOrder(expert, OrderPlan(Order_T::INCR, -1), qid++, ints),
+                {IntValue(1), IntValue(3), IntValue(3), IntValue(5), IntValue(7), IntValue(9)});
+
+    // mixed types, sorted by value_t comparison
+    vector<value_t> strs = {StrValue("b"), StrValue("c"), StrValue("a")};
+    ExpectEqual(RunOrder(expert, OrderPlan(Order_T::DECR, -1), qid++, strs), {StrValue("c"), StrValue("b"), StrValue("a")});
+    vector<value_t> mixed = {IntValue(2), StrValue("a"), IntValue(1)};
+    vector<value_t> sorted = RunOrder(expert, OrderPlan(Order_T::INCR, -1), qid++, mixed);
+    CHECK_EQ(sorted.size(), 3);
+    for (int i = 1; i < sorted.size(); i++) {
+        CHECK(!(sorted[i] < sorted[i - 1]));
+    }
+    ExpectEqual(RunOrder(expert, OrderPlan(Order_T::INCR, 1), qid++, mixed), {sorted[0], sorted[1]});
+
+    cout << "order_expert_test passed" << endl;
+    return 0;
+}
@@ -0,0 +1,114 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "base/type.hpp"
+#include "layout/concurrent_mem_pool.hpp"
+#include "layout/mvcc_definition.hpp"
+#include "layout/mvcc_list.hpp"
+#include "layout/redo_logger.hpp"
+#include "utils/tid_pool_manager.hpp"
+
+#include "glog/logging.h"
+
+using namespace std;
+
+/*
+Test of replaying the redo log after restart.
+Records are logged with commit times of the previous launch, which are far larger than timestamps of the new launch,
+since the clock restarts from 0. Replayed versions must be visible to a transaction starting right after replaying.
+Each record adds (payload 1) or drops (payload 0) a vertex, replayed into one MVCCList like DataStorage::ReplayRedoLog.
+*/
+
+namespace {
+
+// Timestamps of the previous launch, about one hour after its clock started
+const uint64_t OLD_EPOCH = (3600ULL * 1000000000ULL) << 8;
+
+void AppendRecord(RedoLogger& logger, uint64_t commit_time, bool is_add) {
+    char payload = is_add ? 1 : 0;
+    logger.WaitDurable(logger.Append(commit_time, &payload, 1));
+}
+
+// Replay records into list, each as a transaction with begin_time == commit_time
+void Replay(const vector<RedoLogger::Record>& records, MVCCList<VertexMVCCItem>& list) {
+    uint64_t trx_id = TRX_ID_MASK;
+    for (auto& record : records) {
+        trx_id++;
+        bool* val = list.AppendVersion(trx_id, record.commit_time);
+        CHECK(val != nullptr);
+        *val = record.payload[0] == 1;
+        list.CommitVersion(trx_id, record.commit_time);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    google::InitGoogleLogging(argv[0]);
+    TidPoolManager::GetInstance()->Register(TID_TYPE::CONTAINER, 0);
+    MVCCList<VertexMVCCItem>::SetGlobalMemoryPool(ConcurrentMemPool<VertexMVCCItem>::GetInstance(nullptr, 1024, 1, false));
+
+    char path[] = "/tmp/redo_replay_test_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    close(fd);
+    unlink(path);
+
+    // Previous launch: add, drop and add again, conflicting records are appended in commit order
+    {
+        RedoLogger logger(path, 0);
+        AppendRecord(logger, OLD_EPOCH + 100, true);
+        AppendRecord(logger, OLD_EPOCH + 200, false);
+        AppendRecord(logger, OLD_EPOCH + 300, true);
+    }
+
+    // Restart
+    vector<RedoLogger::Record> records;
+    CHECK_GT(RedoLogger::ReadLog(path, records), 0);
+    CHECK_EQ(records.size(), 3);
+
+    // Without rebasing, a transaction of the new launch sees nothing
+    {
+        MVCCList<VertexMVCCItem> list;
+        Replay(records, list);
+        bool val;
+        CHECK(!list.SnapshotLevelGetVisibleVersion(TRX_ID_MASK + 100, 1 << 8, val));
+    }
+
+    uint64_t replay_end_time = RedoLogger::RebaseCommitTimes(records);
+    CHECK_EQ(replay_end_time, 3);
+    for (int i = 0; i < records.size(); i++)
+        CHECK_EQ(records[i].commit_time, i + 1);
+
+    MVCCList<VertexMVCCItem> list;
+    Replay(records, list);
+
+    // The first BT handed out is larger than replay_end_time, it reads the last replayed version
+    bool val = false;
+    CHECK(list.SnapshotLevelGetVisibleVersion(TRX_ID_MASK + 100, replay_end_time + 1, val));
+    CHECK(val);
+    // Replayed versions keep their order
+    CHECK(list.SnapshotLevelGetVisibleVersion(TRX_ID_MASK + 100, 2, val));
+    CHECK(!val);
+
+    unlink(path);
+    printf("redo_replay_test passed\n");
+    return 0;
+}
@@ -60,8 +60,16 @@ class Config{
 
     string HDFS_OUTPUT_PATH;
 
+    bool HDFS_BINARY_INPUT;  // input in binary columnar format instead of text
+
     string SNAPSHOT_PATH;  // if can be left to blank
 
+    // dump filled containers under SNAPSHOT_PATH and map them on restart instead of refilling
+    bool enable_container_snapshot;
+
+    // log committed updates under SNAPSHOT_PATH, and replay them on restart
+    bool enable_redo_log;
+
     // ==========================System Parameters==========================
     ISOLATION_LEVEL isolation_level;
     int global_num_workers;
@@ -74,8 +82,13 @@ class Config{
     static const int process_allocated_ts_tid = 1;
     static const int recv_notification_tid = 2;
     static const int perform_calibration_tid = 3;
+    static const int ingest_batch_tid = 4;
+    static const int ingest_part_tid = 5;
 
-    static const int extra_rdma_rc_thread_count = 4;
+    static const int extra_rdma_rc_thread_count = 6;
+
+    // Count of threads using containers outside ExpertAdapter and GCConsumer, i.e., main thread and two ingestion threads
+    static const int extra_container_thread_count = 3;
 
     // Count of extra RDMA send-buf in RDMAMainbox, for:
     // 1. Worker::Start
@@ -108,6 +121,8 @@ class Config{
 
     // per recv buffer should be able to contain up to N msg
     int global_per_recv_buffer_sz_mb;
+    // a thread is congested once its msgs waiting for remote buffers exceed it
+    int mailbox_congestion_cap_mb;
 
     // transaction table
     int trx_table_sz_mb;
@@ -120,12 +135,26 @@ class Config{
     bool global_enable_step_reorder;
     bool global_enable_indexing;
     bool global_enable_workstealing;
+    // share one recv buffer among all local threads for each remote worker
+    bool global_shared_recv_ring;
+    // number of connections to each remote worker in TCPMailbox, 0 to connect each remote thread
+    int tcp_mux_channels;
+    // deliver msgs between workers on the same host through shared memory
+    bool global_enable_shm_mailbox;
     bool global_enable_garbage_collect;
     bool global_enable_opt_preread;
     bool global_enable_opt_validation;
 
 
     int max_data_size;
+    // max number of prepared transactions cached on each worker, least recently used ones are evicted
+    int prepared_cache_size;
+    // capacity of QueryPlanStore, 0 to always ship full query plan in INIT msg
+    int plan_cache_size;
+    // number of threads scanning data when building property index in background
+    int index_build_threads;
+    // worker i serves runtime metrics on port metrics_port + i, 0 to disable
+    int metrics_port;
     // by default, do not rerun trx
     int abort_rerun_times = 0;
 
@@ -164,17 +193,19 @@ class Config{
     // send_buffer_offset = kvstore_sz + kvstore_offset
     uint64_t send_buffer_offset;
 
-    // recv_buffer_sz = (num_machines - 1) * num_threads *global_per_recv_buffer_sz_mb
+    // num_recv_rings = global_shared_recv_ring ? 1 : num_threads
+    int num_recv_rings;
+    // recv_buffer_sz = (num_machines - 1) * num_recv_rings *global_per_recv_buffer_sz_mb
     uint64_t recv_buffer_sz;
     // recv_buffer_offset = send_buffer_sz + send_buffer_offset
     uint64_t recv_buffer_offset;
 
-    // local_head_buffer_sz = (num_machines - 1) * num_threads *sizeof(uint64_t)
+    // local_head_buffer_sz = (num_machines - 1) * num_recv_rings *sizeof(uint64_t)
     uint64_t local_head_buffer_sz;
     // local_head_buffer_offset = recv_buffer_sz + recv_buffer_offset
     uint64_t local_head_buffer_offset;
 
-    // remote_head_buffer_sz = (num_machines - 1) * num_threads *sizeof(uint64_t)
+    // remote_head_buffer_sz = (num_machines - 1) * num_recv_rings *sizeof(uint64_t)
     uint64_t remote_head_buffer_sz;
     // remote_head_buffer_offset = local_head_buffer_sz + local_head_buffer_offset
     uint64_t remote_head_buffer_offset;
@@ -319,6 +350,13 @@ class Config{
             exit(-1);
         }
 
+        str = iniparser_getstring(ini, "HDFS:HDFS_INPUT_FORMAT", str_not_found);
+        if (strcmp(str, str_not_found) != 0) {
+            HDFS_BINARY_INPUT = (strcmp(str, "binary") == 0);
+        } else {
+            HDFS_BINARY_INPUT = false;
+        }
+
         // // [SYSTEM]
         // val = iniparser_getint(ini, "SYSTEM:NUM_WORKER_NODES", val_not_found);
         // if (val != val_not_found) global_num_workers=val;
@@ -543,6 +581,35 @@ class Config{
             exit(-1);
         }
 
+        val = iniparser_getboolean(ini, "SYSTEM:SHARED_RECV_RING", val_not_found);
+        if (val != val_not_found) {
+            global_shared_recv_ring = val;
+        } else {
+            global_shared_recv_ring = false;
+        }
+
+        val = iniparser_getint(ini, "SYSTEM:MAILBOX_CONGESTION_CAP_MB", val_not_found);
+        if (val != val_not_found && val > 0) {
+            mailbox_congestion_cap_mb = val;
+        } else {
+            mailbox_congestion_cap_mb = global_per_recv_buffer_sz_mb;
+        }
+
+        val = iniparser_getint(ini, "SYSTEM:TCP_MUX_CHANNELS", val_not_found);
+        if (val != val_not_found && val > 0) {
+            // channels reuse the ports of per-thread connections
+            tcp_mux_channels = min(val, global_num_threads);
+        } else {
+            tcp_mux_channels = 0;
+        }
+
+        val = iniparser_getboolean(ini, "SYSTEM:ENABLE_SHM_MAILBOX", val_not_found);
+        if (val != val_not_found) {
+            global_enable_shm_mailbox = val;
+        } else {
+            global_enable_shm_mailbox = false;
+        }
+
         val = iniparser_getboolean(ini, "SYSTEM:ENABLE_GARBAGE_COLLECT", val_not_found);
         if (val != val_not_found) {
             global_enable_garbage_collect = val;
@@ -575,6 +642,34 @@ class Config{
             exit(-1);
         }
 
+        val = iniparser_getint(ini, "SYSTEM:PREPARED_CACHE_SIZE", val_not_found);
+        if (val != val_not_found && val > 0) {
+            prepared_cache_size = val;
+        } else {
+            prepared_cache_size = 1024;
+        }
+
+        val = iniparser_getint(ini, "SYSTEM:PLAN_CACHE_SIZE", val_not_found);
+        if (val != val_not_found) {
+            plan_cache_size = val;
+        } else {
+            plan_cache_size = 4096;
+        }
+
+        val = iniparser_getint(ini, "SYSTEM:INDEX_BUILD_THREADS", val_not_found);
+        if (val != val_not_found && val > 0) {
+            index_build_threads = val;
+        } else {
+            index_build_threads = 2;
+        }
+
+        val = iniparser_getint(ini, "SYSTEM:METRICS_PORT", val_not_found);
+        if (val != val_not_found && val > 0) {
+            metrics_port = val;
+        } else {
+            metrics_port = 0;
+        }
+
         str = iniparser_getstring(ini, "SYSTEM:SNAPSHOT_PATH", str_not_found);
 
         if (strcmp(str, str_not_found) != 0) {
@@ -600,6 +695,20 @@ class Config{
             SNAPSHOT_PATH = "";
         }
 
+        val = iniparser_getboolean(ini, "SYSTEM:ENABLE_CONTAINER_SNAPSHOT", val_not_found);
+        if (val != val_not_found) {
+            enable_container_snapshot = val;
+        } else {
+            enable_container_snapshot = false;
+        }
+
+        val = iniparser_getboolean(ini, "SYSTEM:ENABLE_REDO_LOG", val_not_found);
+        if (val != val_not_found) {
+            enable_redo_log = val;
+        } else {
+            enable_redo_log = false;
+        }
+
         val = iniparser_getint(ini, "GC:ERASE_V_T_THRESHOLD", val_not_found);
         if (val != val_not_found) {
             Erase_V_Task_THRESHOLD = val;
@@ -749,13 +858,15 @@ class Config{
             send_buffer_sz = (global_num_threads + extra_send_buf_count) * MiB2B(global_per_send_buffer_sz_mb);
             send_buffer_offset = kvstore_offset + kvstore_sz;
 
-            recv_buffer_sz = (global_num_workers - 1) * global_num_threads * MiB2B(global_per_recv_buffer_sz_mb);
+            // one recv buffer per (remote worker, local thread), or per remote worker if shared
+            num_recv_rings = global_shared_recv_ring ? 1 : global_num_threads;
+            recv_buffer_sz = (global_num_workers - 1) * num_recv_rings * MiB2B(global_per_recv_buffer_sz_mb);
             recv_buffer_offset = send_buffer_offset + send_buffer_sz;
 
-            local_head_buffer_sz = (global_num_workers - 1) * global_num_threads * sizeof(uint64_t);
+            local_head_buffer_sz = (global_num_workers - 1) * num_recv_rings * sizeof(uint64_t);
             local_head_buffer_offset = recv_buffer_sz + recv_buffer_offset;
 
-            remote_head_buffer_sz = (global_num_workers - 1) * global_num_threads * sizeof(uint64_t);
+            remote_head_buffer_sz = (global_num_workers - 1) * num_recv_rings * sizeof(uint64_t);
             remote_head_buffer_offset = local_head_buffer_sz + local_head_buffer_offset;
 
             // only one thread (GC) will read MIN_BT from master
@@ -798,7 +909,10 @@ class Config{
         ss << "HDFS_VP_SUBFOLDER : " << HDFS_VP_SUBFOLDER << endl;
         ss << "HDFS_EP_SUBFOLDER : " << HDFS_EP_SUBFOLDER << endl;
         ss << "HDFS_OUTPUT_PATH : " << HDFS_OUTPUT_PATH << endl;
+        ss << "HDFS_BINARY_INPUT : " << HDFS_BINARY_INPUT << endl;
         ss << "SNAPSHOT_PATH : " << SNAPSHOT_PATH << endl;
+        ss << "ENABLE_CONTAINER_SNAPSHOT : " << enable_container_snapshot << endl;
+        ss << "ENABLE_REDO_LOG : " << enable_redo_log << endl;
 
         ss << "kvstore_sz : " << kvstore_sz << endl;
         ss << "send_buffer_sz : " << send_buffer_sz << endl;
@@ -819,12 +933,16 @@ class Config{
         ss << "global_edge_property_kv_sz_gb : " << global_edge_property_kv_sz_gb << endl;
         ss << "global_per_send_buffer_sz_mb : " << global_per_send_buffer_sz_mb << endl;
         ss << "global_per_recv_buffer_sz_mb : " << global_per_recv_buffer_sz_mb << endl;
+        ss << "mailbox_congestion_cap_mb : " << mailbox_congestion_cap_mb << endl;
 
         ss << "global_use_rdma : " << global_use_rdma << endl;
         ss << "global_enable_caching : " << global_enable_caching << endl;
         ss << "global_enable_core_binding : " << global_enable_core_binding << endl;
         ss << "global_enable_expert_division : " << global_enable_expert_division << endl;
         ss << "global_enable_workstealing : " << global_enable_workstealing << endl;
+        ss << "global_shared_recv_ring : " << global_shared_recv_ring << endl;
+        ss << "tcp_mux_channels : " << tcp_mux_channels << endl;
+        ss << "global_enable_shm_mailbox : " << global_enable_shm_mailbox << endl;
 
         return ss.str();
     }
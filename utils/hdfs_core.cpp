@@ -103,6 +103,32 @@ hdfsFile get_rw_handle(const char* path, hdfsFS fs) {
     return hdl;
 }
 
+// ====== Read file ======
+
+void read_file(const char* path, hdfsFS fs, vector<char>& buf) {
+    hdfsFileInfo* info = hdfsGetPathInfo(fs, path);
+    if (!info) {
+        fprintf(stderr, "Failed to get info of %s!\n", path);
+        exit(-1);
+    }
+    size_t size = info->mSize;
+    hdfsFreeFileInfo(info, 1);
+
+    buf.resize(size);
+    hdfsFile in = get_r_handle(path, fs);
+    size_t pos = 0;
+    while (pos < size) {
+        tSize len = min(size - pos, (size_t)HDFS_BLOCK_SIZE);
+        tSize ret = hdfsRead(fs, in, &buf[pos], len);
+        if (ret <= 0) {
+            fprintf(stderr, "Failed to read %s!\n", path);
+            exit(-1);
+        }
+        pos += ret;
+    }
+    hdfsCloseFile(fs, in);
+}
+
 // ====== Read line ======
 
 // logic:
@@ -56,6 +56,11 @@ hdfsFile get_w_handle(const char* path, hdfsFS fs);
 
 hdfsFile get_rw_handle(const char* path, hdfsFS fs);
 
+// ====== Read file ======
+
+// read the whole file into buf, used for binary input
+void read_file(const char* path, hdfsFS fs, vector<char>& buf);
+
 // ====== Read line ======
 
 // logic:
@@ -0,0 +1,98 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+/* High dynamic range histogram of uint64_t values (e.g., latency in us), in fixed memory.
+ * Values are bucketed by their highest set bit, and each bucket is split into SUB_BUCKET_COUNT linear sub-buckets,
+ * thus the relative error of recorded values is below 1 / SUB_BUCKET_COUNT (i.e., 3 significant digits).
+ */
+class HdrHistogram {
+ public:
+    HdrHistogram() : counts_(NUM_BUCKETS * SUB_BUCKET_COUNT, 0) {}
+
+    void Record(uint64_t value) {
+        counts_[GetIndex(value)]++;
+        total_count_++;
+        sum_ += value;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+
+    void Merge(const HdrHistogram& other) {
+        for (size_t i = 0; i < counts_.size(); i++)
+            counts_[i] += other.counts_[i];
+        total_count_ += other.total_count_;
+        sum_ += other.sum_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    void Reset() {
+        std::fill(counts_.begin(), counts_.end(), 0);
+        total_count_ = sum_ = max_ = 0;
+        min_ = UINT64_MAX;
+    }
+
+    uint64_t Count() const { return total_count_; }
+    uint64_t Min() const { return total_count_ == 0 ? 0 : min_; }
+    uint64_t Max() const { return max_; }
+    double Mean() const { return total_count_ == 0 ? 0 : static_cast<double>(sum_) / total_count_; }
+
+    // percentile in [0, 100], returns the highest value equivalent to the value at percentile
+    uint64_t ValueAtPercentile(double percentile) const {
+        if (total_count_ == 0)
+            return 0;
+        uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(percentile / 100.0 * total_count_ + 0.5));
+        uint64_t count = 0;
+        for (size_t i = 0; i < counts_.size(); i++) {
+            count += counts_[i];
+            if (count >= target)
+                return std::min(GetHighestEquivalentValue(i), max_);
+        }
+        return max_;
+    }
+
+ private:
+    static const int SUB_BUCKET_BITS = 10;
+    static const uint64_t SUB_BUCKET_COUNT = 1ULL << SUB_BUCKET_BITS;
+    // bucket 0 holds [0, SUB_BUCKET_COUNT) exactly, bucket b > 0 holds [2^(b-1) * SUB_BUCKET_COUNT, 2^b * SUB_BUCKET_COUNT)
+    static const int NUM_BUCKETS = 64 - SUB_BUCKET_BITS + 1;
+
+    // sub-bucket s of bucket b > 0 holds [(SUB_BUCKET_COUNT + s) << (b - 1), (SUB_BUCKET_COUNT + s + 1) << (b - 1))
+    static size_t GetIndex(uint64_t value) {
+        int bucket = value < SUB_BUCKET_COUNT ? 0 : 64 - SUB_BUCKET_BITS - __builtin_clzll(value);
+        uint64_t sub_bucket = bucket == 0 ? value : (value >> (bucket - 1)) - SUB_BUCKET_COUNT;
+        return bucket * SUB_BUCKET_COUNT + sub_bucket;
+    }
+
+    static uint64_t GetHighestEquivalentValue(size_t index) {
+        int bucket = index / SUB_BUCKET_COUNT;
+        uint64_t sub_bucket = index % SUB_BUCKET_COUNT;
+        if (bucket == 0)
+            return sub_bucket;
+        return ((SUB_BUCKET_COUNT + sub_bucket + 1) << (bucket - 1)) - 1;
+    }
+
+    std::vector<uint64_t> counts_;
+    uint64_t total_count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t min_ = UINT64_MAX;
+    uint64_t max_ = 0;
+};
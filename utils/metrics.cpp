@@ -0,0 +1,182 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <sstream>
+
+#include "glog/logging.h"
+#include "utils/metrics.hpp"
+
+using namespace std;
+
+void ShardedHistogram::Snapshot(vector<uint64_t>& counts, uint64_t& sum) const {
+    counts.assign(NUM_BOUNDS + 1, 0);
+    sum = 0;
+    for (int i = 0; i < METRICS_NUM_SHARDS; i++) {
+        for (int j = 0; j <= NUM_BOUNDS; j++)
+            counts[j] += shards_[i].counts[j].load(memory_order_relaxed);
+        sum += shards_[i].sum.load(memory_order_relaxed);
+    }
+}
+
+MetricsRegistry::Family& MetricsRegistry::GetFamily(const string& name, const string& help, MetricType type) {
+    auto itr = families_.find(name);
+    if (itr == families_.end()) {
+        itr = families_.emplace(name, Family()).first;
+        itr->second.type = type;
+        itr->second.help = help;
+    }
+    CHECK(itr->second.type == type) << "[MetricsRegistry] " << name << " is registered with another type";
+    return itr->second;
+}
+
+ShardedCounter* MetricsRegistry::GetCounter(const string& name, const string& help, const string& labels) {
+    lock_guard<mutex> lock(mutex_);
+    unique_ptr<ShardedCounter>& counter = GetFamily(name, help, COUNTER).counters[labels];
+    if (!counter)
+        counter.reset(new ShardedCounter());
+    return counter.get();
+}
+
+ShardedHistogram* MetricsRegistry::GetHistogram(const string& name, const string& help, const string& labels) {
+    lock_guard<mutex> lock(mutex_);
+    unique_ptr<ShardedHistogram>& histogram = GetFamily(name, help, HISTOGRAM).histograms[labels];
+    if (!histogram)
+        histogram.reset(new ShardedHistogram());
+    return histogram.get();
+}
+
+void MetricsRegistry::RegisterGauge(const string& name, const string& help, GaugeCollector collector) {
+    lock_guard<mutex> lock(mutex_);
+    GetFamily(name, help, GAUGE).collectors.push_back(move(collector));
+}
+
+// name{labels}, or name{labels,extra} if extra is given
+static string Series(const string& name, const string& labels, const string& extra = "") {
+    string all = labels;
+    if (!extra.empty())
+        all += (all.empty() ? "" : ",") + extra;
+    return all.empty() ? name : name + "{" + all + "}";
+}
+
+string MetricsRegistry::ExportText() {
+    lock_guard<mutex> lock(mutex_);
+    stringstream ss;
+    for (auto& family_pair : families_) {
+        const string& name = family_pair.first;
+        Family& family = family_pair.second;
+
+        ss << "# HELP " << name << " " << family.help << "\n";
+        switch (family.type) {
+          case COUNTER:
+            ss << "# TYPE " << name << " counter\n";
+            for (auto& p : family.counters)
+                ss << Series(name, p.first) << " " << p.second->Value() << "\n";
+            break;
+          case HISTOGRAM:
+            ss << "# TYPE " << name << " histogram\n";
+            for (auto& p : family.histograms) {
+                vector<uint64_t> counts;
+                uint64_t sum;
+                p.second->Snapshot(counts, sum);
+                // buckets are cumulative
+                uint64_t count = 0;
+                for (int i = 0; i < counts.size(); i++) {
+                    count += counts[i];
+                    string le = i < ShardedHistogram::NUM_BOUNDS ? to_string(1ULL << i) : "+Inf";
+                    ss << Series(name + "_bucket", p.first, "le=\"" + le + "\"") << " " << count << "\n";
+                }
+                ss << Series(name + "_sum", p.first) << " " << sum << "\n";
+                ss << Series(name + "_count", p.first) << " " << count << "\n";
+            }
+            break;
+          case GAUGE:
+            ss << "# TYPE " << name << " gauge\n";
+            for (auto& collector : family.collectors) {
+                vector<pair<string, double>> samples;
+                collector(samples);
+                for (auto& sample : samples)
+                    ss << Series(name, sample.first) << " " << sample.second << "\n";
+            }
+            break;
+        }
+    }
+    return ss.str();
+}
+
+bool MetricsRegistry::StartServer(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return false;
+
+    int opt = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+        close(fd);
+        return false;
+    }
+
+    server_thread_ = thread(&MetricsRegistry::Serve, this, fd);
+    server_thread_.detach();
+    return true;
+}
+
+// Minimal HTTP/1.0 server: any request gets all metrics, and the connection is closed after the response
+void MetricsRegistry::Serve(int listen_fd) {
+    char buf[4096];
+    while (true) {
+        int conn_fd = accept(listen_fd, NULL, NULL);
+        if (conn_fd < 0)
+            continue;
+
+        // a client that connects without sending or reading must not block the server
+        struct timeval timeout;
+        timeout.tv_sec = 1;
+        timeout.tv_usec = 0;
+        setsockopt(conn_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(conn_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        // the request is not parsed, read until the end of header or the buffer is full
+        string request;
+        ssize_t n;
+        while (request.find("\r\n\r\n") == string::npos && request.size() < sizeof(buf)
+               && (n = read(conn_fd, buf, sizeof(buf))) > 0) {
+            request.append(buf, n);
+        }
+
+        string body = ExportText();
+        string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+                          + to_string(body.size()) + "\r\n\r\n" + body;
+        size_t sent = 0;
+        while (sent < response.size()) {
+            // no SIGPIPE if the scraper has closed the connection
+            n = send(conn_fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0)
+                break;
+            sent += n;
+        }
+        close(conn_fd);
+    }
+}
@@ -0,0 +1,146 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/* Runtime metrics of a worker, exported in Prometheus text format.
+ * -----------------------------------------------------------------------------------
+ * Counters and histograms are sharded by thread, i.e., each thread updates its own cache line with a relaxed atomic,
+ * and shards are summed up only on export. Gauges are collected by callbacks on export, thus cost nothing in between.
+ *
+ * Metrics are identified by name and labels, where labels are formatted as `key="value",key2="value2"`.
+ * Pointers returned by GetCounter/GetHistogram are valid until exit, callers are expected to keep them.
+ *
+ * Usage:
+ *     static ShardedCounter* commits = MetricsRegistry::GetInstance()->GetCounter(
+ *         "gtran_trx_total", "Finished transactions", "result=\"commit\"");
+ *     commits->Inc();
+ */
+
+#define METRICS_NUM_SHARDS 64
+
+// Shard of the calling thread, assigned round-robin at first use
+inline int MetricsThreadShard() {
+    static std::atomic<int> next_shard(0);
+    static thread_local int shard = next_shard++ % METRICS_NUM_SHARDS;
+    return shard;
+}
+
+class ShardedCounter {
+ public:
+    void Inc(uint64_t n = 1) {
+        shards_[MetricsThreadShard()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t Value() const {
+        uint64_t sum = 0;
+        for (int i = 0; i < METRICS_NUM_SHARDS; i++)
+            sum += shards_[i].value.load(std::memory_order_relaxed);
+        return sum;
+    }
+
+ private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+    Shard shards_[METRICS_NUM_SHARDS];
+};
+
+// Histogram with power-of-2 bucket bounds 1, 2, 4, ..., 2^(NUM_BOUNDS - 1), plus +Inf
+class ShardedHistogram {
+ public:
+    static const int NUM_BOUNDS = 25;
+
+    void Observe(uint64_t value) {
+        Shard& shard = shards_[MetricsThreadShard()];
+        // index of the smallest bound >= value
+        int idx = value <= 1 ? 0 : 64 - __builtin_clzll(value - 1);
+        if (idx > NUM_BOUNDS)
+            idx = NUM_BOUNDS;
+        shard.counts[idx].fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    // counts[i] is the number of values in (bound(i - 1), bound(i)], the last one is for +Inf
+    void Snapshot(std::vector<uint64_t>& counts, uint64_t& sum) const;
+
+ private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> counts[NUM_BOUNDS + 1];
+        std::atomic<uint64_t> sum;
+        Shard() : sum(0) {
+            for (auto& c : counts)
+                c = 0;
+        }
+    };
+    Shard shards_[METRICS_NUM_SHARDS];
+};
+
+class MetricsRegistry {
+ public:
+    // Append <labels, value> of each sample
+    typedef std::function<void(std::vector<std::pair<std::string, double>>&)> GaugeCollector;
+
+    static MetricsRegistry* GetInstance() {
+        static MetricsRegistry registry;
+        return &registry;
+    }
+
+    // Same name and labels return the same metric
+    ShardedCounter* GetCounter(const std::string& name, const std::string& help, const std::string& labels = "");
+    ShardedHistogram* GetHistogram(const std::string& name, const std::string& help, const std::string& labels = "");
+
+    // collector is called on every export, and must not call the registry
+    void RegisterGauge(const std::string& name, const std::string& help, GaugeCollector collector);
+
+    // All metrics in Prometheus text exposition format
+    std::string ExportText();
+
+    // Serve ExportText() over HTTP on given port in a background thread
+    // Return false if port cannot be bound
+    bool StartServer(int port);
+
+ private:
+    MetricsRegistry() {}
+
+    enum MetricType { COUNTER, HISTOGRAM, GAUGE };
+
+    struct Family {
+        MetricType type;
+        std::string help;
+        // labels -> metric
+        std::map<std::string, std::unique_ptr<ShardedCounter>> counters;
+        std::map<std::string, std::unique_ptr<ShardedHistogram>> histograms;
+        std::vector<GaugeCollector> collectors;
+    };
+
+    Family& GetFamily(const std::string& name, const std::string& help, MetricType type);
+    void Serve(int listen_fd);
+
+    std::mutex mutex_;
+    std::map<std::string, Family> families_;
+    std::thread server_thread_;
+};
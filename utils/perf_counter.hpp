@@ -0,0 +1,88 @@
+// Copyright 2020 BigGraph Team @ Husky Data Lab, CUHK
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* Hardware event counter of the calling thread via perf_event_open(2).
+ * Open() fails (returns false) when the event is not supported or not permitted
+ * (see /proc/sys/kernel/perf_event_paranoid), and Read() returns 0 in that case.
+ *
+ * Usage:
+ *     PerfCounter llc_miss;
+ *     llc_miss.Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+ *     llc_miss.Start();
+ *     ...
+ *     llc_miss.Stop();
+ *     uint64_t count = llc_miss.Read();
+ */
+class PerfCounter {
+ public:
+    PerfCounter() {}
+    PerfCounter(const PerfCounter&) = delete;
+    PerfCounter& operator=(const PerfCounter&) = delete;
+    ~PerfCounter() {
+        if (fd_ >= 0)
+            close(fd_);
+    }
+
+    // user-space events only, so that it works with perf_event_paranoid <= 2
+    bool Open(uint32_t type, uint64_t config) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        return fd_ >= 0;
+    }
+
+    // L1D read misses, as the config of PERF_TYPE_HW_CACHE
+    static uint64_t L1DReadMissConfig() {
+        return PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    }
+
+    bool Valid() const { return fd_ >= 0; }
+
+    void Start() {
+        if (fd_ < 0)
+            return;
+        ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    void Stop() {
+        if (fd_ >= 0)
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    uint64_t Read() const {
+        uint64_t count = 0;
+        if (fd_ < 0 || read(fd_, &count, sizeof(count)) != sizeof(count))
+            return 0;
+        return count;
+    }
+
+ private:
+    int fd_ = -1;
+};